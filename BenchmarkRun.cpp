@@ -0,0 +1,167 @@
+#include "BenchmarkRun.h"
+
+#include <format>
+#include <fstream>
+
+#include "FrameStats.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// The flythrough: around the regular scene, then out over the
+	// field stress entities are spawned in, then back
+	const XMFLOAT3 PATH_POSITIONS[] = {
+		XMFLOAT3(-6, 3, -14),
+		XMFLOAT3(8, 6, -12),
+		XMFLOAT3(26, 5, 0),
+		XMFLOAT3(12, 10, 18),
+		XMFLOAT3(-30, 18, 30),
+		XMFLOAT3(-60, 25, 90),
+		XMFLOAT3(40, 30, 60),
+		XMFLOAT3(0, 12, -20) };
+	const XMFLOAT3 PATH_TARGETS[] = {
+		XMFLOAT3(8, 0, 0),
+		XMFLOAT3(10, 0, 0),
+		XMFLOAT3(10, 0, 0),
+		XMFLOAT3(0, 0, 60),
+		XMFLOAT3(0, 0, 80),
+		XMFLOAT3(20, 0, 140),
+		XMFLOAT3(-20, 0, 60),
+		XMFLOAT3(10, 0, 0) };
+	const int PATH_KEYS = sizeof(PATH_POSITIONS) / sizeof(PATH_POSITIONS[0]);
+
+	XMVECTOR SamplePath(const XMFLOAT3* keys, float t)
+	{
+		int segment = (int)t;
+		segment = segment < PATH_KEYS - 1 ? segment : PATH_KEYS - 2;
+		float s = t - segment;
+
+		//end keys are repeated so the curve still starts and ends on them
+		auto key = [keys](int i) { return XMLoadFloat3(&keys[i < 0 ? 0 : (i < PATH_KEYS ? i : PATH_KEYS - 1)]); };
+		return XMVectorCatmullRom(key(segment - 1), key(segment), key(segment + 1), key(segment + 2), s);
+	}
+
+	std::string SummaryJson(std::vector<float>& samples)
+	{
+		FrameStats::Summary summary = FrameStats::SummarizeSamples(samples);
+		return std::format("{{\"count\":{},\"mean\":{:.4f},\"p50\":{:.4f},\"p95\":{:.4f},\"p99\":{:.4f},\"max\":{:.4f},\"hitches\":{}}}",
+			summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max, summary.hitches);
+	}
+}
+
+BenchmarkRun::BenchmarkRun(const std::string& scene, unsigned int frameCount, unsigned long long firstFrame, const std::string& reportPath)
+{
+	this->scene = scene;
+	this->reportPath = reportPath;
+	this->firstFrame = firstFrame;
+	records.resize(frameCount > 0 ? frameCount : 1, FrameRecord{});
+	framesRecorded = 0;
+}
+
+BenchmarkRun::~BenchmarkRun()
+{
+}
+
+void BenchmarkRun::CameraPose(unsigned long long frame, XMFLOAT3& position, XMFLOAT3& target)
+{
+	unsigned long long index = frame - firstFrame;
+	float progress = records.size() > 1 ? (float)index / (records.size() - 1) : 0.0f;
+	float t = (progress < 1.0f ? progress : 1.0f) * (PATH_KEYS - 1);
+	XMStoreFloat3(&position, SamplePath(PATH_POSITIONS, t));
+	XMStoreFloat3(&target, SamplePath(PATH_TARGETS, t));
+}
+
+void BenchmarkRun::RecordFrame(unsigned long long frame, float frameMs, float updateMs, unsigned int entities, unsigned int visible, unsigned int shadowCasters)
+{
+	unsigned long long index = frame - firstFrame;
+	if (frame < firstFrame || index >= records.size()) {
+		return;
+	}
+
+	FrameRecord& record = records[index];
+	record.frameMs = frameMs;
+	record.updateMs = updateMs;
+	record.entities = entities;
+	record.visible = visible;
+	record.shadowCasters = shadowCasters;
+	framesRecorded++;
+}
+
+void BenchmarkRun::RecordDraw(unsigned long long frame, float drawMs, const StateCache::Stats& states)
+{
+	unsigned long long index = frame - firstFrame;
+	if (frame < firstFrame || index >= records.size()) {
+		return;
+	}
+
+	FrameRecord& record = records[index];
+	record.drawn = true;
+	record.drawMs = drawMs;
+	record.drawCalls = states.draws;
+	record.uploads = states.uploads;
+	record.uploadBytes = states.uploadBytes;
+	record.stateCalls = 0;
+	record.redundantStateCalls = 0;
+	for (int i = 0; i < StateCache::CATEGORY_COUNT; ++i) {
+		record.stateCalls += states.issued[i];
+		record.redundantStateCalls += states.skipped[i];
+	}
+}
+
+void BenchmarkRun::AddResult(const std::string& name, const std::string& json)
+{
+	results.push_back({ name, json });
+}
+
+// --------------------------------------------------------
+// Summaries first, then every frame.  The first frame's
+// frameMs has nothing before it to measure from, so it's left
+// out of the summary; frames the renderer never got to (it
+// always skips to the newest snapshot) have no draw numbers
+// --------------------------------------------------------
+bool BenchmarkRun::WriteReport(unsigned int width, unsigned int height, bool deferredPasses, bool nullBackend)
+{
+	std::ofstream out(reportPath);
+	if (!out) {
+		return false;
+	}
+
+	std::vector<float> frameTimes;
+	std::vector<float> updateTimes;
+	std::vector<float> drawTimes;
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (i > 0) {
+			frameTimes.push_back(records[i].frameMs);
+		}
+		updateTimes.push_back(records[i].updateMs);
+		if (records[i].drawn) {
+			drawTimes.push_back(records[i].drawMs);
+		}
+	}
+	size_t drawn = drawTimes.size();
+
+	out << "{\n";
+	out << std::format("\"scene\":\"{}\",\n\"frames\":{},\n\"framesDrawn\":{},\n\"width\":{},\n\"height\":{},\n\"deferredPasses\":{},\n\"nullBackend\":{},\n",
+		scene, records.size(), drawn, width, height, deferredPasses ? "true" : "false", nullBackend ? "true" : "false");
+	for (const auto& result : results) {
+		out << std::format("\"{}\":{},\n", result.first, result.second);
+	}
+	out << "\"summary\":{\n";
+	out << "\"frameMs\":" << SummaryJson(frameTimes) << ",\n";
+	out << "\"updateMs\":" << SummaryJson(updateTimes) << ",\n";
+	out << "\"drawMs\":" << SummaryJson(drawTimes) << "\n";
+	out << "},\n\"perFrame\":[\n";
+	for (size_t i = 0; i < records.size(); ++i) {
+		const FrameRecord& r = records[i];
+		out << std::format("{{\"frame\":{},\"frameMs\":{:.4f},\"updateMs\":{:.4f},\"entities\":{},\"visible\":{},\"shadowCasters\":{}",
+			i, r.frameMs, r.updateMs, r.entities, r.visible, r.shadowCasters);
+		if (r.drawn) {
+			out << std::format(",\"drawMs\":{:.4f},\"drawCalls\":{},\"uploads\":{},\"uploadBytes\":{},\"stateCalls\":{},\"redundantStateCalls\":{}",
+				r.drawMs, r.drawCalls, r.uploads, r.uploadBytes, r.stateCalls, r.redundantStateCalls);
+		}
+		out << (i + 1 < records.size() ? "},\n" : "}\n");
+	}
+	out << "]\n}\n";
+	return (bool)out;
+}
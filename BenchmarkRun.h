@@ -0,0 +1,75 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+#include "StateCache.h"
+
+// --------------------------------------------------------
+// A scripted, repeatable run of the real frame loop.  The
+// camera flies a fixed path over a set number of frames and
+// every frame's CPU timings and counters are kept for a JSON
+// report.  Started with -benchmark on the command line (see
+// Main.cpp), which also pins the simulation to one tick per
+// frame and turns the UI off.
+//
+// The main thread records a frame's simulation side, the
+// render thread its draw side.  They write different fields
+// of a record sized up front, so nothing is locked; the
+// report is only written once the render thread has stopped.
+// --------------------------------------------------------
+class BenchmarkRun
+{
+public:
+
+	BenchmarkRun(const std::string& scene, unsigned int frameCount, unsigned long long firstFrame, const std::string& reportPath);
+	~BenchmarkRun();
+	BenchmarkRun(const BenchmarkRun&) = delete; // Remove copy constructor
+	BenchmarkRun& operator=(const BenchmarkRun&) = delete; // Remove copy-assignment operator
+
+	// Camera path position and look-at target for a frame of the run,
+	// Catmull-Rom through the recorded keys
+	void CameraPose(unsigned long long frame, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& target);
+
+	// Main thread, once per published frame
+	void RecordFrame(unsigned long long frame, float frameMs, float updateMs, unsigned int entities, unsigned int visible, unsigned int shadowCasters);
+	// Render thread, once per drawn frame
+	void RecordDraw(unsigned long long frame, float drawMs, const StateCache::Stats& states);
+
+	bool Done() { return framesRecorded >= records.size(); }
+
+	// An extra top level field for the report, value already JSON
+	void AddResult(const std::string& name, const std::string& json);
+
+	// Writes the report.  Returns false if it couldn't
+	bool WriteReport(unsigned int width, unsigned int height, bool deferredPasses, bool nullBackend);
+
+private:
+
+	struct FrameRecord
+	{
+		// Main thread
+		float frameMs;
+		float updateMs;
+		unsigned int entities;
+		unsigned int visible;
+		unsigned int shadowCasters;
+
+		// Render thread
+		bool drawn;
+		float drawMs;
+		unsigned int drawCalls;
+		unsigned int uploads;
+		unsigned long long uploadBytes;
+		unsigned int stateCalls;
+		unsigned int redundantStateCalls;
+	};
+
+	std::string scene;
+	std::string reportPath;
+	unsigned long long firstFrame;
+	std::vector<FrameRecord> records;
+	unsigned int framesRecorded;
+	std::vector<std::pair<std::string, std::string>> results;
+};
@@ -0,0 +1,406 @@
+#include "Benchmarks.h"
+
+#include <DirectXMath.h>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "EntityStore.h"
+#include "JobSystem.h"
+#include "PbrBatch.h"
+#include "PbrLighting.h"
+#include "Transform.h"
+#include "TransformPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Milliseconds elapsed since start
+	double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Stand-in for the old Entity: components held by shared_ptr, with
+	// both kinds of getter.  Kept out of line so the copies can't be
+	// optimized away across the call
+	struct GetterEntity
+	{
+		std::shared_ptr<float> transform;
+		std::shared_ptr<float> mesh;
+		std::shared_ptr<float> material;
+
+		__declspec(noinline) std::shared_ptr<float> GetTransformOwning() { return transform; }
+		__declspec(noinline) std::shared_ptr<float> GetMaterialOwning() { return material; }
+		__declspec(noinline) std::shared_ptr<float> GetMeshOwning() { return mesh; }
+		__declspec(noinline) float* GetTransform() { return transform.get(); }
+		__declspec(noinline) float* GetMaterial() { return material.get(); }
+		__declspec(noinline) float* GetMesh() { return mesh.get(); }
+	};
+}
+
+// --------------------------------------------------------
+// Times two cases per frame on a fresh pool:
+//  - the root moves, so every node's world is recomposed
+//  - one leaf moves, so only that leaf is rebuilt
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::TransformHierarchy(unsigned int nodeCount, bool deep, int frames)
+{
+	TransformPool pool;
+	std::vector<std::unique_ptr<Transform>> nodes;
+	nodes.reserve(nodeCount);
+
+	for (unsigned int i = 0; i < nodeCount; ++i) {
+		nodes.push_back(std::make_unique<Transform>(&pool));
+		nodes[i]->SetPosition(0, 0.01f, 0);
+		if (i > 0) {
+			nodes[i]->SetParent(deep ? nodes[i - 1].get() : nodes[0].get());
+		}
+	}
+
+	//first update pays for laying out the hierarchy
+	auto start = std::chrono::high_resolution_clock::now();
+	pool.UpdateDirty();
+	double buildMs = ElapsedMs(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int f = 0; f < frames; ++f) {
+		nodes[0]->SetRotation(0, f * 0.01f, 0);
+		pool.UpdateDirty();
+	}
+	double rootMs = ElapsedMs(start) / frames;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int f = 0; f < frames; ++f) {
+		nodes[nodeCount - 1]->SetRotation(0, f * 0.01f, 0);
+		pool.UpdateDirty();
+	}
+	double leafMs = ElapsedMs(start) / frames;
+
+	return Result{ std::format("{} hierarchy, {} nodes: first update {:.3f} ms, root moved {:.3f} ms, leaf moved {:.3f} ms",
+		deep ? "Deep" : "Wide", nodeCount, buildMs, rootMs, leafMs) };
+}
+
+// --------------------------------------------------------
+// Fills a pool with random rotations, non-uniform scales and
+// translations, times the batch rebuild (which builds the
+// inverse-transpose from the components), then times the old
+// general inverse over the same worlds and compares the two
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::InverseTranspose(unsigned int transformCount)
+{
+	TransformPool pool;
+	std::vector<unsigned int> indices(transformCount);
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> scale(0.1f, 5.0f);
+	std::uniform_real_distribution<float> offset(-100.0f, 100.0f);
+	for (unsigned int i = 0; i < transformCount; ++i) {
+		indices[i] = pool.Allocate();
+		pool.SetPitchYawRoll(indices[i], angle(rng), angle(rng), angle(rng));
+		pool.SetScale(indices[i], scale(rng), scale(rng), scale(rng));
+		pool.SetPosition(indices[i], offset(rng), offset(rng), offset(rng));
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	pool.UpdateDirty();
+	double fastMs = ElapsedMs(start);
+
+	std::vector<XMFLOAT4X4> general(transformCount);
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < transformCount; ++i) {
+		XMMATRIX world = XMLoadFloat4x4(&pool.GetWorldMatrix(indices[i]));
+		XMStoreFloat4x4(&general[i], XMMatrixInverse(0, XMMatrixTranspose(world)));
+	}
+	double generalMs = ElapsedMs(start);
+
+	//relative to the element size, since translation terms get large
+	float maxError = 0;
+	for (unsigned int i = 0; i < transformCount; ++i) {
+		const XMFLOAT4X4& fast = pool.GetWorldInverseTranspose(indices[i]);
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				float error = std::fabs(fast.m[r][c] - general[i].m[r][c]) / (std::fabs(general[i].m[r][c]) + 1.0f);
+				maxError = error > maxError ? error : maxError;
+			}
+		}
+	}
+
+	//NaN fails too
+	bool passed = maxError <= INVERSE_TRANSPOSE_TOLERANCE;
+	double perMillion = 1000000.0 / transformCount;
+	return Result{ std::format("Inverse-transpose, {} transforms: full rebuild {:.2f} ms/million (general inverse alone {:.2f} ms/million), max relative difference {:.2e}{}",
+		transformCount, fastMs * perMillion, generalMs * perMillion, maxError, passed ? "" : " (OVER TOLERANCE)"), passed };
+}
+
+// --------------------------------------------------------
+// Entities have no mesh or material here, only the parts the
+// CPU side systems touch.  The camera looks down +Z from the
+// middle of one edge of the grid.
+//
+// Also checks the parallel spin lands on exactly the same
+// rotations as the serial one
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::EntityIteration(unsigned int entityCount, int frames, JobSystem* jobSystem)
+{
+	TransformPool pool;
+	EntityStore store(&pool);
+
+	unsigned int side = (unsigned int)std::sqrt((double)entityCount) + 1;
+	for (unsigned int i = 0; i < entityCount; ++i) {
+		EntityHandle entity = store.Create(nullptr, nullptr);
+		pool.SetPosition(store.GetTransform(entity), (float)(i % side) - side * 0.5f, 0, (float)(i / side));
+		store.SetSpin(entity, true, (float)i);
+	}
+	pool.UpdateDirty();
+
+	XMFLOAT4X4 viewProjection;
+	XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 5, -1, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV2, 16.0f / 9.0f, 0.01f, 500.0f)));
+	std::vector<unsigned int> visible;
+	JobSystem& jobs = jobSystem ? *jobSystem : JobSystem::Default();
+
+	std::vector<XMFLOAT4> serialRotations(pool.GetCount());
+	store.UpdateSpin(1.0f);
+	for (unsigned int i = 0; i < pool.GetCount(); ++i) {
+		serialRotations[i] = pool.GetRotation(i);
+	}
+	store.UpdateSpin(1.0f, &jobs);
+	bool deterministic = true;
+	for (unsigned int i = 0; i < pool.GetCount(); ++i) {
+		XMFLOAT4 rotation = pool.GetRotation(i);
+		deterministic = deterministic && memcmp(&rotation, &serialRotations[i], sizeof(XMFLOAT4)) == 0;
+	}
+
+	double spinMs = 0;
+	double spinParallelMs = 0;
+	double rebuildMs = 0;
+	double rebuildParallelMs = 0;
+	double cullMs = 0;
+	for (int f = 0; f < frames; ++f) {
+		auto start = std::chrono::high_resolution_clock::now();
+		store.UpdateSpin(f * 0.016f);
+		spinMs += ElapsedMs(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		pool.UpdateDirty();
+		rebuildMs += ElapsedMs(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		store.UpdateSpin(f * 0.016f, &jobs);
+		spinParallelMs += ElapsedMs(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		pool.UpdateDirty(&jobs);
+		rebuildParallelMs += ElapsedMs(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		store.Cull(viewProjection, visible);
+		cullMs += ElapsedMs(start);
+	}
+
+	return Result{ std::format("Entities, {} on {} threads: spin {:.3f} / {:.3f} ms, transform rebuild {:.3f} / {:.3f} ms (serial / parallel), cull {:.3f} ms ({} visible) per frame, parallel results {}",
+		entityCount, jobs.GetThreadCount(), spinMs / frames, spinParallelMs / frames, rebuildMs / frames, rebuildParallelMs / frames,
+		cullMs / frames, visible.size(), deterministic ? "identical" : "DIFFER"), deterministic };
+}
+
+// --------------------------------------------------------
+// Mirrors the old draw loop's access pattern: the material
+// fetched 8 times, the transform twice and the mesh once per
+// entity per frame
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::GetterOverhead(unsigned int entityCount, int frames)
+{
+	std::vector<GetterEntity> entities(entityCount);
+	for (GetterEntity& e : entities) {
+		e.transform = std::make_shared<float>(1.0f);
+		e.mesh = std::make_shared<float>(2.0f);
+		e.material = std::make_shared<float>(3.0f);
+	}
+
+	float sum = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int f = 0; f < frames; ++f) {
+		for (GetterEntity& e : entities) {
+			for (int m = 0; m < 8; ++m) {
+				sum += *e.GetMaterialOwning();
+			}
+			sum += *e.GetTransformOwning() + *e.GetTransformOwning();
+			sum += *e.GetMeshOwning();
+		}
+	}
+	double owningMs = ElapsedMs(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int f = 0; f < frames; ++f) {
+		for (GetterEntity& e : entities) {
+			for (int m = 0; m < 8; ++m) {
+				sum += *e.GetMaterial();
+			}
+			sum += *e.GetTransform() + *e.GetTransform();
+			sum += *e.GetMesh();
+		}
+	}
+	double rawMs = ElapsedMs(start);
+
+	double perEntity = 1000000.0 / ((double)entityCount * frames);
+	return Result{ std::format("Getters, {} entities: shared_ptr copies {:.1f} ns/entity, raw pointers {:.1f} ns/entity (checksum {})",
+		entityCount, owningMs * perEntity, rawMs * perEntity, sum) };
+}
+
+// --------------------------------------------------------
+// A fresh scheduler per thread count.  The stress half has
+// every job fork and wait on a child, so stealing and helping
+// while waiting both get exercised; the sum checks nothing
+// was lost or run twice
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::JobScaling(unsigned int jobCount, unsigned int transformCount, unsigned int maxThreads)
+{
+	TransformPool pool;
+	std::vector<unsigned int> indices(transformCount);
+	for (unsigned int i = 0; i < transformCount; ++i) {
+		indices[i] = pool.Allocate();
+	}
+
+	Result result{ std::format("Job scaling, {} jobs / {} transforms:", jobCount, transformCount) };
+	if (maxThreads == 0) {
+		maxThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+	}
+	for (unsigned int threads = 1; threads <= maxThreads; ++threads) {
+		JobSystem jobs(threads - 1);
+
+		std::atomic<unsigned int> finished = 0;
+		JobSystem::Counter counter = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int j = 0; j < jobCount; ++j) {
+			jobs.Run([&jobs, &finished]() {
+				JobSystem::Counter child = 0;
+				jobs.Run([&finished]() { finished++; }, &child);
+				jobs.Wait(&child);
+				finished++;
+			}, &counter);
+		}
+		jobs.Wait(&counter);
+		double stressMs = ElapsedMs(start);
+
+		for (unsigned int i = 0; i < transformCount; ++i) {
+			pool.SetPosition(indices[i], (float)i, 0, 0);
+		}
+		start = std::chrono::high_resolution_clock::now();
+		pool.UpdateDirty(&jobs);
+		double transformMs = ElapsedMs(start);
+
+		bool allRan = finished == jobCount * 2;
+		result.passed = result.passed && allRan;
+		result.text += std::format("\n  {} threads: jobs {:.2f} ms{}, transforms {:.2f} ms",
+			threads, stressMs, allRan ? "" : " (LOST JOBS)", transformMs);
+	}
+	return result;
+}
+
+// --------------------------------------------------------
+// The same random samples through both versions.  Error is
+// relative to the scalar result, with a floor so that near
+// black samples don't blow it up; the two only differ in
+// rounding (pow(x, 5) is multiplied out, for one)
+// --------------------------------------------------------
+Benchmarks::Result Benchmarks::BatchLighting(unsigned int sampleCount)
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> zeroOne(0.0f, 1.0f);
+
+	//one of each kind up front, then a spread of point and spot lights
+	const unsigned int lightCount = 8;
+	Light lights[lightCount] = {};
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		Light& light = lights[i];
+		light.Type = i == 0 ? LIGHT_TYPE_DIRECTIONAL : (i % 2 ? LIGHT_TYPE_POINT : LIGHT_TYPE_SPOT);
+		XMStoreFloat3(&light.Direction, XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 0)));
+		light.Position = XMFLOAT3(unit(rng) * 10, unit(rng) * 10, unit(rng) * 10);
+		light.Range = 8 + zeroOne(rng) * 8;
+		light.Intensity = 0.5f + zeroOne(rng);
+		light.Color = XMFLOAT3(zeroOne(rng), zeroOne(rng), zeroOne(rng));
+		light.SpotInnerAngle = XMConvertToRadians(20);
+		light.SpotOuterAngle = XMConvertToRadians(35);
+	}
+	PbrLighting::Vec3 cameraPos{ 0, 2, -15 };
+
+	std::vector<float> inputs[12];
+	for (auto& input : inputs) {
+		input.resize(sampleCount);
+	}
+	for (unsigned int i = 0; i < sampleCount; ++i) {
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, XMVector3Normalize(XMVectorSet(unit(rng), unit(rng), unit(rng), 0)));
+		inputs[0][i] = n.x;
+		inputs[1][i] = n.y;
+		inputs[2][i] = n.z;
+		for (int a = 3; a < 6; ++a) {
+			inputs[a][i] = unit(rng) * 10;
+		}
+		for (int a = 6; a < 9; ++a) {
+			inputs[a][i] = zeroOne(rng);
+		}
+		inputs[9][i] = 0.05f + zeroOne(rng) * 0.95f;
+		inputs[10][i] = zeroOne(rng) < 0.5f ? 0.0f : 1.0f;
+		inputs[11][i] = zeroOne(rng) < 0.3f ? 0.0f : 1.0f;
+	}
+
+	std::vector<float> scalar[3];
+	std::vector<float> batched[3];
+	for (int c = 0; c < 3; ++c) {
+		scalar[c].resize(sampleCount);
+		batched[c].resize(sampleCount);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < sampleCount; ++i) {
+		PbrLighting::Vec3 color = PbrLighting::Shade(
+			PbrLighting::Vec3{ inputs[0][i], inputs[1][i], inputs[2][i] },
+			PbrLighting::Vec3{ inputs[3][i], inputs[4][i], inputs[5][i] },
+			cameraPos,
+			PbrLighting::Vec3{ inputs[6][i], inputs[7][i], inputs[8][i] },
+			inputs[9][i], inputs[10][i], inputs[11][i], lights, lightCount);
+		scalar[0][i] = color.x;
+		scalar[1][i] = color.y;
+		scalar[2][i] = color.z;
+	}
+	double scalarMs = ElapsedMs(start);
+
+	PbrBatch::SampleStream stream = {};
+	stream.count = sampleCount;
+	for (int c = 0; c < 3; ++c) {
+		stream.normal[c] = inputs[c].data();
+		stream.position[c] = inputs[3 + c].data();
+		stream.albedo[c] = inputs[6 + c].data();
+		stream.color[c] = batched[c].data();
+	}
+	stream.roughness = inputs[9].data();
+	stream.metalness = inputs[10].data();
+	stream.shadow = inputs[11].data();
+
+	start = std::chrono::high_resolution_clock::now();
+	PbrBatch::ShadeStream(stream, cameraPos, lights, lightCount);
+	double batchMs = ElapsedMs(start);
+
+	float maxError = 0;
+	unsigned int mismatches = 0;
+	for (int c = 0; c < 3; ++c) {
+		for (unsigned int i = 0; i < sampleCount; ++i) {
+			float error = std::fabs(batched[c][i] - scalar[c][i]) / std::fmax(std::fabs(scalar[c][i]), 0.01f);
+			maxError = std::fmax(maxError, error);
+			mismatches += !(error <= PbrBatch::SCALAR_TOLERANCE); //NaNs count too
+		}
+	}
+
+	return Result{ std::format("Batch lighting, {} samples x {} lights: scalar {:.2f} ms, {} wide {:.2f} ms ({:.1f}x), max relative error {:.2e}{}",
+		sampleCount, lightCount, scalarMs, PbrBatch::WIDTH, batchMs, scalarMs / batchMs, maxError,
+		mismatches == 0 ? "" : std::format(" ({} MISMATCHED)", mismatches)), mismatches == 0 };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+class JobSystem;
+
+// --------------------------------------------------------
+// Synthetic CPU benchmarks that can be kicked off from the
+// debug UI.  Each one builds its own data (nothing in the
+// running scene is touched) and returns a line of results.
+//
+// Some also check the result of the code they time against
+// a reference; those report whether it held, so the tests
+// can run them headless and fail on it.
+// --------------------------------------------------------
+namespace Benchmarks
+{
+	struct Result
+	{
+		std::string text;
+		bool passed = true; // false when a check failed, which the text also says
+	};
+
+	// Largest relative difference allowed between the pool's
+	// inverse-transpose and the general inverse
+	const float INVERSE_TRANSPOSE_TOLERANCE = 1e-3f;
+
+	// Transform hierarchy update: one long parent chain (deep) or one
+	// root with every other node as a direct child (wide)
+	Result TransformHierarchy(unsigned int nodeCount, bool deep, int frames);
+
+	// Closed-form inverse-transpose from the pool vs the general
+	// XMMatrixInverse path it replaced: timing and largest difference,
+	// which fails above INVERSE_TRANSPOSE_TOLERANCE
+	Result InverseTranspose(unsigned int transformCount);
+
+	// Entity store systems (spin, transform rebuild, frustum cull) over
+	// a grid of entities, only part of which is in view.  Spin and the
+	// rebuild run both serially and on a job system (the default one
+	// unless given), and it fails unless the parallel spin matches the
+	// serial one bit for bit
+	Result EntityIteration(unsigned int entityCount, int frames, JobSystem* jobSystem = nullptr);
+
+	// Cost per entity of reaching components through getters that hand
+	// back shared_ptr copies vs raw observer pointers
+	Result GetterOverhead(unsigned int entityCount, int frames);
+
+	// Job system stress (lots of tiny jobs, with nested waits) and the
+	// batched transform rebuild, each timed with 1..N threads, N being
+	// the core count unless given.  Fails if any job is lost or run twice
+	Result JobScaling(unsigned int jobCount, unsigned int transformCount, unsigned int maxThreads = 0);
+
+	// PbrBatch against the scalar PbrLighting it mirrors, over random
+	// samples and a mix of light types: timing and largest difference,
+	// which fails above PbrBatch::SCALAR_TOLERANCE
+	Result BatchLighting(unsigned int sampleCount);
+}
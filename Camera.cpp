@@ -1,5 +1,7 @@
 #include "Camera.h"
 #include "Input.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace DirectX;
 
@@ -17,19 +19,19 @@ Camera::~Camera()
 {
 }
 
-XMFLOAT4X4 Camera::GetViewMatrix()
+const XMFLOAT4X4& Camera::GetViewMatrix()
 {
 	return viewMat;
 }
 
-XMFLOAT4X4 Camera::GetProjectionMatrix()
+const XMFLOAT4X4& Camera::GetProjectionMatrix()
 {
 	return projectionMat;
 }
 
-std::shared_ptr<Transform> Camera::GetTransform()
+Transform* Camera::GetTransform()
 {
-	return transformPtr;
+	return transformPtr.get();
 }
 
 void Camera::Update(float dt)
@@ -59,12 +61,13 @@ void Camera::Update(float dt)
 		int cursorMovementX = Input::GetMouseXDelta();
 		int cursorMovementY = Input::GetMouseYDelta();
 
-		transformPtr.get()->Rotate(cursorMovementY * mouseLookSpeed, cursorMovementX * mouseLookSpeed, 0);
-		if (transformPtr.get()->GetPitchYawRoll().y > XM_PI) {
-			transformPtr.get()->SetRotation(0, -XM_PI, 0);
-		}
-		else if (transformPtr.get()->GetPitchYawRoll().y < -XM_PI) {
-			transformPtr.get()->SetRotation(0, XM_PI, 0);
+		//kept as angles so nothing is read back out of the quaternion; pitch
+		//has to stop short of straight up/down or it flips over into yaw + pi
+		if (cursorMovementX != 0 || cursorMovementY != 0) {
+			float pitchLimit = XM_PIDIV2 - 0.01f;
+			pitch = std::clamp(pitch + cursorMovementY * mouseLookSpeed, -pitchLimit, pitchLimit);
+			yaw = std::remainder(yaw + cursorMovementX * mouseLookSpeed, XM_2PI);
+			transformPtr.get()->SetRotation(pitch, yaw, 0);
 		}
 	}
 
@@ -83,6 +86,19 @@ void Camera::Update(float dt)
 }
 	
 
+void Camera::LookAt(XMFLOAT3 position, XMFLOAT3 target)
+{
+	XMFLOAT3 direction;
+	XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&target), XMLoadFloat3(&position))));
+
+	//positive pitch looks down, zero yaw looks down +z
+	pitch = -asinf(direction.y);
+	yaw = atan2f(direction.x, direction.z);
+	transformPtr.get()->SetPosition(position);
+	transformPtr.get()->SetRotation(pitch, yaw, 0);
+	UpdateViewMatrix();
+}
+
 void Camera::UpdateViewMatrix()
 {
 	XMFLOAT3 pos = transformPtr.get()->GetPosition();
@@ -13,12 +13,15 @@ public:
 	Camera(const Camera&) = delete; // Remove copy constructor
 	Camera& operator=(const	Camera&) = delete; // Remove copy-assignment operator
 
-	DirectX::XMFLOAT4X4 GetViewMatrix();
-	DirectX::XMFLOAT4X4 GetProjectionMatrix();
-	std::shared_ptr<Transform> GetTransform();
+	const DirectX::XMFLOAT4X4& GetViewMatrix();
+	const DirectX::XMFLOAT4X4& GetProjectionMatrix();
+	Transform* GetTransform(); //non-owning
 	void UpdateProjectionMatrix(float aspectRatio);
 
 	void Update(float dt);
+	// Puts the camera at position facing target (no roll), for scripted
+	// cameras in place of Update
+	void LookAt(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 target);
 
 private:
 
@@ -31,6 +34,8 @@ private:
 	float farClip = 500;
 	float moveSpeed = 3;
 	float mouseLookSpeed = .01f; 
+	float pitch = 0; //mouse look angles, the transform's rotation is built from these
+	float yaw = 0;
 	bool isPerspective = true;
 
 	void UpdateViewMatrix();
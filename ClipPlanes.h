@@ -0,0 +1,15 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The near and far planes a perspective projection was built
+// with, read back out of the matrix: _33 = f / (f - n) and
+// _43 = -n * f / (f - n), as XMMatrixPerspectiveFovLH makes
+// them
+// --------------------------------------------------------
+inline void GetClipPlanes(const DirectX::XMFLOAT4X4& projection, float& nearZ, float& farZ)
+{
+	nearZ = -projection._43 / projection._33;
+	farZ = projection._43 / (1.0f - projection._33);
+}
@@ -0,0 +1,55 @@
+#include "D3D11RenderContext.h"
+
+D3D11RenderContext::D3D11RenderContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->context = context;
+}
+
+D3D11RenderContext::~D3D11RenderContext()
+{
+}
+
+void D3D11RenderContext::VSSetShader(ID3D11VertexShader* shader) { context->VSSetShader(shader, 0, 0); }
+void D3D11RenderContext::PSSetShader(ID3D11PixelShader* shader) { context->PSSetShader(shader, 0, 0); }
+void D3D11RenderContext::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) { context->VSSetConstantBuffers(slot, 1, &buffer); }
+void D3D11RenderContext::PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) { context->PSSetConstantBuffers(slot, 1, &buffer); }
+void D3D11RenderContext::VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) { context->VSSetShaderResources(slot, count, srvs); }
+void D3D11RenderContext::PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) { context->PSSetShaderResources(slot, count, srvs); }
+void D3D11RenderContext::VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) { context->VSSetSamplers(slot, 1, &sampler); }
+void D3D11RenderContext::PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) { context->PSSetSamplers(slot, 1, &sampler); }
+
+void D3D11RenderContext::IASetInputLayout(ID3D11InputLayout* layout) { context->IASetInputLayout(layout); }
+void D3D11RenderContext::IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) { context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset); }
+void D3D11RenderContext::IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset) { context->IASetIndexBuffer(buffer, (DXGI_FORMAT)format, offset); }
+void D3D11RenderContext::IASetPrimitiveTopology(unsigned int topology) { context->IASetPrimitiveTopology((D3D11_PRIMITIVE_TOPOLOGY)topology); }
+
+void D3D11RenderContext::RSSetState(ID3D11RasterizerState* state) { context->RSSetState(state); }
+
+void D3D11RenderContext::RSSetViewport(float width, float height, float left, float top)
+{
+	D3D11_VIEWPORT viewport = {};
+	viewport.TopLeftX = left;
+	viewport.TopLeftY = top;
+	viewport.Width = width;
+	viewport.Height = height;
+	viewport.MaxDepth = 1.0f;
+	context->RSSetViewports(1, &viewport);
+}
+
+void D3D11RenderContext::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) { context->OMSetDepthStencilState(state, stencilRef); }
+void D3D11RenderContext::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) { context->OMSetRenderTargets(count, rtvs, dsv); }
+void D3D11RenderContext::ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4]) { context->ClearRenderTargetView(rtv, color); }
+void D3D11RenderContext::ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth) { context->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH, depth, 0); }
+
+void D3D11RenderContext::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) { context->DrawIndexed(indexCount, startIndex, baseVertex); }
+void D3D11RenderContext::Draw(unsigned int vertexCount, unsigned int startVertex) { context->Draw(vertexCount, startVertex); }
+
+//constant buffers are always replaced whole, so bytes is only for backends that count
+void D3D11RenderContext::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) { context->UpdateSubresource(buffer, 0, 0, data, 0, 0); }
+
+//other buffers are usually bigger than what's in use, so only that much is copied
+void D3D11RenderContext::UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes)
+{
+	D3D11_BOX box = { 0, 0, 0, bytes, 1, 1 };
+	context->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "RenderContext.h"
+
+// --------------------------------------------------------
+// RenderContext on top of an immediate or deferred D3D11
+// device context.  Every call goes straight through
+// --------------------------------------------------------
+class D3D11RenderContext : public RenderContext
+{
+public:
+
+	D3D11RenderContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~D3D11RenderContext();
+	D3D11RenderContext(const D3D11RenderContext&) = delete; // Remove copy constructor
+	D3D11RenderContext& operator=(const D3D11RenderContext&) = delete; // Remove copy-assignment operator
+
+	void VSSetShader(ID3D11VertexShader* shader) override;
+	void PSSetShader(ID3D11PixelShader* shader) override;
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) override;
+	void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) override;
+	void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) override;
+	void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) override;
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override;
+	void IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset) override;
+	void IASetPrimitiveTopology(unsigned int topology) override;
+
+	void RSSetState(ID3D11RasterizerState* state) override;
+	void RSSetViewport(float width, float height, float left, float top) override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override;
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) override;
+	void ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4]) override;
+	void ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth) override;
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+	void Draw(unsigned int vertexCount, unsigned int startVertex) override;
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) override;
+	void UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) override;
+
+private:
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+};
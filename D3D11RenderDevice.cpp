@@ -0,0 +1,411 @@
+#include "D3D11RenderDevice.h"
+#include "WICTextureLoader.h"
+
+#include <d3dcompiler.h>
+#include <cstring>
+#include <string>
+
+#pragma comment(lib, "dxguid.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+
+namespace
+{
+	// --------------------------------------------------------
+	// Everything SimpleShader needs to know about a compiled
+	// shader's constant buffers, textures and samplers
+	// --------------------------------------------------------
+	void Reflect(ID3D11ShaderReflection* refl, ShaderReflection& reflection)
+	{
+		D3D11_SHADER_DESC shaderDesc;
+		refl->GetDesc(&shaderDesc);
+
+		//bound resources, structured buffers being textures as far as binding goes
+		for (unsigned int r = 0; r < shaderDesc.BoundResources; r++) {
+			D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
+			refl->GetResourceBindingDesc(r, &resourceDesc);
+
+			switch (resourceDesc.Type) {
+			case D3D_SIT_STRUCTURED:
+			case D3D_SIT_TEXTURE:
+				reflection.textures.push_back(ShaderReflection::Resource{ resourceDesc.Name, resourceDesc.BindPoint });
+				break;
+			case D3D_SIT_SAMPLER:
+				reflection.samplers.push_back(ShaderReflection::Resource{ resourceDesc.Name, resourceDesc.BindPoint });
+				break;
+			default:
+				break;
+			}
+		}
+
+		for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++) {
+			ID3D11ShaderReflectionConstantBuffer* cb = refl->GetConstantBufferByIndex(b);
+			D3D11_SHADER_BUFFER_DESC bufferDesc;
+			cb->GetDesc(&bufferDesc);
+
+			//how it's bound in the shader
+			D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+			refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+
+			ShaderReflection::ConstantBuffer buffer;
+			buffer.name = bufferDesc.Name;
+			buffer.type = (unsigned int)bufferDesc.Type;
+			buffer.size = bufferDesc.Size;
+			buffer.bindIndex = bindDesc.BindPoint;
+			for (unsigned int v = 0; v < bufferDesc.Variables; v++) {
+				D3D11_SHADER_VARIABLE_DESC varDesc;
+				cb->GetVariableByIndex(v)->GetDesc(&varDesc);
+				buffer.variables.push_back(ShaderReflection::Variable{ varDesc.Name, varDesc.StartOffset, varDesc.Size });
+			}
+			reflection.constantBuffers.push_back(buffer);
+		}
+	}
+
+	// --------------------------------------------------------
+	// An input layout matching what the vertex shader expects.
+	// Inputs with a semantic ending in "_PER_INSTANCE" come
+	// from slot 1, one step per instance.  Adapted from:
+	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
+	// --------------------------------------------------------
+	void CreateInputLayout(ID3D11Device* device, ID3D11ShaderReflection* refl, ID3DBlob* shaderBlob, ID3D11InputLayout** inputLayout)
+	{
+		D3D11_SHADER_DESC shaderDesc;
+		refl->GetDesc(&shaderDesc);
+
+		std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
+		for (unsigned int i = 0; i < shaderDesc.InputParameters; i++) {
+			D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+			refl->GetInputParameterDesc(i, &paramDesc);
+
+			std::string perInstanceStr = "_PER_INSTANCE";
+			std::string sem = paramDesc.SemanticName;
+			int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
+			bool isPerInstance = lenDiff >= 0 && sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+
+			D3D11_INPUT_ELEMENT_DESC elementDesc = {};
+			elementDesc.SemanticName = paramDesc.SemanticName;
+			elementDesc.SemanticIndex = paramDesc.SemanticIndex;
+			elementDesc.InputSlot = isPerInstance ? 1 : 0;
+			elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+			elementDesc.InputSlotClass = isPerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+			elementDesc.InstanceDataStepRate = isPerInstance ? 1 : 0;
+
+			//one to four components of the one type
+			static const DXGI_FORMAT formats[4][3] = {
+				{ DXGI_FORMAT_R32_UINT, DXGI_FORMAT_R32_SINT, DXGI_FORMAT_R32_FLOAT },
+				{ DXGI_FORMAT_R32G32_UINT, DXGI_FORMAT_R32G32_SINT, DXGI_FORMAT_R32G32_FLOAT },
+				{ DXGI_FORMAT_R32G32B32_UINT, DXGI_FORMAT_R32G32B32_SINT, DXGI_FORMAT_R32G32B32_FLOAT },
+				{ DXGI_FORMAT_R32G32B32A32_UINT, DXGI_FORMAT_R32G32B32A32_SINT, DXGI_FORMAT_R32G32B32A32_FLOAT } };
+			unsigned int components = paramDesc.Mask == 1 ? 1 : paramDesc.Mask <= 3 ? 2 : paramDesc.Mask <= 7 ? 3 : 4;
+			switch (paramDesc.ComponentType) {
+			case D3D_REGISTER_COMPONENT_UINT32: elementDesc.Format = formats[components - 1][0]; break;
+			case D3D_REGISTER_COMPONENT_SINT32: elementDesc.Format = formats[components - 1][1]; break;
+			case D3D_REGISTER_COMPONENT_FLOAT32: elementDesc.Format = formats[components - 1][2]; break;
+			default: break;
+			}
+
+			inputLayoutDesc.push_back(elementDesc);
+		}
+
+		//shaders fed only system values (a full screen triangle) get no
+		//layout, which they don't need
+		if (!inputLayoutDesc.empty()) {
+			device->CreateInputLayout(inputLayoutDesc.data(), (unsigned int)inputLayoutDesc.size(),
+				shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), inputLayout);
+		}
+	}
+
+	bool ReadShader(const wchar_t* file, Microsoft::WRL::ComPtr<ID3DBlob>& blob, Microsoft::WRL::ComPtr<ID3D11ShaderReflection>& refl)
+	{
+		if (FAILED(D3DReadFileToBlob(file, blob.GetAddressOf()))) {
+			return false;
+		}
+		return SUCCEEDED(D3DReflect(blob->GetBufferPointer(), blob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)refl.GetAddressOf()));
+	}
+
+	bool CreateBuffer(ID3D11Device* device, const D3D11_BUFFER_DESC& desc, const void* data, ID3D11Buffer** buffer)
+	{
+		D3D11_SUBRESOURCE_DATA initialData = {};
+		initialData.pSysMem = data;
+		return SUCCEEDED(device->CreateBuffer(&desc, data ? &initialData : 0, buffer));
+	}
+}
+
+D3D11RenderDevice::D3D11RenderDevice(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->device = device;
+	this->context = context;
+}
+
+D3D11RenderDevice::~D3D11RenderDevice()
+{
+}
+
+bool D3D11RenderDevice::LoadVertexShader(const wchar_t* file, ID3D11VertexShader** shader, ID3D11InputLayout** inputLayout, ShaderReflection& reflection)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
+	if (!ReadShader(file, blob, refl) || FAILED(device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), 0, shader))) {
+		return false;
+	}
+	Reflect(refl.Get(), reflection);
+	CreateInputLayout(device.Get(), refl.Get(), blob.Get(), inputLayout);
+	return true;
+}
+
+bool D3D11RenderDevice::LoadPixelShader(const wchar_t* file, ID3D11PixelShader** shader, ShaderReflection& reflection)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
+	if (!ReadShader(file, blob, refl) || FAILED(device->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), 0, shader))) {
+		return false;
+	}
+	Reflect(refl.Get(), reflection);
+	return true;
+}
+
+bool D3D11RenderDevice::CreateVertexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.ByteWidth = bytes;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	return CreateBuffer(device.Get(), desc, data, buffer);
+}
+
+bool D3D11RenderDevice::CreateIndexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.ByteWidth = bytes;
+	desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	return CreateBuffer(device.Get(), desc, data, buffer);
+}
+
+bool D3D11RenderDevice::CreateConstantBuffer(unsigned int bytes, ID3D11Buffer** buffer)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = bytes;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	return CreateBuffer(device.Get(), desc, 0, buffer);
+}
+
+bool D3D11RenderDevice::CreateStructuredBuffer(unsigned int stride, unsigned int count, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = stride * count;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = stride;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = count;
+
+	return CreateBuffer(device.Get(), desc, 0, buffer) && SUCCEEDED(device->CreateShaderResourceView(*buffer, &srvDesc, srv));
+}
+
+// --------------------------------------------------------
+// Author: Chris Cascioli
+// Purpose: Creates a cube map on the GPU from 6 individual textures
+//
+// - You are allowed to directly copy/paste this into your code base
+//   for assignments, given that you clearly cite that this is not
+//   code of your own design.
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Loads six individual textures (the six faces of a cube map), then
+// creates a blank cube map and copies each of the six textures to
+// another face.  Afterwards, creates a shader resource view for
+// the cube map and cleans up all of the temporary resources.
+// --------------------------------------------------------
+bool D3D11RenderDevice::LoadCubeMap(const wchar_t* const faces[6], ID3D11ShaderResourceView** srv)
+{
+	// Load the 6 textures into an array.
+	// - We need references to the TEXTURES, not SHADER RESOURCE VIEWS!
+	// - Explicitly NOT generating mipmaps, as we don't need them for the sky!
+	// - Order matters here!  +X, -X, +Y, -Y, +Z, -Z
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> textures[6] = {};
+	for (int i = 0; i < 6; i++)
+	{
+		if (FAILED(CreateWICTextureFromFile(device.Get(), faces[i], (ID3D11Resource**)textures[i].GetAddressOf(), 0)))
+			return false;
+	}
+
+	// We'll assume all of the textures are the same color format and resolution,
+	// so get the description of the first texture
+	D3D11_TEXTURE2D_DESC faceDesc = {};
+	textures[0]->GetDesc(&faceDesc);
+
+	// Describe the resource for the cube map, which is simply
+	// a "texture 2d array" with the TEXTURECUBE flag set.
+	// This is a special GPU resource format, NOT just a
+	// C++ array of textures!!!
+	D3D11_TEXTURE2D_DESC cubeDesc = {};
+	cubeDesc.ArraySize = 6;            // Cube map!
+	cubeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // We'll be using as a texture in a shader
+	cubeDesc.CPUAccessFlags = 0;       // No read back
+	cubeDesc.Format = faceDesc.Format; // Match the loaded texture's color format
+	cubeDesc.Width = faceDesc.Width;   // Match the size
+	cubeDesc.Height = faceDesc.Height; // Match the size
+	cubeDesc.MipLevels = 1;            // Only need 1
+	cubeDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE; // This should be treated as a CUBE, not 6 separate textures
+	cubeDesc.Usage = D3D11_USAGE_DEFAULT; // Standard usage
+	cubeDesc.SampleDesc.Count = 1;
+	cubeDesc.SampleDesc.Quality = 0;
+
+	// Create the final texture resource to hold the cube map
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
+	if (FAILED(device->CreateTexture2D(&cubeDesc, 0, cubeMapTexture.GetAddressOf())))
+		return false;
+
+	// Loop through the individual face textures and copy them,
+	// one at a time, to the cube map texure
+	for (int i = 0; i < 6; i++)
+	{
+		// Calculate the subresource position to copy into
+		unsigned int subresource = D3D11CalcSubresource(
+			0,  // Which mip (zero, since there's only one)
+			i,  // Which array element?
+			1); // How many mip levels are in the texture?
+
+		// Copy from one resource (texture) to another
+		context->CopySubresourceRegion(
+			cubeMapTexture.Get(),  // Destination resource
+			subresource,           // Dest subresource index (one of the array elements)
+			0, 0, 0,               // XYZ location of copy
+			textures[i].Get(),     // Source resource
+			0,                     // Source subresource index (we're assuming there's only one)
+			0);                    // Source subresource "box" of data to copy (zero means the whole thing)
+	}
+
+	// At this point, all of the faces have been copied into the
+	// cube map texture, so we can describe a shader resource view for it
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = cubeDesc.Format;         // Same format as texture
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE; // Treat this as a cube!
+	srvDesc.TextureCube.MipLevels = 1;        // Only need access to 1 mip
+	srvDesc.TextureCube.MostDetailedMip = 0;  // Index of the first mip we want to see
+
+	// Make the SRV, which is what we need for our shaders
+	return SUCCEEDED(device->CreateShaderResourceView(cubeMapTexture.Get(), &srvDesc, srv));
+}
+
+// --------------------------------------------------------
+// Copies the cube map's top mip into a staging array the CPU
+// can map, then out of that one face at a time
+// --------------------------------------------------------
+bool D3D11RenderDevice::ReadCubeMap(ID3D11ShaderResourceView* cubeMap, std::vector<unsigned char> faces[6], unsigned int& size, bool& bgra)
+{
+	Microsoft::WRL::ComPtr<ID3D11Resource> cubeResource;
+	cubeMap->GetResource(cubeResource.GetAddressOf());
+	ID3D11Texture2D* cubeTexture = (ID3D11Texture2D*)cubeResource.Get();
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	cubeTexture->GetDesc(&desc);
+	switch (desc.Format) {
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		bgra = false;
+		break;
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		bgra = true;
+		break;
+	default:
+		return false;
+	}
+
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.BindFlags = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.MiscFlags = 0;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> staging;
+	if (FAILED(device->CreateTexture2D(&desc, 0, staging.GetAddressOf()))) {
+		return false;
+	}
+	for (unsigned int i = 0; i < 6; i++) {
+		unsigned int subresource = D3D11CalcSubresource(0, i, desc.MipLevels);
+		context->CopySubresourceRegion(staging.Get(), subresource, 0, 0, 0, cubeTexture, subresource, 0);
+	}
+
+	//rows tightly packed, whatever pitch the driver mapped them with
+	size = desc.Width;
+	for (unsigned int i = 0; i < 6; ++i) {
+		unsigned int subresource = D3D11CalcSubresource(0, i, desc.MipLevels);
+		D3D11_MAPPED_SUBRESOURCE face = {};
+		if (FAILED(context->Map(staging.Get(), subresource, D3D11_MAP_READ, 0, &face))) {
+			return false;
+		}
+		faces[i].resize(size * size * 4);
+		for (unsigned int y = 0; y < size; ++y) {
+			std::memcpy(&faces[i][y * size * 4], (const unsigned char*)face.pData + y * face.RowPitch, size * 4);
+		}
+		context->Unmap(staging.Get(), subresource);
+	}
+	return true;
+}
+
+bool D3D11RenderDevice::CreateFloatTexture(unsigned int size, unsigned int channels, unsigned int mips, bool cube, const void* const* data, ID3D11ShaderResourceView** srv)
+{
+	unsigned int faces = cube ? 6 : 1;
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = size;
+	desc.Height = size;
+	desc.MipLevels = mips;
+	desc.ArraySize = faces;
+	desc.Format = channels == 2 ? DXGI_FORMAT_R32G32_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	//every face's whole mip chain at once, each mip half the last
+	std::vector<D3D11_SUBRESOURCE_DATA> subresources(faces * mips);
+	for (unsigned int face = 0; face < faces; ++face) {
+		for (unsigned int mip = 0; mip < mips; ++mip) {
+			D3D11_SUBRESOURCE_DATA& subresource = subresources[D3D11CalcSubresource(mip, face, mips)];
+			subresource.pSysMem = data[face * mips + mip];
+			subresource.SysMemPitch = ((size >> mip) > 1 ? (size >> mip) : 1) * channels * sizeof(float);
+		}
+	}
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&desc, subresources.data(), texture.GetAddressOf()))) {
+		return false;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = desc.Format;
+	if (cube) {
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		srvDesc.TextureCube.MipLevels = mips;
+	}
+	else {
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = mips;
+	}
+	return SUCCEEDED(device->CreateShaderResourceView(texture.Get(), &srvDesc, srv));
+}
+
+bool D3D11RenderDevice::CreateRasterizerState(unsigned int cullMode, ID3D11RasterizerState** state)
+{
+	D3D11_RASTERIZER_DESC desc = {};
+	desc.FillMode = D3D11_FILL_SOLID;
+	desc.CullMode = (D3D11_CULL_MODE)cullMode;
+	desc.DepthClipEnable = true;
+	return SUCCEEDED(device->CreateRasterizerState(&desc, state));
+}
+
+bool D3D11RenderDevice::CreateDepthStencilState(unsigned int comparison, bool depthWrite, ID3D11DepthStencilState** state)
+{
+	D3D11_DEPTH_STENCIL_DESC desc = {};
+	desc.DepthEnable = true;
+	desc.DepthWriteMask = depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+	desc.DepthFunc = (D3D11_COMPARISON_FUNC)comparison;
+	return SUCCEEDED(device->CreateDepthStencilState(&desc, state));
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// RenderDevice on top of a D3D11 device.  The immediate
+// context is only used at load time, to put the sky's faces
+// together and read them back
+// --------------------------------------------------------
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+
+	D3D11RenderDevice(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~D3D11RenderDevice();
+	D3D11RenderDevice(const D3D11RenderDevice&) = delete; // Remove copy constructor
+	D3D11RenderDevice& operator=(const D3D11RenderDevice&) = delete; // Remove copy-assignment operator
+
+	bool LoadVertexShader(const wchar_t* file, ID3D11VertexShader** shader, ID3D11InputLayout** inputLayout, ShaderReflection& reflection) override;
+	bool LoadPixelShader(const wchar_t* file, ID3D11PixelShader** shader, ShaderReflection& reflection) override;
+
+	bool CreateVertexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateIndexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateConstantBuffer(unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateStructuredBuffer(unsigned int stride, unsigned int count, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv) override;
+
+	bool LoadCubeMap(const wchar_t* const faces[6], ID3D11ShaderResourceView** srv) override;
+	bool ReadCubeMap(ID3D11ShaderResourceView* cubeMap, std::vector<unsigned char> faces[6], unsigned int& size, bool& bgra) override;
+	bool CreateFloatTexture(unsigned int size, unsigned int channels, unsigned int mips, bool cube, const void* const* data, ID3D11ShaderResourceView** srv) override;
+
+	bool CreateRasterizerState(unsigned int cullMode, ID3D11RasterizerState** state) override;
+	bool CreateDepthStencilState(unsigned int comparison, bool depthWrite, ID3D11DepthStencilState** state) override;
+
+private:
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+};
@@ -0,0 +1,57 @@
+#include "DeferredPassRecorder.h"
+#include "D3D11RenderContext.h"
+
+DeferredPassRecorder::DeferredPassRecorder(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate, StateCache* immediateStates, unsigned int passCount, JobSystem* jobs)
+	: scheduler(passCount, jobs)
+{
+	this->immediate = immediate;
+	this->immediateStates = immediateStates;
+
+	passes.resize(passCount);
+	for (Pass& pass : passes) {
+		device->CreateDeferredContext(0, pass.context.GetAddressOf());
+		pass.states = std::make_unique<StateCache>(std::make_shared<D3D11RenderContext>(pass.context));
+	}
+}
+
+DeferredPassRecorder::~DeferredPassRecorder()
+{
+	//a job still recording would be left writing into freed passes
+	scheduler.Wait();
+}
+
+void DeferredPassRecorder::Record(unsigned int pass, PassBody body)
+{
+	Pass* target = &passes[pass];
+	scheduler.Record(pass, [target, body = std::move(body)]() {
+		StateCache::Scope scope(target->states.get());
+
+		//every command list starts from default state, whatever the last one left
+		target->states->Invalidate();
+		target->states->ResetStats();
+
+		body(target->states.get());
+		target->context->FinishCommandList(FALSE, target->commands.ReleaseAndGetAddressOf());
+	});
+}
+
+void DeferredPassRecorder::Submit()
+{
+	scheduler.Submit([this](unsigned int pass) {
+		Pass& target = passes[pass];
+		if (target.commands) {
+			immediate->ExecuteCommandList(target.commands.Get(), FALSE);
+			target.commands.Reset();
+		}
+	});
+
+	//not restoring the immediate context's state resets it to defaults
+	immediateStates->Invalidate();
+}
+
+void DeferredPassRecorder::AddStats(StateCache::Stats& stats)
+{
+	for (Pass& pass : passes) {
+		StateCache::Accumulate(stats, pass.states->GetStats());
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+
+#include "PassRecorder.h"
+#include "JobSystem.h"
+#include "PassScheduler.h"
+
+// --------------------------------------------------------
+// Each pass slot has a deferred context (and state filter)
+// of its own.  Record schedules a job that records the pass
+// into a command list, so passes record side by side on the
+// job system's workers; Submit waits for them and executes
+// the lists in slot order on the immediate context
+// --------------------------------------------------------
+class DeferredPassRecorder : public PassRecorder
+{
+public:
+
+	DeferredPassRecorder(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate, StateCache* immediateStates, unsigned int passCount, JobSystem* jobs);
+	~DeferredPassRecorder();
+	DeferredPassRecorder(const DeferredPassRecorder&) = delete; // Remove copy constructor
+	DeferredPassRecorder& operator=(const DeferredPassRecorder&) = delete; // Remove copy-assignment operator
+
+	void Record(unsigned int pass, PassBody body) override;
+	void Submit() override;
+	void AddStats(StateCache::Stats& stats) override;
+
+private:
+
+	struct Pass
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+		std::unique_ptr<StateCache> states;
+		Microsoft::WRL::ComPtr<ID3D11CommandList> commands;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate;
+	StateCache* immediateStates;
+
+	std::vector<Pass> passes;
+	PassScheduler scheduler;
+};
@@ -0,0 +1,287 @@
+#include "EntityStore.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+EntityStore::EntityStore(TransformPool* pool)
+{
+	this->pool = pool;
+}
+
+EntityStore::~EntityStore()
+{
+	for (unsigned int transform : transforms) {
+		pool->Release(transform);
+	}
+}
+
+EntityHandle EntityStore::Create(Mesh* mesh, Material* material)
+{
+	unsigned int index;
+	if (!freeHandles.empty()) {
+		index = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else {
+		index = (unsigned int)slots.size();
+		slots.push_back(TransformPool::NONE);
+		generations.push_back(0);
+	}
+
+	unsigned int slot = (unsigned int)meshes.size();
+	slots[index] = slot;
+
+	transforms.push_back(pool->Allocate());
+	meshes.push_back(mesh);
+	materials.push_back(material);
+	boundsCenters.push_back(mesh ? mesh->GetBoundsCenter() : XMFLOAT3(0, 0, 0));
+	boundsRadii.push_back(mesh ? mesh->GetBoundsRadius() : 0.0f);
+	spins.push_back(0);
+	spinPhases.push_back(0);
+	slotOwners.push_back(index);
+	layoutTick = pool->GetTick();
+
+	return EntityHandle{ index, generations[index] };
+}
+
+// --------------------------------------------------------
+// Moves the last entity into the destroyed one's slot so the
+// arrays stay packed, and retires the handle
+// --------------------------------------------------------
+void EntityStore::Destroy(EntityHandle entity)
+{
+	unsigned int slot = SlotOf(entity);
+	if (slot == TransformPool::NONE) {
+		return;
+	}
+
+	pool->Release(transforms[slot]);
+	layoutTick = pool->GetTick();
+
+	unsigned int last = (unsigned int)meshes.size() - 1;
+	if (slot != last) {
+		transforms[slot] = transforms[last];
+		meshes[slot] = meshes[last];
+		materials[slot] = materials[last];
+		boundsCenters[slot] = boundsCenters[last];
+		boundsRadii[slot] = boundsRadii[last];
+		spins[slot] = spins[last];
+		spinPhases[slot] = spinPhases[last];
+		slotOwners[slot] = slotOwners[last];
+		slots[slotOwners[slot]] = slot;
+	}
+
+	transforms.pop_back();
+	meshes.pop_back();
+	materials.pop_back();
+	boundsCenters.pop_back();
+	boundsRadii.pop_back();
+	spins.pop_back();
+	spinPhases.pop_back();
+	slotOwners.pop_back();
+
+	slots[entity.index] = TransformPool::NONE;
+	generations[entity.index]++;
+	freeHandles.push_back(entity.index);
+}
+
+bool EntityStore::IsAlive(EntityHandle entity)
+{
+	return SlotOf(entity) != TransformPool::NONE;
+}
+
+unsigned int EntityStore::GetTransform(EntityHandle entity)
+{
+	unsigned int slot = SlotOf(entity);
+	return slot == TransformPool::NONE ? TransformPool::NONE : transforms[slot];
+}
+
+Mesh* EntityStore::GetMesh(EntityHandle entity)
+{
+	unsigned int slot = SlotOf(entity);
+	return slot == TransformPool::NONE ? nullptr : meshes[slot];
+}
+
+Material* EntityStore::GetMaterial(EntityHandle entity)
+{
+	unsigned int slot = SlotOf(entity);
+	return slot == TransformPool::NONE ? nullptr : materials[slot];
+}
+
+void EntityStore::SetMaterial(EntityHandle entity, Material* material)
+{
+	unsigned int slot = SlotOf(entity);
+	if (slot != TransformPool::NONE) {
+		materials[slot] = material;
+	}
+}
+
+void EntityStore::SetSpin(EntityHandle entity, bool spins, float phase)
+{
+	unsigned int slot = SlotOf(entity);
+	if (slot != TransformPool::NONE) {
+		this->spins[slot] = spins ? 1 : 0;
+		spinPhases[slot] = phase;
+	}
+}
+
+unsigned int EntityStore::SlotOf(EntityHandle entity)
+{
+	if (entity.index >= slots.size() || generations[entity.index] != entity.generation) {
+		return TransformPool::NONE;
+	}
+	return slots[entity.index];
+}
+
+// --------------------------------------------------------
+// The trig and quaternion building only write to each slot's
+// own scratch entry, so that part runs in parallel chunks.
+// Handing the results to the pool stays serial since marking
+// transforms dirty touches shared counters
+// --------------------------------------------------------
+void EntityStore::UpdateSpin(float totalTime, JobSystem* jobs)
+{
+	PROFILE_SCOPE("EntityStore::UpdateSpin");
+
+	unsigned int count = (unsigned int)spins.size();
+	spinRotations.resize(count);
+
+	auto spin = [this, totalTime](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			if (spins[i]) {
+				float sinT, cosT;
+				XMScalarSinCos(&sinT, &cosT, totalTime + spinPhases[i]);
+				XMStoreFloat4(&spinRotations[i], XMQuaternionRotationRollPitchYaw(sinT, cosT, sinT * cosT));
+			}
+		}
+	};
+
+	if (jobs != nullptr) {
+		jobs->ParallelFor(count, SPIN_CHUNK, spin);
+	}
+	else {
+		spin(0, count);
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		if (spins[i]) {
+			pool->SetRotation(transforms[i], spinRotations[i]);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Tests each entity's bounding sphere against the frustum of
+// a view * projection matrix.  Planes come straight out of
+// the matrix columns (near is z >= 0 in D3D clip space).
+//
+// Only reads the pool's cached world matrices (it never
+// rebuilds one), so several culls can run at once, but the
+// pool's batch update has to have run first
+// --------------------------------------------------------
+void EntityStore::Cull(const DirectX::XMFLOAT4X4& viewProjection, std::vector<unsigned int>& visible)
+{
+	PROFILE_SCOPE("EntityStore::Cull");
+
+	const XMFLOAT4X4& m = viewProjection;
+	XMVECTOR col0 = XMVectorSet(m._11, m._21, m._31, m._41);
+	XMVECTOR col1 = XMVectorSet(m._12, m._22, m._32, m._42);
+	XMVECTOR col2 = XMVectorSet(m._13, m._23, m._33, m._43);
+	XMVECTOR col3 = XMVectorSet(m._14, m._24, m._34, m._44);
+
+	XMVECTOR planes[6] = {
+		XMPlaneNormalize(XMVectorAdd(col3, col0)),
+		XMPlaneNormalize(XMVectorSubtract(col3, col0)),
+		XMPlaneNormalize(XMVectorAdd(col3, col1)),
+		XMPlaneNormalize(XMVectorSubtract(col3, col1)),
+		XMPlaneNormalize(col2),
+		XMPlaneNormalize(XMVectorSubtract(col3, col2)) };
+
+	visible.clear();
+	unsigned int count = (unsigned int)transforms.size();
+	for (unsigned int i = 0; i < count; ++i) {
+		XMMATRIX world = XMLoadFloat4x4(&pool->GetCachedWorldMatrix(transforms[i]));
+		XMVECTOR center = XMVector3Transform(XMLoadFloat3(&boundsCenters[i]), world);
+
+		//the largest axis scale keeps the sphere conservative
+		XMVECTOR scaleSq = XMVectorMax(XMVector3LengthSq(world.r[0]), XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+		float radius = boundsRadii[i] * XMVectorGetX(XMVectorSqrt(scaleSq));
+
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; ++p) {
+			inside = XMVectorGetX(XMPlaneDotCoord(planes[p], center)) >= -radius;
+		}
+		if (inside) {
+			visible.push_back(i);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Copies what the shadow pass needs for each visible slot.
+// Like Cull this reads the pool's cached matrices (and the
+// interpolation state), so the batch update has to have run
+// --------------------------------------------------------
+void EntityStore::GatherDepth(const std::vector<unsigned int>& visible, float alpha, std::vector<DepthItem>& items, JobSystem* jobs)
+{
+	unsigned int count = (unsigned int)visible.size();
+	items.resize(count);
+
+	auto gather = [this, &visible, alpha, &items](unsigned int begin, unsigned int end) {
+		XMFLOAT4X4 inverseTranspose;
+		for (unsigned int i = begin; i < end; ++i) {
+			unsigned int slot = visible[i];
+			pool->GetInterpolatedWorld(transforms[slot], alpha, items[i].world, inverseTranspose);
+			items[i].mesh = meshes[slot];
+		}
+	};
+
+	if (jobs != nullptr) {
+		jobs->ParallelFor(count, GATHER_CHUNK, gather);
+	}
+	else {
+		gather(0, count);
+	}
+}
+
+// --------------------------------------------------------
+// Copies what the main pass needs for each visible slot,
+// material parameters included, so the render thread never
+// has to look at the store, the pool or the materials' live
+// values
+// --------------------------------------------------------
+void EntityStore::Gather(const std::vector<unsigned int>& visible, float alpha, std::vector<DrawItem>& items, JobSystem* jobs)
+{
+	unsigned int count = (unsigned int)visible.size();
+	items.resize(count);
+
+	auto gather = [this, &visible, alpha, &items](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			unsigned int slot = visible[i];
+			DrawItem& item = items[i];
+			pool->GetInterpolatedWorld(transforms[slot], alpha, item.world, item.worldInvTranspose);
+			item.params = materials[slot]->GetParams();
+			item.mesh = meshes[slot];
+			item.material = materials[slot];
+		}
+	};
+
+	if (jobs != nullptr) {
+		jobs->ParallelFor(count, GATHER_CHUNK, gather);
+	}
+	else {
+		gather(0, count);
+	}
+}
+
+unsigned long long EntityStore::GetChangeTick(const std::vector<unsigned int>& visible)
+{
+	unsigned long long latest = layoutTick;
+	for (unsigned int slot : visible) {
+		unsigned long long changed = pool->GetChangeTick(transforms[slot]);
+		latest = changed > latest ? changed : latest;
+	}
+	return latest;
+}
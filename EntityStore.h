@@ -0,0 +1,102 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "TransformPool.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "SceneSnapshot.h"
+
+// --------------------------------------------------------
+// Refers to an entity in an EntityStore.  The generation is
+// bumped whenever a slot is reused, so a handle to something
+// that was destroyed stops resolving instead of silently
+// pointing at whatever took its place.
+// --------------------------------------------------------
+struct EntityHandle
+{
+	unsigned int index;
+	unsigned int generation;
+};
+
+// --------------------------------------------------------
+// Every entity's components, one dense array per component.
+//
+// Live entities are always packed at the front of the arrays
+// (destroying one moves the last entity into its slot), so
+// the systems below are plain loops over contiguous memory.
+// Handles go through a sparse table to find the dense slot.
+//
+// Meshes and materials are not owned, whoever created them
+// has to keep them alive.  Transforms live in the pool.
+// --------------------------------------------------------
+class EntityStore
+{
+public:
+
+	EntityStore(TransformPool* pool);
+	~EntityStore();
+	EntityStore(const EntityStore&) = delete; // Remove copy constructor
+	EntityStore& operator=(const EntityStore&) = delete; // Remove copy-assignment operator
+
+	// Entities per job when UpdateSpin or the gathers are split up
+	static const unsigned int SPIN_CHUNK = 2048;
+	static const unsigned int GATHER_CHUNK = 4096;
+
+	EntityHandle Create(Mesh* mesh, Material* material);
+	void Destroy(EntityHandle entity);
+	bool IsAlive(EntityHandle entity);
+
+	// Component access, invalid handles get NONE/nullptr
+	unsigned int GetTransform(EntityHandle entity);
+	Mesh* GetMesh(EntityHandle entity);
+	Material* GetMaterial(EntityHandle entity);
+	void SetMaterial(EntityHandle entity, Material* material);
+
+	// Spinning entities get their rotation driven by UpdateSpin
+	void SetSpin(EntityHandle entity, bool spins, float phase);
+
+	unsigned int GetCount() { return (unsigned int)meshes.size(); }
+	TransformPool* GetTransformPool() { return pool; }
+
+	// Systems.  Cull fills a list of dense slots, the gathers copy those
+	// slots out into a scene snapshot for the render thread to draw,
+	// with transforms interpolated from the last tick by alpha.
+	// Anything given a job system splits its work across it
+	void UpdateSpin(float totalTime, JobSystem* jobs = nullptr);
+	void Cull(const DirectX::XMFLOAT4X4& viewProjection, std::vector<unsigned int>& visible);
+	void GatherDepth(const std::vector<unsigned int>& visible, float alpha, std::vector<DepthItem>& items, JobSystem* jobs = nullptr);
+	void Gather(const std::vector<unsigned int>& visible, float alpha, std::vector<DrawItem>& items, JobSystem* jobs = nullptr);
+
+	// The last tick (see TransformPool::GetTick) any of these slots'
+	// transforms changed in, or entities were created or destroyed in,
+	// which can change what's in a slot
+	unsigned long long GetChangeTick(const std::vector<unsigned int>& visible);
+
+private:
+
+	unsigned int SlotOf(EntityHandle entity);
+
+	TransformPool* pool;
+
+	// Dense components, indexed by slot
+	std::vector<unsigned int> transforms;
+	std::vector<Mesh*> meshes;
+	std::vector<Material*> materials;
+	std::vector<DirectX::XMFLOAT3> boundsCenters;
+	std::vector<float> boundsRadii;
+	std::vector<unsigned char> spins;
+	std::vector<float> spinPhases;
+	std::vector<unsigned int> slotOwners; // handle index of each slot
+	unsigned long long layoutTick = 0; // last Create or Destroy
+
+	// Scratch for UpdateSpin's parallel half
+	std::vector<DirectX::XMFLOAT4> spinRotations;
+
+	// Sparse, indexed by handle index
+	std::vector<unsigned int> slots;
+	std::vector<unsigned int> generations;
+	std::vector<unsigned int> freeHandles;
+};
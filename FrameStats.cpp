@@ -0,0 +1,222 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <format>
+#include <fstream>
+
+#include "ImGui/imgui.h"
+
+namespace
+{
+	// Rolling windows the UI offers, in samples
+	const unsigned int WINDOWS[] = { 120, 600, 3600 };
+	const char* WINDOW_NAMES[] = { "Last 120 samples", "Last 600 samples", "Last 3600 samples" };
+
+	const unsigned int HISTOGRAM_BUCKETS = 48;
+
+	// Nearest-rank percentile of sorted samples
+	float Percentile(const std::vector<float>& sorted, float fraction)
+	{
+		size_t rank = (size_t)std::ceil(fraction * sorted.size());
+		return sorted[rank > 0 ? rank - 1 : 0];
+	}
+}
+
+FrameStats::FrameStats()
+{
+	for (Ring& ring : rings) {
+		for (std::atomic<float>& sample : ring.samples) {
+			sample.store(0.0f, std::memory_order_relaxed);
+		}
+		ring.head = 0;
+		ring.writing = 0;
+	}
+}
+
+FrameStats::~FrameStats()
+{
+}
+
+const char* FrameStats::SeriesName(Series series)
+{
+	switch (series) {
+	case SERIES_FRAME: return "Frame";
+	case SERIES_UPDATE: return "Update";
+	case SERIES_DRAW: return "Draw";
+	default: return "";
+	}
+}
+
+// --------------------------------------------------------
+// Same protocol as the profiler's rings: claim the index,
+// fence, write, then publish it
+// --------------------------------------------------------
+void FrameStats::Record(Series series, float milliseconds)
+{
+	Ring& ring = rings[series];
+	unsigned long long index = ring.head.load(std::memory_order_relaxed);
+	ring.writing.store(index, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	ring.samples[index & (CAPACITY - 1)].store(milliseconds, std::memory_order_relaxed);
+	ring.head.store(index + 1, std::memory_order_release);
+}
+
+// --------------------------------------------------------
+// Copies the newest samples, then drops any at the old end
+// that the writer could have lapped while they were copied
+// --------------------------------------------------------
+void FrameStats::GetSamples(Series series, unsigned int window, std::vector<float>& samples)
+{
+	Ring& ring = rings[series];
+	unsigned long long head = ring.head.load(std::memory_order_acquire);
+	unsigned long long count = std::min<unsigned long long>({ head, window, CAPACITY });
+	unsigned long long first = head - count;
+
+	samples.resize((size_t)count);
+	for (unsigned long long i = 0; i < count; ++i) {
+		samples[(size_t)i] = ring.samples[(first + i) & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	unsigned long long writing = ring.writing.load(std::memory_order_relaxed);
+	if (writing + 1 > first + CAPACITY) {
+		unsigned long long torn = std::min(writing + 1 - CAPACITY - first, count);
+		samples.erase(samples.begin(), samples.begin() + (size_t)torn);
+	}
+}
+
+FrameStats::Summary FrameStats::Summarize(Series series, unsigned int window, float hitchFactor)
+{
+	std::vector<float> samples;
+	GetSamples(series, window, samples);
+	return SummarizeSamples(samples, hitchFactor);
+}
+
+FrameStats::Summary FrameStats::SummarizeSamples(std::vector<float>& sorted, float hitchFactor)
+{
+	Summary summary = {};
+	if (sorted.empty()) {
+		return summary;
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0;
+	for (float sample : sorted) {
+		total += sample;
+	}
+
+	summary.count = (unsigned int)sorted.size();
+	summary.mean = (float)(total / sorted.size());
+	summary.p50 = Percentile(sorted, 0.50f);
+	summary.p95 = Percentile(sorted, 0.95f);
+	summary.p99 = Percentile(sorted, 0.99f);
+	summary.max = sorted.back();
+
+	//sorted, so the hitches are everything past the first sample over the line
+	float hitch = summary.p50 * hitchFactor;
+	summary.hitches = (unsigned int)(sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), hitch));
+	return summary;
+}
+
+bool FrameStats::WriteCsv(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out) {
+		return false;
+	}
+
+	std::vector<float> series[SERIES_COUNT];
+	size_t rows = 0;
+	for (int s = 0; s < SERIES_COUNT; ++s) {
+		GetSamples((Series)s, CAPACITY, series[s]);
+		rows = std::max(rows, series[s].size());
+	}
+
+	out << "sample";
+	for (int s = 0; s < SERIES_COUNT; ++s) {
+		out << "," << SeriesName((Series)s) << "_ms";
+	}
+	out << "\n";
+
+	//series can hold different amounts, so line them up by their newest
+	for (size_t row = 0; row < rows; ++row) {
+		out << row;
+		for (int s = 0; s < SERIES_COUNT; ++s) {
+			size_t missing = rows - series[s].size();
+			out << ",";
+			if (row >= missing) {
+				out << std::format("{:.4f}", series[s][row - missing]);
+			}
+		}
+		out << "\n";
+	}
+	return (bool)out;
+}
+
+void FrameStats::ShowWindow()
+{
+	ImGui::Begin("Frame Statistics");
+
+	ImGui::Combo("Window", &windowChoice, WINDOW_NAMES, IM_ARRAYSIZE(WINDOW_NAMES));
+	ImGui::SliderFloat("Hitch threshold (x median)", &hitchFactor, 1.25f, 5.0f, "%.2f");
+	unsigned int window = WINDOWS[windowChoice];
+
+	if (ImGui::BeginTable("Percentiles", 7, ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn("Series");
+		ImGui::TableSetupColumn("Mean");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableSetupColumn("Hitches");
+		ImGui::TableHeadersRow();
+		for (int s = 0; s < SERIES_COUNT; ++s) {
+			Summary summary = Summarize((Series)s, window, hitchFactor);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", SeriesName((Series)s));
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", summary.mean);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", summary.p50);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", summary.p95);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", summary.p99);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", summary.max);
+			ImGui::TableNextColumn(); ImGui::Text("%u of %u", summary.hitches, summary.count);
+		}
+		ImGui::EndTable();
+	}
+	ImGui::TextDisabled("All times in ms");
+
+	ImGui::SeparatorText("Distribution");
+	const char* seriesNames[SERIES_COUNT] = { SeriesName(SERIES_FRAME), SeriesName(SERIES_UPDATE), SeriesName(SERIES_DRAW) };
+	ImGui::Combo("Series", &histogramSeries, seriesNames, SERIES_COUNT);
+
+	std::vector<float> samples;
+	GetSamples((Series)histogramSeries, window, samples);
+	if (!samples.empty()) {
+		float longest = *std::max_element(samples.begin(), samples.end());
+		float bucketWidth = longest > 0 ? longest / HISTOGRAM_BUCKETS : 1.0f;
+		float buckets[HISTOGRAM_BUCKETS] = {};
+		for (float sample : samples) {
+			unsigned int bucket = (unsigned int)(sample / bucketWidth);
+			buckets[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1]++;
+		}
+
+		ImGui::PlotHistogram("##Histogram", buckets, HISTOGRAM_BUCKETS, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+		ImGui::Text("0 to %.2f ms, %.2f ms per bar", longest, bucketWidth);
+		ImGui::PlotLines("##History", samples.data(), (int)samples.size(), 0, "History (ms)", 0.0f, FLT_MAX, ImVec2(0, 80));
+	}
+
+	ImGui::SeparatorText("Export");
+	ImGui::InputText("CSV file", csvPath, sizeof(csvPath));
+	if (ImGui::Button("Write CSV")) {
+		csvStatus = WriteCsv(csvPath) ? std::format("Wrote {}", csvPath) : std::format("Couldn't write {}", csvPath);
+	}
+	if (!csvStatus.empty()) {
+		ImGui::SameLine();
+		ImGui::Text("%s", csvStatus.c_str());
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Rolling frame timing: whole-frame CPU time, simulation
+// time and render time, each kept as a ring of the most
+// recent samples.
+//
+// Every series has one writer thread (the main thread for
+// frame and update, the render thread for draw) and can be
+// read from any other without locks, the same way the
+// profiler's rings are.  Stats are worked out on demand over
+// however many recent samples are asked for.
+// --------------------------------------------------------
+class FrameStats
+{
+public:
+
+	enum Series
+	{
+		SERIES_FRAME, // main loop, frame start to frame start
+		SERIES_UPDATE, // fixed ticks plus Frame on the main thread
+		SERIES_DRAW, // render thread, Game::Draw starting to Present returning
+		SERIES_COUNT
+	};
+
+	// Samples kept per series, a power of two
+	static const unsigned int CAPACITY = 4096;
+
+	struct Summary
+	{
+		unsigned int count;
+		float mean; // all in ms
+		float p50;
+		float p95;
+		float p99;
+		float max;
+		unsigned int hitches; // samples over hitchFactor times p50
+	};
+
+	FrameStats();
+	~FrameStats();
+	FrameStats(const FrameStats&) = delete; // Remove copy constructor
+	FrameStats& operator=(const FrameStats&) = delete; // Remove copy-assignment operator
+
+	static const char* SeriesName(Series series);
+
+	// Only ever from that series' one writer thread
+	void Record(Series series, float milliseconds);
+
+	// The newest samples (up to window of them), oldest first
+	void GetSamples(Series series, unsigned int window, std::vector<float>& samples);
+	Summary Summarize(Series series, unsigned int window, float hitchFactor = 2.0f);
+
+	// The same over any list of samples (sorts it)
+	static Summary SummarizeSamples(std::vector<float>& samples, float hitchFactor = 2.0f);
+
+	// Every sample held, one column per series and one row per sample
+	// (newest last).  Returns false if the file couldn't be written
+	bool WriteCsv(const std::string& path);
+
+	// Percentile table, histogram and history, call while building the UI
+	void ShowWindow();
+
+private:
+
+	struct Ring
+	{
+		std::atomic<float> samples[CAPACITY];
+		std::atomic<unsigned long long> head; // samples recorded
+		std::atomic<unsigned long long> writing; // sample being written
+	};
+
+	Ring rings[SERIES_COUNT];
+
+	// UI state
+	int windowChoice = 0;
+	int histogramSeries = SERIES_FRAME;
+	float hitchFactor = 2.0f;
+	char csvPath[260] = "frame_stats.csv";
+	std::string csvStatus;
+};
@@ -9,9 +9,19 @@
 #include "SimpleShader.h"
 #include "Material.h"
 #include "Lights.h"
+#include "TransformPool.h"
+#include "Benchmarks.h"
+#include "JobSystem.h"
+#include "SceneSnapshot.h"
+#include "PassRecorder.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <memory>
 #include <iostream>
 #include <format>
+#include <random>
 
 //include ImGui files
 #include "ImGui/imgui.h"
@@ -47,7 +57,7 @@ void Game::Initialize()
 		// Tell the input assembler (IA) stage of the pipeline what kind of
 		// geometric primitives (points, lines or triangles) we want to draw.  
 		// Essentially: "What kind of shape should the GPU draw with our vertices?"
-		Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		Graphics::States->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	}
 
@@ -111,6 +121,11 @@ void Game::Initialize()
 	lights[lights.size() - 1].SpotInnerAngle = 20;
 	lights[lights.size() - 1].SpotOuterAngle = 30;
 
+	//shaders, meshes and the sky are made through the render device,
+	//which the scene renderer's buffers come from too
+	renderDevice = std::make_unique<D3D11RenderDevice>(Graphics::Device, Graphics::Context);
+	sceneRenderer = std::make_unique<SceneRenderer>(renderDevice.get(), &JobSystem::Default());
+
 	CreateShadowmapResources();
 
 	// Helper methods for loading
@@ -148,6 +163,44 @@ void Game::Initialize()
 	chromaticOffsets[1] = 0;
 	chromaticOffsets[2] = 0;
 
+	//the shadow maps never change, so the materials only need them once
+	for (auto& m : materials) {
+		m->AddTextureSRV("ShadowMap", shadowSRV.Get());
+		m->AddTextureSRV("ShadowAtlas", shadowAtlasSRV.Get());
+		if (sky->HasLighting()) {
+			m->AddTextureSRV("SpecularIBL", sky->GetSpecularIBL());
+			m->AddTextureSRV("BrdfLut", sky->GetBrdfLut());
+		}
+	}
+
+	//from here on all drawing happens on the render thread, which
+	//only ever sees the snapshots Update publishes
+	renderWidth = Window::Width();
+	renderHeight = Window::Height();
+	renderStats.scenePreview = ppShaderResourceViews[0];
+	for (auto& m : materials) {
+		sceneResources.materials.push_back(m.get());
+	}
+	sceneResources.sky = sky.get();
+	sceneResources.shadowVS = shadowVS.get();
+	sceneResources.shadowClearVS = shadowClearVS.get();
+	sceneResources.shadowRasterizer = shadowRasterizer.Get();
+	sceneResources.shadowClearDepthState = shadowClearDepthState.Get();
+	for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+		sceneResources.shadowDSVs[i] = shadowDSVs[i].Get();
+	}
+	sceneResources.shadowAtlasDSV = shadowAtlasDSV.Get();
+	sceneResources.postVS = ppVS.get();
+	for (auto& ps : ppPixelShaders) {
+		sceneResources.postShaders.push_back(ps.get());
+	}
+	sceneResources.postSampler = ppSampler.Get();
+	BindSceneTargets();
+	immediateRecorder = std::make_unique<ImmediatePassRecorder>(Graphics::States.get());
+	deferredRecorder = std::make_unique<DeferredPassRecorder>(Graphics::Device, Graphics::Context, Graphics::States.get(), SceneRenderer::PASS_COUNT, &JobSystem::Default());
+	nullRecorder = std::make_unique<NullPassRecorder>();
+	softwareRasterizer = std::make_unique<SoftwareRasterizer>(&JobSystem::Default());
+	renderThread = std::thread(&Game::RenderLoop, this);
 }
 
 
@@ -159,6 +212,12 @@ void Game::Initialize()
 // --------------------------------------------------------
 Game::~Game()
 {
+	//stop drawing before anything the render thread uses goes away
+	snapshots.Close();
+	if (renderThread.joinable()) {
+		renderThread.join();
+	}
+
 	//ImGui Cleanup
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -323,31 +382,33 @@ void Game::CreateShaderToEntity()
 	Graphics::Device->CreateSamplerState(&ppSamplerDesc, ppSampler.GetAddressOf());
 
 	//make post process render targets
-	RecreatePostprocessResources();
+	RecreatePostprocessResources(Window::Width(), Window::Height());
 
 	//load shaders:
 	std::shared_ptr<SimpleVertexShader> vs = std::make_shared<SimpleVertexShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"VertexShader.cso").c_str());
+		renderDevice.get(), FixPath(L"VertexShader.cso").c_str());
 	std::shared_ptr<SimplePixelShader> ps = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"PixelShader.cso").c_str());
+		renderDevice.get(), FixPath(L"PixelShader.cso").c_str());
 	std::shared_ptr<SimplePixelShader> uvDebugPS = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"DebugUVsPS.cso").c_str());
+		renderDevice.get(), FixPath(L"DebugUVsPS.cso").c_str());
 	std::shared_ptr<SimplePixelShader> normalDebugPS = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"DebugNormalsPS.cso").c_str());
+		renderDevice.get(), FixPath(L"DebugNormalsPS.cso").c_str());
 	std::shared_ptr<SimplePixelShader> custom1PS = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"CustomPS1.cso").c_str());
+		renderDevice.get(), FixPath(L"CustomPS1.cso").c_str());
 	std::shared_ptr<SimplePixelShader> twoTexturePS = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"TwoTextureShader.cso").c_str());
+		renderDevice.get(), FixPath(L"TwoTextureShader.cso").c_str());
 	shadowVS = std::make_shared<SimpleVertexShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"ShadowVertexShader.cso").c_str());
+		renderDevice.get(), FixPath(L"ShadowVertexShader.cso").c_str());
+	shadowClearVS = std::make_shared<SimpleVertexShader>(
+		renderDevice.get(), FixPath(L"ShadowClearVS.cso").c_str());
 
 	//pp shaders:
-	ppVS = std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FixPath(L"FullTriVS.cso").c_str());
-	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, 
+	ppVS = std::make_shared<SimpleVertexShader>(renderDevice.get(), FixPath(L"FullTriVS.cso").c_str());
+	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(renderDevice.get(),
 		FixPath(L"GaussianBlurXPS.cso").c_str()));
-	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context,
+	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(renderDevice.get(),
 		FixPath(L"GaussianBlurYPS.cso").c_str()));
-	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context,
+	ppPixelShaders.push_back(std::make_shared<SimplePixelShader>(renderDevice.get(),
 		FixPath(L"ChromaticAbberationPS.cso").c_str()));
 
 
@@ -383,17 +444,18 @@ void Game::CreateShaderToEntity()
 
 
 	//load meshes
-	meshPtrs.push_back(std::make_shared<Mesh>(FixPath("../../Assets/Models/cube.obj").c_str()));
-	meshPtrs.push_back(std::make_shared<Mesh>(FixPath("../../Assets/Models/sphere.obj").c_str()));
-	meshPtrs.push_back(std::make_shared<Mesh>(FixPath("../../Assets/Models/helix.obj").c_str()));
-	meshPtrs.push_back(std::make_shared<Mesh>(FixPath("../../Assets/Models/torus.obj").c_str()));
+	meshPtrs.push_back(std::make_shared<Mesh>(renderDevice.get(), FixPath("../../Assets/Models/cube.obj").c_str()));
+	meshPtrs.push_back(std::make_shared<Mesh>(renderDevice.get(), FixPath("../../Assets/Models/sphere.obj").c_str()));
+	meshPtrs.push_back(std::make_shared<Mesh>(renderDevice.get(), FixPath("../../Assets/Models/helix.obj").c_str()));
+	meshPtrs.push_back(std::make_shared<Mesh>(renderDevice.get(), FixPath("../../Assets/Models/torus.obj").c_str()));
 
 
 	//make entities
 		//Note: when we make an entity, make sure we're adding the float arrays to entityData
 	for (int i = 0; i < materials.size(); i++) {
 		for (int j = 0; j < meshPtrs.size(); j++) {
-			entityPtrs.push_back(std::make_shared<Entity>(meshPtrs[j], materials[i]));
+			entityHandles.push_back(entities.Create(meshPtrs[j].get(), materials[i].get()));
+			entities.SetSpin(entityHandles.back(), true, (float)(entityHandles.size() - 1));
 			
 			//position:
 			entityData.push_back(j * 3.5f); //x
@@ -411,27 +473,28 @@ void Game::CreateShaderToEntity()
 			entityData.push_back(1);
 
 			//set position and stuff:
-			entityPtrs[meshPtrs.size() * i + j].get()->GetTransform()->SetPosition(j * 3.5f, 0, (i - materials.size() / 2.0f) * 3.5f);
+			TransformPool::Default().SetPosition(entities.GetTransform(entityHandles.back()), j * 3.5f, 0, (i - materials.size() / 2.0f) * 3.5f);
 			
 		}
 	}
-	//make floor entity
-	entityPtrs.push_back(std::make_shared<Entity>(meshPtrs[0], materials[0]));
+	//make floor entity (doesn't spin)
+	entityHandles.push_back(entities.Create(meshPtrs[0].get(), materials[0].get()));
 	entityData.push_back(0); entityData.push_back(-2.0f); entityData.push_back(0);
 	entityData.push_back(0); entityData.push_back(0); entityData.push_back(0);
 	entityData.push_back(25); entityData.push_back(0.1f); entityData.push_back(25);
-	entityPtrs[entityPtrs.size() - 1].get()->GetTransform()->SetPosition(0, -2.0f, 0);
-	entityPtrs[entityPtrs.size() - 1].get()->GetTransform()->SetScale(25, 0.1f, 25);
+	TransformPool::Default().SetPosition(entities.GetTransform(entityHandles.back()), 0, -2.0f, 0);
+	TransformPool::Default().SetScale(entities.GetTransform(entityHandles.back()), 25, 0.1f, 25);
 
 
 	// load sky:
 
 	std::shared_ptr<SimpleVertexShader> skyVs = std::make_shared<SimpleVertexShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"SkyVertexShader.cso").c_str());
+		renderDevice.get(), FixPath(L"SkyVertexShader.cso").c_str());
 	std::shared_ptr<SimplePixelShader> skyPs = std::make_shared<SimplePixelShader>(
-		Graphics::Device, Graphics::Context, FixPath(L"SkyPixelShader.cso").c_str());
+		renderDevice.get(), FixPath(L"SkyPixelShader.cso").c_str());
 
 	sky = std::make_shared<Sky>(
+		renderDevice.get(),
 		meshPtrs[0], //cube mesh
 		samplerState,
 		skyVs,
@@ -441,7 +504,9 @@ void Game::CreateShaderToEntity()
 		FixPath(L"../../Assets/Images/Planet/up.png").c_str(),
 		FixPath(L"../../Assets/Images/Planet/down.png").c_str(),
 		FixPath(L"../../Assets/Images/Planet/front.png").c_str(),
-		FixPath(L"../../Assets/Images/Planet/back.png").c_str()
+		FixPath(L"../../Assets/Images/Planet/back.png").c_str(),
+		FixPath(L""), //lighting cache next to the exe
+		&JobSystem::Default()
 	);
 
 
@@ -450,16 +515,15 @@ void Game::CreateShaderToEntity()
 
 // --------------------------------------------------------
 // Handle resizing to match the new window size
-//  - Eventually, we'll want to update our 3D camera
+//  - The render thread resizes the swap chain and post
+//    process targets itself once a snapshot with the new
+//    size reaches it, only the cameras are updated here
 // --------------------------------------------------------
 void Game::OnResize()
 {
 	for (int i = 0; i < cameraPtrs.size(); ++i) {
 		cameraPtrs[i].get()->UpdateProjectionMatrix(Window::AspectRatio());
 	}
-
-	RecreatePostprocessResources();
-	
 }
 
 
@@ -468,46 +532,264 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	//Update ImGui information. This MUST run first.
-	UpdateImGui(deltaTime);
-
-	//Build the Debug UI
-	BuildUI();
+	PROFILE_SCOPE("Game::Update");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-
-	//update Camera:
-	if (cameraIndex < cameraPtrs.size()) {
-		cameraPtrs[cameraIndex].get()->Update(deltaTime);
-	}
+	//whatever changes from here on blends in over the next frames
+	TransformPool::Default().BeginTick();
+	ticksSinceFrame++;
 
 	//update objects 
-	for (int i = 0; i < entityPtrs.size() - 1; ++i) { //-1 because floor should not rotate
-		entityPtrs[i].get()->GetTransform()->SetRotation(sin(totalTime + i), cos(totalTime + i), sin(totalTime + i) * cos(totalTime + i));
-	}
+	entities.UpdateSpin(totalTime, &JobSystem::Default());
 
 	// Example input checking: Quit if the escape key is pressed
 	if (Input::KeyDown(VK_ESCAPE))
 		Window::Quit();
+
+	tickTimeSinceFrame += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 
 // --------------------------------------------------------
-// Clear the screen, redraw everything, present to the user
+// Once per presented frame, however many ticks ran before it.
+// The UI and camera follow the real frame time, and the
+// scene is handed over interpolated between the last two
+// ticks by alpha (0 = previous tick, 1 = latest)
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Frame(float deltaTime, float totalTime, float alpha)
 {
+	PROFILE_SCOPE("Game::Frame");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	ticksLastFrame = ticksSinceFrame;
+	ticksSinceFrame = 0;
+
+	//wall time rather than deltaTime, which a benchmark pins to one tick
+	float frameTime = 0;
+	if (lastFrameStart != std::chrono::steady_clock::time_point()) {
+		frameTime = std::chrono::duration<float, std::milli>(start - lastFrameStart).count();
+		frameStats.Record(FrameStats::SERIES_FRAME, frameTime);
+	}
+	lastFrameStart = start;
+
+	//benchmarks run without the UI and fly the camera themselves
+	if (benchmark) {
+		if (cameraIndex < cameraPtrs.size()) {
+			XMFLOAT3 position, target;
+			benchmark->CameraPose(simulationFrame + 1, position, target);
+			cameraPtrs[cameraIndex].get()->LookAt(position, target);
+		}
+	}
+	else {
+		//Update ImGui information. This MUST run first.
+		UpdateImGui(deltaTime);
+
+		//Build the Debug UI
+		BuildUI();
+
+
+		//update Camera:
+		if (cameraIndex < cameraPtrs.size()) {
+			cameraPtrs[cameraIndex].get()->Update(deltaTime);
+		}
+
+		//finish the UI, the render thread draws a copy of it
+		ImGui::Render();
+	}
+
+	//hand the frame to the render thread, which draws it while the
+	//next one is simulated
+	PublishSnapshot(totalTime, alpha);
+
+	//everything the main thread did for this frame, ticks included
+	float frameWork = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	frameStats.Record(FrameStats::SERIES_UPDATE, tickTimeSinceFrame + frameWork);
+	if (benchmark) {
+		benchmark->RecordFrame(simulationFrame, frameTime, tickTimeSinceFrame + frameWork, entities.GetCount(), sceneRenderer->GetVisibleCount(), sceneRenderer->GetShadowCasterCount());
+	}
+	tickTimeSinceFrame = 0;
+}
+
+
+// --------------------------------------------------------
+// Benchmark scenes are the regular scene plus some number of
+// stress entities, and lights4k thousands of point lights on
+// top.  The run starts with the next frame
+// --------------------------------------------------------
+bool Game::StartBenchmark(const std::string& scene, unsigned int frameCount, const std::string& reportPath)
+{
+	if (scene == "stress10k") {
+		SpawnStressEntities(10000);
+	}
+	else if (scene == "stress100k") {
+		SpawnStressEntities(100000);
+	}
+	else if (scene == "lights4k") {
+		SpawnStressEntities(10000);
+		SpawnStressLights(4096);
+	}
+	else if (scene != "default") {
+		return false;
+	}
+
+	cameraIndex = 0;
+	benchmark = std::make_unique<BenchmarkRun>(scene, frameCount, simulationFrame + 1, reportPath);
+	return true;
+}
+
+bool Game::BenchmarkDone()
+{
+	return benchmark && benchmark->Done();
+}
+
+bool Game::FinishBenchmark()
+{
+	//the report reads what the render thread recorded, so it has to stop first
+	snapshots.Close();
+	if (renderThread.joinable()) {
+		renderThread.join();
+	}
+	//the rasterizer holds the last frame the render thread drew
+	bool passed = true;
+	if (softwareRaster && !softwareImagePath.empty()) {
+		bool written = softwareRasterizer->WritePpm(softwareImagePath);
+		benchmark->AddResult("image", std::format("\"{}\"", written ? softwareImagePath : ""));
+		passed = passed && written;
+	}
+	if (softwareRaster && !goldenImagePath.empty()) {
+		long long mismatched = softwareRasterizer->CompareToPpm(goldenImagePath, goldenTolerance);
+		benchmark->AddResult("golden", std::format("{{\"path\":\"{}\",\"tolerance\":{},\"mismatchedPixels\":{}}}", goldenImagePath, goldenTolerance, mismatched));
+		printf("Golden image %s: %lld pixels differ\n", goldenImagePath.c_str(), mismatched);
+		passed = passed && mismatched == 0;
+	}
+	benchmark->AddResult("clusteredLighting", clusteredLighting ? "true" : "false");
+	benchmark->AddResult("objectLights", objectLights && !clusteredLighting ? "true" : "false");
+	benchmark->AddResult("shadowAtlas", shadowAtlasEnabled ? "true" : "false");
+	benchmark->AddResult("skyLighting", skyLighting && sky->HasLighting() ? "true" : "false");
+	{
+		std::lock_guard<std::mutex> guard(renderStatsLock);
+		const ShadowCache::Stats& cacheStats = renderStats.shadowCache;
+		benchmark->AddResult("shadowCache", std::format("{{\"enabled\":{},\"viewsRedrawn\":{},\"viewsReused\":{}}}", shadowCaching ? "true" : "false", cacheStats.totalRedrawn, cacheStats.totalReused));
+	}
+	benchmark->AddResult("lights", std::format("{}", lights.size()));
+	return benchmark->WriteReport(renderWidth, renderHeight, deferredPasses, nullBackend || softwareRaster) && passed;
+}
+
+void Game::SetSoftwareOutput(const std::string& imagePath, const std::string& goldenPath, int tolerance)
+{
+	softwareImagePath = imagePath;
+	goldenImagePath = goldenPath;
+	goldenTolerance = tolerance;
+}
+
+
+// --------------------------------------------------------
+// Finishes the simulation half of a frame: brings every
+// matrix up to date, culls, and copies everything the render
+// thread needs into the next snapshot before handing it over
+// --------------------------------------------------------
+void Game::PublishSnapshot(float totalTime, float alpha)
+{
+	PROFILE_SCOPE("Game::PublishSnapshot");
+
+	SceneSnapshot& frame = snapshots.BeginWrite();
+	frame.frame = ++simulationFrame;
+	frame.totalTime = totalTime;
+	frame.width = Window::Width();
+	frame.height = Window::Height();
+
+	frame.hasCamera = cameraIndex < cameraPtrs.size();
+	if (frame.hasCamera) {
+		Camera* camera = cameraPtrs[cameraIndex].get();
+		frame.view = camera->GetViewMatrix();
+		frame.projection = camera->GetProjectionMatrix();
+		frame.cameraPosition = camera->GetTransform()->GetPosition();
+	}
+
+	//culls, shadow views, gathers and light lists
+	SceneRenderer::Settings settings = {};
+	settings.clusteredLighting = clusteredLighting;
+	settings.objectLights = objectLights;
+	settings.shadowAtlas = shadowAtlasEnabled;
+	settings.shadowCaching = shadowCaching;
+	sceneRenderer->Prepare(frame, entities, lights, alpha, settings);
+
+	frame.ambient = ambientColor;
+	frame.skyLighting = skyLighting && sky->HasLighting();
+	for (int i = 0; i < 4; ++i) {
+		frame.background[i] = ImGui_bgColor[i];
+		frame.tint[i] = ImGui_colorTint[i];
+	}
+
+	frame.blurRadius = blurRadius;
+	for (int i = 0; i < 3; ++i) {
+		frame.chromaticOffsets[i] = chromaticOffsets[i];
+	}
+	frame.chromaticMode = chromaticMode;
+	frame.deferredPasses = deferredPasses;
+	frame.nullBackend = nullBackend;
+	frame.softwareRaster = softwareRaster;
+	frame.mousePosition = XMFLOAT2((float)Input::GetMouseX() / Window::Width(), (float)Input::GetMouseY() / Window::Height());
+
+	frame.hasUI = !benchmark;
+	if (frame.hasUI) {
+		PROFILE_SCOPE("Copy UI");
+		frame.ui.Copy(ImGui::GetDrawData());
+	}
+	frame.benchmark = benchmark.get();
+	frame.uiTextures.clear();
+	frame.uiTextures.push_back(uiScenePreview);
+
+	frame.simulated = std::chrono::steady_clock::now();
+	snapshots.Publish();
+}
+
+
+// --------------------------------------------------------
+// Body of the render thread: draws the newest snapshot every
+// time one comes in, until the game shuts down
+// --------------------------------------------------------
+void Game::RenderLoop()
+{
+	Profiler::SetThreadName("Render");
+
+	while (const SceneSnapshot* frame = snapshots.WaitForLatest()) {
+		Draw(*frame);
+
+#if defined(DEBUG) || defined(_DEBUG)
+		// Print any graphics debug messages that occurred this frame
+		Graphics::PrintDebugMessages();
+#endif
+	}
+}
+
+
+// --------------------------------------------------------
+// Clear the screen, redraw everything, present to the user.
+// Runs on the render thread and only reads the snapshot and
+// GPU resources, never the live scene
+// --------------------------------------------------------
+void Game::Draw(const SceneSnapshot& frame)
+{
+	PROFILE_SCOPE("Game::Draw");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//the window thread only records new sizes, the swap chain and
+	//everything sized to match get resized here where they're used
+	if (frame.width != renderWidth || frame.height != renderHeight) {
+		Graphics::ResizeBuffers(frame.width, frame.height);
+		RecreatePostprocessResources(frame.width, frame.height);
+		BindSceneTargets();
+		renderWidth = frame.width;
+		renderHeight = frame.height;
+	}
+
 	// Frame START
 	// - These things should happen ONCE PER FRAME
 	// - At the beginning of Game::Draw() before drawing *anything*
 	{
-		// Clear the back buffer (erase what's on screen) and depth buffer
-		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(),	ImGui_bgColor);
-		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-		for (int i = 0; i < numPostProcesses; ++i) {
-			Graphics::Context->ClearRenderTargetView(ppRenderTargetViews[i].Get(), ImGui_bgColor);
-		}
-
+		// Start this frame's redundant state counters fresh
+		Graphics::States->ResetStats();
 	}
 
 	// DRAW geometry
@@ -538,128 +820,195 @@ void Game::Draw(float deltaTime, float totalTime)
 	}
 	*/
 
-	//Draw Shadowmap!
-	Graphics::Context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-	ID3D11RenderTargetView* nullRTV{};
-	Graphics::Context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
-	Graphics::Context->PSSetShader(0, 0, 0); //deactivates pixel shader
-
-	//fix viewport to render the shadow map size
-	D3D11_VIEWPORT viewport = {};
-	viewport.Width = (float)shadowMapResolution;
-	viewport.Height = (float)shadowMapResolution;
-	viewport.MaxDepth = 1.0f;
-	Graphics::Context->RSSetViewports(1, &viewport);
-
-	shadowVS->SetShader();
-	shadowVS->SetMatrix4x4("view", lightViewMatrixList[0]);
-	shadowVS->SetMatrix4x4("projection", lightProjectionMatrixList[0]);
-	Graphics::Context->RSSetState(shadowRasterizer.Get());
-	// Loop and draw all entities to shadowMap
-	for (auto& e : entityPtrs)
-	{
-		shadowVS->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-		shadowVS->CopyAllBufferData();
-		// Draw the mesh directly to avoid the entity's material
-		// Note: Your code may differ significantly here!
-		e->DrawForLight();
-	}
-
-	//reset back to normal
-	viewport.Width = (float)((int)Window::Width());
-	viewport.Height = (float)((int)Window::Height());
-	Graphics::Context->RSSetViewports(1, &viewport);
-	Graphics::Context->OMSetRenderTargets(1, ppRenderTargetViews[0].GetAddressOf(), Graphics::DepthBufferDSV.Get());
-	Graphics::Context->RSSetState(0);
-
-	//Draw entities
-	for (int i = 0; i < entityPtrs.size(); ++i) {
-		if (cameraIndex < cameraPtrs.size()) {
-			entityPtrs[i].get()->GetMaterial()->BindMaterialShaders();
-			//send light/shadow info
-			entityPtrs[i].get()->GetMaterial()->AddTextureSRV("ShadowMap", shadowSRV.Get());
-			//entityPtrs[i].get()->GetMaterial()->GetPixelShader()->SetSamplerState("ShadowSampler", shadowSampler);
-			entityPtrs[i].get()->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightView", lightViewMatrixList[0]);
-			entityPtrs[i].get()->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightProjection", lightProjectionMatrixList[0]);
-			entityPtrs[i].get()->GetMaterial()->GetPixelShader()->SetFloat3("ambient", ambientColor);
-			entityPtrs[i].get()->GetMaterial()->GetPixelShader()->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-			entityPtrs[i].get()->GetMaterial()->GetPixelShader()->SetInt("lightCount", lights.size());
-			entityPtrs[i].get()->Draw(ImGui_colorTint, cameraPtrs[cameraIndex].get());
-
-		}
-	}
+	//Each pass sets up everything it uses (targets, viewport, topology),
+	//since recorded on a deferred context it starts from default state
+	PassRecorder& passes = (frame.nullBackend || frame.softwareRaster) ? (PassRecorder&)*nullRecorder
+		: frame.deferredPasses ? (PassRecorder&)*deferredRecorder : (PassRecorder&)*immediateRecorder;
 
-	//Draw Skybox
-	sky->Draw(cameraPtrs[cameraIndex].get());
+	//the shadow, opaque and post passes
+	sceneRenderer->Record(passes, frame, sceneResources);
 
+	//runs the passes here or waits for their command lists, in pass order
+	{
+		PROFILE_SCOPE("Submit passes");
+		passes.Submit();
+	}
 
-	//DRAW POST PROCESSES:
-
-	ppVS->SetShader();
-
-
-	for (int i = 0; i < ppPixelShaders.size(); ++i) {
-		if ( i == ppPixelShaders.size() - 1) {
-			Graphics::Context->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
-		}
-		else {
-			//we use i + 1 because the original scene is rendered to 0 and the final post process is rendered to the back buffer
-			Graphics::Context->OMSetRenderTargets(1, ppRenderTargetViews[i + 1].GetAddressOf(), 0);
-		}
-
-		ppPixelShaders[i]->SetShader();
-		ppPixelShaders[i]->SetShaderResourceView("Pixels", ppShaderResourceViews[i].Get());
-		ppPixelShaders[i]->SetSamplerState("ClampSampler", ppSampler.Get());
-
-		//send other cbuffer data here! 
-		switch (i) {
-
-		case 0: //X Gaussian Blur
-		case 1: //Y Gaussian Blur
-			ppPixelShaders[i]->SetInt("blurAmount", blurRadius);
-			ppPixelShaders[i]->SetFloat("pixelSize", (i == 0 ? 1.0f / Window::Width() : 1.0f / Window::Height()));
-			break;
-
-		case 2: //chromatic abberation
-			ppPixelShaders[i]->SetFloat2("mousePos", XMFLOAT2((float)Input::GetMouseX() / Window::Width(), (float)Input::GetMouseY() / Window::Height()));
-			ppPixelShaders[i]->SetFloat3("offsets", XMFLOAT3(chromaticOffsets[0], chromaticOffsets[1], chromaticOffsets[2]));
-			ppPixelShaders[i]->SetInt("mode", chromaticMode);
-			break;
-
-		}
-
-		ppPixelShaders[i]->CopyAllBufferData();
+	//with deferred passes the immediate context comes back with nothing bound
+	Graphics::States->OMSetRenderTargets(1, Graphics::BackBufferRTV.GetAddressOf(), 0);
 
-		Graphics::Context->Draw(3, 0);
-		
+	//the null backend drew nothing, so the UI goes over a plain background
+	//or the software rasterizer's image
+	if (frame.softwareRaster) {
+		DrawSoftware(frame);
+	}
+	else if (frame.nullBackend) {
+		Graphics::States->ClearRenderTargetView(Graphics::BackBufferRTV.Get(), frame.background);
 	}
 
-	
+	//Last thing to draw: ImGui! (as it was when this snapshot was taken)
+	//the backend wants a non-const pointer but only reads through it
+	if (frame.hasUI) {
+		PROFILE_SCOPE("Draw UI");
+		ImGui_ImplDX11_RenderDrawData(const_cast<ImDrawData*>(&frame.ui.data));
+	}
 
-	//Last thing to draw: ImGui!
-	ImGui::Render();
-	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+	//ImGui binds its own shaders/buffers/states behind our back
+	Graphics::States->Invalidate();
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
-	{
+	// - A null backend frame without UI has nothing to show, so it
+	//   isn't presented and the run measures the CPU side alone
+	if (!frame.nullBackend || frame.hasUI) {
 		// Present at the end of the frame
+		PROFILE_SCOPE("Present");
 		bool vsync = Graphics::VsyncState();
 		Graphics::SwapChain->Present(
 			vsync ? 1 : 0,
 			vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
 
 		// Re-bind back buffer and depth buffer after presenting
-		Graphics::Context->OMSetRenderTargets(
+		Graphics::States->OMSetRenderTargets(
 			1,
 			Graphics::BackBufferRTV.GetAddressOf(),
 			Graphics::DepthBufferDSV.Get());
 
 		//same as above but with shadow map (resetting to avoid OMDepthStencil Warning)
-		ID3D11ShaderResourceView* nullSRVs[128] = {};
-		Graphics::Context->PSSetShaderResources(0, 128, nullSRVs);
+		Graphics::States->PSClearShaderResources();
+	}
+
+	//hand this frame's numbers to the UI.  Latency is from the end of
+	//the Update that built the snapshot to Present returning
+	std::chrono::steady_clock::time_point presented = std::chrono::steady_clock::now();
+	float drawTime = std::chrono::duration<float, std::milli>(presented - start).count();
+	frameStats.Record(FrameStats::SERIES_DRAW, drawTime);
+	StateCache::Stats frameStates;
+	{
+		std::lock_guard<std::mutex> guard(renderStatsLock);
+		renderStats.states = Graphics::States->GetStats();
+		passes.AddStats(renderStats.states);
+		frameStates = renderStats.states;
+		if (renderStats.framesRendered > 0) {
+			renderStats.snapshotsSkipped += frame.frame - lastRenderedFrame - 1;
+			float frameTime = std::chrono::duration<float, std::milli>(presented - lastPresent).count();
+			renderStats.frameTime += (frameTime - renderStats.frameTime) * 0.1f;
+		}
+		renderStats.framesRendered++;
+		renderStats.latencies[renderStats.latencyOffset] = std::chrono::duration<float, std::milli>(presented - frame.simulated).count();
+		renderStats.latencyOffset = (renderStats.latencyOffset + 1) % LATENCY_HISTORY;
+		renderStats.scenePreview = frame.softwareRaster ? softwareSRV : ppShaderResourceViews[0];
+		renderStats.nullBackend = frame.nullBackend || frame.softwareRaster;
+		if (renderStats.nullBackend) {
+			renderStats.nullTotals = nullRecorder->GetTotals();
+		}
+		renderStats.software = frame.softwareRaster;
+		if (frame.softwareRaster) {
+			renderStats.softwareStats = softwareRasterizer->GetStats();
+		}
+		renderStats.shadowCache = sceneRenderer->GetShadowCacheStats();
+		Profiler::Counter("Draw calls", renderStats.states.draws);
+		Profiler::Counter("Constant buffer uploads", renderStats.states.uploads);
+		Profiler::Counter("Constant buffer bytes", (long long)renderStats.states.uploadBytes);
+		Profiler::Counter("Shadow views redrawn", renderStats.shadowCache.redrawn);
+	}
+	lastRenderedFrame = frame.frame;
+	lastPresent = presented;
+
+	if (frame.benchmark) {
+		frame.benchmark->RecordDraw(frame.frame, drawTime, frameStates);
+	}
+}
+
+
+// --------------------------------------------------------
+// Draws the snapshot's opaque entities on the CPU and puts
+// the image in the back buffer.  Runs on the render thread
+// after the passes, which went to the null backend
+// --------------------------------------------------------
+void Game::DrawSoftware(const SceneSnapshot& frame)
+{
+	PROFILE_SCOPE("Game::DrawSoftware");
+
+	rasterScene.width = frame.width;
+	rasterScene.height = frame.height;
+	rasterScene.view = frame.view;
+	rasterScene.projection = frame.projection;
+	rasterScene.cameraPosition = frame.cameraPosition;
+	rasterScene.lights = frame.lights.data();
+	rasterScene.lightCount = (unsigned int)frame.lights.size();
+	for (int i = 0; i < 4; ++i) {
+		rasterScene.background[i] = frame.background[i];
+	}
+
+	//textures only live on the GPU, so the material's tint stands in for albedo
+	rasterScene.draws.clear();
+	if (frame.hasCamera) {
+		for (const DrawItem& item : frame.opaque) {
+			RasterDraw draw;
+			draw.vertices = item.mesh->GetVertices().data();
+			draw.indices = item.mesh->GetIndices().data();
+			draw.indexCount = (unsigned int)item.mesh->GetIndices().size();
+			draw.world = item.world;
+			draw.worldInvTranspose = item.worldInvTranspose;
+			draw.albedo = XMFLOAT3(item.params.colorTint.x, item.params.colorTint.y, item.params.colorTint.z);
+			draw.roughness = item.params.roughness;
+			draw.metalness = 0.0f;
+			rasterScene.draws.push_back(draw);
+		}
+	}
+	softwareRasterizer->Render(rasterScene);
+
+	//same size and format as the back buffer, so it can be copied straight in
+	D3D11_TEXTURE2D_DESC existing = {};
+	if (softwareTexture) {
+		softwareTexture->GetDesc(&existing);
+	}
+	if (existing.Width != frame.width || existing.Height != frame.height) {
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = frame.width;
+		desc.Height = frame.height;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		softwareTexture.Reset();
+		softwareSRV.Reset();
+		Graphics::Device->CreateTexture2D(&desc, 0, softwareTexture.GetAddressOf());
+		Graphics::Device->CreateShaderResourceView(softwareTexture.Get(), 0, softwareSRV.GetAddressOf());
 	}
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+	Graphics::BackBufferRTV->GetResource(backBuffer.GetAddressOf());
+	Graphics::Context->UpdateSubresource(softwareTexture.Get(), 0, 0, softwareRasterizer->Pixels().data(), frame.width * 4, 0);
+	Graphics::Context->CopyResource(backBuffer.Get(), softwareTexture.Get());
+}
+
+
+	unsigned int capacity = target.capacity * 2 > 64 ? target.capacity * 2 : 64;
+	capacity = count > capacity ? count : capacity;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = stride * capacity;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = stride;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = capacity;
+
+	target.buffer.Reset();
+	target.srv.Reset();
+	Graphics::Device->CreateBuffer(&desc, 0, target.buffer.GetAddressOf());
+	Graphics::Device->CreateShaderResourceView(target.buffer.Get(), &srvDesc, target.srv.GetAddressOf());
+	target.capacity = capacity;
 }
 
 
@@ -686,10 +1035,19 @@ void Game::UpdateImGui(float deltaTime) {
 
 //Helper Function that builds our ImGui UI
 void Game::BuildUI() {
+	PROFILE_SCOPE("Game::BuildUI");
+
+	//whatever the render thread last reported
+	RenderStats rendered;
+	{
+		std::lock_guard<std::mutex> guard(renderStatsLock);
+		rendered = renderStats;
+	}
+
 	//start a new window
 	ImGui::Begin("A Cool New Window");
 
-	ImGui::Text("Current Framerate: %d", ImGui::GetIO().Framerate);
+	ImGui::Text("Current Framerate: %.1f", ImGui::GetIO().Framerate);
 	ImGui::Text("Current Window Dimensions: %d, %d", Window::Width(), Window::Height());
 
 	ImGui::ColorEdit4("Background Color", ImGui_bgColor);
@@ -722,22 +1080,9 @@ void Game::BuildUI() {
 		}
 	}
 
-	static float vals[90] = {};
-	static int valOffset = 0;
-	static double refreshTime = 0.0;
-	if (refreshTime == 0)
-		refreshTime = ImGui::GetTime();
-
-	while (refreshTime < ImGui::GetTime()) 
-	{
-		static float phase = 0.0f;
-		vals[valOffset] = (float)sin(phase * refreshTime);
-		valOffset = (valOffset + 1) % 90;
-		phase += .1f * valOffset;
-		refreshTime += 1.0f / 60.0f;
-	}
-
-	ImGui::PlotLines("A Really Cool Plot!!!!!", vals, 90, valOffset);
+	std::vector<float> frameTimes;
+	frameStats.GetSamples(FrameStats::SERIES_FRAME, 90, frameTimes);
+	ImGui::PlotLines("Frame time (ms)", frameTimes.data(), (int)frameTimes.size());
 
 
 
@@ -762,7 +1107,8 @@ void Game::BuildUI() {
 	}
 
 	if (ImGui::CollapsingHeader("Entity Information")) {
-		for (int i = 0; i < entityPtrs.size(); ++i) {
+		ImGui::Text("Drawn: %u of %u (%u shadow casters)", sceneRenderer->GetVisibleCount(), entities.GetCount(), sceneRenderer->GetShadowCasterCount());
+		for (int i = 0; i < entityHandles.size(); ++i) {
 			if (ImGui::CollapsingHeader(std::format("Entity {}", i).c_str())) {
 
 				float pos[3] = { entityData[i * 9], entityData[i * 9 + 1], entityData[i * 9 + 2] };
@@ -784,9 +1130,10 @@ void Game::BuildUI() {
 				entityData[i * 9 + 7] = scale[1];
 				entityData[i * 9 + 8] = scale[2];
 
-				entityPtrs[i].get()->GetTransform().get()->SetPosition(pos[0], pos[1], pos[2]);
-				entityPtrs[i].get()->GetTransform().get()->SetRotation(rot[0], rot[1], rot[2]);
-				entityPtrs[i].get()->GetTransform().get()->SetScale(scale[0], scale[1], scale[2]);
+				unsigned int transform = entities.GetTransform(entityHandles[i]);
+				TransformPool::Default().SetPosition(transform, pos[0], pos[1], pos[2]);
+				TransformPool::Default().SetPitchYawRoll(transform, rot[0], rot[1], rot[2]);
+				TransformPool::Default().SetScale(transform, scale[0], scale[1], scale[2]);
 
 			}
 		}
@@ -833,8 +1180,83 @@ void Game::BuildUI() {
 
 	ImGui::Begin("Lights");
 
+	ImGui::Checkbox("Clustered lighting", &clusteredLighting);
+	if (clusteredLighting) {
+		const LightClusters::Stats& clusterStats = sceneRenderer->GetClusterStats();
+		ImGui::Text("%u point/spot lights (%u out of view), %u directional", clusterStats.lights, clusterStats.lightsCulled, clusterStats.directional);
+		ImGui::Text("%u light references, at most %u in a cluster, %u of %u clusters empty", clusterStats.references, clusterStats.maxPerCluster, clusterStats.emptyClusters, LightClusters::CLUSTER_COUNT);
+		ImGui::Text("Built in %.2f ms", clusterStats.buildMs);
+	}
+	else {
+		if (lights.size() > MAX_LIGHT_COUNT) {
+			ImGui::Text("Only the first %d of %zu lights are drawn without clustering", MAX_LIGHT_COUNT, lights.size());
+		}
+		ImGui::Checkbox("Per-object light lists", &objectLights);
+		if (objectLights) {
+			const ObjectLights::Stats& objectStats = sceneRenderer->GetObjectLightStats();
+			ImGui::Text("%u draws, %u lights listed (at most %d each), %u left off full lists", objectStats.draws, objectStats.references, MAX_OBJECT_LIGHTS, objectStats.dropped);
+			ImGui::Text("%u of %u light evaluations saved per pixel, summed over draws", objectStats.evaluationsSaved, objectStats.draws * objectStats.lights);
+			ImGui::Text("Built in %.2f ms", objectStats.buildMs);
+		}
+	}
+	ImGui::InputInt("Lights to spawn", &lightSpawnCount, 100, 1000);
+	if (ImGui::Button("Spawn lights")) {
+		SpawnStressLights(lightSpawnCount > 0 ? lightSpawnCount : 0);
+	}
+
+	//the first light's cascaded shadow map and the shadow atlas
+	if (ImGui::CollapsingHeader("Shadows")) {
+		ShadowCascades& shadowCascades = sceneRenderer->GetShadowCascades();
+		float lambda = shadowCascades.GetSplitLambda();
+		if (ImGui::SliderFloat("Split lambda (linear - log)", &lambda, 0, 1)) {
+			shadowCascades.SetSplitLambda(lambda);
+		}
+		float distance = shadowCascades.GetShadowDistance();
+		if (ImGui::SliderFloat("Shadow distance", &distance, 10, 500)) {
+			shadowCascades.SetShadowDistance(distance);
+		}
+		float reach = shadowCascades.GetCasterReach();
+		if (ImGui::SliderFloat("Caster reach", &reach, 0, 500)) {
+			shadowCascades.SetCasterReach(reach);
+		}
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			const ShadowCascades::Cascade& cascade = shadowCascades.GetCascade(i);
+			ImGui::Text("Cascade %u: %.2f to %.2f, %u casters, %.3f units per texel", i, cascade.splitNear, cascade.splitFar, sceneRenderer->GetCascadeCasterCount(i), cascade.texelSize);
+		}
+
+		//every other light's tiles
+		ImGui::Checkbox("Shadow atlas", &shadowAtlasEnabled);
+		if (shadowAtlasEnabled) {
+			ShadowAtlas& shadowAtlas = sceneRenderer->GetShadowAtlas();
+			const ShadowAtlas::Stats& atlasStats = shadowAtlas.GetStats();
+			unsigned int atlasTexels = shadowAtlas.GetSize() * shadowAtlas.GetSize();
+			ImGui::Text("%u of %u lights shadowed (%u left out), %zu tiles", atlasStats.shadowed, atlasStats.candidates, atlasStats.dropped, shadowAtlas.GetTiles().size());
+			ImGui::Text("%.1f%% of the %ux%u atlas used", 100.0f * atlasStats.texels / atlasTexels, shadowAtlas.GetSize(), shadowAtlas.GetSize());
+		}
+
+		//views that would draw the same thing as last time are kept
+		ImGui::Checkbox("Cache unchanged shadows", &shadowCaching);
+		const ShadowCache::Stats& cacheStats = rendered.shadowCache;
+		ImGui::Text("%u views redrawn, %u kept (%u caster draws saved)", cacheStats.redrawn, cacheStats.reused, cacheStats.castersSkipped);
+		ImGui::Text("%llu of %llu views kept so far", cacheStats.totalReused, cacheStats.totalRedrawn + cacheStats.totalReused);
+	}
+
+	//ambient from the sky, built once at startup
+	if (ImGui::CollapsingHeader("Sky Lighting")) {
+		if (sky->HasLighting()) {
+			ImGui::Checkbox("Image based ambient", &skyLighting);
+			const SkyLighting::Stats& skyStats = sky->GetLightingStats();
+			ImGui::Text("%s in %.1f ms", skyStats.fromCache ? "Loaded from the cache" : "Built", skyStats.ms);
+			ImGui::Text("%u prefiltered mips from %ux%u, %ux%u BRDF table", SkyLighting::SPECULAR_MIPS, SkyLighting::SPECULAR_SIZE, SkyLighting::SPECULAR_SIZE, SkyLighting::BRDF_LUT_SIZE, SkyLighting::BRDF_LUT_SIZE);
+		}
+		else {
+			ImGui::Text("The sky's faces couldn't be read back, no image based ambient");
+		}
+	}
+
+	//spawned lights aren't listed, there can be thousands
 	if (ImGui::CollapsingHeader("Light Information")) {
-		for (int i = 0; i < lights.size(); ++i) {
+		for (int i = 0; i < lights.size() - stressLightCount; ++i) {
 			float color[3]{ lights[i].Color.x, lights[i].Color.y, lights[i].Color.z };
 			ImGui::DragFloat3(std::format("Color of Light {}", i).c_str(), color, 0.01f, 0.0f, 1.0f);
 			lights[i].Color = XMFLOAT3(color[0], color[1], color[2]);
@@ -842,10 +1264,131 @@ void Game::BuildUI() {
 	}
 	ImGui::End();
 
+	ImGui::Begin("Render State");
+
+	//counters are from the last frame the render thread finished
+	const StateCache::Stats& stateStats = rendered.states;
+	const char* categoryNames[StateCache::CATEGORY_COUNT] = { "Shaders", "SRVs", "Samplers", "CBuffers", "Input Assembler", "Render States" };
+	unsigned int totalIssued = 0;
+	unsigned int totalSkipped = 0;
+	if (ImGui::BeginTable("State Calls", 3)) {
+		ImGui::TableSetupColumn("Binding");
+		ImGui::TableSetupColumn("Issued");
+		ImGui::TableSetupColumn("Skipped");
+		ImGui::TableHeadersRow();
+		for (int i = 0; i < StateCache::CATEGORY_COUNT; ++i) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", categoryNames[i]);
+			ImGui::TableNextColumn(); ImGui::Text("%u", stateStats.issued[i]);
+			ImGui::TableNextColumn(); ImGui::Text("%u", stateStats.skipped[i]);
+			totalIssued += stateStats.issued[i];
+			totalSkipped += stateStats.skipped[i];
+		}
+		ImGui::EndTable();
+	}
+	ImGui::Text("Redundant calls dropped: %u of %u", totalSkipped, totalIssued + totalSkipped);
+	ImGui::Text("Draw calls: %u, constant buffer uploads: %u (%.1f KB)", stateStats.draws, stateStats.uploads, stateStats.uploadBytes / 1024.0);
+
+	ImGui::Checkbox("Record passes on deferred contexts", &deferredPasses);
+	ImGui::Checkbox("Record passes to the null backend (scene isn't drawn)", &nullBackend);
+	ImGui::Checkbox("Draw the scene with the software rasterizer", &softwareRaster);
+	if (rendered.software) {
+		const SoftwareRasterizer::Stats& software = rendered.softwareStats;
+		ImGui::Text("Software: %u triangles, %u culled, %u clipped, %u tile references", software.triangles, software.trianglesCulled, software.trianglesClipped, software.tileReferences);
+		ImGui::Text("Setup %.2f ms, binning %.2f ms, raster %.2f ms, %llu pixels shaded", software.setupMs, software.binMs, software.rasterMs, software.pixelsShaded);
+	}
+	if (rendered.nullBackend && ImGui::BeginTable("Null Commands", 2)) {
+		ImGui::TableSetupColumn("Command");
+		ImGui::TableSetupColumn("Count");
+		ImGui::TableHeadersRow();
+		for (int i = 0; i < NullRenderContext::COMMAND_COUNT; ++i) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", NullRenderContext::CommandName((NullRenderContext::CommandType)i));
+			ImGui::TableNextColumn(); ImGui::Text("%u", rendered.nullTotals.commands[i]);
+		}
+		ImGui::EndTable();
+		ImGui::Text("Bytes uploaded: %llu, vertices submitted: %llu", rendered.nullTotals.uploadBytes, rendered.nullTotals.vertices);
+	}
+
+	ImGui::SeparatorText("Simulation");
+	ImGui::Text("Fixed ticks run for this frame: %u", ticksLastFrame);
+	ImGui::Text("Driver command lists: %s", Graphics::DriverCommandLists() ? "native" : "emulated by the runtime");
+
+	ImGui::SeparatorText("Render Thread");
+	float latencyTotal = 0;
+	float latencyMax = 0;
+	unsigned int latencyCount = rendered.framesRendered < LATENCY_HISTORY ? rendered.framesRendered : LATENCY_HISTORY;
+	for (unsigned int i = 0; i < latencyCount; ++i) {
+		latencyTotal += rendered.latencies[i];
+		latencyMax = rendered.latencies[i] > latencyMax ? rendered.latencies[i] : latencyMax;
+	}
+	ImGui::Text("Render frame time: %.2f ms", rendered.frameTime);
+	ImGui::Text("Snapshot to present: %.2f ms average, %.2f ms worst", latencyCount > 0 ? latencyTotal / latencyCount : 0.0f, latencyMax);
+	ImGui::PlotLines("Latency (ms)", rendered.latencies, LATENCY_HISTORY, rendered.latencyOffset);
+	ImGui::Text("Frames rendered: %u, snapshots never drawn: %llu", rendered.framesRendered, rendered.snapshotsSkipped);
+
+	ImGui::End();
+
+	ImGui::Begin("Benchmarks");
+
+	//these block the frame until they finish
+	if (ImGui::Button("Transforms: 100k deep")) {
+		benchmarkLog.push_back(Benchmarks::TransformHierarchy(100000, true, 100).text);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Transforms: 100k wide")) {
+		benchmarkLog.push_back(Benchmarks::TransformHierarchy(100000, false, 100).text);
+	}
+	if (ImGui::Button("Inverse-transpose: 1M")) {
+		benchmarkLog.push_back(Benchmarks::InverseTranspose(1000000).text);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Entities: 1M")) {
+		benchmarkLog.push_back(Benchmarks::EntityIteration(1000000, 10).text);
+	}
+	if (ImGui::Button("Getters: 100k")) {
+		benchmarkLog.push_back(Benchmarks::GetterOverhead(100000, 10).text);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Job scaling")) {
+		benchmarkLog.push_back(Benchmarks::JobScaling(100000, 1000000).text);
+	}
+	if (ImGui::Button("Batch lighting: 1M")) {
+		benchmarkLog.push_back(Benchmarks::BatchLighting(1000000).text);
+	}
+	if (ImGui::Button("Clear")) {
+		benchmarkLog.clear();
+	}
+
+	ImGui::SeparatorText("Stress Scene");
+	ImGui::InputInt("Count", &spawnCount, 1000, 10000);
+	if (ImGui::Button("Spawn")) {
+		SpawnStressEntities(spawnCount > 0 ? spawnCount : 0);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Remove All")) {
+		for (EntityHandle entity : stressEntities) {
+			entities.Destroy(entity);
+		}
+		stressEntities.clear();
+	}
+	ImGui::Text("Spawned: %u, total entities: %u", (unsigned int)stressEntities.size(), entities.GetCount());
+	for (const std::string& line : benchmarkLog) {
+		ImGui::TextWrapped("%s", line.c_str());
+	}
+
+	ImGui::End();
+
+	Profiler::ShowWindow();
+	frameStats.ShowWindow();
+
 	ImGui::Begin("Post Processing");
 
 	ImGui::SeparatorText("Output of Camera before Post Processing:");
-	ImGui::Image((ImTextureID)ppShaderResourceViews[0].Get(), ImVec2((int)Window::Width() / 5, (int)Window::Height() / 5));
+	//the render thread owns the real targets, this reference keeps
+	//the one shown alive until the snapshot drawing it is done
+	uiScenePreview = rendered.scenePreview;
+	ImGui::Image((ImTextureID)uiScenePreview.Get(), ImVec2((int)Window::Width() / 5, (int)Window::Height() / 5));
 
 	ImGui::DragInt("Blur Radius", &blurRadius, 0, Window::Width());
 	ImGui::DragInt("Chromatic Abberation Mode", &chromaticMode, 0, 2);
@@ -861,12 +1404,60 @@ void Game::BuildUI() {
 
 }
 
+// --------------------------------------------------------
+// Adds count spinning entities, cycling through the loaded
+// meshes and materials, in rows of 100 that extend back from
+// behind the regular scene
+// --------------------------------------------------------
+void Game::SpawnStressEntities(unsigned int count)
+{
+	unsigned int first = (unsigned int)stressEntities.size();
+	unsigned int total = first + count;
+	unsigned int side = 100;
+
+	for (unsigned int i = first; i < total; ++i) {
+		EntityHandle entity = entities.Create(meshPtrs[i % meshPtrs.size()].get(), materials[(i / meshPtrs.size()) % materials.size()].get());
+		TransformPool::Default().SetPosition(entities.GetTransform(entity), ((float)(i % side) - side * 0.5f) * 3.0f, 0, 25.0f + (float)(i / side) * 3.0f);
+		entities.SetSpin(entity, true, (float)i);
+		stressEntities.push_back(entity);
+	}
+}
+
+	for (const std::vector<unsigned int>& casters : tileCasters) {
+		count += casters.size();
+	}
+	return (unsigned int)count;
+}
+
+
+// --------------------------------------------------------
+// Point lights scattered over the regular scene and the
+// stress field, for clustered lighting.  Seeded, so a
+// benchmark gets the same lights every run
+// --------------------------------------------------------
+void Game::SpawnStressLights(unsigned int count)
+{
+	std::mt19937 rng(stressLightCount);
+	std::uniform_real_distribution<float> zeroOne(0.0f, 1.0f);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		Light light = {};
+		light.Type = LIGHT_TYPE_POINT;
+		light.Position = XMFLOAT3(-150.0f + zeroOne(rng) * 300.0f, 0.5f + zeroOne(rng) * 3.0f, -20.0f + zeroOne(rng) * 345.0f);
+		light.Color = XMFLOAT3(zeroOne(rng), zeroOne(rng), zeroOne(rng));
+		light.Intensity = 1.0f + zeroOne(rng) * 2.0f;
+		light.Range = 3.0f + zeroOne(rng) * 5.0f;
+		lights.push_back(light);
+	}
+	stressLightCount += count;
+}
+
 void Game::CreateShadowmapResources()
 {
 	D3D11_TEXTURE2D_DESC shadowDesc = {};
-	shadowDesc.Width = shadowMapResolution;
-	shadowDesc.Height = shadowMapResolution;
-	shadowDesc.ArraySize = 1;
+	shadowDesc.Width = sceneRenderer->GetShadowMapResolution();
+	shadowDesc.Height = sceneRenderer->GetShadowMapResolution();
+	shadowDesc.ArraySize = ShadowCascades::CASCADE_COUNT;
 	shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
 	shadowDesc.CPUAccessFlags = 0;
 	shadowDesc.Format = DXGI_FORMAT_R32_TYPELESS;
@@ -878,32 +1469,65 @@ void Game::CreateShadowmapResources()
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	Graphics::Device->CreateTexture2D(&shadowDesc, 0, shadowTexture.GetAddressOf());
 
-	// Create the depth/stencil view
-	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
-	shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
-	shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	shadowDSDesc.Texture2D.MipSlice = 0;
-	Graphics::Device->CreateDepthStencilView(
-		shadowTexture.Get(),
-		&shadowDSDesc,
-		shadowDSV.GetAddressOf());
+	// Create a depth/stencil view per cascade
+	for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+		D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
+		shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
+		shadowDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+		shadowDSDesc.Texture2DArray.MipSlice = 0;
+		shadowDSDesc.Texture2DArray.FirstArraySlice = i;
+		shadowDSDesc.Texture2DArray.ArraySize = 1;
+		Graphics::Device->CreateDepthStencilView(
+			shadowTexture.Get(),
+			&shadowDSDesc,
+			shadowDSVs[i].GetAddressOf());
+	}
 
-	// Create the SRV for the shadow map
+	// Create the SRV for the shadow map, every cascade at once
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = 1;
-	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
+	srvDesc.Texture2DArray.ArraySize = ShadowCascades::CASCADE_COUNT;
 	Graphics::Device->CreateShaderResourceView(
 		shadowTexture.Get(),
 		&srvDesc,
 		shadowSRV.GetAddressOf());
 
+	// The shadow atlas: one plain depth texture the tiles are packed into
+	D3D11_TEXTURE2D_DESC atlasDesc = shadowDesc;
+	atlasDesc.Width = sceneRenderer->GetShadowAtlas().GetSize();
+	atlasDesc.Height = sceneRenderer->GetShadowAtlas().GetSize();
+	atlasDesc.ArraySize = 1;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> atlasTexture;
+	Graphics::Device->CreateTexture2D(&atlasDesc, 0, atlasTexture.GetAddressOf());
+
+	D3D11_DEPTH_STENCIL_VIEW_DESC atlasDSDesc = {};
+	atlasDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	atlasDSDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+	atlasDSDesc.Texture2D.MipSlice = 0;
+	Graphics::Device->CreateDepthStencilView(
+		atlasTexture.Get(),
+		&atlasDSDesc,
+		shadowAtlasDSV.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC atlasSRVDesc = {};
+	atlasSRVDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	atlasSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	atlasSRVDesc.Texture2D.MipLevels = 1;
+	atlasSRVDesc.Texture2D.MostDetailedMip = 0;
+	Graphics::Device->CreateShaderResourceView(
+		atlasTexture.Get(),
+		&atlasSRVDesc,
+		shadowAtlasSRV.GetAddressOf());
+
 	//create shadowRasterizer
 	D3D11_RASTERIZER_DESC shadowRastDesc = {};
 	shadowRastDesc.FillMode = D3D11_FILL_SOLID;
 	shadowRastDesc.CullMode = D3D11_CULL_BACK;
-	shadowRastDesc.DepthClipEnable = true;
+	shadowRastDesc.DepthClipEnable = false; //casters in front of a cascade get flattened onto its near plane
 	shadowRastDesc.DepthBias = 1000; //NOT WORLD UNITS!
 	shadowRastDesc.SlopeScaledDepthBias = 1.0f; //bias more based on slope
 	Graphics::Device->CreateRasterizerState(&shadowRastDesc, &shadowRasterizer);
@@ -918,38 +1542,17 @@ void Game::CreateShadowmapResources()
 	shadowSampDesc.BorderColor[0] = 1.0f; //we only need the first component, that's what the shader reads
 	Graphics::Device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 
+	//clearing a single atlas tile is a draw that always passes the depth test
+	D3D11_DEPTH_STENCIL_DESC shadowClearDesc = {};
+	shadowClearDesc.DepthEnable = true;
+	shadowClearDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	shadowClearDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+	Graphics::Device->CreateDepthStencilState(&shadowClearDesc, shadowClearDepthState.GetAddressOf());
 
-
-
-	for (int i = 0; i < lights.size(); ++i) {
-		switch (lights[i].Type) {
-		case LIGHT_TYPE_DIRECTIONAL:
-			XMFLOAT4X4 lightView;
-			XMStoreFloat4x4(&lightView, XMMatrixLookAtLH(
-				XMLoadFloat3(&lights[i].Direction) * 30.0f,
-				XMLoadFloat3(&lights[i].Direction),
-				XMVectorSet(0, 1, 0, 0)
-			));
-			lightViewMatrixList.push_back(lightView);
-
-			XMFLOAT4X4 lightProj;
-			XMStoreFloat4x4(&lightProj, XMMatrixOrthographicLH(
-				lightProjectionSize,
-				lightProjectionSize,
-				1.0f,
-				100.0f
-			));
-			lightProjectionMatrixList.push_back(lightProj);
-			break;
-
-		default: //do nothing
-			break;
-		}
-	}
-
+	//the cascades' and tiles' matrices follow the camera, see PublishSnapshot
 }
 
-void Game::RecreatePostprocessResources()
+void Game::RecreatePostprocessResources(unsigned int width, unsigned int height)
 {
 	//check for startup call to make sure graphics device exists
 	if (Graphics::Device == nullptr) {
@@ -970,8 +1573,8 @@ void Game::RecreatePostprocessResources()
 	for (int i = 0; i < numPostProcesses; ++i) {
 
 		D3D11_TEXTURE2D_DESC textureDesc = {};
-		textureDesc.Width = Window::Width();
-		textureDesc.Height = Window::Height();
+		textureDesc.Width = width;
+		textureDesc.Height = height;
 		textureDesc.ArraySize = 1;
 		textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 		textureDesc.CPUAccessFlags = 0;
@@ -1011,3 +1614,16 @@ void Game::RecreatePostprocessResources()
 }
 
 
+void Game::BindSceneTargets()
+{
+	sceneResources.postTargets.clear();
+	sceneResources.postInputs.clear();
+	for (int i = 0; i < numPostProcesses; ++i) {
+		sceneResources.postTargets.push_back(ppRenderTargetViews[i].Get());
+		sceneResources.postInputs.push_back(ppShaderResourceViews[i].Get());
+	}
+	sceneResources.backBuffer = Graphics::BackBufferRTV.Get();
+	sceneResources.depthBuffer = Graphics::DepthBufferDSV.Get();
+}
+
+
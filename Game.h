@@ -4,12 +4,26 @@
 #include <wrl/client.h>
 #include <vector>
 #include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
 #include "Mesh.h"
-#include "Entity.h"
+#include "EntityStore.h"
+#include "TransformPool.h"
 #include "Camera.h"
 #include "SimpleShader.h"
 #include "Lights.h"
 #include "Sky.h"
+#include "SceneSnapshot.h"
+#include "StateCache.h"
+#include "PassRecorder.h"
+#include "DeferredPassRecorder.h"
+#include "D3D11RenderDevice.h"
+#include "SceneRenderer.h"
+#include "FrameStats.h"
+#include "BenchmarkRun.h"
+#include "SoftwareRasterizer.h"
 
 class Game
 {
@@ -20,17 +34,105 @@ public:
 	Game(const Game&) = delete; // Remove copy constructor
 	Game& operator=(const Game&) = delete; // Remove copy-assignment operator
 
-	// Primary functions
+	// Primary functions.  Update is one fixed simulation tick, Frame
+	// runs once per presented frame and publishes the scene to the
+	// render thread Initialize starts
 	void Initialize();
 	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
+	void Frame(float deltaTime, float totalTime, float alpha);
 	void OnResize();
 
+	// Scripted benchmark run (see BenchmarkRun), starting next frame.
+	// Returns false if the scene isn't default, stress10k, stress100k or lights4k
+	bool StartBenchmark(const std::string& scene, unsigned int frameCount, const std::string& reportPath);
+	bool BenchmarkDone();
+	// Records the scene passes to a NullRenderContext instead of D3D11
+	void UseNullBackend(bool use) { nullBackend = use; }
+	// Draws the scene with the SoftwareRasterizer (passes go to the
+	// null backend).  For a benchmark, the last frame drawn is written
+	// to imagePath and compared with goldenPath, if they aren't empty
+	void UseSoftwareRasterizer(bool use) { softwareRaster = use; }
+	void SetSoftwareOutput(const std::string& imagePath, const std::string& goldenPath, int tolerance);
+	// Point and spot lights only reach the pixels in the light clusters
+	// their range touches, and there's no cap on the light count
+	void UseClusteredLighting(bool use) { clusteredLighting = use; }
+	// Without clustering, each draw is only lit by the few lights
+	// near it rather than by every light (see ObjectLights)
+	void UseObjectLights(bool use) { objectLights = use; }
+	// Every light after the first can get a shadow, from tiles
+	// shared in one atlas (see ShadowAtlas)
+	void UseShadowAtlas(bool use) { shadowAtlasEnabled = use; }
+	// Shadow cascades and tiles that would come out the same as last
+	// time aren't drawn again (see ShadowCache)
+	void UseShadowCache(bool use) { shadowCaching = use; }
+	// Ambient light comes from the sky's precomputed image based
+	// lighting rather than nothing (see SkyLighting)
+	void UseSkyLighting(bool use) { skyLighting = use; }
+	// Stops the render thread for good and writes the report
+	bool FinishBenchmark();
+
 private:
 
+	// Frames of snapshot latency kept for the UI
+	static const unsigned int LATENCY_HISTORY = 120;
+
+	// What the render thread reports back after every frame
+	struct RenderStats
+	{
+		StateCache::Stats states;
+		unsigned int framesRendered;
+		unsigned long long snapshotsSkipped;
+		float latencies[LATENCY_HISTORY]; // ms from snapshot built to present
+		unsigned int latencyOffset;
+		float frameTime; // ms between presents, smoothed
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scenePreview;
+		bool nullBackend;
+		NullRenderContext::Totals nullTotals; // only while nullBackend
+		bool software;
+		SoftwareRasterizer::Stats softwareStats; // only while software
+		ShadowCache::Stats shadowCache;
+	};
+
+	void PublishSnapshot(float totalTime, float alpha);
+	void RenderLoop();
+	void Draw(const SceneSnapshot& frame);
+	void DrawSoftware(const SceneSnapshot& frame);
+
+	// Simulation -> render hand off
+	SnapshotBuffer snapshots;
+	unsigned long long simulationFrame = 0;
+	unsigned int ticksSinceFrame = 0;
+	unsigned int ticksLastFrame = 0;
+	float tickTimeSinceFrame = 0; // ms spent in Update since the last Frame
+	FrameStats frameStats;
+	std::chrono::steady_clock::time_point lastFrameStart;
+	std::unique_ptr<BenchmarkRun> benchmark;
+	std::unique_ptr<D3D11RenderDevice> renderDevice;
+	std::unique_ptr<SceneRenderer> sceneRenderer;
+	std::thread renderThread;
+
+	// Render thread only
+	unsigned int renderWidth = 0;
+	unsigned int renderHeight = 0;
+	unsigned long long lastRenderedFrame = 0;
+	std::unique_ptr<ImmediatePassRecorder> immediateRecorder;
+	std::unique_ptr<DeferredPassRecorder> deferredRecorder;
+	std::unique_ptr<NullPassRecorder> nullRecorder;
+	std::unique_ptr<SoftwareRasterizer> softwareRasterizer;
+	RasterScene rasterScene;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> softwareTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> softwareSRV;
+	SceneRenderer::Resources sceneResources; // points into the members below
+	std::chrono::steady_clock::time_point lastPresent;
+
+	std::mutex renderStatsLock;
+	RenderStats renderStats = {};
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> uiScenePreview;
+
 
 	std::vector<std::shared_ptr<Mesh>> meshPtrs;
-	std::vector<std::shared_ptr<Entity>> entityPtrs;
+	EntityStore entities{ &TransformPool::Default() };
+	std::vector<EntityHandle> entityHandles; // creation order, for the UI
 	std::vector<std::shared_ptr<Camera>> cameraPtrs;
 	int cameraIndex = 0;
 
@@ -41,7 +143,11 @@ private:
 	void UpdateImGui(float deltaTime);
 	void BuildUI();
 	void CreateShadowmapResources();
-	void RecreatePostprocessResources();
+	void RecreatePostprocessResources(unsigned int width, unsigned int height);
+	// Points sceneResources at the current targets, after any resize
+	void BindSceneTargets();
+	void SpawnStressEntities(unsigned int count);
+	void SpawnStressLights(unsigned int count);
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -55,15 +161,15 @@ private:
 	std::vector<std::shared_ptr<Material>> materials;
 	std::shared_ptr<Sky> sky;
 
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSVs[ShadowCascades::CASCADE_COUNT];
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV; // every cascade, as an array
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
 	std::shared_ptr<SimpleVertexShader> shadowVS;
-	std::vector<DirectX::XMFLOAT4X4> lightViewMatrixList;
-	std::vector<DirectX::XMFLOAT4X4> lightProjectionMatrixList;
-	int shadowMapResolution = 2048; //Ideally a power of 2
-	float lightProjectionSize = 50.0f;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowAtlasDSV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowAtlasSRV;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> shadowClearDepthState;
+	std::shared_ptr<SimpleVertexShader> shadowClearVS;
 
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> ppSampler;
 	std::shared_ptr<SimpleVertexShader> ppVS;
@@ -82,9 +188,25 @@ private:
 	bool ImGui_Demo_Show = false;
 	std::vector<float> entityData;
 	std::vector<Light> lights;
+	unsigned int stressLightCount = 0; // at the end of lights
+	int lightSpawnCount = 1000;
+	bool clusteredLighting = false;
+	bool objectLights = true;
+	bool shadowAtlasEnabled = true;
+	bool shadowCaching = true;
+	bool skyLighting = true;
 	DirectX::XMFLOAT3 ambientColor;
 	int blurRadius = 10;
 	float chromaticOffsets[3];
 	int chromaticMode = 0;
+	bool deferredPasses = false;
+	bool nullBackend = false;
+	bool softwareRaster = false;
+	std::string softwareImagePath;
+	std::string goldenImagePath;
+	int goldenTolerance = 2;
+	std::vector<std::string> benchmarkLog;
+	std::vector<EntityHandle> stressEntities;
+	int spawnCount = 10000;
 };
 
@@ -1,4 +1,5 @@
 #include "Graphics.h"
+#include "D3D11RenderContext.h"
 #include <dxgi1_6.h>
 
 // Tell the drivers to use high-performance GPU in multi-GPU systems (like laptops)
@@ -20,6 +21,7 @@ namespace Graphics
 		BOOL isFullscreen = false;
 
 		D3D_FEATURE_LEVEL featureLevel;
+		bool driverCommandLists = false;
 
 		Microsoft::WRL::ComPtr<ID3D11InfoQueue> InfoQueue;
 	}
@@ -27,6 +29,7 @@ namespace Graphics
 
 // Getters
 bool Graphics::VsyncState() { return vsyncDesired || !supportsTearing || isFullscreen; }
+bool Graphics::DriverCommandLists() { return driverCommandLists; }
 std::wstring Graphics::APIName() 
 { 
 	switch (featureLevel)
@@ -122,6 +125,17 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 		Context.GetAddressOf());	// Pointer to our Device Context pointer
 	if (FAILED(hr)) return hr;
 
+	// Wrap the immediate context so redundant binds get dropped,
+	// and make it where draw code records by default
+	States = std::make_shared<StateCache>(std::make_shared<D3D11RenderContext>(Context));
+	StateCache::SetDefault(States.get());
+
+	// Deferred contexts always work, but the runtime emulates them
+	// when the driver can't build command lists natively
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	Device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+	driverCommandLists = threading.DriverCommandLists == TRUE;
+
 	// We're set up
 	apiInitialized = true;
 
@@ -152,6 +166,8 @@ HRESULT Graphics::Initialize(unsigned int windowWidth, unsigned int windowHeight
 // --------------------------------------------------------
 void Graphics::ShutDown()
 {
+	StateCache::SetDefault(nullptr);
+	States.reset();
 }
 
 
@@ -238,6 +254,10 @@ void Graphics::ResizeBuffers(unsigned int width, unsigned int height)
 	viewport.MaxDepth = 1.0f;
 	Context->RSSetViewports(1, &viewport);
 
+	// We just talked to the context directly
+	if (States)
+		States->Invalidate();
+
 	// Are we in a fullscreen state?
 	SwapChain->GetFullscreenState(&isFullscreen, 0);
 }
@@ -4,6 +4,9 @@
 #include <d3d11.h>
 #include <string>
 #include <wrl/client.h>
+#include <memory>
+
+#include "StateCache.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -17,6 +20,10 @@ namespace Graphics
 	inline Microsoft::WRL::ComPtr<ID3D11DeviceContext> Context;
 	inline Microsoft::WRL::ComPtr<IDXGISwapChain> SwapChain;
 
+	// Redundant state filter wrapping the immediate context, and
+	// StateCache::Current() outside any recording scope
+	inline std::shared_ptr<StateCache> States;
+
 	// Rendering buffers
 	inline Microsoft::WRL::ComPtr<ID3D11RenderTargetView> BackBufferRTV;
 	inline Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthBufferDSV;
@@ -26,6 +33,7 @@ namespace Graphics
 	// Getters
 	bool VsyncState();
 	std::wstring APIName();
+	bool DriverCommandLists(); // false if the runtime emulates deferred contexts
 
 	// General functions
 	HRESULT Initialize(unsigned int windowWidth, unsigned int windowHeight, HWND windowHandle, bool vsyncIfPossible);
@@ -0,0 +1,188 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <format>
+
+#include <algorithm>
+
+namespace
+{
+	// The queue the current thread uses in each scheduler it's touched
+	struct ThreadQueue
+	{
+		unsigned long long system;
+		unsigned int queue;
+	};
+	thread_local std::vector<ThreadQueue> threadQueues;
+
+	std::atomic<unsigned long long> nextSystemId = 0;
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	queuedJobs = 0;
+	running = true;
+	externalThreads = 0;
+	id = nextSystemId.fetch_add(1);
+
+	for (unsigned int i = 0; i < workerCount + EXTERNAL_QUEUES; ++i) {
+		queues.push_back(std::make_unique<Queue>());
+	}
+	for (unsigned int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		running = false;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+JobSystem& JobSystem::Default()
+{
+	static JobSystem jobs(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+	return jobs;
+}
+
+// --------------------------------------------------------
+// Queues a job on the calling thread's own deque, so jobs
+// spawned by a job stay on that worker unless stolen
+// --------------------------------------------------------
+void JobSystem::Run(std::function<void()> job, Counter* counter)
+{
+	counter->fetch_add(1);
+
+	Queue& queue = *queues[CurrentQueue()];
+	{
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.jobs.push_back(Job{ std::move(job), counter });
+	}
+	queuedJobs.fetch_add(1);
+
+	//taking the lock means a worker can't miss this between checking and sleeping
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+	wake.notify_one();
+}
+
+void JobSystem::Wait(Counter* counter)
+{
+	unsigned int queueIndex = CurrentQueue();
+	while (counter->load() > 0) {
+		if (!TryRunOne(queueIndex, counter)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	if (count == 0) {
+		return;
+	}
+
+	//not worth queueing anything for a single chunk
+	if (count <= chunkSize) {
+		body(0, count);
+		return;
+	}
+
+	Counter counter = 0;
+	for (unsigned int begin = 0; begin < count; begin += chunkSize) {
+		unsigned int end = count - begin > chunkSize ? begin + chunkSize : count;
+		Run([&body, begin, end]() { body(begin, end); }, &counter);
+	}
+	Wait(&counter);
+}
+
+// --------------------------------------------------------
+// Workers know their queue already.  Any other thread is
+// handed the next external one the first time it asks
+// --------------------------------------------------------
+unsigned int JobSystem::CurrentQueue()
+{
+	for (const ThreadQueue& known : threadQueues) {
+		if (known.system == id) {
+			return known.queue;
+		}
+	}
+
+	unsigned int external = std::min(externalThreads.fetch_add(1), EXTERNAL_QUEUES - 1);
+	unsigned int queue = (unsigned int)workers.size() + external;
+	threadQueues.push_back(ThreadQueue{ id, queue });
+	return queue;
+}
+
+// --------------------------------------------------------
+// Newest job from our own queue first (still warm in cache),
+// otherwise the oldest job from the next queue that has any.
+// With a group, only that counter's jobs are taken
+// --------------------------------------------------------
+bool JobSystem::TryRunOne(unsigned int queueIndex, const Counter* group)
+{
+	Job job;
+	bool found = TakeJob(*queues[queueIndex], true, group, job);
+
+	unsigned int queueCount = (unsigned int)queues.size();
+	for (unsigned int i = 1; i < queueCount && !found; ++i) {
+		found = TakeJob(*queues[(queueIndex + i) % queueCount], false, group, job);
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	queuedJobs.fetch_sub(1);
+	job.work();
+	job.counter->fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::TakeJob(Queue& queue, bool newest, const Counter* group, Job& job)
+{
+	std::lock_guard<std::mutex> guard(queue.lock);
+	if (queue.jobs.empty()) {
+		return false;
+	}
+
+	if (group == nullptr) {
+		job = std::move(newest ? queue.jobs.back() : queue.jobs.front());
+		newest ? queue.jobs.pop_back() : queue.jobs.pop_front();
+		return true;
+	}
+
+	//searched from the same end an ungrouped take would use
+	for (size_t i = queue.jobs.size(); i-- > 0;) {
+		size_t index = newest ? i : queue.jobs.size() - 1 - i;
+		if (queue.jobs[index].counter == group) {
+			job = std::move(queue.jobs[index]);
+			queue.jobs.erase(queue.jobs.begin() + index);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::WorkerLoop(unsigned int queueIndex)
+{
+	threadQueues.push_back(ThreadQueue{ id, queueIndex });
+	Profiler::SetThreadName(std::format("Worker {}", queueIndex + 1));
+
+	while (running) {
+		if (TryRunOne(queueIndex, nullptr)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [this]() { return queuedJobs.load() > 0 || !running; });
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Work-stealing job scheduler.
+//
+// Every worker has its own deque: it pushes and pops its own
+// jobs at the back, and when it runs dry it steals from the
+// front of someone else's.  Threads that aren't workers (the
+// simulation and render threads) get a deque each too, the
+// first time they use the scheduler.
+//
+// Jobs report completion through a Counter.  Waiting on one
+// runs that counter's own jobs instead of blocking, so jobs
+// can fork more jobs and wait on them without tying up a
+// thread, but a thread waiting on its culls never ends up
+// recording another thread's render pass.
+// --------------------------------------------------------
+class JobSystem
+{
+public:
+
+	// Outstanding jobs, hits zero when they've all finished
+	typedef std::atomic<int> Counter;
+
+	JobSystem(unsigned int workerCount);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete; // Remove copy constructor
+	JobSystem& operator=(const JobSystem&) = delete; // Remove copy-assignment operator
+
+	// Shared scheduler, one worker per core besides the calling thread
+	static JobSystem& Default();
+
+	void Run(std::function<void()> job, Counter* counter);
+	void Wait(Counter* counter);
+
+	// Calls body(begin, end) over [0, count) in chunks of chunkSize and
+	// returns once every chunk is done.  Chunk boundaries only depend on
+	// the arguments, never on the thread count, so as long as body only
+	// writes per-index results the outcome is the same every time
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int, unsigned int)>& body);
+
+	// Workers plus whoever is waiting
+	unsigned int GetThreadCount() { return (unsigned int)workers.size() + 1; }
+
+	// Deques for threads that aren't workers.  Any past this many
+	// share the last one, which only costs them some contention
+	static const unsigned int EXTERNAL_QUEUES = 4;
+
+private:
+
+	struct Job
+	{
+		std::function<void()> work;
+		Counter* counter;
+	};
+
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<Job> jobs;
+	};
+
+	unsigned int CurrentQueue();
+	bool TryRunOne(unsigned int queueIndex, const Counter* group);
+	bool TakeJob(Queue& queue, bool newest, const Counter* group, Job& job);
+	void WorkerLoop(unsigned int queueIndex);
+
+	// Worker i owns queue i, the EXTERNAL_QUEUES after them are handed
+	// out to other threads in the order they first show up
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<unsigned int> externalThreads;
+	unsigned long long id; // never reused, unlike the address
+
+	std::atomic<int> queuedJobs;
+	std::atomic<bool> running;
+	std::mutex sleepLock;
+	std::condition_variable wake;
+};
@@ -0,0 +1,194 @@
+#include "LightClusters.h"
+#include "ClipPlanes.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// Grid column (or row, with ndc flipped) an NDC coordinate falls in
+	unsigned int CellOf(float ndc, unsigned int cells)
+	{
+		int cell = (int)std::floor((ndc + 1.0f) * 0.5f * cells);
+		return (unsigned int)std::clamp(cell, 0, (int)cells - 1);
+	}
+
+	float DistanceSquaredToBox(const float point[3], const float boxMin[3], const float boxMax[3])
+	{
+		float distSq = 0;
+		for (int k = 0; k < 3; ++k) {
+			float d = std::max(std::max(boxMin[k] - point[k], 0.0f), point[k] - boxMax[k]);
+			distSq += d * d;
+		}
+		return distSq;
+	}
+}
+
+LightClusters::LightClusters(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::Build(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, const Light* lights, unsigned int lightCount, ClusterGrid& grid)
+{
+	PROFILE_SCOPE("LightClusters::Build");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	this->view = view;
+	xScale = projection._11;
+	yScale = projection._22;
+	GetClipPlanes(projection, nearZ, farZ);
+	sliceNear = std::min(std::max(SLICE_NEAR, nearZ), farZ * 0.5f);
+	sliceScale = (GRID_Z - 1) / std::log(farZ / sliceNear);
+	sliceDepths[0] = nearZ;
+	for (unsigned int z = 1; z < GRID_Z; ++z) {
+		sliceDepths[z] = sliceNear * std::exp((z - 1) / sliceScale);
+	}
+	sliceDepths[GRID_Z] = farZ;
+
+	stats = {};
+	grid.indices.clear();
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		if (lights[i].Type == LIGHT_TYPE_DIRECTIONAL) {
+			grid.indices.push_back(i);
+		}
+	}
+	grid.directionalCount = (unsigned int)grid.indices.size();
+	stats.directional = grid.directionalCount;
+	stats.lights = lightCount - grid.directionalCount;
+
+	//assignment: a chunk of lights per job, each only writes its own pairs
+	unsigned int chunkCount = (lightCount + LIGHT_CHUNK - 1) / LIGHT_CHUNK;
+	if (chunks.size() < chunkCount) {
+		chunks.resize(chunkCount);
+	}
+	{
+		PROFILE_SCOPE("Assign lights");
+		jobs->ParallelFor(chunkCount, 1, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int c = begin; c < end; ++c) {
+				Chunk& chunk = chunks[c];
+				chunk.pairs.clear();
+				chunk.culled = 0;
+
+				unsigned int last = std::min((c + 1) * LIGHT_CHUNK, lightCount);
+				for (unsigned int i = c * LIGHT_CHUNK; i < last; ++i) {
+					if (lights[i].Type != LIGHT_TYPE_DIRECTIONAL) {
+						AssignLight(lights[i], i, chunk);
+					}
+				}
+			}
+		});
+	}
+
+	//a counting sort of the pairs by cluster, after the directional
+	//lights.  Chunks go in order, so every list stays in light order
+	grid.ranges.assign(CLUSTER_COUNT, ClusterGrid::Range{ 0, 0 });
+	for (unsigned int c = 0; c < chunkCount; ++c) {
+		for (const Pair& pair : chunks[c].pairs) {
+			grid.ranges[pair.cluster].count++;
+		}
+		stats.lightsCulled += chunks[c].culled;
+	}
+	unsigned int offset = grid.directionalCount;
+	for (ClusterGrid::Range& range : grid.ranges) {
+		range.offset = offset;
+		offset += range.count;
+		stats.maxPerCluster = std::max(stats.maxPerCluster, range.count);
+		stats.emptyClusters += range.count == 0;
+	}
+
+	grid.indices.resize(offset);
+	std::vector<unsigned int> cursor(CLUSTER_COUNT);
+	for (unsigned int i = 0; i < CLUSTER_COUNT; ++i) {
+		cursor[i] = grid.ranges[i].offset;
+	}
+	for (unsigned int c = 0; c < chunkCount; ++c) {
+		for (const Pair& pair : chunks[c].pairs) {
+			grid.indices[cursor[pair.cluster]++] = pair.light;
+		}
+	}
+	stats.references = offset - grid.directionalCount;
+
+	grid.depthPlane = XMFLOAT4(view._13, view._23, view._33, view._43);
+	grid.sliceNear = sliceNear;
+	grid.sliceScale = sliceScale;
+
+	stats.buildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --------------------------------------------------------
+// The light's Range sphere is boxed in view space, and the
+// box's corners give the range of tiles and slices it can
+// touch.  Only the clusters in that range are tested, each
+// as the view space box around its froxel
+// --------------------------------------------------------
+void LightClusters::AssignLight(const Light& light, unsigned int index, Chunk& chunk)
+{
+	XMFLOAT3 center;
+	XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&light.Position), XMLoadFloat4x4(&view)));
+	float c[3] = { center.x, center.y, center.z };
+	float r = light.Range;
+
+	float zLow = std::max(c[2] - r, nearZ);
+	float zHigh = std::min(c[2] + r, farZ);
+	if (zLow > zHigh) {
+		chunk.culled++;
+		return;
+	}
+
+	float xLow = std::min((c[0] - r) / zLow, (c[0] - r) / zHigh) * xScale;
+	float xHigh = std::max((c[0] + r) / zLow, (c[0] + r) / zHigh) * xScale;
+	float yLow = std::min((c[1] - r) / zLow, (c[1] - r) / zHigh) * yScale;
+	float yHigh = std::max((c[1] + r) / zLow, (c[1] + r) / zHigh) * yScale;
+	if (xHigh < -1 || xLow > 1 || yHigh < -1 || yLow > 1) {
+		chunk.culled++;
+		return;
+	}
+
+	unsigned int x0 = CellOf(xLow, GRID_X);
+	unsigned int x1 = CellOf(xHigh, GRID_X);
+	unsigned int y0 = CellOf(-yHigh, GRID_Y); //rows count down from the top
+	unsigned int y1 = CellOf(-yLow, GRID_Y);
+	unsigned int z0 = SliceOf(zLow);
+	unsigned int z1 = SliceOf(zHigh);
+
+	size_t before = chunk.pairs.size();
+	for (unsigned int z = z0; z <= z1; ++z) {
+		float zn = sliceDepths[z];
+		float zf = sliceDepths[z + 1];
+		for (unsigned int y = y0; y <= y1; ++y) {
+			float top = 1.0f - 2.0f * y / GRID_Y;
+			float bottom = top - 2.0f / GRID_Y;
+			for (unsigned int x = x0; x <= x1; ++x) {
+				float left = -1.0f + 2.0f * x / GRID_X;
+				float right = left + 2.0f / GRID_X;
+
+				//a froxel's sides spread out with depth, so its box spans both ends
+				float boxMin[3] = { std::min(left * zn, left * zf) / xScale, std::min(bottom * zn, bottom * zf) / yScale, zn };
+				float boxMax[3] = { std::max(right * zn, right * zf) / xScale, std::max(top * zn, top * zf) / yScale, zf };
+				if (DistanceSquaredToBox(c, boxMin, boxMax) <= r * r) {
+					chunk.pairs.push_back(Pair{ (z * GRID_Y + y) * GRID_X + x, index });
+				}
+			}
+		}
+	}
+	chunk.culled += chunk.pairs.size() == before;
+}
+
+unsigned int LightClusters::SliceOf(float depth)
+{
+	if (depth < sliceNear) {
+		return 0;
+	}
+	unsigned int slice = 1 + (unsigned int)(std::log(depth / sliceNear) * sliceScale);
+	return std::min(slice, GRID_Z - 1);
+}
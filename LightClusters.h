@@ -0,0 +1,124 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Lights.h"
+
+class JobSystem;
+
+// --------------------------------------------------------
+// A frame's light lists per cluster, what the pixel shader
+// reads.  Cluster (x, y, z) is ranges[(z * GRID_Y + y) *
+// GRID_X + x], with y = 0 the top row of the screen
+// --------------------------------------------------------
+struct ClusterGrid
+{
+	// Where a cluster's lights are in indices.  uint2 in the shader
+	struct Range
+	{
+		unsigned int offset;
+		unsigned int count;
+	};
+
+	std::vector<Range> ranges;
+	// Light indices, the directional ones first (see LightClusters)
+	std::vector<unsigned int> indices;
+	unsigned int directionalCount = 0;
+
+	// View space depth is dot(float4(world, 1), depthPlane) and falls
+	// in slice 0 below sliceNear, else 1 + log(depth / sliceNear) * sliceScale
+	DirectX::XMFLOAT4 depthPlane;
+	float sliceNear = 1;
+	float sliceScale = 1;
+};
+
+// --------------------------------------------------------
+// Clustered light assignment for forward shading.  The view
+// frustum is cut into froxels: screen tiles by depth slices,
+// log spaced past the first so near slices stay thin.  Each
+// point and spot light is listed in every froxel its Range
+// sphere touches, and the pixel shader only loops over its
+// own froxel's list, so a pixel pays for the lights near it
+// rather than for every light in the scene.
+//
+// Directional lights reach everywhere, so they aren't put
+// in froxels at all: they head the index list and every
+// pixel runs them first.
+//
+// Built on the CPU every frame.  Lights are split into fixed
+// chunks on the job system, and the chunks' results are
+// merged in chunk order, so each list is in light order no
+// matter how many threads ran
+// --------------------------------------------------------
+class LightClusters
+{
+public:
+
+	// Grid size, the same as CLUSTER_GRID_* in ShaderHeaders.hlsli
+	static const unsigned int GRID_X = 16;
+	static const unsigned int GRID_Y = 9;
+	static const unsigned int GRID_Z = 24;
+	static const unsigned int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+	// Far end of slice 0, unless the near plane is past it
+	static constexpr float SLICE_NEAR = 1.0f;
+
+	struct Stats
+	{
+		unsigned int lights; // point and spot
+		unsigned int directional;
+		unsigned int lightsCulled; // range entirely outside the frustum
+		unsigned int references; // light-cluster pairs
+		unsigned int maxPerCluster;
+		unsigned int emptyClusters;
+		float buildMs;
+	};
+
+	explicit LightClusters(JobSystem* jobs);
+	~LightClusters();
+	LightClusters(const LightClusters&) = delete; // Remove copy constructor
+	LightClusters& operator=(const LightClusters&) = delete; // Remove copy-assignment operator
+
+	// Fills grid for a camera.  The projection has to be a symmetric
+	// perspective one, like every Camera makes
+	void Build(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, const Light* lights, unsigned int lightCount, ClusterGrid& grid);
+
+	const Stats& GetStats() { return stats; }
+
+private:
+
+	// Lights per job.  Fixed, so the merge order never depends on
+	// the machine
+	static const unsigned int LIGHT_CHUNK = 64;
+
+	struct Pair
+	{
+		unsigned int cluster;
+		unsigned int light;
+	};
+
+	// One job's output, kept between frames like the rasterizer's
+	struct Chunk
+	{
+		std::vector<Pair> pairs;
+		unsigned int culled;
+	};
+
+	void AssignLight(const Light& light, unsigned int index, Chunk& chunk);
+	unsigned int SliceOf(float depth);
+
+	JobSystem* jobs;
+	Stats stats = {};
+	std::vector<Chunk> chunks;
+
+	// This frame's camera
+	DirectX::XMFLOAT4X4 view;
+	float xScale = 1; // projection _11 and _22
+	float yScale = 1;
+	float nearZ = 0;
+	float farZ = 1;
+	float sliceNear = 1;
+	float sliceScale = 1;
+	float sliceDepths[GRID_Z + 1]; // slice boundaries in view space
+};
@@ -4,6 +4,11 @@
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_SPOT 2
 
+// Size of the pixel shader's constant buffer light array
+#define MAX_LIGHT_COUNT 128
+// Lights one draw is narrowed to (see ObjectLights), a multiple of 4
+#define MAX_OBJECT_LIGHTS 8
+
 #include <DirectXMath.h>
 
 
@@ -16,5 +21,6 @@ struct Light {
 	DirectX::XMFLOAT3 Color;
 	float SpotInnerAngle;
 	float SpotOuterAngle;
-	DirectX::XMFLOAT2 Padding; //purposefully padding out 16 Byte Boundary
+	int ShadowTile; //first shadow atlas tile, -1 for none (see ShadowAtlas)
+	float Padding; //purposefully padding out 16 Byte Boundary
 };
\ No newline at end of file
@@ -1,11 +1,15 @@
 
 #include <Windows.h>
 #include <crtdbg.h>
+#include <cmath>
+#include <sstream>
+#include <string>
 
 #include "Window.h"
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "Profiler.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -57,6 +61,86 @@ int WINAPI WinMain(
 	bool statsInTitleBar = true;
 	bool vsync = false;
 
+	// Simulation runs in fixed ticks at this rate, no matter how
+	// fast frames are presented.  After a hitch, at most this many
+	// ticks run before the next frame and the rest of the backlog
+	// is dropped, so a slow tick can't snowball into slower frames
+	double tickRate = 60.0;
+	unsigned int maxTicksPerFrame = 8;
+
+	// Command line:
+	//  "-trace <frames>" writes a Chrome trace of the first frames, to
+	//   trace.json or whatever "-tracefile <path>" says
+	//  "-benchmark <scene>" flies the camera along a fixed path for
+	//   "-frames <count>" frames (600 by default) without the UI or
+	//   vsync, writes "-report <path>" (benchmark.json) and exits
+	//  "-null" records the scene to the null backend instead of D3D11,
+	//   and with -benchmark skips Present too, to time the CPU side alone
+	//  "-software" draws the scene with the software rasterizer.  With
+	//   -benchmark, the last frame is written to "-image <path>" and
+	//   compared with "-golden <path>" (channels may differ by
+	//   "-tolerance <n>", 2 by default); a mismatch fails the run
+	//  "-clustered" turns on clustered lighting, which the lights4k
+	//   benchmark scene is for
+	//  "-alllights" lights every draw with every light instead of
+	//   its per-object light list, when not clustered
+	//  "-noshadowatlas" leaves every light but the first unshadowed
+	//  "-noshadowcache" redraws every shadow map every frame
+	//  "-noskylighting" leaves out the sky's image based ambient
+	unsigned int traceFrames = 0;
+	std::string tracePath = "trace.json";
+	std::string benchmarkScene;
+	unsigned int benchmarkFrames = 600;
+	std::string benchmarkReport = "benchmark.json";
+	bool nullBackend = false;
+	bool software = false;
+	bool clustered = false;
+	bool allLights = false;
+	bool shadowAtlas = true;
+	bool shadowCache = true;
+	bool skyLighting = true;
+	std::string softwareImage;
+	std::string goldenImage;
+	int goldenTolerance = 2;
+	std::istringstream arguments(lpCmdLine);
+	std::string argument;
+	while (arguments >> argument)
+	{
+		if (argument == "-trace")
+			arguments >> traceFrames;
+		else if (argument == "-tracefile")
+			arguments >> tracePath;
+		else if (argument == "-benchmark")
+			arguments >> benchmarkScene;
+		else if (argument == "-frames")
+			arguments >> benchmarkFrames;
+		else if (argument == "-report")
+			arguments >> benchmarkReport;
+		else if (argument == "-null")
+			nullBackend = true;
+		else if (argument == "-software")
+			software = true;
+		else if (argument == "-image")
+			arguments >> softwareImage;
+		else if (argument == "-golden")
+			arguments >> goldenImage;
+		else if (argument == "-tolerance")
+			arguments >> goldenTolerance;
+		else if (argument == "-clustered")
+			clustered = true;
+		else if (argument == "-alllights")
+			allLights = true;
+		else if (argument == "-noshadowatlas")
+			shadowAtlas = false;
+		else if (argument == "-noshadowcache")
+			shadowCache = false;
+		else if (argument == "-noskylighting")
+			skyLighting = false;
+	}
+	bool benchmarking = !benchmarkScene.empty();
+	if (benchmarking)
+		vsync = false;
+
 	// The main application object
 	game = new Game();
 
@@ -84,7 +168,27 @@ int WINAPI WinMain(
 	Input::Initialize(Window::Handle());
 
 	// Now the game itself can be initialzied
+	Profiler::SetThreadName("Main");
 	game->Initialize();
+	game->UseNullBackend(nullBackend);
+	game->UseSoftwareRasterizer(software);
+	game->SetSoftwareOutput(softwareImage, goldenImage, goldenTolerance);
+	game->UseClusteredLighting(clustered);
+	game->UseObjectLights(!allLights);
+	game->UseShadowAtlas(shadowAtlas);
+	game->UseShadowCache(shadowCache);
+	game->UseSkyLighting(skyLighting);
+
+	if (benchmarking && !game->StartBenchmark(benchmarkScene, benchmarkFrames, benchmarkReport))
+	{
+		printf("Unknown benchmark scene \"%s\" (default, stress10k, stress100k, lights4k)\n", benchmarkScene.c_str());
+		delete game;
+		Input::ShutDown();
+		Graphics::ShutDown();
+		return 1;
+	}
+	if (traceFrames > 0)
+		Profiler::StartTrace(traceFrames, tracePath);
 
 	// Time tracking
 	LARGE_INTEGER perfFreq{};
@@ -102,7 +206,13 @@ int WINAPI WinMain(
 	currentTime = startTime;
 	previousTime = startTime;
 
+	// Fixed-step bookkeeping
+	double tickTime = 1.0 / tickRate;
+	double simulationTime = 0;
+	double accumulator = 0;
+
 	// Windows message loop (and our game loop)
+	int benchmarkResult = 0;
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
 	{
@@ -116,6 +226,9 @@ int WINAPI WinMain(
 		}
 		else
 		{
+			// Everything from here to the next frame's start is this frame
+			Profiler::BeginFrame();
+
 			// Calculate up-to-date timing info
 			QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
 			float deltaTime = max((float)((currentTime - previousTime) * perfSeconds), 0.0f);
@@ -128,17 +241,42 @@ int WINAPI WinMain(
 			// Input updating
 			Input::Update();
 
-			// Update and draw
-			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
+			// Benchmarks run exactly one tick per frame, so every run
+			// simulates the same frames however fast they go
+			if (benchmarking)
+			{
+				game->Update((float)tickTime, (float)simulationTime);
+				simulationTime += tickTime;
+				game->Frame((float)tickTime, (float)simulationTime, 1.0f);
+				Input::EndOfFrame();
+
+				if (game->BenchmarkDone())
+				{
+					benchmarkResult = game->FinishBenchmark() ? 0 : 1;
+					break;
+				}
+				continue;
+			}
+
+			// Run every whole tick the elapsed time covers
+			accumulator += deltaTime;
+			unsigned int ticks = 0;
+			while (accumulator >= tickTime && ticks < maxTicksPerFrame)
+			{
+				game->Update((float)tickTime, (float)simulationTime);
+				simulationTime += tickTime;
+				accumulator -= tickTime;
+				ticks++;
+			}
+			if (accumulator >= tickTime)
+				accumulator = fmod(accumulator, tickTime);
+
+			// Publish a frame for the game's render thread,
+			// blended by how far we are into the next tick
+			game->Frame(deltaTime, totalTime, (float)(accumulator / tickTime));
 
 			// Notify Input system about end of frame
 			Input::EndOfFrame();
-
-#if defined(DEBUG) || defined(_DEBUG)
-			// Print any graphics debug messages that occurred this frame
-			Graphics::PrintDebugMessages();
-#endif
 		}
 	}
 
@@ -146,5 +284,5 @@ int WINAPI WinMain(
 	delete game;
 	Input::ShutDown();
 	Graphics::ShutDown();
-	return (HRESULT)msg.wParam;
+	return benchmarking ? benchmarkResult : (HRESULT)msg.wParam;
 }
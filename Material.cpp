@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "Profiler.h"
 
 Material::Material(DirectX::XMFLOAT4 colorTint, std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps, int materialType, float roughness)
 {
@@ -52,14 +53,14 @@ int Material::GetTextureCount()
 	return textureSRVs.size();
 }
 
-std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> Material::GetTextureSRVs()
+const std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& Material::GetTextureSRVs()
 {
 	return textureSRVs;
 }
 
-std::shared_ptr<SimpleVertexShader> Material::GetVertexShader()
+SimpleVertexShader* Material::GetVertexShader()
 {
-	return simpleVertexShader;
+	return simpleVertexShader.get();
 }
 
 void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vs)
@@ -67,9 +68,9 @@ void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vs)
 	simpleVertexShader = vs;
 }
 
-std::shared_ptr<SimplePixelShader> Material::GetPixelShader()
+SimplePixelShader* Material::GetPixelShader()
 {
-	return simplePixelShader;
+	return simplePixelShader.get();
 }
 
 void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> ps)
@@ -97,8 +98,10 @@ void Material::AddSampler(std::string samplerName, Microsoft::WRL::ComPtr<ID3D11
 	samplers.insert({ samplerName, sampler });
 }
 
-void Material::PrepareMaterial(Camera* cameraPtr)
+void Material::PrepareMaterial(const MaterialParams& params, DirectX::XMFLOAT3 cameraPosition)
 {
+	PROFILE_SCOPE("Material::PrepareMaterial");
+
 	//bind
 	BindMaterialShaders();
 
@@ -107,10 +110,10 @@ void Material::PrepareMaterial(Camera* cameraPtr)
 	for (auto& s : samplers) { simplePixelShader->SetSamplerState(s.first.c_str(), s.second); }
 
 	//send some data to the shader
-	simplePixelShader->SetFloat2("uvScale", uvScale);
-	simplePixelShader->SetFloat2("uvOffset", uvOffset);
-	simplePixelShader->SetFloat3("cameraPos", cameraPtr->GetTransform()->GetPosition());
-	simplePixelShader->SetFloat("roughness", roughness);
+	simplePixelShader->SetFloat2("uvScale", params.uvScale);
+	simplePixelShader->SetFloat2("uvOffset", params.uvOffset);
+	simplePixelShader->SetFloat3("cameraPos", cameraPosition);
+	simplePixelShader->SetFloat("roughness", params.roughness);
 }
 
 void Material::BindMaterialShaders()
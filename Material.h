@@ -5,6 +5,16 @@
 #include "SimpleShader.h"
 #include "Camera.h"
 
+// The values of a material the UI can edit.  Scene snapshots
+// carry a copy so the render thread never reads them live
+struct MaterialParams
+{
+	DirectX::XMFLOAT4 colorTint;
+	DirectX::XMFLOAT2 uvScale;
+	DirectX::XMFLOAT2 uvOffset;
+	float roughness;
+};
+
 class Material
 {
 
@@ -21,13 +31,15 @@ public:
 	void SetUVScale(DirectX::XMFLOAT2 newScale);
 	DirectX::XMFLOAT2 GetUVOffset();
 	void SetUVOffset(DirectX::XMFLOAT2 newOffset);
+	MaterialParams GetParams() { return MaterialParams{ colorTint, uvScale, uvOffset, roughness }; }
 	int GetTextureCount();
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> GetTextureSRVs();
+	const std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& GetTextureSRVs();
 
 
-	std::shared_ptr<SimpleVertexShader> GetVertexShader();
+	//non-owning, the material keeps the shaders alive
+	SimpleVertexShader* GetVertexShader();
 	void SetVertexShader(std::shared_ptr<SimpleVertexShader> vs);
-	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	SimplePixelShader* GetPixelShader();
 	void SetPixelShader(std::shared_ptr<SimplePixelShader> ps);
 
 	int GetMaterialType();
@@ -36,7 +48,7 @@ public:
 	void AddTextureSRV(std::string textureName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV);
 	void AddSampler(std::string samplerName, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
 
-	void PrepareMaterial(Camera* cameraPtr);
+	void PrepareMaterial(const MaterialParams& params, DirectX::XMFLOAT3 cameraPosition);
 	void BindMaterialShaders();
 
 
@@ -1,24 +1,32 @@
 #include "Mesh.h"
 
-#include "Graphics.h"
+#include "StateCache.h"
 #include "Vertex.h"
+#include "Profiler.h"
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 #include <DirectXMath.h>
 #include <vector>
 
+#if !defined(_MSC_VER)
+// Only numbers are read, which sscanf_s takes just like sscanf
+#define sscanf_s sscanf
+#endif
+
 using namespace DirectX;
 
-Mesh::Mesh(Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount) 
+Mesh::Mesh(RenderDevice* device, Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount) 
 {
 
-	CreateBuffers(vertexList, vertexCount, indexList, indexCount);
+	CreateBuffers(device, vertexList, vertexCount, indexList, indexCount);
 
 }
 
-Mesh::Mesh(const char* objFile)
+Mesh::Mesh(RenderDevice* device, const char* objFile)
 {
+	PROFILE_SCOPE("Mesh load");
 
 	// Author: Chris Cascioli
 // Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
@@ -276,7 +284,7 @@ Mesh::Mesh(const char* objFile)
 	//
 	// *************************************
 
-	CreateBuffers(verts.data(), ((int)verts.size()), indices.data(), ((int)indices.size()));
+	CreateBuffers(device, verts.data(), ((int)verts.size()), indices.data(), ((int)indices.size()));
 }
 
 Mesh::~Mesh() {
@@ -286,12 +294,12 @@ Mesh::~Mesh() {
 
 
 
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer() {
-	return indexBuffer;
+ID3D11Buffer* Mesh::GetIndexBuffer() {
+	return indexBuffer.Get();
 }
 
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer() {
-	return vertexBuffer;
+ID3D11Buffer* Mesh::GetVertexBuffer() {
+	return vertexBuffer.Get();
 }
 
 int Mesh::GetIndexCount() {
@@ -306,79 +314,49 @@ void Mesh::Draw() {
 	//set buffers
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	Graphics::Context->IASetVertexBuffers(0, 1, GetVertexBuffer().GetAddressOf(), &stride, &offset);
-	Graphics::Context->IASetIndexBuffer(GetIndexBuffer().Get(), DXGI_FORMAT_R32_UINT, 0);
+	StateCache* states = StateCache::Current();
+	states->IASetVertexBuffer(vertexBuffer.Get(), stride, offset);
+	states->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
 
 
 	//draw things
-	Graphics::Context->DrawIndexed(
+	states->DrawIndexed(
 		GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
 		0,     // Offset to the first index we want to use
 		0);    // Offset to add to each index when looking up vertices
 
 }
 
-void Mesh::CreateBuffers(Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount)
+void Mesh::CreateBuffers(RenderDevice* device, Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount)
 {
 
 	//Set index and vertex count
 	this->vertexCount = vertexCount;
 	this->indexCount = indexCount;
-
-
-
-	// Create a VERTEX BUFFER
-	// - This holds the vertex data of triangles for a single object
-	// - This buffer is created on the GPU, which is where the data needs to
-	//    be if we want the GPU to act on it (as in: draw it to the screen)
-	{
-		// First, we need to describe the buffer we want Direct3D to make on the GPU
-		//  - Note that this variable is created on the stack since we only need it once
-		//  - After the buffer is created, this description variable is unnecessary
-		D3D11_BUFFER_DESC vbd = {};
-		vbd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		vbd.ByteWidth = sizeof(Vertex) * vertexCount;   
-		vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells Direct3D this is a vertex buffer
-		vbd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
-		vbd.MiscFlags = 0;
-		vbd.StructureByteStride = 0;
-
-		// Create the proper struct to hold the initial vertex data
-		// - This is how we initially fill the buffer with data
-		// - Essentially, we're specifying a pointer to the data to copy
-		D3D11_SUBRESOURCE_DATA initialVertexData = {};
-		initialVertexData.pSysMem = vertexList; // pSysMem = Pointer to System Memory
-
-		// Actually create the buffer on the GPU with the initial data
-		// - Once we do this, we'll NEVER CHANGE DATA IN THE BUFFER AGAIN
-		Graphics::Device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
+	vertices.assign(vertexList, vertexList + vertexCount);
+	indices.assign(indexList, indexList + indexCount);
+
+	//bounding sphere around the box center, loose but cheap to build and test
+	XMFLOAT3 minPos = vertexList[0].Position;
+	XMFLOAT3 maxPos = vertexList[0].Position;
+	for (int i = 1; i < vertexCount; ++i) {
+		XMStoreFloat3(&minPos, XMVectorMin(XMLoadFloat3(&minPos), XMLoadFloat3(&vertexList[i].Position)));
+		XMStoreFloat3(&maxPos, XMVectorMax(XMLoadFloat3(&maxPos), XMLoadFloat3(&vertexList[i].Position)));
 	}
-
-	// Create an INDEX BUFFER
-	// - This holds indices to elements in the vertex buffer
-	// - This is most useful when vertices are shared among neighboring triangles
-	// - This buffer is created on the GPU, which is where the data needs to
-	//    be if we want the GPU to act on it (as in: draw it to the screen)
-	{
-		// Describe the buffer, as we did above, with two major differences
-		//  - Byte Width (3 unsigned integers vs. 3 whole vertices)
-		//  - Bind Flag (used as an index buffer instead of a vertex buffer) 
-		D3D11_BUFFER_DESC ibd = {};
-		ibd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		ibd.ByteWidth = sizeof(unsigned int) * indexCount;	// 3 = number of indices in the buffer
-		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells Direct3D this is an index buffer
-		ibd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
-		ibd.MiscFlags = 0;
-		ibd.StructureByteStride = 0;
-
-		// Specify the initial data for this buffer, similar to above
-		D3D11_SUBRESOURCE_DATA initialIndexData = {};
-		initialIndexData.pSysMem = indexList; // pSysMem = Pointer to System Memory
-
-		// Actually create the buffer with the initial data
-		// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
-		Graphics::Device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+	XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&minPos), XMLoadFloat3(&maxPos)), 0.5f);
+	XMVECTOR radiusSq = XMVectorZero();
+	for (int i = 0; i < vertexCount; ++i) {
+		radiusSq = XMVectorMax(radiusSq, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertexList[i].Position), center)));
 	}
+	XMStoreFloat3(&boundsCenter, center);
+	boundsRadius = XMVectorGetX(XMVectorSqrt(radiusSq));
+
+
+	// Create the VERTEX and INDEX BUFFERS on the GPU, which is where the
+	// data needs to be if we want the GPU to act on it
+	// - Once we do this, we'll NEVER CHANGE DATA IN THE BUFFERS AGAIN
+	device->CreateVertexBuffer(vertexList, sizeof(Vertex) * vertexCount, vertexBuffer.GetAddressOf());
+	device->CreateIndexBuffer(indexList, sizeof(unsigned int) * indexCount, indexBuffer.GetAddressOf());
 }
 
 // --------------------------------------------------------
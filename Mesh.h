@@ -2,24 +2,36 @@
 
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <DirectXMath.h>
+#include <vector>
 
 #include "Vertex.h"
+#include "RenderDevice.h"
 
 class Mesh
 {
 public:
 
-	Mesh(Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount);
-	Mesh(const char* objFile);
+	Mesh(RenderDevice* device, Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount);
+	Mesh(RenderDevice* device, const char* objFile);
 	~Mesh();
 	Mesh(const Mesh&) = delete; // Remove copy constructor
 	Mesh& operator=(const Mesh&) = delete; // Remove copy-assignment operator
 
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	//non-owning, no AddRef/Release
+	ID3D11Buffer* GetVertexBuffer();
+	ID3D11Buffer* GetIndexBuffer();
 	int GetVertextCount();
 	int GetIndexCount();
 
+	//local space bounding sphere
+	DirectX::XMFLOAT3 GetBoundsCenter() { return boundsCenter; }
+	float GetBoundsRadius() { return boundsRadius; }
+
+	//CPU copy of the geometry, for the software rasterizer
+	const std::vector<Vertex>& GetVertices() { return vertices; }
+	const std::vector<unsigned int>& GetIndices() { return indices; }
+
 	void Draw();
 
 
@@ -27,12 +39,17 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 
-	void CreateBuffers(Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount);
+	void CreateBuffers(RenderDevice* device, Vertex vertexList[], int vertexCount, UINT indexList[], int indexCount);
 
 	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
 
 	int indexCount;
 	int vertexCount;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+
+	DirectX::XMFLOAT3 boundsCenter;
+	float boundsRadius;
 
 
 };
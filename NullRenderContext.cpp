@@ -0,0 +1,105 @@
+#include "NullRenderContext.h"
+
+#include <cstring>
+
+NullRenderContext::NullRenderContext(bool keepCommands)
+{
+	this->keepCommands = keepCommands;
+	Reset();
+}
+
+NullRenderContext::~NullRenderContext()
+{
+}
+
+const char* NullRenderContext::CommandName(CommandType type)
+{
+	switch (type) {
+	case COMMAND_SHADER: return "Shaders";
+	case COMMAND_CBUFFER: return "CBuffers";
+	case COMMAND_SRV: return "SRVs";
+	case COMMAND_SAMPLER: return "Samplers";
+	case COMMAND_INPUT_ASSEMBLER: return "Input Assembler";
+	case COMMAND_RENDER_STATE: return "Render States";
+	case COMMAND_TARGET: return "Targets";
+	case COMMAND_CLEAR: return "Clears";
+	case COMMAND_DRAW: return "Draws";
+	case COMMAND_UPLOAD: return "Uploads";
+	default: return "";
+	}
+}
+
+void NullRenderContext::Reset()
+{
+	memset(&totals, 0, sizeof(Totals));
+	//keeps its capacity, so steady frames stop allocating
+	commands.clear();
+}
+
+void NullRenderContext::Add(CommandType type, const void* object, unsigned int value)
+{
+	totals.commands[type]++;
+	if (keepCommands) {
+		commands.push_back(Command{ type, object, value });
+	}
+}
+
+// --------------------------------------------------------
+// A range of views is one call, however many it binds, but
+// each view is kept (with its own slot) so a dump shows all
+// of them.  An empty range is still a call
+// --------------------------------------------------------
+void NullRenderContext::AddResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	totals.commands[COMMAND_SRV]++;
+	if (keepCommands) {
+		for (unsigned int i = 0; i < count; i++) {
+			commands.push_back(Command{ COMMAND_SRV, srvs[i], slot + i });
+		}
+	}
+}
+
+void NullRenderContext::VSSetShader(ID3D11VertexShader* shader) { Add(COMMAND_SHADER, shader, 0); }
+void NullRenderContext::PSSetShader(ID3D11PixelShader* shader) { Add(COMMAND_SHADER, shader, 0); }
+void NullRenderContext::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) { Add(COMMAND_CBUFFER, buffer, slot); }
+void NullRenderContext::PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) { Add(COMMAND_CBUFFER, buffer, slot); }
+void NullRenderContext::VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) { AddResources(slot, count, srvs); }
+void NullRenderContext::PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) { AddResources(slot, count, srvs); }
+void NullRenderContext::VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) { Add(COMMAND_SAMPLER, sampler, slot); }
+void NullRenderContext::PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) { Add(COMMAND_SAMPLER, sampler, slot); }
+
+void NullRenderContext::IASetInputLayout(ID3D11InputLayout* layout) { Add(COMMAND_INPUT_ASSEMBLER, layout, 0); }
+void NullRenderContext::IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int) { Add(COMMAND_INPUT_ASSEMBLER, buffer, stride); }
+void NullRenderContext::IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int) { Add(COMMAND_INPUT_ASSEMBLER, buffer, format); }
+void NullRenderContext::IASetPrimitiveTopology(unsigned int topology) { Add(COMMAND_INPUT_ASSEMBLER, nullptr, topology); }
+
+void NullRenderContext::RSSetState(ID3D11RasterizerState* state) { Add(COMMAND_RENDER_STATE, state, 0); }
+void NullRenderContext::RSSetViewport(float width, float, float, float) { Add(COMMAND_TARGET, nullptr, (unsigned int)width); }
+void NullRenderContext::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) { Add(COMMAND_RENDER_STATE, state, stencilRef); }
+void NullRenderContext::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const*, ID3D11DepthStencilView* dsv) { Add(COMMAND_TARGET, dsv, count); }
+void NullRenderContext::ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float[4]) { Add(COMMAND_CLEAR, rtv, 0); }
+void NullRenderContext::ClearDepthStencilView(ID3D11DepthStencilView* dsv, float) { Add(COMMAND_CLEAR, dsv, 0); }
+
+void NullRenderContext::DrawIndexed(unsigned int indexCount, unsigned int, int)
+{
+	Add(COMMAND_DRAW, nullptr, indexCount);
+	totals.vertices += indexCount;
+}
+
+void NullRenderContext::Draw(unsigned int vertexCount, unsigned int)
+{
+	Add(COMMAND_DRAW, nullptr, vertexCount);
+	totals.vertices += vertexCount;
+}
+
+void NullRenderContext::UpdateConstantBuffer(ID3D11Buffer* buffer, const void*, unsigned int bytes)
+{
+	Add(COMMAND_UPLOAD, buffer, bytes);
+	totals.uploadBytes += bytes;
+}
+
+void NullRenderContext::UpdateBuffer(ID3D11Buffer* buffer, const void*, unsigned int bytes)
+{
+	Add(COMMAND_UPLOAD, buffer, bytes);
+	totals.uploadBytes += bytes;
+}
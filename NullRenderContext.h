@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderContext.h"
+
+// --------------------------------------------------------
+// A RenderContext with nothing behind it.  Each call is
+// counted by type (and optionally kept in order, to compare
+// or dump a frame's command stream), along with the bytes of
+// constant data uploaded and the vertices drawn.
+//
+// Needs no Windows or D3D headers, so it (and StateCache on
+// top of it) builds anywhere.  Not thread safe; give each
+// recording thread its own
+// --------------------------------------------------------
+class NullRenderContext : public RenderContext
+{
+public:
+
+	enum CommandType
+	{
+		COMMAND_SHADER,
+		COMMAND_CBUFFER,
+		COMMAND_SRV,
+		COMMAND_SAMPLER,
+		COMMAND_INPUT_ASSEMBLER,
+		COMMAND_RENDER_STATE,
+		COMMAND_TARGET, // render targets and viewports
+		COMMAND_CLEAR,
+		COMMAND_DRAW,
+		COMMAND_UPLOAD,
+		COMMAND_COUNT
+	};
+
+	struct Command
+	{
+		CommandType type;
+		const void* object; // what was bound, drawn from or written to, if anything
+		unsigned int value; // slot, count or bytes, whichever the command has
+	};
+
+	struct Totals
+	{
+		unsigned int commands[COMMAND_COUNT];
+		unsigned long long uploadBytes;
+		unsigned long long vertices; // indices for indexed draws
+	};
+
+	explicit NullRenderContext(bool keepCommands = false);
+	~NullRenderContext();
+	NullRenderContext(const NullRenderContext&) = delete; // Remove copy constructor
+	NullRenderContext& operator=(const NullRenderContext&) = delete; // Remove copy-assignment operator
+
+	static const char* CommandName(CommandType type);
+
+	// Forgets the counts and commands so far, once per frame
+	void Reset();
+	const Totals& GetTotals() { return totals; }
+	const std::vector<Command>& GetCommands() { return commands; } // an SRV range is kept as one per view
+
+	void VSSetShader(ID3D11VertexShader* shader) override;
+	void PSSetShader(ID3D11PixelShader* shader) override;
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) override;
+	void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) override;
+	void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) override;
+	void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) override;
+	void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) override;
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override;
+	void IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) override;
+	void IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset) override;
+	void IASetPrimitiveTopology(unsigned int topology) override;
+
+	void RSSetState(ID3D11RasterizerState* state) override;
+	void RSSetViewport(float width, float height, float left, float top) override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) override;
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) override;
+	void ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4]) override;
+	void ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth) override;
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+	void Draw(unsigned int vertexCount, unsigned int startVertex) override;
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) override;
+	void UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) override;
+
+private:
+
+	void Add(CommandType type, const void* object, unsigned int value);
+	void AddResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs);
+
+	bool keepCommands;
+	Totals totals;
+	std::vector<Command> commands;
+};
@@ -0,0 +1,145 @@
+#include "NullRenderDevice.h"
+
+#include <atomic>
+#include <filesystem>
+
+namespace
+{
+	std::atomic<unsigned int> liveObjects = 0;
+
+	// A COM object that is nothing but its reference count
+	class StandInObject final : public IUnknown
+	{
+	public:
+
+		StandInObject() { liveObjects++; }
+		~StandInObject() { liveObjects--; }
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) override
+		{
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++references; }
+
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			ULONG left = --references;
+			if (left == 0) {
+				delete this;
+			}
+			return left;
+		}
+
+	private:
+
+		std::atomic<ULONG> references = 1;
+	};
+
+	template <typename T>
+	void Create(T** object)
+	{
+		*object = NullRenderDevice::StandIn<T>().Detach();
+	}
+}
+
+NullRenderDevice::NullRenderDevice()
+{
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+}
+
+void NullRenderDevice::AddShader(const std::wstring& fileName, const ShaderReflection& reflection)
+{
+	shaders[fileName] = reflection;
+}
+
+unsigned int NullRenderDevice::LiveObjects()
+{
+	return liveObjects;
+}
+
+IUnknown* NullRenderDevice::NewObject()
+{
+	return new StandInObject();
+}
+
+void NullRenderDevice::Reflect(const wchar_t* file, ShaderReflection& reflection)
+{
+	auto shader = shaders.find(std::filesystem::path(file).filename().wstring());
+	if (shader != shaders.end()) {
+		reflection = shader->second;
+	}
+}
+
+bool NullRenderDevice::LoadVertexShader(const wchar_t* file, ID3D11VertexShader** shader, ID3D11InputLayout** inputLayout, ShaderReflection& reflection)
+{
+	Reflect(file, reflection);
+	Create(shader);
+	Create(inputLayout);
+	return true;
+}
+
+bool NullRenderDevice::LoadPixelShader(const wchar_t* file, ID3D11PixelShader** shader, ShaderReflection& reflection)
+{
+	Reflect(file, reflection);
+	Create(shader);
+	return true;
+}
+
+bool NullRenderDevice::CreateVertexBuffer(const void*, unsigned int, ID3D11Buffer** buffer)
+{
+	Create(buffer);
+	return true;
+}
+
+bool NullRenderDevice::CreateIndexBuffer(const void*, unsigned int, ID3D11Buffer** buffer)
+{
+	Create(buffer);
+	return true;
+}
+
+bool NullRenderDevice::CreateConstantBuffer(unsigned int, ID3D11Buffer** buffer)
+{
+	Create(buffer);
+	return true;
+}
+
+bool NullRenderDevice::CreateStructuredBuffer(unsigned int, unsigned int, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv)
+{
+	Create(buffer);
+	Create(srv);
+	return true;
+}
+
+bool NullRenderDevice::LoadCubeMap(const wchar_t* const[6], ID3D11ShaderResourceView** srv)
+{
+	Create(srv);
+	return true;
+}
+
+bool NullRenderDevice::ReadCubeMap(ID3D11ShaderResourceView*, std::vector<unsigned char>[6], unsigned int&, bool&)
+{
+	return false;
+}
+
+bool NullRenderDevice::CreateFloatTexture(unsigned int, unsigned int, unsigned int, bool, const void* const*, ID3D11ShaderResourceView** srv)
+{
+	Create(srv);
+	return true;
+}
+
+bool NullRenderDevice::CreateRasterizerState(unsigned int, ID3D11RasterizerState** state)
+{
+	Create(state);
+	return true;
+}
+
+bool NullRenderDevice::CreateDepthStencilState(unsigned int, bool, ID3D11DepthStencilState** state)
+{
+	Create(state);
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <string>
+#include <unordered_map>
+
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// A RenderDevice with nothing behind it, for running the
+// frame on NullRenderContext.  Everything it creates is a
+// distinct stand in object that only counts its references,
+// which is all StateCache and the null context ever touch.
+//
+// Shaders have no files to reflect, so each one's layout is
+// registered by file name with AddShader beforehand; any
+// other file loads as a shader that binds nothing.  Cube
+// maps can't be read back, so a sky made on it has no
+// image based lighting
+// --------------------------------------------------------
+class NullRenderDevice : public RenderDevice
+{
+public:
+
+	NullRenderDevice();
+	~NullRenderDevice();
+	NullRenderDevice(const NullRenderDevice&) = delete; // Remove copy constructor
+	NullRenderDevice& operator=(const NullRenderDevice&) = delete; // Remove copy-assignment operator
+
+	// What a shader file binds, matched on its name without the folder
+	void AddShader(const std::wstring& fileName, const ShaderReflection& reflection);
+
+	// A stand in for anything the device doesn't make, like samplers
+	// or render targets
+	template <typename T>
+	static Microsoft::WRL::ComPtr<T> StandIn()
+	{
+		Microsoft::WRL::ComPtr<T> object;
+		*object.GetAddressOf() = static_cast<T*>(NewObject());
+		return object;
+	}
+
+	// Stand ins not yet released, across every device
+	static unsigned int LiveObjects();
+
+	bool LoadVertexShader(const wchar_t* file, ID3D11VertexShader** shader, ID3D11InputLayout** inputLayout, ShaderReflection& reflection) override;
+	bool LoadPixelShader(const wchar_t* file, ID3D11PixelShader** shader, ShaderReflection& reflection) override;
+
+	bool CreateVertexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateIndexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateConstantBuffer(unsigned int bytes, ID3D11Buffer** buffer) override;
+	bool CreateStructuredBuffer(unsigned int stride, unsigned int count, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv) override;
+
+	bool LoadCubeMap(const wchar_t* const faces[6], ID3D11ShaderResourceView** srv) override;
+	bool ReadCubeMap(ID3D11ShaderResourceView* cubeMap, std::vector<unsigned char> faces[6], unsigned int& size, bool& bgra) override;
+	bool CreateFloatTexture(unsigned int size, unsigned int channels, unsigned int mips, bool cube, const void* const* data, ID3D11ShaderResourceView** srv) override;
+
+	bool CreateRasterizerState(unsigned int cullMode, ID3D11RasterizerState** state) override;
+	bool CreateDepthStencilState(unsigned int comparison, bool depthWrite, ID3D11DepthStencilState** state) override;
+
+private:
+
+	// A new stand in holding one reference
+	static IUnknown* NewObject();
+
+	void Reflect(const wchar_t* file, ShaderReflection& reflection);
+
+	std::unordered_map<std::wstring, ShaderReflection> shaders;
+};
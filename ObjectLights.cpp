@@ -0,0 +1,120 @@
+#include "ObjectLights.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "SceneSnapshot.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+ObjectLights::ObjectLights(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+ObjectLights::~ObjectLights()
+{
+}
+
+void ObjectLights::Build(const Light* lights, unsigned int lightCount, std::vector<DrawItem>& items)
+{
+	PROFILE_SCOPE("ObjectLights::Build");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	lightCount = std::min(lightCount, (unsigned int)MAX_LIGHT_COUNT);
+	unsigned int count = (unsigned int)items.size();
+	unsigned int chunkCount = (count + DRAW_CHUNK - 1) / DRAW_CHUNK;
+	chunkStats.assign(chunkCount, Stats{});
+
+	jobs->ParallelFor(count, DRAW_CHUNK, [&](unsigned int begin, unsigned int end) {
+		Stats& partial = chunkStats[begin / DRAW_CHUNK];
+		for (unsigned int i = begin; i < end; ++i) {
+			SelectLights(lights, lightCount, items[i], partial);
+		}
+	});
+
+	stats = {};
+	for (const Stats& partial : chunkStats) {
+		stats.references += partial.references;
+		stats.dropped += partial.dropped;
+		stats.evaluationsSaved += partial.evaluationsSaved;
+	}
+	stats.draws = count;
+	stats.lights = lightCount;
+	stats.buildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --------------------------------------------------------
+// Directional lights reach everything and take the first
+// slots.  Point and spot lights are ranked by intensity
+// times the shader's falloff, saturate(1 - d^2 / range^2)^2,
+// at the distance d from the light to the nearest point of
+// the bounding sphere, so a light inside the sphere counts
+// at full strength
+// --------------------------------------------------------
+void ObjectLights::SelectLights(const Light* lights, unsigned int lightCount, DrawItem& item, Stats& chunkStats)
+{
+	XMMATRIX world = XMLoadFloat4x4(&item.world);
+	XMFLOAT3 localCenter = item.mesh->GetBoundsCenter();
+	XMFLOAT3 center;
+	XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&localCenter), world));
+
+	//the largest axis scale keeps the sphere conservative, like EntityStore::Cull
+	XMVECTOR scaleSq = XMVectorMax(XMVector3LengthSq(world.r[0]), XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+	float radius = item.mesh->GetBoundsRadius() * XMVectorGetX(XMVectorSqrt(scaleSq));
+
+	//best first, at most a full list of them
+	Candidate best[MAX_OBJECT_LIGHTS];
+	unsigned int bestCount = 0;
+	unsigned int overlapping = 0;
+
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		const Light& light = lights[i];
+		float influence;
+		if (light.Type == LIGHT_TYPE_DIRECTIONAL) {
+			influence = FLT_MAX;
+		}
+		else {
+			float dx = light.Position.x - center.x;
+			float dy = light.Position.y - center.y;
+			float dz = light.Position.z - center.z;
+			float reach = light.Range + radius;
+			float distanceSq = dx * dx + dy * dy + dz * dz;
+			if (distanceSq >= reach * reach) {
+				continue;
+			}
+			float distance = std::max(std::sqrt(distanceSq) - radius, 0.0f);
+			float falloff = 1.0f - distance * distance / (light.Range * light.Range);
+			influence = light.Intensity * std::max(light.Color.x, std::max(light.Color.y, light.Color.z)) * falloff * falloff;
+			if (influence <= 0) {
+				continue;
+			}
+		}
+		overlapping++;
+
+		//insertion into the sorted list; ties keep the earlier light
+		if (bestCount == MAX_OBJECT_LIGHTS && influence <= best[bestCount - 1].influence) {
+			continue;
+		}
+		unsigned int slot = bestCount < MAX_OBJECT_LIGHTS ? bestCount++ : bestCount - 1;
+		while (slot > 0 && best[slot - 1].influence < influence) {
+			best[slot] = best[slot - 1];
+			slot--;
+		}
+		best[slot] = Candidate{ influence, i };
+	}
+
+	//back into light order, so lights add up in the same order as the full loop
+	item.lightCount = bestCount;
+	for (unsigned int i = 0; i < bestCount; ++i) {
+		item.lightIndices[i] = best[i].light;
+	}
+	std::sort(item.lightIndices, item.lightIndices + bestCount);
+
+	chunkStats.references += bestCount;
+	chunkStats.dropped += overlapping - bestCount;
+	chunkStats.evaluationsSaved += lightCount - bestCount;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include "Lights.h"
+
+class JobSystem;
+struct DrawItem;
+
+// --------------------------------------------------------
+// Per-draw light lists for the constant buffer light path.
+// Without them every pixel of every draw loops over all of
+// lights[], even over lights whose Range is nowhere near it.
+//
+// Each draw's world bounding sphere is tested against every
+// point and spot light's Range sphere, and the overlapping
+// lights are scored by how bright they are at the sphere's
+// nearest point (the shader's own attenuation).  The best
+// MAX_OBJECT_LIGHTS, directional lights always first, end up
+// in the DrawItem in light order, and the pixel shader only
+// loops over those.
+//
+// Runs on the job system in fixed chunks of draws, each
+// writing only its own draws and stats
+// --------------------------------------------------------
+class ObjectLights
+{
+public:
+
+	struct Stats
+	{
+		unsigned int draws;
+		unsigned int lights; // considered per draw, the constant buffer's
+		unsigned int references; // lights listed over all draws
+		unsigned int dropped; // overlapping lights that didn't make a full list
+		unsigned int evaluationsSaved; // lights skipped per pixel, summed over draws
+		float buildMs;
+	};
+
+	explicit ObjectLights(JobSystem* jobs);
+	~ObjectLights();
+	ObjectLights(const ObjectLights&) = delete; // Remove copy constructor
+	ObjectLights& operator=(const ObjectLights&) = delete; // Remove copy-assignment operator
+
+	// Fills in every item's light list.  Only the first MAX_LIGHT_COUNT
+	// lights are considered, the ones the constant buffer holds
+	void Build(const Light* lights, unsigned int lightCount, std::vector<DrawItem>& items);
+
+	const Stats& GetStats() { return stats; }
+
+private:
+
+	static const unsigned int DRAW_CHUNK = 256;
+
+	// One light a draw could get, before the best are picked
+	struct Candidate
+	{
+		float influence;
+		unsigned int light;
+	};
+
+	void SelectLights(const Light* lights, unsigned int lightCount, DrawItem& item, Stats& chunkStats);
+
+	JobSystem* jobs;
+	Stats stats = {};
+	std::vector<Stats> chunkStats;
+};
@@ -0,0 +1,71 @@
+#include "PassRecorder.h"
+
+ImmediatePassRecorder::ImmediatePassRecorder(StateCache* states)
+{
+	this->states = states;
+}
+
+ImmediatePassRecorder::~ImmediatePassRecorder()
+{
+}
+
+void ImmediatePassRecorder::Record(unsigned int pass, PassBody body)
+{
+	if (pass >= passes.size()) {
+		passes.resize(pass + 1);
+	}
+	passes[pass] = std::move(body);
+}
+
+void ImmediatePassRecorder::Submit()
+{
+	StateCache::Scope scope(states);
+	for (PassBody& body : passes) {
+		if (body) {
+			body(states);
+			body = nullptr;
+		}
+	}
+}
+
+NullPassRecorder::NullPassRecorder(bool keepCommands)
+{
+	backend = std::make_shared<NullRenderContext>(keepCommands);
+	states = std::make_unique<StateCache>(backend);
+}
+
+NullPassRecorder::~NullPassRecorder()
+{
+}
+
+void NullPassRecorder::Record(unsigned int pass, PassBody body)
+{
+	if (pass >= passes.size()) {
+		passes.resize(pass + 1);
+	}
+	passes[pass] = std::move(body);
+}
+
+// --------------------------------------------------------
+// Everything on this thread goes through our filter to the
+// null backend while the passes run
+// --------------------------------------------------------
+void NullPassRecorder::Submit()
+{
+	StateCache::Scope scope(states.get());
+	backend->Reset();
+	states->ResetStats();
+	states->Invalidate();
+
+	for (PassBody& body : passes) {
+		if (body) {
+			body(states.get());
+			body = nullptr;
+		}
+	}
+}
+
+void NullPassRecorder::AddStats(StateCache::Stats& stats)
+{
+	StateCache::Accumulate(stats, states->GetStats());
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "StateCache.h"
+#include "NullRenderContext.h"
+
+// --------------------------------------------------------
+// Builds a frame out of a fixed set of passes and submits
+// them to the GPU in pass order, no matter what order they
+// finished recording in.
+//
+// A pass body is handed the state filter to record with, and
+// while it runs StateCache::Current() (which Mesh, Sky and
+// SimpleShader use) points at the same one.  Bodies only
+// talk to the backend through it, so the same passes can be
+// recorded for D3D11 or the null backend.  Bodies can't rely
+// on state left behind by an earlier pass: recorded on a
+// deferred context, every pass starts from the defaults.
+//
+// Nothing in the interface needs a device, so a mock that
+// only logs Record and Submit calls is enough to check the
+// order passes reach the GPU in.  The D3D11 deferred context
+// recorder is in DeferredPassRecorder.h.
+// --------------------------------------------------------
+class PassRecorder
+{
+public:
+
+	typedef std::function<void(StateCache* states)> PassBody;
+
+	virtual ~PassRecorder() {}
+
+	// pass is the submission slot, lowest first, each used once a frame
+	virtual void Record(unsigned int pass, PassBody body) = 0;
+
+	// Issues everything recorded since the last Submit to the immediate
+	// context in slot order.  Leaves the immediate context's state
+	// undefined, so re-bind anything needed afterwards
+	virtual void Submit() = 0;
+
+	// Adds the counters of any state filters the recorder owns
+	virtual void AddStats(StateCache::Stats&) {}
+};
+
+// --------------------------------------------------------
+// Everything goes straight to the immediate context: passes
+// are held until Submit and then run in slot order on the
+// calling thread
+// --------------------------------------------------------
+class ImmediatePassRecorder : public PassRecorder
+{
+public:
+
+	ImmediatePassRecorder(StateCache* states);
+	~ImmediatePassRecorder();
+	ImmediatePassRecorder(const ImmediatePassRecorder&) = delete; // Remove copy constructor
+	ImmediatePassRecorder& operator=(const ImmediatePassRecorder&) = delete; // Remove copy-assignment operator
+
+	void Record(unsigned int pass, PassBody body) override;
+	void Submit() override;
+
+private:
+
+	StateCache* states;
+	std::vector<PassBody> passes;
+};
+
+// --------------------------------------------------------
+// Passes run in slot order on the calling thread, like the
+// immediate recorder, but into a NullRenderContext: the
+// whole CPU side of a frame happens and nothing reaches the
+// GPU.  Its counters cover the last Submit, as do the
+// commands when it keeps them
+// --------------------------------------------------------
+class NullPassRecorder : public PassRecorder
+{
+public:
+
+	NullPassRecorder(bool keepCommands = false);
+	~NullPassRecorder();
+	NullPassRecorder(const NullPassRecorder&) = delete; // Remove copy constructor
+	NullPassRecorder& operator=(const NullPassRecorder&) = delete; // Remove copy-assignment operator
+
+	void Record(unsigned int pass, PassBody body) override;
+	void Submit() override;
+	void AddStats(StateCache::Stats& stats) override;
+
+	const NullRenderContext::Totals& GetTotals() { return backend->GetTotals(); }
+	const std::vector<NullRenderContext::Command>& GetCommands() { return backend->GetCommands(); }
+
+private:
+
+	std::shared_ptr<NullRenderContext> backend;
+	std::unique_ptr<StateCache> states;
+	std::vector<PassBody> passes;
+};
@@ -0,0 +1,36 @@
+#include "PassScheduler.h"
+
+PassScheduler::PassScheduler(unsigned int passCount, JobSystem* jobs)
+{
+	this->jobs = jobs;
+	recording = 0;
+	recorded.resize(passCount, 0);
+}
+
+PassScheduler::~PassScheduler()
+{
+	Wait();
+}
+
+void PassScheduler::Record(unsigned int pass, std::function<void()> job)
+{
+	recorded[pass] = 1;
+	jobs->Run(std::move(job), &recording);
+}
+
+void PassScheduler::Submit(const std::function<void(unsigned int)>& submit)
+{
+	Wait();
+
+	for (unsigned int pass = 0; pass < recorded.size(); ++pass) {
+		if (recorded[pass]) {
+			submit(pass);
+			recorded[pass] = 0;
+		}
+	}
+}
+
+void PassScheduler::Wait()
+{
+	jobs->Wait(&recording);
+}
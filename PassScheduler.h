@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// The device-free half of recording passes side by side:
+// each pass is a job on the job system, and Submit hands
+// the passes back one at a time in slot order, no matter
+// what order their jobs finished in.
+//
+// DeferredPassRecorder records into command lists with it;
+// it needs nothing from D3D, so the ordering can be tested
+// with a recorder that only logs
+// --------------------------------------------------------
+class PassScheduler
+{
+public:
+
+	PassScheduler(unsigned int passCount, JobSystem* jobs);
+	~PassScheduler();
+	PassScheduler(const PassScheduler&) = delete; // Remove copy constructor
+	PassScheduler& operator=(const PassScheduler&) = delete; // Remove copy-assignment operator
+
+	// Queues the recording job for a slot, each used once a frame
+	void Record(unsigned int pass, std::function<void()> job);
+
+	// Waits for every queued job, then calls submit(pass) for each slot
+	// recorded since the last Submit, lowest first, on this thread
+	void Submit(const std::function<void(unsigned int)>& submit);
+
+	// Returns once no job is still recording
+	void Wait();
+
+private:
+
+	JobSystem* jobs;
+	JobSystem::Counter recording;
+	std::vector<char> recorded; // per slot, since the last Submit
+};
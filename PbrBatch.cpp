@@ -0,0 +1,201 @@
+#include "PbrBatch.h"
+
+#include <algorithm>
+
+using PbrLighting::Vec3;
+
+namespace PbrBatch
+{
+	namespace
+	{
+		Float8 DiffusePBR(const Vec3x8& normal, const Vec3x8& dirToLight)
+		{
+			return Saturate(Dot(normal, dirToLight));
+		}
+
+		Vec3x8 DiffuseEnergyConserve(Float8 diffuse, const Vec3x8& F, Float8 metalness)
+		{
+			Float8 one = Splat(1.0f);
+			Float8 scale = diffuse * (one - metalness);
+			return Vec3x8{ (one - F.x) * scale, (one - F.y) * scale, (one - F.z) * scale };
+		}
+
+		// x^5 by multiplying, std::pow(x, 5) in the scalar version
+		Float8 Pow5(Float8 x)
+		{
+			Float8 x2 = x * x;
+			return x2 * x2 * x;
+		}
+
+		// What every light does once it knows its direction and scale
+		Vec3x8 LightSurface(const Light& light, const Samples& samples, const Vec3x8& V, const Vec3x8& toLight)
+		{
+			Float8 diff = DiffusePBR(samples.normal, toLight);
+			Vec3x8 fresnel;
+			Vec3x8 spec = MicrofacetBRDF(samples.normal, toLight, V, samples.roughness, samples.albedo, fresnel);
+
+			Vec3x8 balancedDiff = DiffuseEnergyConserve(diff, fresnel, samples.metalness);
+			Vec3x8 radiance = Splat(PbrLighting::ToVec3(light.Color)) * Splat(light.Intensity);
+			return (balancedDiff * samples.albedo + spec) * radiance;
+		}
+
+		void LoadBatch(const float* const* arrays, unsigned int first, Vec3x8& out)
+		{
+			out = Vec3x8{ Load(arrays[0] + first), Load(arrays[1] + first), Load(arrays[2] + first) };
+		}
+	}
+}
+
+PbrBatch::Float8 PbrBatch::D_GGX(const Vec3x8& n, const Vec3x8& h, Float8 roughness)
+{
+	Float8 NdotH = Saturate(Dot(n, h));
+	Float8 NdotH2 = NdotH * NdotH;
+	Float8 a = roughness * roughness;
+	Float8 a2 = Max(a * a, Splat(PbrLighting::MIN_ROUGHNESS));
+
+	Float8 denomToSquare = NdotH2 * (a2 - Splat(1.0f)) + Splat(1.0f);
+	return a2 / (Splat(PbrLighting::PI) * denomToSquare * denomToSquare);
+}
+
+PbrBatch::Vec3x8 PbrBatch::F_Schlick(const Vec3x8& v, const Vec3x8& h, const Vec3x8& f0)
+{
+	Float8 VdotH = Saturate(Dot(v, h));
+	Float8 t = Pow5(Splat(1.0f) - VdotH);
+	Float8 one = Splat(1.0f);
+	return Vec3x8{ f0.x + (one - f0.x) * t, f0.y + (one - f0.y) * t, f0.z + (one - f0.z) * t };
+}
+
+PbrBatch::Float8 PbrBatch::G_SchlickGGX(const Vec3x8& n, const Vec3x8& v, Float8 roughness)
+{
+	Float8 r1 = roughness + Splat(1.0f);
+	Float8 k = r1 * r1 / Splat(8.0f);
+	Float8 NdotV = Saturate(Dot(n, v));
+	return Splat(1.0f) / (NdotV * (Splat(1.0f) - k) + k);
+}
+
+PbrBatch::Vec3x8 PbrBatch::MicrofacetBRDF(const Vec3x8& n, const Vec3x8& l, const Vec3x8& v, Float8 roughness, const Vec3x8& f0, Vec3x8& F_out)
+{
+	Vec3x8 h = Normalize(v + l);
+
+	Float8 D = D_GGX(n, h, roughness);
+	Vec3x8 F = F_Schlick(v, h, f0);
+	Float8 G = G_SchlickGGX(n, v, roughness) * G_SchlickGGX(n, l, roughness);
+
+	F_out = F;
+	return F * (D * G / Splat(4.0f) * Max(Dot(n, l), Splat(0.0f)));
+}
+
+PbrBatch::Float8 PbrBatch::PointAttenuate(const Light& light, const Vec3x8& worldPos)
+{
+	Vec3x8 offset = Splat(PbrLighting::ToVec3(light.Position)) - worldPos;
+	Float8 dist = Sqrt(Dot(offset, offset));
+	Float8 att = Saturate(Splat(1.0f) - dist * dist / Splat(light.Range * light.Range));
+	return att * att;
+}
+
+PbrBatch::Float8 PbrBatch::SpotAttenuate(const Light& light, const Vec3x8& worldPos)
+{
+	Float8 pixelAngle = Saturate(Dot(worldPos - Splat(PbrLighting::ToVec3(light.Position)), Splat(PbrLighting::ToVec3(light.Direction))));
+
+	//the same for every lane, so worked out once
+	float cosOuter = std::cos(light.SpotOuterAngle);
+	float cosInner = std::cos(light.SpotInnerAngle);
+	float falloffRange = cosOuter - cosInner;
+
+	Float8 spotTerm = Saturate((Splat(cosOuter) - pixelAngle) / Splat(falloffRange));
+	return spotTerm * PointAttenuate(light, worldPos);
+}
+
+PbrBatch::Vec3x8 PbrBatch::DirectionalLight(const Light& light, const Samples& samples, const Vec3x8& V)
+{
+	return LightSurface(light, samples, V, Splat(PbrLighting::ToVec3(light.Direction)));
+}
+
+PbrBatch::Vec3x8 PbrBatch::PointLight(const Light& light, const Samples& samples, const Vec3x8& V)
+{
+	Vec3x8 toLight = Splat(PbrLighting::ToVec3(light.Position)) - samples.position;
+	return LightSurface(light, samples, V, toLight) * PointAttenuate(light, samples.position);
+}
+
+PbrBatch::Vec3x8 PbrBatch::SpotLight(const Light& light, const Samples& samples, const Vec3x8& V)
+{
+	return LightSurface(light, samples, V, Splat(PbrLighting::ToVec3(light.Direction))) * SpotAttenuate(light, samples.position);
+}
+
+PbrBatch::Vec3x8 PbrBatch::Shade(const Samples& samples, Vec3 cameraPos, const Light* lights, unsigned int lightCount)
+{
+	Vec3x8 V = Normalize(Splat(cameraPos) - samples.position);
+	Vec3x8 c = Splat(Vec3{ 0, 0, 0 });
+
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		switch (lights[i].Type) {
+		case LIGHT_TYPE_DIRECTIONAL:
+			c = c + (i == 0 ? DirectionalLight(lights[i], samples, V) * samples.shadow : DirectionalLight(lights[i], samples, V));
+			break;
+		case LIGHT_TYPE_POINT:
+			c = c + PointLight(lights[i], samples, V);
+			break;
+		case LIGHT_TYPE_SPOT:
+			c = c + SpotLight(lights[i], samples, V);
+			break;
+		}
+	}
+	return c;
+}
+
+void PbrBatch::ShadeStream(const SampleStream& stream, Vec3 cameraPos, const Light* lights, unsigned int lightCount)
+{
+	unsigned int whole = stream.count - stream.count % WIDTH;
+	Samples samples;
+	for (unsigned int first = 0; first < whole; first += WIDTH) {
+		LoadBatch(stream.normal, first, samples.normal);
+		LoadBatch(stream.position, first, samples.position);
+		LoadBatch(stream.albedo, first, samples.albedo);
+		samples.roughness = Load(stream.roughness + first);
+		samples.metalness = Load(stream.metalness + first);
+		samples.shadow = stream.shadow ? Load(stream.shadow + first) : Splat(1.0f);
+
+		Vec3x8 color = Shade(samples, cameraPos, lights, lightCount);
+		Store(stream.color[0] + first, color.x);
+		Store(stream.color[1] + first, color.y);
+		Store(stream.color[2] + first, color.z);
+	}
+
+	if (whole == stream.count) {
+		return;
+	}
+
+	//copy the rest into a full batch, padded with harmless samples
+	float tail[12][WIDTH];
+	for (int a = 0; a < 12; ++a) {
+		std::fill(tail[a], tail[a] + WIDTH, a == 2 ? 1.0f : 0.0f); //padding normals point along z
+	}
+	const float* sources[12] = {
+		stream.normal[0], stream.normal[1], stream.normal[2],
+		stream.position[0], stream.position[1], stream.position[2],
+		stream.albedo[0], stream.albedo[1], stream.albedo[2],
+		stream.roughness, stream.metalness, stream.shadow };
+	for (int a = 0; a < 12; ++a) {
+		for (unsigned int i = whole; i < stream.count; ++i) {
+			tail[a][i - whole] = sources[a] ? sources[a][i] : 1.0f;
+		}
+	}
+
+	samples.normal = Vec3x8{ Load(tail[0]), Load(tail[1]), Load(tail[2]) };
+	samples.position = Vec3x8{ Load(tail[3]), Load(tail[4]), Load(tail[5]) };
+	samples.albedo = Vec3x8{ Load(tail[6]), Load(tail[7]), Load(tail[8]) };
+	samples.roughness = Load(tail[9]);
+	samples.metalness = Load(tail[10]);
+	samples.shadow = Load(tail[11]);
+
+	Vec3x8 color = Shade(samples, cameraPos, lights, lightCount);
+	float out[3][WIDTH];
+	Store(out[0], color.x);
+	Store(out[1], color.y);
+	Store(out[2], color.z);
+	for (unsigned int i = whole; i < stream.count; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			stream.color[c][i] = out[c][i - whole];
+		}
+	}
+}
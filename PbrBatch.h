@@ -0,0 +1,124 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include "PbrLighting.h"
+
+// --------------------------------------------------------
+// PbrLighting, eight samples at a time.  Samples are held as
+// structures of arrays, one lane per sample, and every light
+// is applied to all eight at once, so the light loop has no
+// branches per sample.  For baking lighting on the CPU
+// (lightmaps, probes) and for the software rasterizer's
+// shading.
+//
+// Same math as the scalar port, which stays the reference:
+// Benchmarks::BatchLighting and BatchLightingTests check the
+// two agree within SCALAR_TOLERANCE.  Float8 is one AVX
+// register when the build targets AVX (/arch:AVX2) and a
+// pair of SSE registers otherwise, which every x64 CPU has
+// --------------------------------------------------------
+namespace PbrBatch
+{
+	const unsigned int WIDTH = 8;
+
+	// Largest difference from the scalar port either path may have,
+	// relative to the scalar result (or to 0.01 below that)
+	const float SCALAR_TOLERANCE = 1e-3f;
+
+	struct Float8
+	{
+#if defined(__AVX__)
+		__m256 v;
+#else
+		__m128 lo;
+		__m128 hi;
+#endif
+	};
+
+#if defined(__AVX__)
+	inline Float8 Splat(float s) { return Float8{ _mm256_set1_ps(s) }; }
+	inline Float8 Load(const float* p) { return Float8{ _mm256_loadu_ps(p) }; }
+	inline void Store(float* p, Float8 a) { _mm256_storeu_ps(p, a.v); }
+	inline Float8 operator+(Float8 a, Float8 b) { return Float8{ _mm256_add_ps(a.v, b.v) }; }
+	inline Float8 operator-(Float8 a, Float8 b) { return Float8{ _mm256_sub_ps(a.v, b.v) }; }
+	inline Float8 operator*(Float8 a, Float8 b) { return Float8{ _mm256_mul_ps(a.v, b.v) }; }
+	inline Float8 operator/(Float8 a, Float8 b) { return Float8{ _mm256_div_ps(a.v, b.v) }; }
+	inline Float8 Min(Float8 a, Float8 b) { return Float8{ _mm256_min_ps(a.v, b.v) }; }
+	inline Float8 Max(Float8 a, Float8 b) { return Float8{ _mm256_max_ps(a.v, b.v) }; }
+	inline Float8 Sqrt(Float8 a) { return Float8{ _mm256_sqrt_ps(a.v) }; }
+#else
+	inline Float8 Splat(float s) { return Float8{ _mm_set1_ps(s), _mm_set1_ps(s) }; }
+	inline Float8 Load(const float* p) { return Float8{ _mm_loadu_ps(p), _mm_loadu_ps(p + 4) }; }
+	inline void Store(float* p, Float8 a) { _mm_storeu_ps(p, a.lo); _mm_storeu_ps(p + 4, a.hi); }
+	inline Float8 operator+(Float8 a, Float8 b) { return Float8{ _mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi) }; }
+	inline Float8 operator-(Float8 a, Float8 b) { return Float8{ _mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi) }; }
+	inline Float8 operator*(Float8 a, Float8 b) { return Float8{ _mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi) }; }
+	inline Float8 operator/(Float8 a, Float8 b) { return Float8{ _mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi) }; }
+	inline Float8 Min(Float8 a, Float8 b) { return Float8{ _mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi) }; }
+	inline Float8 Max(Float8 a, Float8 b) { return Float8{ _mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi) }; }
+	inline Float8 Sqrt(Float8 a) { return Float8{ _mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi) }; }
+#endif
+
+	//min/max return the second operand for NaN, so a NaN saturates to 0 like HLSL
+	inline Float8 Saturate(Float8 a) { return Min(Max(a, Splat(0.0f)), Splat(1.0f)); }
+
+	struct Vec3x8
+	{
+		Float8 x, y, z;
+	};
+
+	inline Vec3x8 Splat(PbrLighting::Vec3 v) { return Vec3x8{ Splat(v.x), Splat(v.y), Splat(v.z) }; }
+	inline Vec3x8 operator+(const Vec3x8& a, const Vec3x8& b) { return Vec3x8{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3x8 operator-(const Vec3x8& a, const Vec3x8& b) { return Vec3x8{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3x8 operator*(const Vec3x8& a, const Vec3x8& b) { return Vec3x8{ a.x * b.x, a.y * b.y, a.z * b.z }; }
+	inline Vec3x8 operator*(const Vec3x8& a, Float8 s) { return Vec3x8{ a.x * s, a.y * s, a.z * s }; }
+	inline Float8 Dot(const Vec3x8& a, const Vec3x8& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	//divides like the scalar version: at low roughness D_GGX turns a reciprocal's rounding into visible error
+	inline Vec3x8 Normalize(const Vec3x8& v) { Float8 length = Sqrt(Dot(v, v)); return Vec3x8{ v.x / length, v.y / length, v.z / length }; }
+
+	// Eight samples' inputs to the light loop, lane i is sample i
+	struct Samples
+	{
+		Vec3x8 normal; // normalized
+		Vec3x8 position; // world space
+		Vec3x8 albedo; // linear
+		Float8 roughness;
+		Float8 metalness;
+		Float8 shadow; // scales lights[0] when it's directional
+	};
+
+	// Microfacet terms
+	Float8 D_GGX(const Vec3x8& n, const Vec3x8& h, Float8 roughness);
+	Vec3x8 F_Schlick(const Vec3x8& v, const Vec3x8& h, const Vec3x8& f0);
+	Float8 G_SchlickGGX(const Vec3x8& n, const Vec3x8& v, Float8 roughness);
+	Vec3x8 MicrofacetBRDF(const Vec3x8& n, const Vec3x8& l, const Vec3x8& v, Float8 roughness, const Vec3x8& f0, Vec3x8& F_out);
+
+	Float8 PointAttenuate(const Light& light, const Vec3x8& worldPos);
+	Float8 SpotAttenuate(const Light& light, const Vec3x8& worldPos);
+
+	// One light's contribution
+	Vec3x8 DirectionalLight(const Light& light, const Samples& samples, const Vec3x8& V);
+	Vec3x8 PointLight(const Light& light, const Samples& samples, const Vec3x8& V);
+	Vec3x8 SpotLight(const Light& light, const Samples& samples, const Vec3x8& V);
+
+	// PbrLighting::Shade for eight samples: linear color, before gamma
+	Vec3x8 Shade(const Samples& samples, PbrLighting::Vec3 cameraPos, const Light* lights, unsigned int lightCount);
+
+	// Any number of samples as separate arrays per component (x, y, z).
+	// Whole batches are read straight from the arrays, the last partial
+	// one is padded
+	struct SampleStream
+	{
+		unsigned int count;
+		const float* normal[3];
+		const float* position[3];
+		const float* albedo[3];
+		const float* roughness;
+		const float* metalness;
+		const float* shadow; // may be null for no shadowing
+		float* color[3]; // written
+	};
+
+	void ShadeStream(const SampleStream& stream, PbrLighting::Vec3 cameraPos, const Light* lights, unsigned int lightCount);
+}
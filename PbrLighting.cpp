@@ -0,0 +1,132 @@
+#include "PbrLighting.h"
+
+namespace PbrLighting
+{
+	namespace
+	{
+		float DiffusePBR(Vec3 normal, Vec3 dirToLight)
+		{
+			return Saturate(Dot(normal, dirToLight));
+		}
+
+		Vec3 DiffuseEnergyConserve(float diffuse, Vec3 F, float metalness)
+		{
+			return (1 - F) * (diffuse * (1 - metalness));
+		}
+	}
+}
+
+float PbrLighting::D_GGX(Vec3 n, Vec3 h, float roughness)
+{
+	float NdotH = Saturate(Dot(n, h));
+	float NdotH2 = NdotH * NdotH;
+	float a = roughness * roughness;
+	float a2 = std::fmax(a * a, MIN_ROUGHNESS); //applied after remap, as in the shader
+
+	float denomToSquare = NdotH2 * (a2 - 1) + 1;
+	return a2 / (PI * denomToSquare * denomToSquare);
+}
+
+PbrLighting::Vec3 PbrLighting::F_Schlick(Vec3 v, Vec3 h, Vec3 f0)
+{
+	float VdotH = Saturate(Dot(v, h));
+	return f0 + (1 - f0) * std::pow(1 - VdotH, 5.0f);
+}
+
+float PbrLighting::G_SchlickGGX(Vec3 n, Vec3 v, float roughness)
+{
+	float k = std::pow(roughness + 1, 2.0f) / 8.0f;
+	float NdotV = Saturate(Dot(n, v));
+
+	//NdotV is left out of the numerator, and the BRDF's denominator
+	return 1 / (NdotV * (1 - k) + k);
+}
+
+PbrLighting::Vec3 PbrLighting::MicrofacetBRDF(Vec3 n, Vec3 l, Vec3 v, float roughness, Vec3 f0, Vec3& F_out)
+{
+	Vec3 h = Normalize(v + l);
+
+	float D = D_GGX(n, h, roughness);
+	Vec3 F = F_Schlick(v, h, f0);
+	float G = G_SchlickGGX(n, v, roughness) * G_SchlickGGX(n, l, roughness);
+
+	F_out = F;
+
+	Vec3 specularResult = F * (D * G / 4);
+	return specularResult * std::fmax(Dot(n, l), 0.0f);
+}
+
+float PbrLighting::PointAttenuate(const Light& light, Vec3 worldPos)
+{
+	float dist = Distance(ToVec3(light.Position), worldPos);
+	float att = Saturate(1.0f - (dist * dist / (light.Range * light.Range)));
+	return att * att;
+}
+
+float PbrLighting::SpotAttenuate(const Light& light, Vec3 worldPos)
+{
+	float pixelAngle = Saturate(Dot(worldPos - ToVec3(light.Position), ToVec3(light.Direction)));
+
+	float cosOuter = std::cos(light.SpotOuterAngle);
+	float cosInner = std::cos(light.SpotInnerAngle);
+	float falloffRange = cosOuter - cosInner;
+
+	float spotTerm = Saturate((cosOuter - pixelAngle) / falloffRange);
+	return spotTerm * PointAttenuate(light, worldPos);
+}
+
+PbrLighting::Vec3 PbrLighting::DirectionalLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, float roughness, float metalness)
+{
+	Vec3 direction = ToVec3(light.Direction);
+	float diff = DiffusePBR(normal, direction);
+	Vec3 fresnel;
+	Vec3 spec = MicrofacetBRDF(normal, direction, V, roughness, surface, fresnel);
+
+	Vec3 balancedDiff = DiffuseEnergyConserve(diff, fresnel, metalness);
+	return (balancedDiff * surface + spec) * ToVec3(light.Color) * light.Intensity;
+}
+
+PbrLighting::Vec3 PbrLighting::PointLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, Vec3 samplePos, float roughness, float metalness)
+{
+	Vec3 toLight = ToVec3(light.Position) - samplePos;
+	float diff = DiffusePBR(normal, toLight);
+	Vec3 fresnel;
+	Vec3 spec = MicrofacetBRDF(normal, toLight, V, roughness, surface, fresnel);
+
+	Vec3 balancedDiff = DiffuseEnergyConserve(diff, fresnel, metalness);
+	Vec3 total = (balancedDiff * surface + spec) * ToVec3(light.Color) * light.Intensity;
+	return total * PointAttenuate(light, samplePos);
+}
+
+PbrLighting::Vec3 PbrLighting::SpotLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, Vec3 samplePos, float roughness, float metalness)
+{
+	Vec3 direction = ToVec3(light.Direction);
+	float diff = DiffusePBR(normal, direction);
+	Vec3 fresnel;
+	Vec3 spec = MicrofacetBRDF(normal, direction, V, roughness, surface, fresnel);
+
+	Vec3 balancedDiff = DiffuseEnergyConserve(diff, fresnel, metalness);
+	Vec3 total = (balancedDiff * surface + spec) * ToVec3(light.Color) * light.Intensity;
+	return total * SpotAttenuate(light, samplePos);
+}
+
+PbrLighting::Vec3 PbrLighting::Shade(Vec3 normal, Vec3 worldPos, Vec3 cameraPos, Vec3 albedo, float roughness, float metalness, float shadow, const Light* lights, unsigned int lightCount)
+{
+	Vec3 V = Normalize(cameraPos - worldPos);
+	Vec3 c = Splat(0);
+
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		switch (lights[i].Type) {
+		case LIGHT_TYPE_DIRECTIONAL:
+			c = c + DirectionalLight(lights[i], normal, albedo, V, roughness, metalness) * (i == 0 ? shadow : 1.0f);
+			break;
+		case LIGHT_TYPE_POINT:
+			c = c + PointLight(lights[i], normal, albedo, V, worldPos, roughness, metalness);
+			break;
+		case LIGHT_TYPE_SPOT:
+			c = c + SpotLight(lights[i], normal, albedo, V, worldPos, roughness, metalness);
+			break;
+		}
+	}
+	return c;
+}
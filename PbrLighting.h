@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cmath>
+
+#include "Lights.h"
+
+// --------------------------------------------------------
+// C++ port of the lighting in ShaderHeaders.hlsli and the
+// light loop in PixelShader.hlsl, one sample at a time.
+//
+// It follows the HLSL line for line, quirks included
+// (directional and spot lights use Direction as the
+// direction to the light, point lights pass an unnormalized
+// one, the BRDF gets the surface color as f0), so what the
+// software rasterizer draws matches what the GPU draws.  Fix
+// a quirk in both places or neither.
+// --------------------------------------------------------
+namespace PbrLighting
+{
+	// Same values as the shader header
+	const float F0_NON_METAL = 0.04f;
+	const float MIN_ROUGHNESS = 0.0000001f;
+	const float PI = 3.14159265359f;
+
+	// Just enough of HLSL's float3 to port the shader code as written
+	struct Vec3
+	{
+		float x, y, z;
+	};
+
+	inline Vec3 operator+(Vec3 a, Vec3 b) { return Vec3{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3 operator-(Vec3 a, Vec3 b) { return Vec3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 operator*(Vec3 a, Vec3 b) { return Vec3{ a.x * b.x, a.y * b.y, a.z * b.z }; }
+	inline Vec3 operator*(Vec3 a, float s) { return Vec3{ a.x * s, a.y * s, a.z * s }; }
+	inline Vec3 operator/(Vec3 a, float s) { return Vec3{ a.x / s, a.y / s, a.z / s }; }
+	inline Vec3 operator-(float s, Vec3 a) { return Vec3{ s - a.x, s - a.y, s - a.z }; }
+	inline Vec3 Splat(float s) { return Vec3{ s, s, s }; }
+	inline Vec3 ToVec3(const DirectX::XMFLOAT3& v) { return Vec3{ v.x, v.y, v.z }; }
+
+	inline float Dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float Saturate(float v) { return v < 0 ? 0 : (v > 1 ? 1 : v); }
+	inline Vec3 Normalize(Vec3 v) { return v / std::sqrt(Dot(v, v)); }
+	inline float Distance(Vec3 a, Vec3 b) { return std::sqrt(Dot(a - b, a - b)); }
+
+	// Microfacet terms
+	float D_GGX(Vec3 n, Vec3 h, float roughness);
+	Vec3 F_Schlick(Vec3 v, Vec3 h, Vec3 f0);
+	float G_SchlickGGX(Vec3 n, Vec3 v, float roughness);
+	Vec3 MicrofacetBRDF(Vec3 n, Vec3 l, Vec3 v, float roughness, Vec3 f0, Vec3& F_out);
+
+	float PointAttenuate(const Light& light, Vec3 worldPos);
+	float SpotAttenuate(const Light& light, Vec3 worldPos);
+
+	// One light's contribution
+	Vec3 DirectionalLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, float roughness, float metalness);
+	Vec3 PointLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, Vec3 samplePos, float roughness, float metalness);
+	Vec3 SpotLight(const Light& light, Vec3 normal, Vec3 surface, Vec3 V, Vec3 samplePos, float roughness, float metalness);
+
+	// The pixel shader's light loop: linear color (before its final
+	// gamma) of a sample with linear albedo.  shadow scales lights[0]
+	// when it's directional, the way the shadow map does
+	Vec3 Shade(Vec3 normal, Vec3 worldPos, Vec3 cameraPos, Vec3 albedo, float roughness, float metalness, float shadow, const Light* lights, unsigned int lightCount);
+}
@@ -5,7 +5,19 @@ Texture2D Albedo : register(t0); // "t" registers for textures
 Texture2D NormalTexture : register(t1); //the normal map for our texture
 Texture2D RoughnessMap : register(t2);
 Texture2D MetalnessMap : register(t3);
-Texture2D ShadowMap : register(t4);
+Texture2DArray ShadowMap : register(t4); //a slice per cascade
+
+//clustered lighting (see LightClusters): every light, each cluster's
+//offset and count in the index list, and the index list itself
+StructuredBuffer<Light> ClusterLights : register(t5);
+StructuredBuffer<uint2> ClusterRanges : register(t6);
+StructuredBuffer<uint> ClusterLightIndices : register(t7);
+
+Texture2D ShadowAtlas : register(t8); //every other shadowed light's tiles (see ShadowAtlas)
+
+//the sky's image based lighting (see SkyLighting)
+TextureCube SpecularIBL : register(t9); //prefiltered, roughness 0 at the top mip to 1 at the last
+Texture2D BrdfLut : register(t10); //F0 scale and bias by (NdotV, roughness)
 
 SamplerState BasicSampler : register(s0); // "s" registers for samplers
 SamplerComparisonState ShadowSampler : register(s1);
@@ -22,6 +34,129 @@ cbuffer ExternalData : register(b0)
     float3 ambient;
     Light lights[MAX_LIGHT_COUNT];
     int lightCount;
+    
+    int clustered; //lights come from the cluster buffers instead of lights[]
+    uint directionalCount; //at the start of ClusterLightIndices
+    float2 clusterScale;
+    float4 clusterDepthPlane;
+    float clusterSliceNear;
+    float clusterSliceScale;
+    
+    int objectLights; //only this draw's objectLightIndices of lights[] (see ObjectLights)
+    int objectLightCount;
+    uint4 objectLightIndices[MAX_OBJECT_LIGHTS / 4]; //packed four to a register
+    
+    matrix shadowViewProjections[SHADOW_CASCADE_COUNT]; //see ShadowCascades
+    float4 shadowSplits; //far end of each cascade in view space depth
+    float4 shadowDepthPlane; //view space depth is dot(float4(worldPos, 1), shadowDepthPlane)
+    
+    matrix shadowTileMatrices[MAX_SHADOW_TILES]; //Light.ShadowTile indexes these
+    float4 shadowTileRects[MAX_SHADOW_TILES]; //atlas UV offset, UV scale, half a texel in UV
+    
+    int skyLighting; //ambient from the sky instead of nothing
+    float specularMipCount;
+    float4 irradianceSH[9];
+}
+
+// How much of the shadowed light reaches a point, from the cascade its view depth falls in
+float ShadowAmount(float3 worldPos)
+{
+    float depth = dot(float4(worldPos, 1), shadowDepthPlane);
+    if (depth > shadowSplits[SHADOW_CASCADE_COUNT - 1])
+    {
+        return 1.0f; //past the shadow distance
+    }
+    uint cascade = 0;
+    [unroll]
+    for (uint i = 0; i < SHADOW_CASCADE_COUNT - 1; ++i)
+    {
+        cascade += depth > shadowSplits[i];
+    }
+    
+    float4 shadowPos = mul(shadowViewProjections[cascade], float4(worldPos, 1));
+    //convert to UVs for sample
+    float2 shadowUV = shadowPos.xy * 0.5f + 0.5f;
+    shadowUV.y = 1 - shadowUV.y; //flip y
+    //clamped like the casters, which the shadow rasterizer doesn't depth clip
+    float distToLight = saturate(shadowPos.z);
+    return ShadowMap.SampleCmpLevelZero(ShadowSampler, float3(shadowUV, cascade), distToLight).r;
+}
+
+// How much of a light with a shadow atlas tile reaches a point.  Point
+// lights have six tiles, one per cube face: +x -x +y -y +z -z
+float AtlasShadowAmount(Light light, float3 worldPos)
+{
+    uint tile = light.ShadowTile;
+    if (light.Type == LIGHT_TYPE_POINT)
+    {
+        float3 toPoint = worldPos - light.Position;
+        float3 axis = abs(toPoint);
+        if (axis.x >= axis.y && axis.x >= axis.z)
+            tile += toPoint.x < 0 ? 1 : 0;
+        else if (axis.y >= axis.z)
+            tile += toPoint.y < 0 ? 3 : 2;
+        else
+            tile += toPoint.z < 0 ? 5 : 4;
+    }
+    
+    float4 shadowPos = mul(shadowTileMatrices[tile], float4(worldPos, 1));
+    if (shadowPos.w <= 0)
+    {
+        return 1.0f; //behind a spot light
+    }
+    shadowPos.xyz /= shadowPos.w;
+    if (any(abs(shadowPos.xy) > 1) || shadowPos.z > 1)
+    {
+        return 1.0f; //outside the tile, nothing there to cast
+    }
+    
+    //into the tile's rect, kept half a texel in so filtering never reads a neighbor
+    float4 rect = shadowTileRects[tile];
+    float2 shadowUV = shadowPos.xy * 0.5f + 0.5f;
+    shadowUV.y = 1 - shadowUV.y; //flip y
+    shadowUV = clamp(rect.xy + shadowUV * rect.z, rect.xy + rect.w, rect.xy + rect.z - rect.w);
+    return ShadowAtlas.SampleCmpLevelZero(ShadowSampler, shadowUV, saturate(shadowPos.z)).r;
+}
+
+// One light's contribution.  The first light in the scene gets the
+// cascaded shadow map, the others their shadow atlas tiles if they have any
+float3 ShadeLight(Light light, uint index, float3 normal, float3 surface, float3 V, float3 worldPos, float3 specularColor, float roughness, float metalness, float shadowAmount)
+{
+    float shadow = 1.0f;
+    if (index == 0 && light.Type == LIGHT_TYPE_DIRECTIONAL)
+    {
+        shadow = shadowAmount;
+    }
+    else if (light.ShadowTile >= 0)
+    {
+        shadow = AtlasShadowAmount(light, worldPos);
+    }
+    
+    switch (light.Type) {
+    case LIGHT_TYPE_DIRECTIONAL:
+        return DirectionalLight(light, normal, surface, V, specularColor, roughness, metalness) * shadow;
+    case LIGHT_TYPE_POINT:
+        return PointLight(light, normal, surface, V, worldPos, specularColor, roughness, metalness) * shadow;
+    case LIGHT_TYPE_SPOT:
+        return SpotLight(light, normal, surface, V, worldPos, specularColor, roughness, metalness) * shadow;
+    }
+    return float3(0, 0, 0);
+}
+
+// Light from the sky itself: diffuse from the irradiance harmonics,
+// specular from the prefiltered cube and the BRDF table (split sum)
+float3 SkyAmbient(float3 normal, float3 surface, float3 V, float3 specularColor, float roughness, float metalness)
+{
+    float NdotV = saturate(dot(normal, V));
+    float3 F = F_SchlickRoughness(NdotV, specularColor, roughness);
+    float3 diffuse = DiffuseEnergyConserve(EvaluateSH9(irradianceSH, normal) * surface, F, metalness);
+    
+    float3 R = reflect(-V, normal);
+    float3 prefiltered = SpecularIBL.SampleLevel(BasicSampler, R, roughness * (specularMipCount - 1)).rgb;
+    float2 lutUV = clamp(float2(NdotV, roughness), 0.5f / BRDF_LUT_SIZE, 1 - 0.5f / BRDF_LUT_SIZE); //BasicSampler wraps
+    float2 brdf = BrdfLut.SampleLevel(BasicSampler, lutUV, 0).rg;
+    
+    return diffuse + prefiltered * (specularColor * brdf.x + brdf.y);
 }
 
 // --------------------------------------------------------
@@ -35,18 +170,7 @@ cbuffer ExternalData : register(b0)
 // --------------------------------------------------------
 float4 main(VertexToPixel input) : SV_TARGET
 {
-    input.shadowMapPos /= input.shadowMapPos.w;
-    //convert to UVs for sample
-    float2 shadowUV = input.shadowMapPos.xy * 0.5f + 0.5f;
-    shadowUV.y = 1 - shadowUV.y; //flip y
-    //distance to light - depth buffer grabbing
-    float distToLight = input.shadowMapPos.z;
-    float distShadowMap = ShadowMap.Sample(BasicSampler, shadowUV).r;
-    float shadowAmount = ShadowMap.SampleCmpLevelZero(ShadowSampler, shadowUV, 
-       distToLight/*-.015f Subtracting this "raises" the floor that counts as "1"*/).r;
-    
-    //return float4(shadowAmount, distToLight, distShadowMap, 1);
-    //return float4(distToLight, distShadowMap, 0, 1);
+    float shadowAmount = ShadowAmount(input.worldPosition);
     
     float2 adjustedUv = input.uv * uvScale + uvOffset;
     
@@ -78,27 +202,42 @@ float4 main(VertexToPixel input) : SV_TARGET
 
     float3 c = float3(0, 0, 0);
 
-    for (int i = 0; i < lightCount; ++i) {
-        switch (lights[i].Type) {
-        case LIGHT_TYPE_DIRECTIONAL:
-                if (i == 0)
-                {
-                    c += DirectionalLight(lights[i], input.normal, (float3) sampleColor, V, specularColor, roughness, metalness) *shadowAmount;// step(distToLight, distShadowMap);
-                }
-                else
-                {
-                    c += DirectionalLight(lights[i], input.normal, (float3) sampleColor, V, specularColor, roughness, metalness);
-                }
-
-            break;
-        case LIGHT_TYPE_POINT:
-                c += PointLight(lights[i], input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness);
-            break;
-        case LIGHT_TYPE_SPOT:
-                c += SpotLight(lights[i], input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness);
-            break;
-        } 
-
+    if (clustered)
+    {
+        //directional lights reach every pixel, the rest only the clusters in their range
+        for (uint d = 0; d < directionalCount; ++d)
+        {
+            uint index = ClusterLightIndices[d];
+            c += ShadeLight(ClusterLights[index], index, input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness, shadowAmount);
+        }
+        
+        uint cluster = ClusterIndex(input.screenPosition.xy, input.worldPosition, clusterScale, clusterDepthPlane, clusterSliceNear, clusterSliceScale);
+        uint2 range = ClusterRanges[cluster];
+        for (uint j = 0; j < range.y; ++j)
+        {
+            uint index = ClusterLightIndices[range.x + j];
+            c += ShadeLight(ClusterLights[index], index, input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness, shadowAmount);
+        }
+    }
+    else if (objectLights)
+    {
+        for (int k = 0; k < objectLightCount; ++k)
+        {
+            uint index = objectLightIndices[k >> 2][k & 3];
+            c += ShadeLight(lights[index], index, input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness, shadowAmount);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < lightCount; ++i)
+        {
+            c += ShadeLight(lights[i], i, input.normal, (float3) sampleColor, V, input.worldPosition, specularColor, roughness, metalness, shadowAmount);
+        }
+    }
+    
+    if (skyLighting)
+    {
+        c += SkyAmbient(normalize(input.normal), (float3) sampleColor, V, specularColor, roughness, metalness);
     }
     
     float3 totalColor = c;
@@ -0,0 +1,549 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "ImGui/imgui.h"
+
+namespace
+{
+	// A ring entry can be overwritten by its thread while the UI copies
+	// it, so each field is atomic (plain moves on x64, relaxed is enough)
+	struct StoredEvent
+	{
+		std::atomic<const char*> name;
+		std::atomic<long long> start;
+		std::atomic<long long> end;
+		std::atomic<unsigned int> depth;
+		std::atomic<Profiler::EventKind> kind;
+		std::atomic<long long> value;
+	};
+
+	struct ThreadLog
+	{
+		std::string name; // guarded by logsLock
+		unsigned int id = 0;
+		unsigned int depth = 0; // owning thread only
+		std::unique_ptr<StoredEvent[]> events;
+		std::atomic<unsigned long long> head = 0; // events finished
+		std::atomic<unsigned long long> writing = 0; // event being written
+	};
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::atomic<bool> enabled = true;
+
+	//logs are never freed, so a Capture can't lose one from under it
+	std::mutex logsLock;
+	std::vector<std::unique_ptr<ThreadLog>> logs;
+	thread_local ThreadLog* currentLog = nullptr;
+
+	//only the main thread writes these
+	std::atomic<long long> frameStarts[Profiler::FRAME_HISTORY];
+	std::atomic<unsigned long long> frameCount = 0;
+
+	// Only the main thread touches the trace
+	struct Trace
+	{
+		bool running = false;
+		bool started = false; // reached the first frame boundary
+		unsigned int frameCount = 0;
+		std::string path;
+		std::vector<long long> frames; // starts of the traced frames, and the end of the last
+		std::vector<std::pair<unsigned int, Profiler::Event>> events; // thread id, event
+		std::vector<unsigned long long> cursors; // next ring index to drain, by thread id
+		unsigned long long dropped = 0;
+		std::string status;
+	};
+	Trace trace;
+
+	ThreadLog* CurrentLog()
+	{
+		if (currentLog == nullptr) {
+			std::unique_ptr<ThreadLog> log = std::make_unique<ThreadLog>();
+			log->events = std::make_unique<StoredEvent[]>(Profiler::EVENT_CAPACITY);
+
+			std::lock_guard<std::mutex> guard(logsLock);
+			log->id = (unsigned int)logs.size();
+			log->name = std::format("Thread {}", log->id);
+			currentLog = log.get();
+			logs.push_back(std::move(log));
+		}
+		return currentLog;
+	}
+
+	// Appends to the calling thread's ring.  The slot is claimed before
+	// it's touched, see Capture
+	void Write(ThreadLog* log, const Profiler::Event& event)
+	{
+		unsigned long long index = log->head.load(std::memory_order_relaxed);
+		log->writing.store(index, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		StoredEvent& stored = log->events[index & (Profiler::EVENT_CAPACITY - 1)];
+		stored.name.store(event.name, std::memory_order_relaxed);
+		stored.start.store(event.start, std::memory_order_relaxed);
+		stored.end.store(event.end, std::memory_order_relaxed);
+		stored.depth.store(event.depth, std::memory_order_relaxed);
+		stored.kind.store(event.kind, std::memory_order_relaxed);
+		stored.value.store(event.value, std::memory_order_relaxed);
+		log->head.store(index + 1, std::memory_order_release);
+	}
+
+	Profiler::Event Read(const StoredEvent& stored)
+	{
+		Profiler::Event event;
+		event.name = stored.name.load(std::memory_order_relaxed);
+		event.start = stored.start.load(std::memory_order_relaxed);
+		event.end = stored.end.load(std::memory_order_relaxed);
+		event.depth = stored.depth.load(std::memory_order_relaxed);
+		event.kind = stored.kind.load(std::memory_order_relaxed);
+		event.value = stored.value.load(std::memory_order_relaxed);
+		return event;
+	}
+
+	// --------------------------------------------------------
+	// Moves everything recorded since the last drain into the
+	// trace, up to its limit.  As in Capture, whatever a thread
+	// overwrote while it was being copied is thrown away, and a
+	// thread that lapped its ring since the last drain loses the
+	// difference.  Caller holds logsLock
+	// --------------------------------------------------------
+	void DrainTrace()
+	{
+		trace.cursors.resize(logs.size(), 0);
+		for (const std::unique_ptr<ThreadLog>& log : logs) {
+			unsigned long long& cursor = trace.cursors[log->id];
+			unsigned long long head = log->head.load(std::memory_order_acquire);
+			if (head - cursor > Profiler::EVENT_CAPACITY) {
+				trace.dropped += head - Profiler::EVENT_CAPACITY - cursor;
+				cursor = head - Profiler::EVENT_CAPACITY;
+			}
+
+			unsigned long long available = head - cursor;
+			unsigned long long room = Profiler::TRACE_EVENT_LIMIT - trace.events.size();
+			unsigned long long copied = std::min(available, room);
+			size_t first = trace.events.size();
+			for (unsigned long long i = 0; i < copied; ++i) {
+				trace.events.emplace_back(log->id, Read(log->events[(cursor + i) & (Profiler::EVENT_CAPACITY - 1)]));
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			unsigned long long writing = log->writing.load(std::memory_order_relaxed);
+			unsigned long long torn = 0;
+			if (writing + 1 > cursor + Profiler::EVENT_CAPACITY) {
+				torn = std::min(writing + 1 - Profiler::EVENT_CAPACITY - cursor, copied);
+				trace.events.erase(trace.events.begin() + first, trace.events.begin() + first + torn);
+			}
+
+			trace.dropped += available - copied + torn;
+			cursor = head;
+		}
+	}
+
+	std::string Escape(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+				escaped += c;
+			}
+			else if ((unsigned char)c < 0x20) {
+				escaped += std::format("\\u{:04x}", (unsigned int)c);
+			}
+			else {
+				escaped += c;
+			}
+		}
+		return escaped;
+	}
+
+	// --------------------------------------------------------
+	// Chrome trace event JSON: thread names as metadata, scopes
+	// as complete ("X") events, counters as counter ("C")
+	// events and a global instant event at every frame start.
+	// Times are in microseconds.  Caller holds logsLock
+	// --------------------------------------------------------
+	void WriteTrace()
+	{
+		std::ofstream out(trace.path);
+		if (!out) {
+			trace.status = std::format("Couldn't open {} for writing", trace.path);
+			return;
+		}
+
+		const char* separator = "";
+		out << "{\"traceEvents\":[\n";
+		for (const std::unique_ptr<ThreadLog>& log : logs) {
+			out << separator << std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", log->id, Escape(log->name));
+			separator = ",\n";
+		}
+		for (size_t i = 0; i + 1 < trace.frames.size(); ++i) {
+			out << separator << std::format("{{\"name\":\"Frame {}\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":{:.3f}}}", i, trace.frames[i] / 1000.0);
+		}
+		for (const auto& [thread, event] : trace.events) {
+			std::string name = Escape(event.name);
+			if (event.kind == Profiler::EVENT_COUNTER) {
+				out << separator << std::format("{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"args\":{{\"value\":{}}}}}", name, thread, event.start / 1000.0, event.value);
+			}
+			else {
+				out << separator << std::format("{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", name, thread, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			}
+		}
+		out << std::format("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{{\"droppedEvents\":{}}}}}\n", trace.dropped);
+
+		trace.status = std::format("Wrote {} events over {} frames to {}, {} dropped", trace.events.size(), trace.frames.size() - 1, trace.path, trace.dropped);
+	}
+
+	// Called at every frame start while a trace is running
+	void StepTrace(long long now)
+	{
+		std::lock_guard<std::mutex> guard(logsLock);
+
+		//whatever the frame StartTrace was called in did is left out
+		if (!trace.started) {
+			trace.cursors.clear();
+			for (const std::unique_ptr<ThreadLog>& log : logs) {
+				trace.cursors.push_back(log->head.load(std::memory_order_acquire));
+			}
+			trace.started = true;
+		}
+		else {
+			DrainTrace();
+		}
+
+		trace.frames.push_back(now);
+		if (trace.frames.size() > trace.frameCount) {
+			WriteTrace();
+			trace.running = false;
+			std::vector<std::pair<unsigned int, Profiler::Event>>().swap(trace.events);
+		}
+	}
+
+	// Same name, same color, whichever literal it came from
+	ImU32 ScopeColor(const char* name)
+	{
+		size_t hash = std::hash<std::string_view>()(name);
+		return ImColor::HSV((hash % 360) / 360.0f, 0.45f, 0.9f);
+	}
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadLog* log = CurrentLog();
+	std::lock_guard<std::mutex> guard(logsLock);
+	log->name = name;
+}
+
+void Profiler::BeginFrame()
+{
+	long long now = Now();
+	if (trace.running) {
+		StepTrace(now);
+	}
+
+	if (!enabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	unsigned long long frame = frameCount.load(std::memory_order_relaxed);
+	frameStarts[frame % FRAME_HISTORY].store(now, std::memory_order_relaxed);
+	frameCount.store(frame + 1, std::memory_order_release);
+}
+
+void Profiler::SetEnabled(bool enable)
+{
+	enabled.store(enable);
+}
+
+bool Profiler::IsEnabled()
+{
+	return enabled.load();
+}
+
+long long Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Counter(const char* name, long long value)
+{
+	if (!enabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	long long now = Now();
+	Write(CurrentLog(), Event{ name, now, now, 0, EVENT_COUNTER, value });
+}
+
+void Profiler::StartTrace(unsigned int frameCount, const std::string& path)
+{
+	if (trace.running || frameCount == 0) {
+		return;
+	}
+
+	trace.running = true;
+	trace.started = false;
+	trace.frameCount = frameCount;
+	trace.path = path;
+	trace.frames.clear();
+	trace.events.clear();
+	trace.dropped = 0;
+	trace.status = std::format("Waiting for the next frame to trace {} frames", frameCount);
+	enabled.store(true);
+}
+
+bool Profiler::IsTracing()
+{
+	return trace.running;
+}
+
+std::string Profiler::TraceStatus()
+{
+	if (trace.running && trace.started) {
+		return std::format("Tracing frame {} of {}, {} events so far", trace.frames.size(), trace.frameCount, trace.events.size());
+	}
+	return trace.status;
+}
+
+// --------------------------------------------------------
+// Walks each ring from the newest scope back.  Scopes are
+// stored in the order they end, so the walk stops at the
+// first one that ended before the range.
+//
+// Whatever a thread overwrote while we were copying is thrown
+// away afterwards: writers note the index they're about to
+// write (then fence) before touching a slot, so after our own
+// fence every slot we could have read half-written is at or
+// below that index minus the ring size
+// --------------------------------------------------------
+void Profiler::Capture(long long from, long long to, std::vector<ThreadEvents>& threads)
+{
+	threads.clear();
+	std::vector<unsigned long long> indices;
+
+	std::lock_guard<std::mutex> guard(logsLock);
+	for (const std::unique_ptr<ThreadLog>& log : logs) {
+		ThreadEvents& thread = threads.emplace_back();
+		thread.name = log->name;
+		thread.id = log->id;
+
+		unsigned long long head = log->head.load(std::memory_order_acquire);
+		unsigned long long oldest = head > EVENT_CAPACITY ? head - EVENT_CAPACITY : 0;
+		indices.clear();
+		for (unsigned long long i = head; i > oldest; --i) {
+			Event event = Read(log->events[(i - 1) & (EVENT_CAPACITY - 1)]);
+			if (event.end < from) {
+				break;
+			}
+			if (event.start < to) {
+				thread.events.push_back(event);
+				indices.push_back(i - 1);
+			}
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		unsigned long long writing = log->writing.load(std::memory_order_relaxed);
+		size_t intact = thread.events.size();
+		while (intact > 0 && indices[intact - 1] + EVENT_CAPACITY <= writing) {
+			intact--;
+		}
+		thread.events.resize(intact);
+	}
+}
+
+void Profiler::GetFrameStarts(std::vector<long long>& starts)
+{
+	starts.clear();
+	unsigned long long count = frameCount.load(std::memory_order_acquire);
+	unsigned long long first = count > FRAME_HISTORY ? count - FRAME_HISTORY : 0;
+	for (unsigned long long i = first; i < count; ++i) {
+		starts.push_back(frameStarts[i % FRAME_HISTORY].load(std::memory_order_relaxed));
+	}
+}
+
+// --------------------------------------------------------
+// One lane per thread with nested scopes stacked below their
+// parents, over the last few whole frames, then min/avg/max
+// per scope name over the same frames
+// --------------------------------------------------------
+void Profiler::ShowWindow()
+{
+	static int framesShown = 3;
+	static std::vector<long long> frames;
+	static std::vector<ThreadEvents> threads;
+
+	ImGui::Begin("Profiler");
+
+	bool recording = IsEnabled();
+	if (ImGui::Checkbox("Recording", &recording)) {
+		SetEnabled(recording);
+	}
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200.0f);
+	ImGui::SliderInt("Frames shown", &framesShown, 1, 32);
+
+	//the newest start is the frame being built right now, so whole
+	//frames end there
+	GetFrameStarts(frames);
+	if (frames.size() < 2) {
+		ImGui::Text("Waiting for frames...");
+		ImGui::End();
+		return;
+	}
+	size_t last = frames.size() - 1;
+	size_t first = last > (size_t)framesShown ? last - framesShown : 0;
+	long long from = frames[first];
+	long long to = frames[last];
+	Capture(from, to, threads);
+
+	ImGui::SeparatorText("Timeline");
+	const float labelWidth = 90.0f;
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 50.0f);
+	float scale = width / (float)(to - from);
+	ImVec2 mouse = ImGui::GetIO().MousePos;
+	bool windowHovered = ImGui::IsWindowHovered();
+	const Event* hovered = nullptr;
+
+	float y = origin.y;
+	for (const ThreadEvents& thread : threads) {
+		unsigned int rows = 0;
+		for (const Event& event : thread.events) {
+			if (event.kind == EVENT_SCOPE) {
+				rows = std::max(rows, event.depth + 1);
+			}
+		}
+		if (rows == 0) {
+			continue;
+		}
+		drawList->AddText(ImVec2(origin.x, y + 2.0f), ImGui::GetColorU32(ImGuiCol_Text), thread.name.c_str());
+
+		for (const Event& event : thread.events) {
+			if (event.kind != EVENT_SCOPE) {
+				continue;
+			}
+			float x0 = origin.x + labelWidth + std::max(event.start - from, 0LL) * scale;
+			float x1 = origin.x + labelWidth + std::min(event.end - from, to - from) * scale;
+			ImVec2 topLeft(x0, y + event.depth * rowHeight);
+			ImVec2 bottomRight(std::max(x1, x0 + 1.0f), topLeft.y + rowHeight - 1.0f);
+			drawList->AddRectFilled(topLeft, bottomRight, ScopeColor(event.name));
+
+			//only label scopes with room for a few letters
+			if (bottomRight.x - topLeft.x > 20.0f) {
+				ImVec4 clip(topLeft.x + 2.0f, topLeft.y, bottomRight.x - 2.0f, bottomRight.y);
+				drawList->AddText(nullptr, 0.0f, ImVec2(topLeft.x + 3.0f, topLeft.y + 2.0f), IM_COL32(0, 0, 0, 255), event.name, nullptr, 0.0f, &clip);
+			}
+
+			if (windowHovered && mouse.x >= topLeft.x && mouse.x < bottomRight.x && mouse.y >= topLeft.y && mouse.y < bottomRight.y) {
+				hovered = &event;
+			}
+		}
+		y += rows * rowHeight + 4.0f;
+	}
+
+	for (size_t i = first; i <= last; ++i) {
+		float x = origin.x + labelWidth + (frames[i] - from) * scale;
+		drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, y), IM_COL32(255, 255, 255, 96));
+	}
+	ImGui::Dummy(ImVec2(labelWidth + width, std::max(y - origin.y, rowHeight)));
+
+	if (hovered != nullptr) {
+		ImGui::SetTooltip("%s\n%.3f ms", hovered->name, (hovered->end - hovered->start) * 1e-6);
+	}
+
+	//scopes cut off by either end of the range would skew the numbers
+	struct ScopeStats
+	{
+		unsigned int calls = 0;
+		long long total = 0;
+		long long min = LLONG_MAX;
+		long long max = 0;
+	};
+	std::map<std::string_view, ScopeStats> byName;
+	for (const ThreadEvents& thread : threads) {
+		for (const Event& event : thread.events) {
+			if (event.kind != EVENT_SCOPE || event.start < from || event.end > to) {
+				continue;
+			}
+			long long duration = event.end - event.start;
+			ScopeStats& stats = byName[event.name];
+			stats.calls++;
+			stats.total += duration;
+			stats.min = std::min(stats.min, duration);
+			stats.max = std::max(stats.max, duration);
+		}
+	}
+	std::vector<std::pair<std::string_view, ScopeStats>> sorted(byName.begin(), byName.end());
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.total > b.second.total; });
+
+	ImGui::SeparatorText("Scopes");
+	float frameCount = (float)(last - first);
+	if (ImGui::BeginTable("Scope Stats", 6, ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("Calls/frame");
+		ImGui::TableSetupColumn("Min (ms)");
+		ImGui::TableSetupColumn("Avg (ms)");
+		ImGui::TableSetupColumn("Max (ms)");
+		ImGui::TableSetupColumn("ms/frame");
+		ImGui::TableHeadersRow();
+		for (const auto& [name, stats] : sorted) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%.*s", (int)name.size(), name.data());
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.calls / frameCount);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.min * 1e-6);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.total * 1e-6 / stats.calls);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.max * 1e-6);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.total * 1e-6 / frameCount);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::SeparatorText("Trace");
+	static int traceFrames = 120;
+	static char tracePath[260] = "trace.json";
+	ImGui::InputInt("Frames to trace", &traceFrames);
+	ImGui::InputText("Trace file", tracePath, sizeof(tracePath));
+	ImGui::BeginDisabled(IsTracing());
+	if (ImGui::Button("Capture trace")) {
+		StartTrace(traceFrames > 0 ? traceFrames : 1, tracePath);
+	}
+	ImGui::EndDisabled();
+	ImGui::TextWrapped("%s", TraceStatus().c_str());
+
+	ImGui::End();
+}
+
+Profiler::Scope::Scope(const char* name)
+{
+	if (!enabled.load(std::memory_order_relaxed)) {
+		this->name = nullptr;
+		return;
+	}
+
+	this->name = name;
+	CurrentLog()->depth++;
+	start = Now();
+}
+
+Profiler::Scope::~Scope()
+{
+	if (name == nullptr) {
+		return;
+	}
+
+	long long end = Now();
+	ThreadLog* log = currentLog;
+	unsigned int depth = --log->depth;
+	Write(log, Event{ name, start, end, depth, EVENT_SCOPE, 0 });
+}
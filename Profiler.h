@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Scoped CPU timing.  PROFILE_SCOPE("Name") times the rest of
+// the enclosing block.  Every thread appends its finished
+// scopes to a ring buffer of its own, so recording never
+// takes a lock or touches another thread's memory, and the
+// Profiler window reads the rings back for the last few
+// frames.
+//
+// Counters (draw calls, culled entities...) go in the same
+// rings as a value at a point in time.
+//
+// A trace captures a range of whole frames from every thread
+// and writes it as Chrome trace event JSON, which opens in
+// chrome://tracing or ui.perfetto.dev.  While tracing, the
+// rings are drained into the trace at every frame start, so
+// how long a trace runs isn't limited by their size.
+//
+// Only the name's pointer is kept, so names have to be string
+// literals (or otherwise live as long as the program)
+// --------------------------------------------------------
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+namespace Profiler
+{
+	// Finished scopes each thread's ring holds (a power of two),
+	// and how many frame starts are remembered
+	const unsigned int EVENT_CAPACITY = 1 << 16;
+	const unsigned int FRAME_HISTORY = 256;
+
+	// Most events a trace holds, anything past it is counted and dropped
+	const unsigned int TRACE_EVENT_LIMIT = 1 << 20;
+
+	enum EventKind
+	{
+		EVENT_SCOPE,
+		EVENT_COUNTER
+	};
+
+	struct Event
+	{
+		const char* name;
+		long long start; // ns since the profiler started
+		long long end; // same as start for counters
+		unsigned int depth; // 0 for the outermost scope on its thread
+		EventKind kind;
+		long long value; // counters only
+	};
+
+	struct ThreadEvents
+	{
+		std::string name;
+		unsigned int id; // order the threads first recorded in
+		std::vector<Event> events; // newest first
+	};
+
+	// Names the calling thread in the timeline
+	void SetThreadName(const std::string& name);
+
+	// Marks the start of a frame, once per frame from the main thread
+	void BeginFrame();
+
+	// Pausing holds the last capture still in the window
+	void SetEnabled(bool enabled);
+	bool IsEnabled();
+
+	// Profiler clock, ns since it started
+	long long Now();
+
+	// Records a counter's value as of now on the calling thread
+	void Counter(const char* name, long long value);
+
+	// Traces the next frameCount whole frames (starting at the next
+	// BeginFrame) and writes them to path once they're done.  Turns
+	// recording on.  Ignored while a trace is already running.  These
+	// three are for the main thread only, same as BeginFrame
+	void StartTrace(unsigned int frameCount, const std::string& path);
+	bool IsTracing();
+	// What the running or last trace did, for the UI
+	std::string TraceStatus();
+
+	// Every scope overlapping [from, to) on every thread, and every
+	// counter recorded in it.  Safe to call
+	// while other threads keep recording
+	void Capture(long long from, long long to, std::vector<ThreadEvents>& threads);
+
+	// Starts of the most recent frames, oldest first.  The last one is
+	// the frame in progress
+	void GetFrameStarts(std::vector<long long>& starts);
+
+	// Timeline and per-scope stats, call while building the UI
+	void ShowWindow();
+
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name);
+		~Scope();
+		Scope(const Scope&) = delete; // Remove copy constructor
+		Scope& operator=(const Scope&) = delete; // Remove copy-assignment operator
+
+	private:
+		const char* name; // nullptr when recording was off at the start
+		long long start;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// The D3D11 objects a context binds are only ever passed
+// through by pointer, so declaring them is enough and this
+// header doesn't need Windows or D3D headers at all
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11InputLayout;
+struct ID3D11RasterizerState;
+struct ID3D11DepthStencilState;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+
+// --------------------------------------------------------
+// The narrow set of commands a frame is recorded with, which
+// is everything StateCache forwards.  D3D11RenderContext
+// sends them to a real device context; NullRenderContext
+// just counts them, so the whole draw stream (culling,
+// sorting, binding, uploads) can run and be profiled without
+// a GPU.
+//
+// Resources are still created on the D3D11 device; a
+// backend only ever sees their pointers.  Formats and
+// topologies are the D3D11/DXGI enum values
+// --------------------------------------------------------
+class RenderContext
+{
+public:
+
+	// Slot counts, the same as D3D11's
+	static const unsigned int CONSTANT_BUFFER_SLOTS = 14;
+	static const unsigned int INPUT_RESOURCE_SLOTS = 128;
+	static const unsigned int SAMPLER_SLOTS = 16;
+
+	virtual ~RenderContext() {}
+
+	// Shaders
+	virtual void VSSetShader(ID3D11VertexShader* shader) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* shader) = 0;
+	virtual void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) = 0;
+	virtual void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) = 0;
+	virtual void VSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void PSSetShaderResources(unsigned int slot, unsigned int count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) = 0;
+	virtual void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler) = 0;
+
+	// Input assembler
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset) = 0;
+	virtual void IASetPrimitiveTopology(unsigned int topology) = 0;
+
+	// Fixed function state and targets.  A viewport's corner is at
+	// (left, top) in pixels and it always covers depths 0 to 1
+	virtual void RSSetState(ID3D11RasterizerState* state) = 0;
+	virtual void RSSetViewport(float width, float height, float left, float top) = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) = 0;
+	virtual void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv) = 0;
+	virtual void ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4]) = 0;
+	virtual void ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth) = 0;
+
+	// Work
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	virtual void Draw(unsigned int vertexCount, unsigned int startVertex) = 0;
+	virtual void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) = 0;
+	// The first bytes of any other default usage buffer (structured buffers)
+	virtual void UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes) = 0;
+};
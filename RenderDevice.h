@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Only ever pointed to here, so no D3D headers needed
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11RasterizerState;
+struct ID3D11DepthStencilState;
+
+// --------------------------------------------------------
+// What a compiled shader binds, as its reflection tells it:
+// every constant buffer with the variables in it, and the
+// textures and samplers by register
+// --------------------------------------------------------
+struct ShaderReflection
+{
+	struct Variable
+	{
+		std::string name;
+		unsigned int offset; // bytes into its buffer
+		unsigned int size;
+	};
+
+	struct ConstantBuffer
+	{
+		std::string name;
+		unsigned int type; // D3D_CBUFFER_TYPE
+		unsigned int size;
+		unsigned int bindIndex;
+		std::vector<Variable> variables;
+	};
+
+	struct Resource
+	{
+		std::string name;
+		unsigned int bindIndex;
+	};
+
+	std::vector<ConstantBuffer> constantBuffers;
+	std::vector<Resource> textures; // structured buffers too
+	std::vector<Resource> samplers;
+};
+
+// --------------------------------------------------------
+// The GPU resources the engine makes past start up (shaders,
+// meshes, the sky, the passes' buffers), so the code making
+// them needs no D3D headers and runs on NullRenderDevice in
+// tests.  The device side counterpart of RenderContext.
+//
+// Creation returns false and leaves the out pointers null
+// when it fails.  D3D enum values are passed as unsigned
+// ints, as in RenderContext
+// --------------------------------------------------------
+class RenderDevice
+{
+public:
+
+	virtual ~RenderDevice() {}
+
+	// Compiled shader files.  A vertex shader comes with an input
+	// layout built from its inputs
+	virtual bool LoadVertexShader(const wchar_t* file, ID3D11VertexShader** shader, ID3D11InputLayout** inputLayout, ShaderReflection& reflection) = 0;
+	virtual bool LoadPixelShader(const wchar_t* file, ID3D11PixelShader** shader, ShaderReflection& reflection) = 0;
+
+	// Vertex and index buffers never change once made.  Constant and
+	// structured buffers are filled through StateCache
+	virtual bool CreateVertexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) = 0;
+	virtual bool CreateIndexBuffer(const void* data, unsigned int bytes, ID3D11Buffer** buffer) = 0;
+	virtual bool CreateConstantBuffer(unsigned int bytes, ID3D11Buffer** buffer) = 0;
+	virtual bool CreateStructuredBuffer(unsigned int stride, unsigned int count, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv) = 0;
+
+	// A cube map from six image files, +X -X +Y -Y +Z -Z
+	virtual bool LoadCubeMap(const wchar_t* const faces[6], ID3D11ShaderResourceView** srv) = 0;
+	// A cube map's faces back on the CPU, 8 bit RGBA (or BGRA) with
+	// size * 4 bytes a row.  False for any other format
+	virtual bool ReadCubeMap(ID3D11ShaderResourceView* cubeMap, std::vector<unsigned char> faces[6], unsigned int& size, bool& bgra) = 0;
+	// An immutable 32 bit float texture with 2 or 4 channels.  data has
+	// one entry per face and mip, data[face * mips + mip], and a 2D
+	// texture is a single face
+	virtual bool CreateFloatTexture(unsigned int size, unsigned int channels, unsigned int mips, bool cube, const void* const* data, ID3D11ShaderResourceView** srv) = 0;
+
+	// Solid fill with depth clipping, cullMode a D3D11_CULL_MODE
+	virtual bool CreateRasterizerState(unsigned int cullMode, ID3D11RasterizerState** state) = 0;
+	// Depth test only, comparison a D3D11_COMPARISON_FUNC
+	virtual bool CreateDepthStencilState(unsigned int comparison, bool depthWrite, ID3D11DepthStencilState** state) = 0;
+};
@@ -0,0 +1,439 @@
+#include "SceneRenderer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+SceneRenderer::SceneRenderer(RenderDevice* device, JobSystem* jobs, unsigned int shadowMapResolution, unsigned int shadowAtlasSize) :
+	device(device),
+	jobs(jobs),
+	shadowMapResolution(shadowMapResolution),
+	shadowAtlas(shadowAtlasSize),
+	lightClusters(jobs),
+	objectLightLists(jobs)
+{
+}
+
+SceneRenderer::~SceneRenderer()
+{
+}
+
+
+// --------------------------------------------------------
+// Brings every matrix up to date, culls, and copies what
+// the passes draw into the snapshot
+// --------------------------------------------------------
+void SceneRenderer::Prepare(SceneSnapshot& frame, EntityStore& entities, const std::vector<Light>& lights, float alpha, const Settings& settings)
+{
+	PROFILE_SCOPE("SceneRenderer::Prepare");
+
+	//Rebuild every matrix Update touched in one batched pass, so the
+	//culls and copies below only ever read cached results
+	TransformPool* pool = entities.GetTransformPool();
+	pool->UpdateDirty(jobs);
+	assert(pool->GetDirtyCount() == 0);
+
+	//with matrices final, the shadow and camera culls only read shared
+	//data and write their own lists, so they can run side by side
+	XMFLOAT4X4 viewProjection;
+	JobSystem::Counter culls = 0;
+	if (frame.hasCamera) {
+		XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&frame.view), XMLoadFloat4x4(&frame.projection)));
+		jobs->Run([&]() { PROFILE_SCOPE("Cull camera"); entities.Cull(viewProjection, visibleEntities); }, &culls);
+	}
+	else {
+		visibleEntities.clear();
+	}
+
+	//only the first light is shadowed, and only if it's directional.
+	//The cascades follow the camera, so they're refitted every frame
+	bool shadowed = frame.hasCamera && !lights.empty() && lights[0].Type == LIGHT_TYPE_DIRECTIONAL;
+	unsigned long long casterChanges[ShadowCache::MAX_VIEWS] = {};
+	float splits[ShadowCascades::CASCADE_COUNT] = {};
+	frame.shadowDepthPlane = XMFLOAT4(0, 0, 0, 1);
+	if (shadowed) {
+		shadowCascades.Fit(frame.view, frame.projection, lights[0].Direction, shadowMapResolution);
+		frame.shadowDepthPlane = XMFLOAT4(frame.view._13, frame.view._23, frame.view._33, frame.view._43);
+	}
+	for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+		const ShadowCascades::Cascade& cascade = shadowCascades.GetCascade(i);
+		frame.cascades[i].view = cascade.view;
+		frame.cascades[i].projection = cascade.projection;
+		frame.cascades[i].viewProjection = cascade.viewProjection;
+		if (shadowed) {
+			splits[i] = cascade.splitFar;
+			jobs->Run([&, i]() {
+				PROFILE_SCOPE("Cull shadow casters");
+				entities.Cull(shadowCascades.GetCascade(i).cullViewProjection, cascadeCasters[i]);
+				casterChanges[i] = entities.GetChangeTick(cascadeCasters[i]);
+			}, &culls);
+		}
+		else {
+			cascadeCasters[i].clear();
+		}
+	}
+	frame.shadowSplits = XMFLOAT4(splits[0], splits[1], splits[2], splits[3]);
+
+	//every other light can get a shadow from the atlas, which picks and
+	//sizes its tiles by how much of the screen each light covers
+	frame.lights = lights;
+	unsigned int tileCount = 0;
+	if (settings.shadowAtlas && frame.hasCamera) {
+		shadowAtlas.Allocate(frame.view, frame.projection, frame.lights, shadowCascades.GetShadowDistance(), shadowCascades.GetCasterReach());
+		tileCount = (unsigned int)shadowAtlas.GetTiles().size();
+		Profiler::Counter("Shadow atlas tiles", tileCount);
+	}
+	else {
+		for (Light& light : frame.lights) {
+			light.ShadowTile = -1;
+		}
+	}
+	frame.shadowAtlasSize = shadowAtlas.GetSize();
+	frame.shadowTiles.resize(tileCount);
+	tileCasters.resize(tileCount);
+	for (unsigned int i = 0; i < tileCount; ++i) {
+		const ShadowAtlas::Tile& tile = shadowAtlas.GetTiles()[i];
+		frame.shadowTiles[i].view = tile.view;
+		frame.shadowTiles[i].projection = tile.projection;
+		frame.shadowTiles[i].viewProjection = tile.viewProjection;
+		frame.shadowTiles[i].x = tile.x;
+		frame.shadowTiles[i].y = tile.y;
+		frame.shadowTiles[i].size = tile.size;
+		jobs->Run([&, i]() {
+			PROFILE_SCOPE("Cull shadow casters");
+			entities.Cull(shadowAtlas.GetTiles()[i].cullViewProjection, tileCasters[i]);
+			casterChanges[ShadowCache::TileView(i)] = entities.GetChangeTick(tileCasters[i]);
+		}, &culls);
+	}
+	jobs->Wait(&culls);
+
+	//a version per view, so the render thread knows which ones it can keep
+	unsigned long long tick = pool->GetTick();
+	for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+		frame.cascades[i].version = shadowCache.Track(i, frame.cascades[i].viewProjection, 0, 0, 0, cascadeCasters[i], casterChanges[i], tick);
+	}
+	for (unsigned int i = 0; i < tileCount; ++i) {
+		const ShadowTile& tile = frame.shadowTiles[i];
+		frame.shadowTiles[i].version = shadowCache.Track(ShadowCache::TileView(i), tile.viewProjection, tile.x, tile.y, tile.size, tileCasters[i], casterChanges[ShadowCache::TileView(i)], tick);
+	}
+	frame.shadowCaching = settings.shadowCaching;
+	Profiler::Counter("Culled entities", entities.GetCount() - (long long)visibleEntities.size());
+
+	{
+		PROFILE_SCOPE("Gather");
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			entities.GatherDepth(cascadeCasters[i], alpha, frame.cascades[i].casters, jobs);
+		}
+		for (unsigned int i = 0; i < tileCount; ++i) {
+			entities.GatherDepth(tileCasters[i], alpha, frame.shadowTiles[i].casters, jobs);
+		}
+		entities.Gather(visibleEntities, alpha, frame.opaque, jobs);
+	}
+
+	frame.clusteredLighting = settings.clusteredLighting && frame.hasCamera;
+	if (frame.clusteredLighting) {
+		lightClusters.Build(frame.view, frame.projection, lights.data(), (unsigned int)lights.size(), frame.clusters);
+		Profiler::Counter("Cluster light references", lightClusters.GetStats().references);
+	}
+	frame.objectLights = settings.objectLights && !frame.clusteredLighting;
+	if (frame.objectLights) {
+		objectLightLists.Build(lights.data(), (unsigned int)lights.size(), frame.opaque);
+		Profiler::Counter("Light evaluations saved", objectLightLists.GetStats().evaluationsSaved);
+	}
+}
+
+
+// --------------------------------------------------------
+// Records the frame's passes.  Anything that creates
+// resources or touches the shadow cache happens here, on
+// the calling thread, since the pass bodies may be recorded
+// on workers
+// --------------------------------------------------------
+void SceneRenderer::Record(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources)
+{
+	PROFILE_SCOPE("SceneRenderer::Record");
+
+	//the opaque pass fills these
+	if (frame.clusteredLighting) {
+		GrowShaderBuffer(clusterLightBuffer, sizeof(Light), (unsigned int)frame.lights.size());
+		GrowShaderBuffer(clusterRangeBuffer, sizeof(ClusterGrid::Range), (unsigned int)frame.clusters.ranges.size());
+		GrowShaderBuffer(clusterIndexBuffer, sizeof(unsigned int), (unsigned int)frame.clusters.indices.size());
+	}
+
+	//the cache only knows what was drawn to the real shadow maps
+	if (!frame.shadowCaching || &passes != shadowRecorder) {
+		shadowCache.Invalidate();
+		shadowRecorder = &passes;
+	}
+	shadowCache.ResetStats();
+
+	RecordShadows(passes, frame, resources);
+	RecordOpaque(passes, frame, resources);
+	RecordPost(passes, frame, resources);
+}
+
+
+// --------------------------------------------------------
+// Draw Shadowmap!  A cascade at a time, then the atlas
+// tiles, skipping any the shadow cache says still hold what
+// they'd draw
+// --------------------------------------------------------
+void SceneRenderer::RecordShadows(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources)
+{
+	//which views the cache can keep is settled here, so the pass only
+	//reads its own copy
+	bool redrawCascades[ShadowCascades::CASCADE_COUNT];
+	for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+		const ShadowCascade& cascade = frame.cascades[i];
+		redrawCascades[i] = shadowCache.NeedsRedraw(i, cascade.version, 0, 0, 0, (unsigned int)cascade.casters.size());
+	}
+	std::vector<unsigned int> redrawTiles;
+	for (unsigned int i = 0; i < (unsigned int)frame.shadowTiles.size(); ++i) {
+		const ShadowTile& tile = frame.shadowTiles[i];
+		if (shadowCache.NeedsRedraw(ShadowCache::TileView(i), tile.version, tile.x, tile.y, tile.size, (unsigned int)tile.casters.size())) {
+			redrawTiles.push_back(i);
+		}
+	}
+
+	passes.Record(PASS_SHADOW, [&, redrawCascades, redrawTiles = std::move(redrawTiles)](StateCache* states) {
+		PROFILE_SCOPE("Shadow pass");
+		SimpleVertexShader* shadowVS = resources.shadowVS;
+		states->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		states->PSSetShader(0); //deactivates pixel shader
+
+		//fix viewport to render the shadow map size
+		states->RSSetViewport((float)shadowMapResolution, (float)shadowMapResolution);
+
+		shadowVS->SetShader();
+		states->RSSetState(resources.shadowRasterizer);
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			if (!redrawCascades[i]) {
+				continue;
+			}
+			const ShadowCascade& cascade = frame.cascades[i];
+			states->ClearDepthStencilView(resources.shadowDSVs[i], 1.0f);
+			ID3D11RenderTargetView* nullRTV{};
+			states->OMSetRenderTargets(1, &nullRTV, resources.shadowDSVs[i]);
+
+			shadowVS->SetMatrix4x4("view", cascade.view);
+			shadowVS->SetMatrix4x4("projection", cascade.projection);
+			// Draw everything the cascade can see to its slice, meshes only (no materials)
+			frame.DrawShadowCasters(shadowVS, cascade.casters);
+		}
+
+		//the atlas keeps the tiles that aren't redrawn, so each redrawn
+		//one is cleared on its own, all of them before any casters
+		if (!redrawTiles.empty()) {
+			ID3D11RenderTargetView* nullRTV{};
+			states->OMSetRenderTargets(1, &nullRTV, resources.shadowAtlasDSV);
+			states->RSSetState(0);
+			states->OMSetDepthStencilState(resources.shadowClearDepthState, 0);
+			resources.shadowClearVS->SetShader();
+			for (unsigned int i : redrawTiles) {
+				const ShadowTile& tile = frame.shadowTiles[i];
+				states->RSSetViewport((float)tile.size, (float)tile.size, (float)tile.x, (float)tile.y);
+				states->Draw(3, 0);
+			}
+			states->OMSetDepthStencilState(0, 0);
+
+			shadowVS->SetShader();
+			states->RSSetState(resources.shadowRasterizer);
+			for (unsigned int i : redrawTiles) {
+				const ShadowTile& tile = frame.shadowTiles[i];
+				states->RSSetViewport((float)tile.size, (float)tile.size, (float)tile.x, (float)tile.y);
+				shadowVS->SetMatrix4x4("view", tile.view);
+				shadowVS->SetMatrix4x4("projection", tile.projection);
+				frame.DrawShadowCasters(shadowVS, tile.casters);
+			}
+		}
+		states->RSSetState(0);
+	});
+}
+
+
+// --------------------------------------------------------
+// Draws the scene into the first post process target
+// --------------------------------------------------------
+void SceneRenderer::RecordOpaque(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources)
+{
+	passes.Record(PASS_OPAQUE, [&](StateCache* states) {
+		PROFILE_SCOPE("Opaque pass");
+		states->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		states->ClearRenderTargetView(resources.postTargets[0], frame.background);
+		states->ClearDepthStencilView(resources.depthBuffer, 1.0f);
+
+		states->RSSetViewport((float)frame.width, (float)frame.height);
+		states->OMSetRenderTargets(1, &resources.postTargets[0], resources.depthBuffer);
+
+		if (!frame.hasCamera) {
+			return;
+		}
+
+		if (frame.clusteredLighting) {
+			auto upload = [states](ShaderBuffer& target, const void* data, size_t bytes) {
+				if (bytes > 0) {
+					states->UpdateBuffer(target.buffer.Get(), data, (unsigned int)bytes);
+				}
+			};
+			upload(clusterLightBuffer, frame.lights.data(), sizeof(Light) * frame.lights.size());
+			upload(clusterRangeBuffer, frame.clusters.ranges.data(), sizeof(ClusterGrid::Range) * frame.clusters.ranges.size());
+			upload(clusterIndexBuffer, frame.clusters.indices.data(), sizeof(unsigned int) * frame.clusters.indices.size());
+		}
+
+		//send light/shadow info once per pixel shader, however many
+		//materials share it, rather than per entity. Without clustering
+		//only what fits in the constant buffer is lit
+		int shaderLights = (int)(frame.lights.size() < MAX_LIGHT_COUNT ? frame.lights.size() : MAX_LIGHT_COUNT);
+		XMFLOAT4X4 shadowViewProjections[ShadowCascades::CASCADE_COUNT];
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			shadowViewProjections[i] = frame.cascades[i].viewProjection;
+		}
+		//each tile's rect in atlas UVs: offset, scale, and half a texel
+		XMFLOAT4X4 shadowTileMatrices[ShadowAtlas::MAX_TILES];
+		XMFLOAT4 shadowTileRects[ShadowAtlas::MAX_TILES];
+		unsigned int tileCount = (unsigned int)frame.shadowTiles.size();
+		float atlasScale = frame.shadowAtlasSize > 0 ? 1.0f / frame.shadowAtlasSize : 0.0f;
+		for (unsigned int i = 0; i < tileCount; ++i) {
+			const ShadowTile& tile = frame.shadowTiles[i];
+			shadowTileMatrices[i] = tile.viewProjection;
+			shadowTileRects[i] = XMFLOAT4(tile.x * atlasScale, tile.y * atlasScale, tile.size * atlasScale, 0.5f * atlasScale);
+		}
+		std::vector<SimplePixelShader*> frameShaders;
+		for (Material* m : resources.materials) {
+			SimplePixelShader* ps = m->GetPixelShader();
+			if (std::find(frameShaders.begin(), frameShaders.end(), ps) != frameShaders.end()) {
+				continue;
+			}
+			frameShaders.push_back(ps);
+
+			ps->SetData("shadowViewProjections", shadowViewProjections, sizeof(shadowViewProjections));
+			ps->SetFloat4("shadowSplits", frame.shadowSplits);
+			ps->SetFloat4("shadowDepthPlane", frame.shadowDepthPlane);
+			if (tileCount > 0) {
+				ps->SetData("shadowTileMatrices", shadowTileMatrices, sizeof(XMFLOAT4X4) * tileCount);
+				ps->SetData("shadowTileRects", shadowTileRects, sizeof(XMFLOAT4) * tileCount);
+			}
+			ps->SetFloat3("ambient", frame.ambient);
+			ps->SetInt("skyLighting", frame.skyLighting);
+			if (frame.skyLighting) {
+				ps->SetData("irradianceSH", resources.sky->GetIrradiance(), sizeof(XMFLOAT4) * 9);
+				ps->SetFloat("specularMipCount", (float)SkyLighting::SPECULAR_MIPS);
+			}
+			ps->SetInt("clustered", frame.clusteredLighting);
+			ps->SetInt("objectLights", frame.objectLights);
+			if (frame.clusteredLighting) {
+				ps->SetShaderResourceView("ClusterLights", clusterLightBuffer.srv);
+				ps->SetShaderResourceView("ClusterRanges", clusterRangeBuffer.srv);
+				ps->SetShaderResourceView("ClusterLightIndices", clusterIndexBuffer.srv);
+				ps->SetInt("directionalCount", (int)frame.clusters.directionalCount);
+				ps->SetFloat2("clusterScale", XMFLOAT2((float)LightClusters::GRID_X / frame.width, (float)LightClusters::GRID_Y / frame.height));
+				ps->SetFloat4("clusterDepthPlane", frame.clusters.depthPlane);
+				ps->SetFloat("clusterSliceNear", frame.clusters.sliceNear);
+				ps->SetFloat("clusterSliceScale", frame.clusters.sliceScale);
+			}
+			else {
+				ps->SetData("lights", frame.lights.data(), sizeof(Light) * shaderLights);
+				ps->SetInt("lightCount", shaderLights);
+			}
+		}
+
+		//Draw entities
+		frame.DrawOpaque();
+
+		//Draw Skybox
+		resources.sky->Draw(frame.view, frame.projection);
+	});
+}
+
+
+// --------------------------------------------------------
+// DRAW POST PROCESSES: each one a full screen triangle
+// reading the one before
+// --------------------------------------------------------
+void SceneRenderer::RecordPost(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources)
+{
+	passes.Record(PASS_POST, [&](StateCache* states) {
+		PROFILE_SCOPE("Post process pass");
+		states->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		states->ClearRenderTargetView(resources.backBuffer, frame.background);
+		for (size_t i = 1; i < resources.postTargets.size(); ++i) {
+			states->ClearRenderTargetView(resources.postTargets[i], frame.background);
+		}
+
+		states->RSSetViewport((float)frame.width, (float)frame.height);
+
+		resources.postVS->SetShader();
+
+		for (size_t i = 0; i < resources.postShaders.size(); ++i) {
+			SimplePixelShader* ps = resources.postShaders[i];
+			if (i == resources.postShaders.size() - 1) {
+				states->OMSetRenderTargets(1, &resources.backBuffer, 0);
+			}
+			else {
+				//we use i + 1 because the original scene is rendered to 0 and the final post process is rendered to the back buffer
+				states->OMSetRenderTargets(1, &resources.postTargets[i + 1], 0);
+			}
+
+			ps->SetShader();
+			ps->SetShaderResourceView("Pixels", resources.postInputs[i]);
+			ps->SetSamplerState("ClampSampler", resources.postSampler);
+
+			//send other cbuffer data here!
+			switch (i) {
+
+			case 0: //X Gaussian Blur
+			case 1: //Y Gaussian Blur
+				ps->SetInt("blurAmount", frame.blurRadius);
+				ps->SetFloat("pixelSize", (i == 0 ? 1.0f / frame.width : 1.0f / frame.height));
+				break;
+
+			case 2: //chromatic abberation
+				ps->SetFloat2("mousePos", frame.mousePosition);
+				ps->SetFloat3("offsets", XMFLOAT3(frame.chromaticOffsets[0], frame.chromaticOffsets[1], frame.chromaticOffsets[2]));
+				ps->SetInt("mode", frame.chromaticMode);
+				break;
+
+			}
+
+			ps->CopyAllBufferData();
+
+			states->Draw(3, 0);
+		}
+	});
+}
+
+
+// --------------------------------------------------------
+// Makes sure a structured buffer holds at least count
+// elements.  It grows by doubling, so a light count that
+// creeps up doesn't mean a new buffer every frame
+// --------------------------------------------------------
+void SceneRenderer::GrowShaderBuffer(ShaderBuffer& target, unsigned int stride, unsigned int count)
+{
+	if (target.buffer && count <= target.capacity) {
+		return;
+	}
+
+	unsigned int capacity = target.capacity * 2 > 64 ? target.capacity * 2 : 64;
+	capacity = count > capacity ? count : capacity;
+
+	target.buffer.Reset();
+	target.srv.Reset();
+	device->CreateStructuredBuffer(stride, capacity, target.buffer.GetAddressOf(), target.srv.GetAddressOf());
+	target.capacity = capacity;
+}
+
+
+unsigned int SceneRenderer::GetShadowCasterCount()
+{
+	size_t count = 0;
+	for (const std::vector<unsigned int>& casters : cascadeCasters) {
+		count += casters.size();
+	}
+	for (const std::vector<unsigned int>& casters : tileCasters) {
+		count += casters.size();
+	}
+	return (unsigned int)count;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "JobSystem.h"
+#include "EntityStore.h"
+#include "SceneSnapshot.h"
+#include "PassRecorder.h"
+#include "Sky.h"
+#include "LightClusters.h"
+#include "ObjectLights.h"
+#include "ShadowCascades.h"
+#include "ShadowAtlas.h"
+#include "ShadowCache.h"
+
+// --------------------------------------------------------
+// The scene half of a frame, from culling to the last post
+// process.  Prepare fills a snapshot's scene on the
+// simulation thread (culls, shadow views, gathers, light
+// lists); Record turns it into the shadow, opaque and post
+// passes on the render thread.
+//
+// Everything it makes goes through a RenderDevice and every
+// command through the StateCache a PassRecorder hands out,
+// so the whole frame runs on NullRenderDevice and
+// NullPassRecorder without a GPU.  The window, swap chain,
+// UI and presenting stay with Game
+// --------------------------------------------------------
+class SceneRenderer
+{
+public:
+
+	// Submission order of the passes a frame is recorded as
+	enum Pass
+	{
+		PASS_SHADOW,
+		PASS_OPAQUE,
+		PASS_POST,
+		PASS_COUNT
+	};
+
+	// What Prepare puts in the snapshot
+	struct Settings
+	{
+		bool clusteredLighting; // see LightClusters
+		bool objectLights; // see ObjectLights, without clustering only
+		bool shadowAtlas; // see ShadowAtlas
+		bool shadowCaching; // see ShadowCache
+	};
+
+	// What the passes draw with and into, owned by the caller.
+	// Recorded passes point at it until they're submitted
+	struct Resources
+	{
+		std::vector<Material*> materials; // each pixel shader gets the frame's lights and shadows once
+		Sky* sky = nullptr;
+
+		SimpleVertexShader* shadowVS = nullptr;
+		SimpleVertexShader* shadowClearVS = nullptr; // depth 1 over a whole atlas tile
+		ID3D11RasterizerState* shadowRasterizer = nullptr;
+		ID3D11DepthStencilState* shadowClearDepthState = nullptr;
+		ID3D11DepthStencilView* shadowDSVs[ShadowCascades::CASCADE_COUNT] = {};
+		ID3D11DepthStencilView* shadowAtlasDSV = nullptr;
+
+		// The scene is drawn into postTargets[0], then each post
+		// shader reads postInputs[i] and writes postTargets[i + 1],
+		// the last one the back buffer
+		SimpleVertexShader* postVS = nullptr;
+		std::vector<SimplePixelShader*> postShaders;
+		ID3D11SamplerState* postSampler = nullptr;
+		std::vector<ID3D11RenderTargetView*> postTargets;
+		std::vector<ID3D11ShaderResourceView*> postInputs;
+		ID3D11RenderTargetView* backBuffer = nullptr;
+		ID3D11DepthStencilView* depthBuffer = nullptr;
+	};
+
+	SceneRenderer(RenderDevice* device, JobSystem* jobs, unsigned int shadowMapResolution = 2048, unsigned int shadowAtlasSize = 4096);
+	~SceneRenderer();
+	SceneRenderer(const SceneRenderer&) = delete; // Remove copy constructor
+	SceneRenderer& operator=(const SceneRenderer&) = delete; // Remove copy-assignment operator
+
+	// Simulation side.  The snapshot's camera (hasCamera, view,
+	// projection, cameraPosition) is set first; this brings the
+	// entities' matrices up to date and fills in the rest of the scene
+	void Prepare(SceneSnapshot& frame, EntityStore& entities, const std::vector<Light>& lights, float alpha, const Settings& settings);
+
+	// Render side.  Records the passes for passes.Submit, which has to
+	// come before the frame or resources change
+	void Record(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources);
+
+	// For the UI, from the last Prepare
+	unsigned int GetVisibleCount() { return (unsigned int)visibleEntities.size(); }
+	unsigned int GetCascadeCasterCount(unsigned int cascade) { return (unsigned int)cascadeCasters[cascade].size(); }
+	// Shadow caster draws, a caster counting once per cascade or tile
+	unsigned int GetShadowCasterCount();
+	ShadowCascades& GetShadowCascades() { return shadowCascades; }
+	ShadowAtlas& GetShadowAtlas() { return shadowAtlas; }
+	const LightClusters::Stats& GetClusterStats() { return lightClusters.GetStats(); }
+	const ObjectLights::Stats& GetObjectLightStats() { return objectLightLists.GetStats(); }
+
+	// For the render side's stats, from the last Record
+	const ShadowCache::Stats& GetShadowCacheStats() { return shadowCache.GetStats(); }
+
+	unsigned int GetShadowMapResolution() { return shadowMapResolution; }
+
+private:
+
+	// A structured buffer the pixel shader reads, grown to fit
+	struct ShaderBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+		unsigned int capacity = 0; // elements
+	};
+
+	void GrowShaderBuffer(ShaderBuffer& target, unsigned int stride, unsigned int count);
+	void RecordShadows(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources);
+	void RecordOpaque(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources);
+	void RecordPost(PassRecorder& passes, const SceneSnapshot& frame, const Resources& resources);
+
+	RenderDevice* device;
+	JobSystem* jobs;
+	unsigned int shadowMapResolution; // per cascade
+
+	// Simulation side
+	ShadowCascades shadowCascades;
+	ShadowAtlas shadowAtlas;
+	LightClusters lightClusters;
+	ObjectLights objectLightLists;
+	std::vector<unsigned int> visibleEntities;
+	std::vector<unsigned int> cascadeCasters[ShadowCascades::CASCADE_COUNT];
+	std::vector<std::vector<unsigned int>> tileCasters; // one per shadow atlas tile
+
+	// Both; Prepare tracks what each view would draw and Record
+	// decides which ones have to be drawn again
+	ShadowCache shadowCache;
+
+	// Render side
+	ShaderBuffer clusterLightBuffer;
+	ShaderBuffer clusterRangeBuffer;
+	ShaderBuffer clusterIndexBuffer;
+	PassRecorder* shadowRecorder = nullptr; // what the shadow cache's views were drawn with
+};
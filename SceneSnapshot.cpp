@@ -0,0 +1,125 @@
+#include "SceneSnapshot.h"
+
+using namespace DirectX;
+
+void UISnapshot::Copy(const ImDrawData* source)
+{
+	while (lists.size() < (size_t)source->CmdListsCount) {
+		lists.push_back(std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+	}
+
+	//copying the header copies the list pointers too, which get swapped for ours
+	data = *source;
+	for (int i = 0; i < source->CmdListsCount; ++i) {
+		const ImDrawList* from = source->CmdLists[i];
+		ImDrawList* to = lists[i].get();
+		to->CmdBuffer = from->CmdBuffer;
+		to->IdxBuffer = from->IdxBuffer;
+		to->VtxBuffer = from->VtxBuffer;
+		to->Flags = from->Flags;
+		data.CmdLists[i] = to;
+	}
+}
+
+void SceneSnapshot::DrawShadowCasters(SimpleVertexShader* vs, const std::vector<DepthItem>& casters) const
+{
+	for (const DepthItem& item : casters) {
+		vs->SetMatrix4x4("world", item.world);
+		vs->CopyAllBufferData();
+		item.mesh->Draw();
+	}
+}
+
+// --------------------------------------------------------
+// Material setup only happens when the material changes
+// between consecutive items, same as it used to when this
+// walked the entity store directly
+// --------------------------------------------------------
+void SceneSnapshot::DrawOpaque() const
+{
+	Material* current = nullptr;
+	for (const DrawItem& item : opaque) {
+		Material* material = item.material;
+		SimpleVertexShader* vs = material->GetVertexShader();
+		SimplePixelShader* ps = material->GetPixelShader();
+
+		if (material != current) {
+			material->PrepareMaterial(item.params, cameraPosition);
+			vs->SetMatrix4x4("viewMatrix", view);
+			vs->SetMatrix4x4("projectionMatrix", projection);
+			current = material;
+		}
+
+		switch (material->GetMaterialType()) {
+
+		case 2:
+			ps->SetFloat("timeInSeconds", totalTime);
+			break;
+
+		case 1: {
+			const XMFLOAT4& colorTint = item.params.colorTint;
+			ps->SetFloat4("colorTint", XMFLOAT4(colorTint.x * tint[0], colorTint.y * tint[1], colorTint.z * tint[2], colorTint.w * tint[3]));
+			break;
+		}
+
+		case 0:
+		default:
+			break;
+		}
+
+		if (objectLights) {
+			ps->SetInt("objectLightCount", (int)item.lightCount);
+			ps->SetData("objectLightIndices", item.lightIndices, sizeof(item.lightIndices));
+		}
+
+		vs->SetMatrix4x4("worldMatrix", item.world);
+		vs->SetMatrix4x4("worldInvTranspose", item.worldInvTranspose);
+
+		//actually send data we bound
+		ps->CopyAllBufferData();
+		vs->CopyAllBufferData();
+
+		item.mesh->Draw();
+	}
+}
+
+SnapshotBuffer::SnapshotBuffer()
+{
+	writeSlot = 0;
+	readSlot = 1;
+	middle = 2;
+}
+
+SnapshotBuffer::~SnapshotBuffer()
+{
+}
+
+void SnapshotBuffer::Publish()
+{
+	//release: the render thread sees everything written to the slot before it
+	unsigned int previous = middle.exchange(writeSlot | FRESH, std::memory_order_acq_rel);
+	writeSlot = previous & SLOT_MASK;
+	middle.notify_one();
+}
+
+SceneSnapshot* SnapshotBuffer::WaitForLatest()
+{
+	unsigned int state = middle.load(std::memory_order_acquire);
+	while ((state & (FRESH | CLOSED)) == 0) {
+		middle.wait(state, std::memory_order_acquire);
+		state = middle.load(std::memory_order_acquire);
+	}
+
+	unsigned int previous = middle.exchange(readSlot, std::memory_order_acq_rel);
+	if (previous & CLOSED) {
+		return nullptr;
+	}
+	readSlot = previous & SLOT_MASK;
+	return &slots[readSlot];
+}
+
+void SnapshotBuffer::Close()
+{
+	middle.fetch_or(CLOSED, std::memory_order_acq_rel);
+	middle.notify_all();
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Lights.h"
+#include "LightClusters.h"
+#include "ShadowCascades.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "SimpleShader.h"
+#include "ImGui/imgui.h"
+
+class BenchmarkRun;
+
+// An entity as the main pass sees it, copied out of the store
+struct DrawItem
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+	MaterialParams params;
+	Mesh* mesh;
+	Material* material;
+
+	// The lights this draw is lit by, in light order, when
+	// SceneSnapshot::objectLights is on (see ObjectLights)
+	unsigned int lightCount;
+	unsigned int lightIndices[MAX_OBJECT_LIGHTS];
+};
+
+// An entity as the shadow pass sees it
+struct DepthItem
+{
+	DirectX::XMFLOAT4X4 world;
+	Mesh* mesh;
+};
+
+// One shadow map cascade as the shadow pass sees it
+struct ShadowCascade
+{
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT4X4 viewProjection;
+	unsigned long long version; // see ShadowCache
+	std::vector<DepthItem> casters;
+};
+
+// One shadow atlas tile as the shadow pass sees it
+struct ShadowTile
+{
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT4X4 viewProjection;
+	unsigned int x; // texels from the atlas' top left
+	unsigned int y;
+	unsigned int size;
+	unsigned long long version;
+	std::vector<DepthItem> casters;
+};
+
+// --------------------------------------------------------
+// A deep copy of ImGui's draw data.  ImGui reuses its draw
+// lists as soon as the next frame starts, so the render
+// thread can't keep pointing at them
+// --------------------------------------------------------
+struct UISnapshot
+{
+	ImDrawData data;
+	std::vector<std::unique_ptr<ImDrawList>> lists;
+
+	void Copy(const ImDrawData* source);
+};
+
+// --------------------------------------------------------
+// Everything one rendered frame needs from the simulation,
+// copied out at the end of Update.  The render thread only
+// ever reads a snapshot, so the next Update can change the
+// scene freely while it's drawn.
+//
+// Meshes, materials and GPU resources are pointed to rather
+// than copied: they're created up front and outlive the
+// render thread.  Anything about them the UI can edit gets
+// copied in (DrawItem::params) like the rest.
+// --------------------------------------------------------
+struct SceneSnapshot
+{
+	unsigned long long frame = 0;
+	std::chrono::steady_clock::time_point simulated; // when Update finished with it
+	float totalTime = 0;
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	bool hasCamera = false;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT3 cameraPosition;
+
+	std::vector<Light> lights;
+	bool clusteredLighting = false;
+	ClusterGrid clusters; // only built for clusteredLighting
+	bool objectLights = false; // every DrawItem has its own light list
+	DirectX::XMFLOAT3 ambient;
+	bool skyLighting = false; // image based ambient from the sky (see SkyLighting)
+	float background[4];
+	float tint[4];
+
+	std::vector<DrawItem> opaque;
+
+	// lights[0]'s cascaded shadow map (see ShadowCascades).  With no
+	// camera or no directional light first, every split is 0
+	ShadowCascade cascades[ShadowCascades::CASCADE_COUNT];
+	DirectX::XMFLOAT4 shadowSplits; // far end of each cascade, view space depth
+	DirectX::XMFLOAT4 shadowDepthPlane; // like ClusterGrid::depthPlane
+
+	// Every other shadowed light's tiles (see ShadowAtlas), which
+	// Light::ShadowTile points into.  Empty with the atlas off
+	std::vector<ShadowTile> shadowTiles;
+	unsigned int shadowAtlasSize = 0;
+	bool shadowCaching = false; // views whose version was drawn already are skipped
+
+	int blurRadius = 0;
+	float chromaticOffsets[3];
+	int chromaticMode = 0;
+	DirectX::XMFLOAT2 mousePosition; // 0-1 across the window
+
+	bool deferredPasses = false; // record passes on worker threads
+	bool nullBackend = false; // record passes to NullRenderContext, draw nothing
+	bool softwareRaster = false; // null backend passes, SoftwareRasterizer draws
+
+	bool hasUI = true; // off for benchmarks
+	UISnapshot ui;
+	// Holds textures the UI shows alive until this snapshot is reused
+	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> uiTextures;
+
+	// Where the render thread reports this frame's numbers, if anywhere
+	BenchmarkRun* benchmark = nullptr;
+
+	// The caller binds the shadow vertex shader and the cascade's or tile's matrices first
+	void DrawShadowCasters(SimpleVertexShader* vs, const std::vector<DepthItem>& casters) const;
+	// Per-frame material data (lights, shadows) must already be set
+	void DrawOpaque() const;
+};
+
+// --------------------------------------------------------
+// Triple buffer handing snapshots from the simulation thread
+// to the render thread.
+//
+// Each side owns one slot outright and the third sits in the
+// middle.  Publishing swaps the writer's slot into the middle
+// and taking one swaps it back out, each a single atomic
+// exchange, so neither thread ever waits for the other to
+// finish with a slot.  The renderer always gets the newest
+// snapshot; ones it was too slow for are simply overwritten.
+// --------------------------------------------------------
+class SnapshotBuffer
+{
+public:
+
+	SnapshotBuffer();
+	~SnapshotBuffer();
+	SnapshotBuffer(const SnapshotBuffer&) = delete; // Remove copy constructor
+	SnapshotBuffer& operator=(const SnapshotBuffer&) = delete; // Remove copy-assignment operator
+
+	// Simulation side: fill in the slot from BeginWrite, then Publish it
+	SceneSnapshot& BeginWrite() { return slots[writeSlot]; }
+	void Publish();
+
+	// Render side: sleeps until there's something newer than the last
+	// snapshot taken, then returns it.  Returns nullptr after Close
+	SceneSnapshot* WaitForLatest();
+
+	// Wakes the render side for good, don't Publish afterwards
+	void Close();
+
+private:
+
+	static const unsigned int SLOT_MASK = 3;
+	static const unsigned int FRESH = 4; // middle slot hasn't been taken yet
+	static const unsigned int CLOSED = 8;
+
+	SceneSnapshot slots[3];
+	unsigned int writeSlot;
+	unsigned int readSlot;
+	std::atomic<unsigned int> middle; // slot index | flags
+};
@@ -7,6 +7,21 @@
 #define LIGHT_TYPE_SPOT 2
 #define MAX_SPECULAR_EXPONENT 256.0f
 #define MAX_LIGHT_COUNT 128
+#define MAX_OBJECT_LIGHTS 8
+
+// Light cluster grid, the same as LightClusters::GRID_*
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
+// Shadow map cascades, the same as ShadowCascades::CASCADE_COUNT
+#define SHADOW_CASCADE_COUNT 4
+
+// Shadow atlas tiles, the same as ShadowAtlas::MAX_TILES
+#define MAX_SHADOW_TILES 32
+
+// Sky BRDF table size, the same as SkyLighting::BRDF_LUT_SIZE
+#define BRDF_LUT_SIZE 64
 
 // A constant Fresnel value for non-metals (glass and plastic have values of about 0.04)
 static const float F0_NON_METAL = 0.04f;
@@ -35,7 +50,6 @@ struct VertexToPixel
     float3 normal : NORMAL;
     float3 worldPosition : POSITION;
     float3 tangent : TANGENT;
-    float4 shadowMapPos : SHADOW_POSITION;
 };
 
 //vertex to pixel for sky shaders SPECIFICALLY
@@ -75,7 +89,8 @@ struct Light
     float3 Color;
     float SpotInnerAngle;
     float SpotOuterAngle;
-    float2 Padding; //purposefully padding out 16 Byte Boundary
+    int ShadowTile; //first shadow atlas tile, -1 for none
+    float Padding; //purposefully padding out 16 Byte Boundary
 };
 
 float3 DirectionToLight(Light light, float3 worldPos)
@@ -168,6 +183,34 @@ float3 F_Schlick(float3 v, float3 h, float3 f0)
 
 
 
+// Fresnel term for light from every direction at once (image based
+// lighting), where rough surfaces never quite reach 1 at grazing angles
+//
+// NdotV - Normal dot view
+// f0 - Value when l = n
+float3 F_SchlickRoughness(float NdotV, float3 f0, float roughness)
+{
+    return f0 + (max(1 - roughness, f0) - f0) * pow(1 - saturate(NdotV), 5);
+}
+
+// Evaluates 9 spherical harmonic coefficients (see SkyLighting) in
+// direction n, which gives irradiance already divided by pi
+float3 EvaluateSH9(float4 sh[9], float3 n)
+{
+    float3 result = sh[0].rgb * 0.282095f
+        + sh[1].rgb * (0.488603f * n.y)
+        + sh[2].rgb * (0.488603f * n.z)
+        + sh[3].rgb * (0.488603f * n.x)
+        + sh[4].rgb * (1.092548f * n.x * n.y)
+        + sh[5].rgb * (1.092548f * n.y * n.z)
+        + sh[6].rgb * (0.315392f * (3 * n.z * n.z - 1))
+        + sh[7].rgb * (1.092548f * n.x * n.z)
+        + sh[8].rgb * (0.546274f * (n.x * n.x - n.y * n.y));
+    return max(result, 0);
+}
+
+
+
 // Geometric Shadowing - Schlick-GGX
 // - k is remapped to a / 2, roughness remapped to (r+1)/2 before squaring!
 //
@@ -224,6 +267,22 @@ float3 MicrofacetBRDF(float3 n, float3 l, float3 v, float roughness, float3 f0,
     return specularResult * max(dot(n, l), 0);
 }
 
+// Which light cluster a pixel is in (see LightClusters).  pixel is
+// SV_POSITION's xy, clusterScale is grid cells per pixel
+uint ClusterIndex(float2 pixel, float3 worldPos, float2 clusterScale, float4 depthPlane, float sliceNear, float sliceScale)
+{
+    uint x = min((uint)(pixel.x * clusterScale.x), CLUSTER_GRID_X - 1);
+    uint y = min((uint)(pixel.y * clusterScale.y), CLUSTER_GRID_Y - 1);
+    
+    float depth = dot(float4(worldPos, 1), depthPlane);
+    uint z = 0;
+    if (depth >= sliceNear)
+    {
+        z = min(1 + (uint)(log(depth / sliceNear) * sliceScale), CLUSTER_GRID_Z - 1);
+    }
+    return (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+}
+
 float PointAttenuate(Light light, float3 worldPos)
 {
     float dist = distance(light.Position, worldPos);
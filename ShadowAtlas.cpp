@@ -0,0 +1,205 @@
+#include "ShadowAtlas.h"
+#include "ShadowCascades.h"
+#include "ClipPlanes.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "ImGui/imstb_rectpack.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Smallest power of two at least value
+	unsigned int PowerOfTwoAbove(float value)
+	{
+		unsigned int result = 1;
+		while (result < value) {
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+ShadowAtlas::ShadowAtlas(unsigned int size)
+{
+	this->size = size;
+	nodes.resize(size);
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+}
+
+void ShadowAtlas::Allocate(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, std::vector<Light>& lights, float shadowDistance, float casterReach)
+{
+	stats = {};
+	requests.clear();
+	tiles.clear();
+
+	for (unsigned int i = 0; i < lights.size(); ++i) {
+		lights[i].ShadowTile = -1;
+		if (i == 0 && lights[i].Type == LIGHT_TYPE_DIRECTIONAL) {
+			continue;
+		}
+		float importance = Importance(lights[i], view, projection);
+		if (importance <= 0) {
+			continue;
+		}
+
+		Request request;
+		request.light = i;
+		request.importance = importance;
+		request.faces = lights[i].Type == LIGHT_TYPE_POINT ? 6 : 1;
+		request.tileSize = std::clamp(PowerOfTwoAbove(importance * MAX_TILE), MIN_TILE, request.faces > 1 ? MAX_TILE / 2 : MAX_TILE);
+		requests.push_back(request);
+	}
+	stats.candidates = (unsigned int)requests.size();
+
+	//most important first, ties in light order so nothing flickers
+	std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+		return a.importance != b.importance ? a.importance > b.importance : a.light < b.light;
+	});
+
+	//only so many tiles fit the shader's arrays
+	unsigned int tileCount = 0;
+	unsigned int kept = 0;
+	while (kept < requests.size() && tileCount + requests[kept].faces <= MAX_TILES) {
+		tileCount += requests[kept++].faces;
+	}
+	requests.resize(kept);
+
+	//shrink the least important light that still can, and once none
+	//can, drop it, until everything packs
+	while (!requests.empty() && !Pack()) {
+		unsigned int shrink = (unsigned int)requests.size();
+		while (shrink > 0 && requests[shrink - 1].tileSize == MIN_TILE) {
+			shrink--;
+		}
+		if (shrink > 0) {
+			requests[shrink - 1].tileSize /= 2;
+		}
+		else {
+			requests.pop_back();
+		}
+	}
+
+	//the projections need the camera's near and far planes, like ShadowCascades
+	float nearZ, farZ;
+	GetClipPlanes(projection, nearZ, farZ);
+	float directionalFar = std::max(std::min(shadowDistance, farZ), nearZ * 2);
+
+	const stbrp_rect* faceRects = rects.data();
+	for (const Request& request : requests) {
+		lights[request.light].ShadowTile = (int)tiles.size();
+		AddTiles(request, faceRects, lights[request.light], view, projection, nearZ, directionalFar, casterReach);
+		faceRects += request.faces;
+		stats.texels += request.faces * request.tileSize * request.tileSize;
+	}
+	stats.shadowed = (unsigned int)requests.size();
+	stats.dropped = stats.candidates - stats.shadowed;
+}
+
+// --------------------------------------------------------
+// The fraction of the screen's height a light's Range sphere
+// spans, 1 once the camera is inside it, 0 if it's out of
+// view.  Directional lights reach the whole screen
+// --------------------------------------------------------
+float ShadowAtlas::Importance(const Light& light, const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	if (light.Type == LIGHT_TYPE_DIRECTIONAL) {
+		return 1.0f;
+	}
+
+	XMFLOAT3 center;
+	XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&light.Position), XMLoadFloat4x4(&view)));
+	float r = light.Range;
+	float xScale = projection._11;
+	float yScale = projection._22;
+	float nearZ, farZ;
+	GetClipPlanes(projection, nearZ, farZ);
+
+	//the frustum's side planes through the eye, x * xScale = z and the rest
+	if (center.z + r < nearZ || center.z - r > farZ ||
+		(std::abs(center.x) * xScale - center.z) / std::sqrt(xScale * xScale + 1) > r ||
+		(std::abs(center.y) * yScale - center.z) / std::sqrt(yScale * yScale + 1) > r) {
+		return 0.0f;
+	}
+	if (center.z - r <= nearZ) {
+		return 1.0f;
+	}
+	return std::min(r * yScale / center.z, 1.0f);
+}
+
+bool ShadowAtlas::Pack()
+{
+	rects.clear();
+	unsigned int area = 0;
+	for (unsigned int i = 0; i < requests.size(); ++i) {
+		for (unsigned int face = 0; face < requests[i].faces; ++face) {
+			stbrp_rect rect = {};
+			rect.id = (int)i;
+			rect.w = requests[i].tileSize;
+			rect.h = requests[i].tileSize;
+			rects.push_back(rect);
+		}
+		area += requests[i].faces * requests[i].tileSize * requests[i].tileSize;
+	}
+
+	//not worth trying when the area alone is too much
+	if (area > size * size) {
+		return false;
+	}
+
+	stbrp_context context;
+	stbrp_init_target(&context, size, size, nodes.data(), (int)nodes.size());
+	return stbrp_pack_rects(&context, rects.data(), (int)rects.size()) == 1;
+}
+
+void ShadowAtlas::AddTiles(const Request& request, const stbrp_rect* faceRects, const Light& light, const XMFLOAT4X4& view, const XMFLOAT4X4& projection, float directionalNear, float directionalFar, float casterReach)
+{
+	//cube faces in the order the shader picks them: +x -x +y -y +z -z
+	static const XMFLOAT3 faceDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	static const XMFLOAT3 faceUps[6] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+
+	for (unsigned int face = 0; face < request.faces; ++face) {
+		Tile tile;
+		tile.light = request.light;
+		tile.x = faceRects[face].x;
+		tile.y = faceRects[face].y;
+		tile.size = request.tileSize;
+
+		if (light.Type == LIGHT_TYPE_DIRECTIONAL) {
+			ShadowCascades::Cascade cascade;
+			ShadowCascades::FitSlice(view, projection, light.Direction, directionalNear, directionalFar, tile.size, casterReach, cascade);
+			tile.view = cascade.view;
+			tile.projection = cascade.projection;
+			tile.viewProjection = cascade.viewProjection;
+			tile.cullViewProjection = cascade.cullViewProjection;
+		}
+		else {
+			XMVECTOR position = XMLoadFloat3(&light.Position);
+			XMMATRIX lightView;
+			float fov;
+			if (light.Type == LIGHT_TYPE_SPOT) {
+				XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.Direction));
+				XMVECTOR up = std::abs(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+				lightView = XMMatrixLookToLH(position, direction, up);
+				fov = 2 * std::clamp(light.SpotOuterAngle, 0.01f, MAX_SPOT_ANGLE);
+			}
+			else {
+				lightView = XMMatrixLookToLH(position, XMLoadFloat3(&faceDirections[face]), XMLoadFloat3(&faceUps[face]));
+				fov = XM_PIDIV2;
+			}
+			XMMATRIX lightProjection = XMMatrixPerspectiveFovLH(fov, 1.0f, light.Range * 0.01f, light.Range);
+			XMStoreFloat4x4(&tile.view, lightView);
+			XMStoreFloat4x4(&tile.projection, lightProjection);
+			XMStoreFloat4x4(&tile.viewProjection, XMMatrixMultiply(lightView, lightProjection));
+			tile.cullViewProjection = tile.viewProjection;
+		}
+		tiles.push_back(tile);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Lights.h"
+
+struct stbrp_node;
+struct stbrp_rect;
+
+// --------------------------------------------------------
+// Shadows for every light but the cascaded one, packed as
+// square tiles into one depth texture.
+//
+// Each frame, the lights that can reach the view are ranked
+// by screen importance: how much of the screen their Range
+// sphere covers (directional lights cover all of it).  That
+// picks each light's tile size, a power of two, and tiles
+// are packed with stb_rect_pack in importance order.  When
+// they don't fit, the least important lights' tiles shrink
+// first, and past the smallest size they're dropped.
+//
+// A spot light gets one perspective tile, a point light six
+// (one per cube face, +x -x +y -y +z -z), and a directional
+// light one cascade over the whole shadow distance.  The
+// light's ShadowTile is set to its first tile, or -1
+// --------------------------------------------------------
+class ShadowAtlas
+{
+public:
+
+	// Tiles the pixel shader can read, the same as MAX_SHADOW_TILES in ShaderHeaders.hlsli
+	static const unsigned int MAX_TILES = 32;
+	static constexpr unsigned int MIN_TILE = 128;
+	static constexpr unsigned int MAX_TILE = 2048;
+
+	struct Tile
+	{
+		unsigned int light;
+		unsigned int x; // texels from the atlas' top left
+		unsigned int y;
+		unsigned int size;
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+		DirectX::XMFLOAT4X4 viewProjection;
+		DirectX::XMFLOAT4X4 cullViewProjection; // directional tiles pull the near plane back for casters
+	};
+
+	struct Stats
+	{
+		unsigned int candidates; // lights that could use a shadow this frame
+		unsigned int shadowed;
+		unsigned int dropped; // no room left, even at MIN_TILE
+		unsigned int texels; // covered by tiles
+	};
+
+	explicit ShadowAtlas(unsigned int size);
+	~ShadowAtlas();
+	ShadowAtlas(const ShadowAtlas&) = delete; // Remove copy constructor
+	ShadowAtlas& operator=(const ShadowAtlas&) = delete; // Remove copy-assignment operator
+
+	// Picks and packs this frame's tiles for a camera, and sets every
+	// light's ShadowTile.  lights[0], when directional, is skipped: it has
+	// the ShadowCascades.  Directional tiles reach shadowDistance, with
+	// casters up to casterReach in front, like the cascades
+	void Allocate(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, std::vector<Light>& lights, float shadowDistance, float casterReach);
+
+	unsigned int GetSize() { return size; }
+	const std::vector<Tile>& GetTiles() { return tiles; }
+	const Stats& GetStats() { return stats; }
+
+private:
+
+	// Spot cones past this (in radians from the axis) get clamped
+	static constexpr float MAX_SPOT_ANGLE = DirectX::XM_PI / 3;
+
+	// A light that wants a shadow, and the size it gets
+	struct Request
+	{
+		unsigned int light;
+		float importance;
+		unsigned int faces; // tiles, all the same size
+		unsigned int tileSize;
+	};
+
+	float Importance(const Light& light, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+	bool Pack();
+	void AddTiles(const Request& request, const stbrp_rect* faceRects, const Light& light, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, float directionalNear, float directionalFar, float casterReach);
+
+	unsigned int size;
+	Stats stats = {};
+	std::vector<Request> requests;
+	std::vector<Tile> tiles;
+	std::vector<stbrp_rect> rects; // every request's faces, in request order
+	std::vector<stbrp_node> nodes;
+};
@@ -0,0 +1,80 @@
+#include "ShadowCache.h"
+
+#include <cstring>
+
+using namespace DirectX;
+
+ShadowCache::ShadowCache()
+{
+}
+
+ShadowCache::~ShadowCache()
+{
+}
+
+unsigned long long ShadowCache::Track(unsigned int view, const XMFLOAT4X4& viewProjection, unsigned int x, unsigned int y, unsigned int size,
+	const std::vector<unsigned int>& casters, unsigned long long casterChangeTick, unsigned long long tick)
+{
+	TrackedView& entry = tracked[view];
+
+	//exact compares: anything recomputed the same way comes out bit for bit the same
+	bool same = entry.version != NONE &&
+		casterChangeTick < entry.tick &&
+		entry.x == x && entry.y == y && entry.size == size &&
+		std::memcmp(&entry.viewProjection, &viewProjection, sizeof(XMFLOAT4X4)) == 0 &&
+		entry.casters == casters;
+	if (!same) {
+		entry.viewProjection = viewProjection;
+		entry.x = x;
+		entry.y = y;
+		entry.size = size;
+		entry.casters = casters;
+		entry.tick = tick;
+		entry.version = nextVersion++;
+	}
+	return entry.version;
+}
+
+bool ShadowCache::NeedsRedraw(unsigned int view, unsigned long long version, unsigned int x, unsigned int y, unsigned int size, unsigned int casterCount)
+{
+	DrawnView& entry = drawn[view];
+	if (entry.version == version && entry.x == x && entry.y == y && entry.size == size) {
+		stats.reused++;
+		stats.totalReused++;
+		stats.castersSkipped += casterCount;
+		return false;
+	}
+
+	//tiles share the atlas, so whatever this draws over is gone
+	if (view >= ShadowCascades::CASCADE_COUNT) {
+		for (unsigned int other = ShadowCascades::CASCADE_COUNT; other < MAX_VIEWS; ++other) {
+			DrawnView& old = drawn[other];
+			if (other != view && old.version != NONE &&
+				old.x < x + size && x < old.x + old.size && old.y < y + size && y < old.y + old.size) {
+				old.version = NONE;
+			}
+		}
+	}
+
+	entry.x = x;
+	entry.y = y;
+	entry.size = size;
+	entry.version = version;
+	stats.redrawn++;
+	stats.totalRedrawn++;
+	return true;
+}
+
+void ShadowCache::Invalidate()
+{
+	for (DrawnView& entry : drawn) {
+		entry.version = NONE;
+	}
+}
+
+void ShadowCache::ResetStats()
+{
+	stats.redrawn = 0;
+	stats.reused = 0;
+	stats.castersSkipped = 0;
+}
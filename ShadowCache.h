@@ -0,0 +1,99 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "ShadowCascades.h"
+#include "ShadowAtlas.h"
+
+// --------------------------------------------------------
+// Keeps shadow views (the cascades and the atlas tiles) that
+// would draw exactly what they drew before from being drawn
+// again.
+//
+// The simulation side gives each view a version, bumped when
+// what it would draw changes:
+//  - its matrices or atlas rect differ, which covers the
+//    light and, for the cascades, the camera
+//  - its caster list differs
+//  - a caster's transform changed since the version was
+//    handed out (see EntityStore::GetChangeTick).  A caster
+//    that moved this tick is drawn interpolated, so its views
+//    stay dirty until a tick goes by without it moving
+//
+// The render side remembers the version each view was last
+// drawn at, so snapshots the render thread never drew can't
+// leave a view stale.  Redrawing a tile also forgets any
+// other tile whose old rect it drew over.
+// --------------------------------------------------------
+class ShadowCache
+{
+public:
+
+	// Cascades first, then atlas tiles
+	static const unsigned int MAX_VIEWS = ShadowCascades::CASCADE_COUNT + ShadowAtlas::MAX_TILES;
+	static unsigned int TileView(unsigned int tile) { return ShadowCascades::CASCADE_COUNT + tile; }
+
+	struct Stats
+	{
+		unsigned int redrawn; // this frame
+		unsigned int reused;
+		unsigned int castersSkipped; // caster draws the reused views saved
+		unsigned long long totalRedrawn; // since the start
+		unsigned long long totalReused;
+	};
+
+	ShadowCache();
+	~ShadowCache();
+	ShadowCache(const ShadowCache&) = delete; // Remove copy constructor
+	ShadowCache& operator=(const ShadowCache&) = delete; // Remove copy-assignment operator
+
+	// Simulation side: the version of what a view draws this frame.
+	// casterChangeTick is EntityStore::GetChangeTick of the casters,
+	// tick the pool's current one.  Cascades have no rect
+	unsigned long long Track(unsigned int view, const DirectX::XMFLOAT4X4& viewProjection, unsigned int x, unsigned int y, unsigned int size,
+		const std::vector<unsigned int>& casters, unsigned long long casterChangeTick, unsigned long long tick);
+
+	// Render side: whether a view has to be drawn for this version, and
+	// if so it counts as drawn from here on.  Call for every view drawn
+	// this frame, after ResetStats
+	bool NeedsRedraw(unsigned int view, unsigned long long version, unsigned int x, unsigned int y, unsigned int size, unsigned int casterCount);
+	// Forget everything drawn, when the shadow maps were drawn somewhere else
+	void Invalidate();
+	void ResetStats();
+	const Stats& GetStats() { return stats; }
+
+private:
+
+	// A version no view is ever drawn at
+	static const unsigned long long NONE = 0;
+
+	// What a view drew at its current version
+	struct TrackedView
+	{
+		DirectX::XMFLOAT4X4 viewProjection;
+		unsigned int x;
+		unsigned int y;
+		unsigned int size;
+		std::vector<unsigned int> casters;
+		unsigned long long tick; // when the version was handed out
+		unsigned long long version = NONE;
+	};
+
+	// What's in a view's part of the shadow maps
+	struct DrawnView
+	{
+		unsigned int x;
+		unsigned int y;
+		unsigned int size;
+		unsigned long long version = NONE;
+	};
+
+	// Simulation side
+	TrackedView tracked[MAX_VIEWS];
+	unsigned long long nextVersion = 1;
+
+	// Render side
+	DrawnView drawn[MAX_VIEWS];
+	Stats stats = {};
+};
@@ -0,0 +1,114 @@
+#include "ShadowCascades.h"
+#include "ClipPlanes.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+ShadowCascades::ShadowCascades()
+{
+	for (Cascade& cascade : cascades) {
+		XMStoreFloat4x4(&cascade.view, XMMatrixIdentity());
+		XMStoreFloat4x4(&cascade.projection, XMMatrixIdentity());
+		XMStoreFloat4x4(&cascade.viewProjection, XMMatrixIdentity());
+		XMStoreFloat4x4(&cascade.cullViewProjection, XMMatrixIdentity());
+		cascade.splitNear = 0;
+		cascade.splitFar = 0;
+		cascade.texelSize = 0;
+	}
+}
+
+ShadowCascades::~ShadowCascades()
+{
+}
+
+void ShadowCascades::Fit(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, XMFLOAT3 lightDirection, unsigned int resolution)
+{
+	float xScale = projection._11;
+	float yScale = projection._22;
+	float nearZ, farZ;
+	GetClipPlanes(projection, nearZ, farZ);
+	float shadowFar = std::max(std::min(shadowDistance, farZ), nearZ * 2);
+
+	XMMATRIX cameraWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&view));
+	XMMATRIX lightView = LightView(lightDirection);
+
+	for (unsigned int i = 0; i < CASCADE_COUNT; ++i) {
+		float t = (float)(i + 1) / CASCADE_COUNT;
+		float logSplit = nearZ * std::pow(shadowFar / nearZ, t);
+		float linearSplit = nearZ + (shadowFar - nearZ) * t;
+
+		Cascade& cascade = cascades[i];
+		cascade.splitNear = i == 0 ? nearZ : cascades[i - 1].splitFar;
+		cascade.splitFar = i == CASCADE_COUNT - 1 ? shadowFar : splitLambda * logSplit + (1 - splitLambda) * linearSplit;
+		XMStoreFloat4x4(&cascade.view, lightView);
+		FitCascade(cascade, cameraWorld, lightView, xScale, yScale, resolution, casterReach);
+	}
+}
+
+void ShadowCascades::FitSlice(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, XMFLOAT3 lightDirection, float splitNear, float splitFar, unsigned int resolution, float casterReach, Cascade& cascade)
+{
+	XMMATRIX lightView = LightView(lightDirection);
+	cascade.splitNear = splitNear;
+	cascade.splitFar = splitFar;
+	XMStoreFloat4x4(&cascade.view, lightView);
+	FitCascade(cascade, XMMatrixInverse(nullptr, XMLoadFloat4x4(&view)), lightView, projection._11, projection._22, resolution, casterReach);
+}
+
+// --------------------------------------------------------
+// The light camera sits at the origin, so following the
+// camera only ever moves a cascade's projection and never
+// turns it
+// --------------------------------------------------------
+XMMATRIX ShadowCascades::LightView(XMFLOAT3 lightDirection)
+{
+	XMVECTOR toLight = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+	XMVECTOR up = std::abs(XMVectorGetY(toLight)) > 0.99f ? XMVectorSet(0, 0, 1, 0) : XMVectorSet(0, 1, 0, 0);
+	return XMMatrixLookToLH(XMVectorZero(), XMVectorNegate(toLight), up);
+}
+
+// --------------------------------------------------------
+// A slice's corners at view depth d are d * (+-1 / xScale,
+// +-1 / yScale, 1).  The smallest sphere around them is
+// centered on the view axis where the near and far corners
+// are equally far away, or at the far end for slices wider
+// than they are deep
+// --------------------------------------------------------
+void ShadowCascades::FitCascade(Cascade& cascade, FXMMATRIX cameraWorld, CXMMATRIX lightView, float xScale, float yScale, unsigned int resolution, float casterReach)
+{
+	float dn = cascade.splitNear;
+	float df = cascade.splitFar;
+	float slopeSq = 1 / (xScale * xScale) + 1 / (yScale * yScale);
+	float center = std::min((dn + df) * (1 + slopeSq) * 0.5f, df);
+	float radius = std::sqrt(std::max((center - dn) * (center - dn) + dn * dn * slopeSq, (df - center) * (df - center) + df * df * slopeSq));
+
+	//a texel of margin, so snapping never uncovers the sphere
+	radius *= (float)resolution / (resolution - 2);
+	cascade.texelSize = 2 * radius / resolution;
+
+	XMMATRIX viewToLight = XMMatrixMultiply(cameraWorld, lightView);
+	XMFLOAT3 lightCenter;
+	XMStoreFloat3(&lightCenter, XMVector3TransformCoord(XMVectorSet(0, 0, center, 1), viewToLight));
+	float x = std::floor(lightCenter.x / cascade.texelSize) * cascade.texelSize;
+	float y = std::floor(lightCenter.y / cascade.texelSize) * cascade.texelSize;
+
+	//depth only needs to cover the slice itself
+	float minZ = FLT_MAX;
+	float maxZ = -FLT_MAX;
+	for (int corner = 0; corner < 8; ++corner) {
+		float d = (corner & 4) ? df : dn;
+		float sx = (corner & 1) ? 1.0f : -1.0f;
+		float sy = (corner & 2) ? 1.0f : -1.0f;
+		float z = XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(sx * d / xScale, sy * d / yScale, d, 1), viewToLight));
+		minZ = std::min(minZ, z);
+		maxZ = std::max(maxZ, z);
+	}
+
+	XMMATRIX projection = XMMatrixOrthographicOffCenterLH(x - radius, x + radius, y - radius, y + radius, minZ, maxZ);
+	XMMATRIX cullProjection = XMMatrixOrthographicOffCenterLH(x - radius, x + radius, y - radius, y + radius, minZ - casterReach, maxZ);
+	XMStoreFloat4x4(&cascade.projection, projection);
+	XMStoreFloat4x4(&cascade.viewProjection, XMMatrixMultiply(lightView, projection));
+	XMStoreFloat4x4(&cascade.cullViewProjection, XMMatrixMultiply(lightView, cullProjection));
+}
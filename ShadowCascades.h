@@ -0,0 +1,76 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Cascaded shadow maps for a directional light, refitted to
+// the camera every frame.
+//
+// The view frustum, out to the shadow distance, is cut into
+// CASCADE_COUNT slices with the practical split scheme: a
+// blend (by lambda) of logarithmic splits, which match how
+// screen space texels grow with depth, and linear ones,
+// which keep the near slices from getting too thin.  Each
+// slice gets its own orthographic light camera:
+//  - Across, it covers the slice's bounding sphere.  Its
+//    size doesn't change as the camera turns, so snapping
+//    its center to whole shadow map texels keeps shadow
+//    edges from crawling as the camera moves
+//  - In depth, it's fitted to the slice's corners.  Casters
+//    in front of that get flattened onto the near plane (the
+//    shadow rasterizer doesn't clip depth), so they're culled
+//    with the near plane pulled back by casterReach instead
+// --------------------------------------------------------
+class ShadowCascades
+{
+public:
+
+	// Cascades, the same as SHADOW_CASCADE_COUNT in ShaderHeaders.hlsli.
+	// The shader keeps the splits in a float4, so at most 4
+	static const unsigned int CASCADE_COUNT = 4;
+
+	struct Cascade
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+		DirectX::XMFLOAT4X4 viewProjection;
+		DirectX::XMFLOAT4X4 cullViewProjection; // near plane pulled back for casters
+		float splitNear; // view space depth
+		float splitFar;
+		float texelSize; // world units across one shadow map texel
+	};
+
+	ShadowCascades();
+	~ShadowCascades();
+
+	// Fits every cascade to a camera.  The projection has to be a
+	// symmetric perspective one, like every Camera makes.
+	// lightDirection points toward the light, like Light::Direction
+	void Fit(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, DirectX::XMFLOAT3 lightDirection, unsigned int resolution);
+
+	const Cascade& GetCascade(unsigned int index) { return cascades[index]; }
+
+	// A single cascade from view depth splitNear to splitFar, for
+	// directional lights that only get one (see ShadowAtlas)
+	static void FitSlice(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, DirectX::XMFLOAT3 lightDirection, float splitNear, float splitFar, unsigned int resolution, float casterReach, Cascade& cascade);
+
+	// 0 is linear splits, 1 logarithmic
+	float GetSplitLambda() { return splitLambda; }
+	void SetSplitLambda(float lambda) { splitLambda = lambda; }
+	// How far from the camera shadows reach, at most the far plane
+	float GetShadowDistance() { return shadowDistance; }
+	void SetShadowDistance(float distance) { shadowDistance = distance; }
+	// How far in front of a cascade casters are still drawn
+	float GetCasterReach() { return casterReach; }
+	void SetCasterReach(float reach) { casterReach = reach; }
+
+private:
+
+	static DirectX::XMMATRIX LightView(DirectX::XMFLOAT3 lightDirection);
+	static void FitCascade(Cascade& cascade, DirectX::FXMMATRIX cameraWorld, DirectX::CXMMATRIX lightView, float xScale, float yScale, unsigned int resolution, float casterReach);
+
+	Cascade cascades[CASCADE_COUNT];
+	float splitLambda = 0.75f;
+	float shadowDistance = 100;
+	float casterReach = 200;
+};
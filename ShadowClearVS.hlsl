@@ -0,0 +1,8 @@
+// Covers the whole viewport at the far plane.  Drawn with the depth test
+// always passing, it clears one shadow atlas tile without touching the
+// tiles around it (see ShadowCache)
+float4 main(uint id : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((id << 1) & 2, id & 2);
+    return float4(uv.x * 2 - 1, uv.y * -2 + 1, 1, 1);
+}
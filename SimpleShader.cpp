@@ -1,5 +1,8 @@
 #include "SimpleShader.h"
 
+#include <cstdio>
+#include <cstring>
+
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
@@ -11,19 +14,23 @@ bool ISimpleShader::ReportWarnings = false;
 // ISimpleShader::ReportErrors = true;
 // ISimpleShader::ReportWarnings = true;
 
+// Shaders are created through a RenderDevice, and bind and
+// copy through StateCache::Current(), so the same objects
+// draw to the GPU, into a deferred context or into a
+// NullRenderContext depending on who is recording.
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
 // --------------------------------------------------------
-// Constructor accepts Direct3D device & context
+// Constructor accepts the device to create resources on
 // --------------------------------------------------------
-ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+ISimpleShader::ISimpleShader(RenderDevice* device)
 {
 	// Save the device
 	this->device = device;
-	this->deviceContext = context;
 
 	// Set up fields
 	this->constantBufferCount = 0;
@@ -80,151 +87,83 @@ void ISimpleShader::CleanUp()
 // --------------------------------------------------------
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 {
-	// Load the shader to a blob and ensure it worked
-	HRESULT hr = D3DReadFileToBlob(shaderFile, shaderBlob.GetAddressOf());
-	if (hr != S_OK)
-	{
-		if (ReportErrors)
-		{
-			LogError("SimpleShader::LoadShaderFile() - Error loading file '");
-			LogW(shaderFile);
-			LogError("'. Ensure this file exists and is spelled correctly.\n");
-		}
-
-		return false;
-	}
-
 	// Create the shader - Calls an overloaded version of this abstract
-	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
+	// method in the appropriate child class, which also reflects it
+	// to get information about its variables, buffers, etc.
+	ShaderReflection reflection;
+	shaderValid = CreateShader(shaderFile, reflection);
 	if (!shaderValid)
 	{
 		if (ReportErrors)
 		{
-			LogError("SimpleShader::LoadShaderFile() - Error creating shader from file '");
+			LogError("SimpleShader::LoadShaderFile() - Error loading shader from file '");
 			LogW(shaderFile);
-			LogError("'. Ensure the type of shader (vertex, pixel, etc.) matches the SimpleShader type (SimpleVertexShader, SimplePixelShader, etc.) you're using.\n");
+			LogError("'. Ensure this file exists and that the type of shader (vertex, pixel) matches the SimpleShader type (SimpleVertexShader, SimplePixelShader) you're using.\n");
 		}
 
 		return false;
 	}
 
-	// Set up shader reflection to get information about
-	// this shader and its variables,  buffers, etc.
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
+	constantBufferCount = (unsigned int)reflection.constantBuffers.size();
 	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
-	// Handle bound resources (like shaders and samplers)
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
-	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
 
-		// Check the type
-		switch (resourceDesc.Type)
-		{
-		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
-		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
+	// Handle bound resources (like textures and samplers)
+	for (const ShaderReflection::Resource& texture : reflection.textures)
+	{
+		// Create the SRV wrapper
+		SimpleSRV* srv = new SimpleSRV();
+		srv->BindIndex = texture.bindIndex;						// Shader bind point
+		srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
 
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
-			break;
+		textureTable.insert(std::pair<std::string, SimpleSRV*>(texture.name, srv));
+		shaderResourceViews.push_back(srv);
+	}
 
-		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
+	for (const ShaderReflection::Resource& sampler : reflection.samplers)
+	{
+		// Create the sampler wrapper
+		SimpleSampler* samp = new SimpleSampler();
+		samp->BindIndex = sampler.bindIndex;				// Shader bind point
+		samp->Index = (unsigned int)samplerStates.size();	// Raw index
 
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
-			break;
-		}
+		samplerTable.insert(std::pair<std::string, SimpleSampler*>(sampler.name, samp));
+		samplerStates.push_back(samp);
 	}
 
 	// Loop through all constant buffers
 	for (unsigned int b = 0; b < constantBufferCount; b++)
 	{
 		// Get this buffer
-		ID3D11ShaderReflectionConstantBuffer* cb =
-			refl->GetConstantBufferByIndex(b);
-		
-		// Get the description of this buffer
-		D3D11_SHADER_BUFFER_DESC bufferDesc;
-		cb->GetDesc(&bufferDesc);
+		const ShaderReflection::ConstantBuffer& bufferDesc = reflection.constantBuffers[b];
 
 		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-		
-		// Get the description of the resource binding, so
-		// we know exactly how it's bound in the shader
-		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)bufferDesc.type;
+
 		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
+		constantBuffers[b].BindIndex = bufferDesc.bindIndex;
+		constantBuffers[b].Name = bufferDesc.name;
+		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.name, &constantBuffers[b]));
 
 		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc = {};
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
+		device->CreateConstantBuffer(((bufferDesc.size + 15) / 16) * 16, constantBuffers[b].ConstantBuffer.GetAddressOf()); // Quick and dirty 16-byte alignment using integer division
 
 		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		constantBuffers[b].Size = bufferDesc.size;
+		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.size];
+		memset(constantBuffers[b].LocalDataBuffer, 0, bufferDesc.size);
 
 		// Loop through all variables in this buffer
-		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		for (const ShaderReflection::Variable& varDesc : bufferDesc.variables)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
-			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
-
 			// Create the variable struct
 			SimpleShaderVariable varStruct = {};
 			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
+			varStruct.ByteOffset = varDesc.offset;
+			varStruct.Size = varDesc.size;
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varDesc.name, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
@@ -284,6 +223,7 @@ SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
 // --------------------------------------------------------
 void ISimpleShader::Log(std::string message, WORD color)
 {
+#if defined(_WIN32)
 	// Swap console color
 	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 	SetConsoleTextAttribute(hConsole, color);
@@ -293,6 +233,11 @@ void ISimpleShader::Log(std::string message, WORD color)
 
 	// Swap back
 	SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#else
+	// No console colors or output window anywhere else
+	(void)color;
+	printf("%s", message.c_str());
+#endif
 }
 
 // --------------------------------------------------------
@@ -301,6 +246,7 @@ void ISimpleShader::Log(std::string message, WORD color)
 // --------------------------------------------------------
 void ISimpleShader::LogW(std::wstring message, WORD color)
 {
+#if defined(_WIN32)
 	// Swap console color
 	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 	SetConsoleTextAttribute(hConsole, color);
@@ -310,6 +256,11 @@ void ISimpleShader::LogW(std::wstring message, WORD color)
 
 	// Swap back
 	SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#else
+	// No console colors or output window anywhere else
+	(void)color;
+	printf("%ls", message.c_str());
+#endif
 }
 
 
@@ -349,9 +300,7 @@ void ISimpleShader::CopyAllBufferData()
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
 		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		StateCache::Current()->UpdateConstantBuffer(constantBuffers[i].ConstantBuffer.Get(), constantBuffers[i].LocalDataBuffer, constantBuffers[i].Size);
 	}
 }
 
@@ -380,9 +329,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	StateCache::Current()->UpdateConstantBuffer(cb->ConstantBuffer.Get(), cb->LocalDataBuffer, cb->Size);
 }
 
 // --------------------------------------------------------
@@ -402,9 +349,7 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	StateCache::Current()->UpdateConstantBuffer(cb->ConstantBuffer.Get(), cb->LocalDataBuffer, cb->Size);
 }
 
 
@@ -691,32 +636,9 @@ const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(unsigned int index)
 // --------------------------------------------------------
 // Constructor just calls the base
 // --------------------------------------------------------
-SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile)
-	: ISimpleShader(device, context) 
+SimpleVertexShader::SimpleVertexShader(RenderDevice* device, LPCWSTR shaderFile)
+	: ISimpleShader(device) 
 { 
-	// Ensure we set to zero to successfully trigger
-	// the Input Layout creation during LoadShaderFile()
-	this->perInstanceCompatible = false;
-
-	// Load the actual compiled shader file
-	this->LoadShaderFile(shaderFile);
-}
-
-// --------------------------------------------------------
-// Constructor overload which takes a custom input layout
-//
-// Passing in a valid input layout will stop LoadShaderFile()
-// from creating an input layout from shader reflection
-// --------------------------------------------------------
-SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile, Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout, bool perInstanceCompatible)
-	: ISimpleShader(device, context)
-{
-	// Save the custom input layout
-	this->inputLayout = inputLayout;
-
-	// Unable to determine from an input layout, require user to tell us
-	this->perInstanceCompatible = perInstanceCompatible;
-
 	// Load the actual compiled shader file
 	this->LoadShaderFile(shaderFile);
 }
@@ -738,125 +660,22 @@ void SimpleVertexShader::CleanUp()
 }
 
 // --------------------------------------------------------
-// Creates the  Direct3D vertex shader
+// Creates the  Direct3D vertex shader, along with an input
+// layout matching what it expects
 //
-// shaderBlob - The shader's compiled code
+// shaderFile - The compiled shader to load
+// reflection - Filled in with what the shader binds
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
+bool SimpleVertexShader::CreateShader(LPCWSTR shaderFile, ShaderReflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
 	this->CleanUp();
 
-	// Create the shader from the blob
-	HRESULT result = device->CreateVertexShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Did the creation work?
-	if (result != S_OK)
-		return false;
-
-	// Do we already have an input layout?
-	// (This would come from one of the constructor overloads)
-	if (inputLayout)
-		return true;
-
-	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
-	// matches what the vertex shader expects.  Code adapted from:
-	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
-
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Read input layout description from shader info
-	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
-	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
-		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
-		bool isPerInstance = 
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
-
-		// Fill out input element desc
-		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
-		elementDesc.SemanticName = paramDesc.SemanticName;
-		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
-		elementDesc.InputSlot = 0;
-		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-		elementDesc.InstanceDataStepRate = 0;
-
-		// Replace anything affected by "per instance" data
-		if (isPerInstance)
-		{
-			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
-			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
-			elementDesc.InstanceDataStepRate = 1;
-
-			perInstanceCompatible = true;
-		}
-
-		// Determine DXGI format
-		if (paramDesc.Mask == 1)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 3)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 7)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 15)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		}
-
-		// Save element desc
-		inputLayoutDesc.push_back(elementDesc);
-	}
-
-	// Try to create Input Layout
-	HRESULT hr = device->CreateInputLayout(
-		&inputLayoutDesc[0], 
-		(unsigned int)inputLayoutDesc.size(), 
-		shaderBlob->GetBufferPointer(), 
-		shaderBlob->GetBufferSize(),
-		inputLayout.GetAddressOf());
-
-	// All done, clean up
-	return true;
+	// Load the shader and build its input layout
+	return device->LoadVertexShader(shaderFile, shader.GetAddressOf(), inputLayout.GetAddressOf(), reflection);
 }
 
 // --------------------------------------------------------
@@ -869,8 +688,9 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	StateCache* states = StateCache::Current();
+	states->IASetInputLayout(inputLayout.Get());
+	states->VSSetShader(shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -880,10 +700,7 @@ void SimpleVertexShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		states->VSSetConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
 	}
 }
 
@@ -911,7 +728,7 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	StateCache::Current()->VSSetShaderResource(srvInfo->BindIndex, srv.Get());
 
 	// Success
 	return true;
@@ -941,7 +758,7 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	StateCache::Current()->VSSetSampler(sampInfo->BindIndex, samplerState.Get());
 
 	// Success
 	return true;
@@ -955,8 +772,8 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 // --------------------------------------------------------
 // Constructor just calls the base
 // --------------------------------------------------------
-SimplePixelShader::SimplePixelShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile)
-	: ISimpleShader(device, context) 
+SimplePixelShader::SimplePixelShader(RenderDevice* device, LPCWSTR shaderFile)
+	: ISimpleShader(device) 
 { 
 	// Load the actual compiled shader file
 	this->LoadShaderFile(shaderFile);
@@ -981,25 +798,19 @@ void SimplePixelShader::CleanUp()
 // --------------------------------------------------------
 // Creates the  Direct3D pixel shader
 //
-// shaderBlob - The shader's compiled code
+// shaderFile - The compiled shader to load
+// reflection - Filled in with what the shader binds
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
+bool SimplePixelShader::CreateShader(LPCWSTR shaderFile, ShaderReflection& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
 	this->CleanUp();
 
-	// Create the shader from the blob
-	HRESULT result = device->CreatePixelShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Check the result
-	return (result == S_OK);
+	// Load the shader
+	return device->LoadPixelShader(shaderFile, shader.GetAddressOf(), reflection);
 }
 
 // --------------------------------------------------------
@@ -1012,7 +823,8 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	StateCache* states = StateCache::Current();
+	states->PSSetShader(shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,10 +834,7 @@ void SimplePixelShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		states->PSSetConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
 	}
 }
 
@@ -1053,7 +862,7 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	StateCache::Current()->PSSetShaderResource(srvInfo->BindIndex, srv.Get());
 
 	// Success
 	return true;
@@ -1083,888 +892,8 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// ------ SIMPLE DOMAIN SHADER ------------------------------------------------
-///////////////////////////////////////////////////////////////////////////////
-
-// --------------------------------------------------------
-// Constructor just calls the base
-// --------------------------------------------------------
-SimpleDomainShader::SimpleDomainShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile)
-	: ISimpleShader(device, context) 
-{ 
-	// Load the actual compiled shader file
-	this->LoadShaderFile(shaderFile);
-}
-
-// --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
-// --------------------------------------------------------
-SimpleDomainShader::~SimpleDomainShader()
-{
-	CleanUp();
-}
-
-// --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
-// --------------------------------------------------------
-void SimpleDomainShader::CleanUp()
-{
-	ISimpleShader::CleanUp();
-}
-
-// --------------------------------------------------------
-// Creates the  Direct3D domain shader
-//
-// shaderBlob - The shader's compiled code
-//
-// Returns true if shader is created correctly, false otherwise
-// --------------------------------------------------------
-bool SimpleDomainShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
-{
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
-	// Create the shader from the blob
-	HRESULT result = device->CreateDomainShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Check the result
-	return (result == S_OK);
-}
-
-// --------------------------------------------------------
-// Sets the domain shader and constant buffers for
-// future  Direct3D drawing
-// --------------------------------------------------------
-void SimpleDomainShader::SetShaderAndCBs()
-{
-	// Is shader valid?
-	if (!shaderValid) return;
-
-	// Set the shader
-	deviceContext->DSSetShader(shader.Get(), 0, 0);
-
-	// Set the constant buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
-			continue;
-
-		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
-	}
-}
-
-// --------------------------------------------------------
-// Sets a shader resource view in the domain shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
-{
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleDomainShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets a sampler state in the domain shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
-{
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleDomainShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	StateCache::Current()->PSSetSampler(sampInfo->BindIndex, samplerState.Get());
 
 	// Success
 	return true;
 }
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// ------ SIMPLE HULL SHADER --------------------------------------------------
-///////////////////////////////////////////////////////////////////////////////
-
-// --------------------------------------------------------
-// Constructor just calls the base
-// --------------------------------------------------------
-SimpleHullShader::SimpleHullShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile)
-	: ISimpleShader(device, context) 
-{ 
-	// Load the actual compiled shader file
-	this->LoadShaderFile(shaderFile);
-}
-
-// --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
-// --------------------------------------------------------
-SimpleHullShader::~SimpleHullShader()
-{
-	CleanUp();
-}
-
-// --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
-// --------------------------------------------------------
-void SimpleHullShader::CleanUp()
-{
-	ISimpleShader::CleanUp();
-}
-
-// --------------------------------------------------------
-// Creates the  Direct3D hull shader
-//
-// shaderBlob - The shader's compiled code
-//
-// Returns true if shader is created correctly, false otherwise
-// --------------------------------------------------------
-bool SimpleHullShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
-{
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
-	// Create the shader from the blob
-	HRESULT result = device->CreateHullShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Check the result
-	return (result == S_OK);
-}
-
-// --------------------------------------------------------
-// Sets the hull shader and constant buffers for
-// future  Direct3D drawing
-// --------------------------------------------------------
-void SimpleHullShader::SetShaderAndCBs()
-{
-	// Is shader valid?
-	if (!shaderValid) return;
-
-	// Set the shader
-	deviceContext->HSSetShader(shader.Get(), 0, 0);
-
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
-			continue;
-
-		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
-	}
-}
-
-// --------------------------------------------------------
-// Sets a shader resource view in the hull shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
-{
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleHullShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets a sampler state in the hull shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
-{
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleHullShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// ------ SIMPLE GEOMETRY SHADER ----------------------------------------------
-///////////////////////////////////////////////////////////////////////////////
-
-// --------------------------------------------------------
-// Constructor calls the base and sets up potential stream-out options
-// --------------------------------------------------------
-SimpleGeometryShader::SimpleGeometryShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile, bool useStreamOut, bool allowStreamOutRasterization)
-	: ISimpleShader(device, context) 
-{ 
-	this->streamOutVertexSize = 0;
-	this->useStreamOut = useStreamOut;
-	this->allowStreamOutRasterization = allowStreamOutRasterization;
-
-	// Load the actual compiled shader file
-	this->LoadShaderFile(shaderFile);
-}
-
-// --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
-// --------------------------------------------------------
-SimpleGeometryShader::~SimpleGeometryShader()
-{
-	CleanUp();
-}
-
-// --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
-// --------------------------------------------------------
-void SimpleGeometryShader::CleanUp()
-{
-	ISimpleShader::CleanUp();
-}
-
-// --------------------------------------------------------
-// Creates the  Direct3D Geometry shader
-//
-// shaderBlob - The shader's compiled code
-//
-// Returns true if shader is created correctly, false otherwise
-// --------------------------------------------------------
-bool SimpleGeometryShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
-{
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
-	// Using stream out?
-	if (useStreamOut)
-		return this->CreateShaderWithStreamOut(shaderBlob);
-
-	// Create the shader from the blob
-	HRESULT result = device->CreateGeometryShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Check the result
-	return (result == S_OK);
-}
-
-// --------------------------------------------------------
-// Creates the  Direct3D Geometry shader and sets it up for
-// stream output, if possible.
-//
-// shaderBlob - The shader's compiled code
-//
-// Returns true if shader is created correctly, false otherwise
-// --------------------------------------------------------
-bool SimpleGeometryShader::CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
-{
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Set up the output signature
-	streamOutVertexSize = 0;
-	std::vector<D3D11_SO_DECLARATION_ENTRY> soDecl;
-	for (unsigned int i = 0; i < shaderDesc.OutputParameters; i++)
-	{
-		// Get the info about this entry
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetOutputParameterDesc(i, &paramDesc);
-		
-		// Create the SO Declaration
-		D3D11_SO_DECLARATION_ENTRY entry = {};
-		entry.SemanticIndex  = paramDesc.SemanticIndex;
-		entry.SemanticName   = paramDesc.SemanticName;
-		entry.Stream         = paramDesc.Stream;
-		entry.StartComponent = 0; // Assume starting at 0
-		entry.OutputSlot     = 0; // Assume the first output slot
-
-		// Check the mask to determine how many components are used
-		entry.ComponentCount = CalcComponentCount(paramDesc.Mask);
-	
-		// Increment the size
-		streamOutVertexSize += entry.ComponentCount * sizeof(float);
-
-		// Add to the declaration
-		soDecl.push_back(entry);
-	}
-
-	// Rasterization allowed?
-	unsigned int rast = allowStreamOutRasterization ? 0 : D3D11_SO_NO_RASTERIZED_STREAM;
-
-	// Create the shader
-	HRESULT result = device->CreateGeometryShaderWithStreamOutput(
-		shaderBlob->GetBufferPointer(), // Shader blob pointer
-		shaderBlob->GetBufferSize(),    // Shader blob size
-		&soDecl[0],                     // Stream out declaration
-		(unsigned int)soDecl.size(),    // Number of declaration entries
-		NULL,                           // Buffer strides (not used - assume tightly packed?)
-		0,                              // No buffer strides
-		rast,                           // Index of the stream to rasterize (if any)
-		NULL,                           // Not using class linkage
-		shader.GetAddressOf());
-	
-	return (result == S_OK);
-}
-
-// --------------------------------------------------------
-// Creates a vertex buffer that is compatible with the stream output
-// delcaration that was used to create the shader.  This buffer will
-// not be cleaned up (Released) by the simple shader - you must clean
-// it up yourself when you're done with it.  Immediately returns
-// false if the shader was not created with stream output, the shader
-// isn't valid or the determined stream out vertex size is zero.
-//
-// buffer - Pointer to an ID3D11Buffer pointer to hold the buffer ref
-// vertexCount - Amount of vertices the buffer should hold
-//
-// Returns true if buffer is created successfully AND stream output
-// was used to create the shader.  False otherwise.
-// --------------------------------------------------------
-bool SimpleGeometryShader::CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount)
-{
-	// Was stream output actually used?
-	if (!this->useStreamOut || !shaderValid || streamOutVertexSize == 0)
-	{
-		if (ReportErrors)
-		{
-			LogError("SimpleGeometryShader::CreateCompatibleStreamOutBuffer() - Either the shader is not valid or this SimpleGeometryShader was not initialized for stream out usage.\n");
-		}
-
-		return false;
-	}
-
-	// Set up the buffer description
-	D3D11_BUFFER_DESC desc = {};
-	desc.BindFlags           = D3D11_BIND_STREAM_OUTPUT | D3D11_BIND_VERTEX_BUFFER;
-	desc.ByteWidth           = streamOutVertexSize * vertexCount;
-	desc.CPUAccessFlags      = 0;
-	desc.MiscFlags           = 0;
-	desc.StructureByteStride = 0;
-	desc.Usage               = D3D11_USAGE_DEFAULT;
-
-	// Attempt to create the buffer and return the result
-	HRESULT result = device->CreateBuffer(&desc, 0, buffer.GetAddressOf());
-	return (result == S_OK);
-}
-
-// --------------------------------------------------------
-// Helper method to unbind all stream out buffers from the SO stage
-// --------------------------------------------------------
-void SimpleGeometryShader::UnbindStreamOutStage(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext)
-{
-	unsigned int offset = 0;
-	ID3D11Buffer* unset[4] = { 0, 0, 0, 0 }; // Max of 4 output targets according to  Direct3D documentation
-	deviceContext->SOSetTargets(4, unset, &offset);
-}
-
-// --------------------------------------------------------
-// Sets the geometry shader and constant buffers for
-// future  Direct3D drawing
-// --------------------------------------------------------
-void SimpleGeometryShader::SetShaderAndCBs()
-{
-	// Is shader valid?
-	if (!shaderValid) return;
-
-	// Set the shader
-	deviceContext->GSSetShader(shader.Get(), 0, 0);
-
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
-			continue;
-
-		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
-	}
-}
-
-// --------------------------------------------------------
-// Sets a shader resource view in the Geometry shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
-{
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleGeometryShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets a sampler state in the Geometry shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
-{
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleGeometryShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Calculates the number of components specified by a parameter description mask
-//
-// mask - The mask to check (only values 0 - 15 are considered)
-//
-// Returns an integer between 0 - 4 inclusive
-// --------------------------------------------------------
-unsigned int SimpleGeometryShader::CalcComponentCount(unsigned int mask)
-{
-	unsigned int result = 0;
-	result += (unsigned int)((mask & 1) == 1);
-	result += (unsigned int)((mask & 2) == 2);
-	result += (unsigned int)((mask & 4) == 4);
-	result += (unsigned int)((mask & 8) == 8);
-	return result;
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// ------ SIMPLE COMPUTE SHADER -----------------------------------------------
-///////////////////////////////////////////////////////////////////////////////
-
-// --------------------------------------------------------
-// Constructor just calls the base
-// --------------------------------------------------------
-SimpleComputeShader::SimpleComputeShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile)
-	: ISimpleShader(device, context) 
-{ 
-	this->threadsTotal = 0;
-	this->threadsX = 0;
-	this->threadsY = 0;
-	this->threadsZ = 0;
-
-	// Load the actual compiled shader file
-	this->LoadShaderFile(shaderFile);
-}
-
-// --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
-// --------------------------------------------------------
-SimpleComputeShader::~SimpleComputeShader()
-{
-	CleanUp();
-}
-
-// --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
-// --------------------------------------------------------
-void SimpleComputeShader::CleanUp()
-{
-	ISimpleShader::CleanUp();
-
-	uavTable.clear();
-}
-
-// --------------------------------------------------------
-// Creates the  Direct3D Compute shader
-//
-// shaderBlob - The shader's compiled code
-//
-// Returns true if shader is created correctly, false otherwise
-// --------------------------------------------------------
-bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
-{
-	// Clean up first, in the event this method is
-	// called more than once on the same object
-	this->CleanUp();
-
-	// Create the shader from the blob
-	HRESULT result = device->CreateComputeShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		shader.GetAddressOf());
-
-	// Was the shader created correctly?
-	if (result != S_OK)
-		return false;
-
-	// Set up shader reflection to get information about UAV's
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-	
-	// Grab the thread info
-	threadsTotal = refl->GetThreadGroupSize(
-		&threadsX,
-		&threadsY,
-		&threadsZ);
-
-	// Loop and get all UAV resources
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
-	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
-
-		// Check the type, looking for any kind of UAV
-		switch (resourceDesc.Type)
-		{
-		case D3D_SIT_UAV_APPEND_STRUCTURED:
-		case D3D_SIT_UAV_CONSUME_STRUCTURED:
-		case D3D_SIT_UAV_RWBYTEADDRESS:
-		case D3D_SIT_UAV_RWSTRUCTURED:
-		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
-		case D3D_SIT_UAV_RWTYPED:
-			uavTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
-		}
-	}
-
-	// All set
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets the Compute shader and constant buffers for
-// future  Direct3D drawing
-// --------------------------------------------------------
-void SimpleComputeShader::SetShaderAndCBs()
-{
-	// Is shader valid?
-	if (!shaderValid) return;
-
-	// Set the shader
-	deviceContext->CSSetShader(shader.Get(), 0, 0);
-
-	// Set the constant buffers?
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Skip "buffers" that aren't true constant buffers
-		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
-			continue;
-
-		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
-	}
-}
-
-// --------------------------------------------------------
-// Dispatches the compute shader with the specified amount 
-// of groups, using the number of threads per group
-// specified in the shader file itself
-//
-// For example, calling this method with params (5,1,1) on
-// a shader with (8,2,2) threads per group will launch a 
-// total of 160 threads: ((5 * 8) * (1 * 2) * (1 * 2))
-//
-// This is identical to using the device context's 
-// Dispatch() method yourself.  
-//
-// Note: This will dispatch the currently active shader, 
-// not necessarily THIS shader. Be sure to activate this
-// shader with SetShader() before calling Dispatch
-//
-// groupsX - Numbers of groups in the X dimension
-// groupsY - Numbers of groups in the Y dimension
-// groupsZ - Numbers of groups in the Z dimension
-// --------------------------------------------------------
-void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ)
-{
-	deviceContext->Dispatch(groupsX, groupsY, groupsZ);
-}
-
-// --------------------------------------------------------
-// Dispatches the compute shader with AT LEAST the 
-// specified amount of threads, calculating the number of
-// groups to dispatch using the number of threads per group
-// specified in the shader file itself
-//
-// For example, calling this method with params (10,3,3) on
-// a shader with (5,2,2) threads per group will launch 
-// 8 total groups and 160 total threads, calculated by:
-// Groups: ceil(10/5) * ceil(3/2) * ceil(3/2) = 8
-// Threads: ((2 * 5) * (2 * 2) * (2 * 2)) = 160
-//
-// Note: This will dispatch the currently active shader, 
-// not necessarily THIS shader. Be sure to activate this
-// shader with SetShader() before calling Dispatch
-//
-// threadsX - Desired numbers of threads in the X dimension
-// threadsY - Desired numbers of threads in the Y dimension
-// threadsZ - Desired numbers of threads in the Z dimension
-// --------------------------------------------------------
-void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ)
-{
-	deviceContext->Dispatch(
-		max((unsigned int)ceil((float)threadsX / this->threadsX), 1),
-		max((unsigned int)ceil((float)threadsY / this->threadsY), 1),
-		max((unsigned int)ceil((float)threadsZ / this->threadsZ), 1));
-}
-
-// --------------------------------------------------------
-// Determines if this shader has the specified UAV
-// --------------------------------------------------------
-bool SimpleComputeShader::HasUnorderedAccessView(std::string name)
-{
-	return GetUnorderedAccessViewIndex(name) != -1;
-}
-
-// --------------------------------------------------------
-// Sets a shader resource view in the Compute shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
-{
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleComputeShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets a sampler state in the Compute shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
-{
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleComputeShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Sets an unordered access view in the Compute shader stage
-//
-// name - The name of the sampler state in the shader
-// uav - The UAV in GPU memory
-// appendConsumeOffset - Used for append or consume UAV's (optional)
-//
-// Returns true if a UAV of the given name was found, false otherwise
-// --------------------------------------------------------
-bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset)
-{
-	// Look for the variable and verify
-	unsigned int bindIndex = GetUnorderedAccessViewIndex(name);
-	if (bindIndex == -1)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleComputeShader::SetUnorderedAccessView() - UAV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->CSSetUnorderedAccessViews(bindIndex, 1, uav.GetAddressOf(), &appendConsumeOffset);
-
-	// Success
-	return true;
-}
-
-// --------------------------------------------------------
-// Gets the index of the specified UAV (or -1)
-// --------------------------------------------------------
-int SimpleComputeShader::GetUnorderedAccessViewIndex(std::string name)
-{
-	// Look for the key
-	std::unordered_map<std::string, unsigned int>::iterator result =
-		uavTable.find(name);
-
-	// Did we find the key?
-	if (result == uavTable.end())
-		return -1;
-
-	// Success
-	return result->second;
-}
\ No newline at end of file
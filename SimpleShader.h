@@ -1,9 +1,6 @@
 #pragma once
-#pragma comment(lib, "dxguid.lib")
-#pragma comment(lib, "d3dcompiler.lib")
 
 #include <d3d11.h>
-#include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include <wrl/client.h>
 
@@ -11,6 +8,9 @@
 #include <vector>
 #include <string>
 
+#include "RenderDevice.h"
+#include "StateCache.h"
+
 
 // --------------------------------------------------------
 // Used by simple shaders to store information about
@@ -63,7 +63,7 @@ struct SimpleSampler
 class ISimpleShader
 {
 public:
-	ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	ISimpleShader(RenderDevice* device);
 	virtual ~ISimpleShader();
 
 	// Simple helpers
@@ -115,9 +115,6 @@ public:
 	const SimpleConstantBuffer* GetBufferInfo(std::string name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
 	
-	// Misc getters
-	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
-
 	// Error reporting
 	static bool ReportErrors;
 	static bool ReportWarnings;
@@ -125,9 +122,7 @@ public:
 protected:
 	
 	bool shaderValid;
-	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
-	Microsoft::WRL::ComPtr<ID3D11Device> device;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+	RenderDevice* device;
 
 	// Resource counts
 	unsigned int constantBufferCount;
@@ -145,7 +140,7 @@ protected:
 	bool LoadShaderFile(LPCWSTR shaderFile);
 
 	// Pure virtual functions for dealing with shader types
-	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
+	virtual bool CreateShader(LPCWSTR shaderFile, ShaderReflection& reflection) = 0;
 	virtual void SetShaderAndCBs() = 0;
 
 	virtual void CleanUp();
@@ -171,21 +166,16 @@ protected:
 class SimpleVertexShader : public ISimpleShader
 {
 public:
-	SimpleVertexShader( Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
-	SimpleVertexShader( Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile, Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout, bool perInstanceCompatible);
+	SimpleVertexShader(RenderDevice* device, LPCWSTR shaderFile);
 	~SimpleVertexShader();
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> GetDirectXShader() { return shader; }
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout() { return inputLayout; }
-	bool GetPerInstanceCompatible() { return perInstanceCompatible; }
 
 	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
-	bool perInstanceCompatible;
-	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
-	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+	bool CreateShader(LPCWSTR shaderFile, ShaderReflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -197,127 +187,15 @@ protected:
 class SimplePixelShader : public ISimpleShader
 {
 public:
-	SimplePixelShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
+	SimplePixelShader(RenderDevice* device, LPCWSTR shaderFile);
 	~SimplePixelShader();
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDirectXShader() { return shader; }
 
 	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
-	void CleanUp();
-};
-
-// --------------------------------------------------------
-// Derived class for DOMAIN shaders ///////////////////////
-// --------------------------------------------------------
-class SimpleDomainShader : public ISimpleShader
-{
-public:
-	SimpleDomainShader(Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
-	~SimpleDomainShader();
-	Microsoft::WRL::ComPtr<ID3D11DomainShader> GetDirectXShader() { return shader; }
-
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
-protected:
-	Microsoft::WRL::ComPtr<ID3D11DomainShader> shader;
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
-	void CleanUp();
-};
-
-// --------------------------------------------------------
-// Derived class for HULL shaders /////////////////////////
-// --------------------------------------------------------
-class SimpleHullShader : public ISimpleShader
-{
-public:
-	SimpleHullShader(Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
-	~SimpleHullShader();
-	Microsoft::WRL::ComPtr<ID3D11HullShader> GetDirectXShader() { return shader; }
-
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
-protected:
-	Microsoft::WRL::ComPtr<ID3D11HullShader> shader;
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
-	void CleanUp();
-};
-
-// --------------------------------------------------------
-// Derived class for GEOMETRY shaders /////////////////////
-// --------------------------------------------------------
-class SimpleGeometryShader : public ISimpleShader
-{
-public:
-	SimpleGeometryShader(Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile, bool useStreamOut = 0, bool allowStreamOutRasterization = 0);
-	~SimpleGeometryShader();
-	Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetDirectXShader() { return shader; }
-
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
-	bool CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount);
-
-	static void UnbindStreamOutStage(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext);
-
-protected:
-	// Shader itself
-	Microsoft::WRL::ComPtr<ID3D11GeometryShader> shader;
-
-	// Stream out related
-	bool useStreamOut;
-	bool allowStreamOutRasterization;
-	unsigned int streamOutVertexSize;
-
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	bool CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
+	bool CreateShader(LPCWSTR shaderFile, ShaderReflection& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
-
-	// Helpers
-	unsigned int CalcComponentCount(unsigned int mask);
 };
-
-
-// --------------------------------------------------------
-// Derived class for COMPUTE shaders //////////////////////
-// --------------------------------------------------------
-class SimpleComputeShader : public ISimpleShader
-{
-public:
-	SimpleComputeShader(Microsoft::WRL::ComPtr<ID3D11Device> device,  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, LPCWSTR shaderFile);
-	~SimpleComputeShader();
-	Microsoft::WRL::ComPtr<ID3D11ComputeShader> GetDirectXShader() { return shader; }
-
-	void DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ);
-	void DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ);
-
-	bool HasUnorderedAccessView(std::string name);
-
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-	bool SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
-
-	int GetUnorderedAccessViewIndex(std::string name);
-
-protected:
-	Microsoft::WRL::ComPtr<ID3D11ComputeShader> shader;
-	std::unordered_map<std::string, unsigned int> uavTable;
-
-	unsigned int threadsX;
-	unsigned int threadsY;
-	unsigned int threadsZ;
-	unsigned int threadsTotal;
-
-	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
-	void SetShaderAndCBs();
-	void CleanUp();
-};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Sky.h"
-#include "Graphics.h"
-#include "WICTextureLoader.h"
+#include "StateCache.h"
+
+#include <format>
 
 
 using namespace DirectX;
@@ -8,6 +9,7 @@ using namespace DirectX;
 
 Sky::Sky
 (
+	RenderDevice* device,
 	std::shared_ptr<Mesh> mesh,
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler,
 	std::shared_ptr<SimpleVertexShader> vs,
@@ -17,26 +19,23 @@ Sky::Sky
 	const wchar_t* up,
 	const wchar_t* down,
 	const wchar_t* front,
-	const wchar_t* back
+	const wchar_t* back,
+	const std::filesystem::path& cacheFolder,
+	JobSystem* jobs
 )
 {
 	skyGeo = mesh;
 	samplerOpts = sampler;
 
-	cubeMapSRV = CreateCubemap(right, left, up, down, front, back);
-
-	D3D11_RASTERIZER_DESC rasterizer_desc = {};
-	rasterizer_desc.FillMode = D3D11_FILL_SOLID;
-	rasterizer_desc.CullMode = D3D11_CULL_FRONT;
-	rasterizer_desc.DepthClipEnable = true;
-
-	Graphics::Device.Get()->CreateRasterizerState(&rasterizer_desc, rasterizerOpts.GetAddressOf());
+	const wchar_t* const faces[6] = { right, left, up, down, front, back };
+	device->LoadCubeMap(faces, cubeMapSRV.GetAddressOf());
 
-	D3D11_DEPTH_STENCIL_DESC depth_desc = {};
-	depth_desc.DepthEnable = true;
-	depth_desc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+	std::wstring facePaths[6] = { right, left, up, down, front, back };
+	CreateLighting(device, facePaths, cacheFolder, jobs);
 
-	Graphics::Device.Get()->CreateDepthStencilState(&depth_desc, skyDepthState.GetAddressOf());
+	//drawn from inside, behind everything already in the depth buffer
+	device->CreateRasterizerState(D3D11_CULL_FRONT, rasterizerOpts.GetAddressOf());
+	device->CreateDepthStencilState(D3D11_COMPARISON_LESS_EQUAL, false, skyDepthState.GetAddressOf());
 
 	skyPs = ps;
 	skyVs = vs;
@@ -47,24 +46,25 @@ Sky::~Sky()
 {
 }
 
-void Sky::Draw(Camera* cameraPtr)
+void Sky::Draw(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection)
 {
-	Graphics::Context->RSSetState(rasterizerOpts.Get());
-	Graphics::Context->OMSetDepthStencilState(skyDepthState.Get(), 0);
+	StateCache* states = StateCache::Current();
+	states->RSSetState(rasterizerOpts.Get());
+	states->OMSetDepthStencilState(skyDepthState.Get(), 0);
 
 	skyVs.get()->SetShader();
 	skyPs.get()->SetShader();
 
-	skyVs.get()->SetMatrix4x4("viewMatrix", cameraPtr->GetViewMatrix());
-	skyVs.get()->SetMatrix4x4("projectionMatrix", cameraPtr->GetProjectionMatrix());
+	skyVs.get()->SetMatrix4x4("viewMatrix", view);
+	skyVs.get()->SetMatrix4x4("projectionMatrix", projection);
 
 	skyPs.get()->SetShaderResourceView("SkyMap", cubeMapSRV);
 	skyPs.get()->SetSamplerState("BasicSampler", samplerOpts);
 
 	skyGeo.get()->Draw();
 
-	Graphics::Context->RSSetState(nullptr);
-	Graphics::Context->OMSetDepthStencilState(nullptr, 0);
+	states->RSSetState(nullptr);
+	states->OMSetDepthStencilState(nullptr, 0);
 
 	skyVs->CopyAllBufferData();
 	skyPs->CopyAllBufferData();
@@ -73,109 +73,59 @@ void Sky::Draw(Camera* cameraPtr)
 
 
 
-
-
-
-
-
 // --------------------------------------------------------
-// Author: Chris Cascioli
-// Purpose: Creates a cube map on the GPU from 6 individual textures
-// 
-// - You are allowed to directly copy/paste this into your code base
-//   for assignments, given that you clearly cite that this is not
-//   code of your own design.
-//
-// - Note: This code assumes youre putting the function in Sky.cpp, 
-//   youve included WICTextureLoader.h and you have an ID3D11Device 
-//   ComPtr called device.  Make any adjustments necessary for
-//   your own implementation.
+// Loads the sky's image based lighting from its cache file
+// in cacheFolder, or builds it from the cube map and writes
+// the cache, then puts it on the GPU
 // --------------------------------------------------------
+void Sky::CreateLighting(RenderDevice* device, const std::wstring facePaths[6], const std::filesystem::path& cacheFolder, JobSystem* jobs)
+{
+	lighting = std::make_unique<SkyLighting>(jobs);
+	unsigned long long key = SkyLighting::CacheKey(facePaths);
+	std::filesystem::path cachePath = cacheFolder / std::format("SkyLighting_{:016x}.cache", key);
+	if (!lighting->Load(cachePath, key)) {
+		if (!BuildLighting(device)) {
+			lighting.reset();
+			return;
+		}
+		lighting->Save(cachePath, key);
+	}
+
+	//prefiltered cube, every face's whole mip chain at once
+	const std::vector<SkyLighting::Cubemap>& specular = lighting->GetSpecular();
+	unsigned int mipCount = (unsigned int)specular.size();
+	std::vector<const void*> specularData(6 * mipCount);
+	for (unsigned int face = 0; face < 6; ++face) {
+		for (unsigned int mip = 0; mip < mipCount; ++mip) {
+			specularData[face * mipCount + mip] = specular[mip].faces[face].data();
+		}
+	}
+	device->CreateFloatTexture(specular[0].size, 4, mipCount, true, specularData.data(), specularSRV.GetAddressOf());
+
+	//BRDF table
+	const void* lutData = lighting->GetBrdfLut().data();
+	device->CreateFloatTexture(SkyLighting::BRDF_LUT_SIZE, 2, 1, false, &lutData, brdfLutSRV.GetAddressOf());
+}
 
 // --------------------------------------------------------
-// Loads six individual textures (the six faces of a cube map), then
-// creates a blank cube map and copies each of the six textures to
-// another face.  Afterwards, creates a shader resource view for
-// the cube map and cleans up all of the temporary resources.
+// Reads the cube map's faces back from the GPU and builds
+// the lighting from them.  False if they're not 8 bit RGBA
+// or BGRA, which is all SkyLighting takes
 // --------------------------------------------------------
-Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::CreateCubemap(
-	const wchar_t* right,
-	const wchar_t* left,
-	const wchar_t* up,
-	const wchar_t* down,
-	const wchar_t* front,
-	const wchar_t* back)
+bool Sky::BuildLighting(RenderDevice* device)
 {
-	// Load the 6 textures into an array.
-	// - We need references to the TEXTURES, not SHADER RESOURCE VIEWS!
-	// - Explicitly NOT generating mipmaps, as we don't need them for the sky!
-	// - Order matters here!  +X, -X, +Y, -Y, +Z, -Z
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> textures[6] = {};
-	CreateWICTextureFromFile(Graphics::Device.Get(), right, (ID3D11Resource**)textures[0].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), left, (ID3D11Resource**)textures[1].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), up, (ID3D11Resource**)textures[2].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), down, (ID3D11Resource**)textures[3].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), front, (ID3D11Resource**)textures[4].GetAddressOf(), 0);
-	CreateWICTextureFromFile(Graphics::Device.Get(), back, (ID3D11Resource**)textures[5].GetAddressOf(), 0);
-
-	// We'll assume all of the textures are the same color format and resolution,
-	// so get the description of the first texture
-	D3D11_TEXTURE2D_DESC faceDesc = {};
-	textures[0]->GetDesc(&faceDesc);
-
-	// Describe the resource for the cube map, which is simply 
-	// a "texture 2d array" with the TEXTURECUBE flag set.  
-	// This is a special GPU resource format, NOT just a 
-	// C++ array of textures!!!
-	D3D11_TEXTURE2D_DESC cubeDesc = {};
-	cubeDesc.ArraySize = 6;            // Cube map!
-	cubeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // We'll be using as a texture in a shader
-	cubeDesc.CPUAccessFlags = 0;       // No read back
-	cubeDesc.Format = faceDesc.Format; // Match the loaded texture's color format
-	cubeDesc.Width = faceDesc.Width;   // Match the size
-	cubeDesc.Height = faceDesc.Height; // Match the size
-	cubeDesc.MipLevels = 1;            // Only need 1
-	cubeDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE; // This should be treated as a CUBE, not 6 separate textures
-	cubeDesc.Usage = D3D11_USAGE_DEFAULT; // Standard usage
-	cubeDesc.SampleDesc.Count = 1;
-	cubeDesc.SampleDesc.Quality = 0;
-
-	// Create the final texture resource to hold the cube map
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
-	Graphics::Device->CreateTexture2D(&cubeDesc, 0, cubeMapTexture.GetAddressOf());
-
-	// Loop through the individual face textures and copy them,
-	// one at a time, to the cube map texure
-	for (int i = 0; i < 6; i++)
-	{
-		// Calculate the subresource position to copy into
-		unsigned int subresource = D3D11CalcSubresource(
-			0,  // Which mip (zero, since there's only one)
-			i,  // Which array element?
-			1); // How many mip levels are in the texture?
-
-		// Copy from one resource (texture) to another
-		Graphics::Context->CopySubresourceRegion(
-			cubeMapTexture.Get(),  // Destination resource
-			subresource,           // Dest subresource index (one of the array elements)
-			0, 0, 0,               // XYZ location of copy
-			textures[i].Get(),     // Source resource
-			0,                     // Source subresource index (we're assuming there's only one)
-			0);                    // Source subresource "box" of data to copy (zero means the whole thing)
+	std::vector<unsigned char> pixels[6];
+	unsigned int size;
+	bool bgra;
+	if (!cubeMapSRV || !device->ReadCubeMap(cubeMapSRV.Get(), pixels, size, bgra)) {
+		return false;
 	}
 
-	// At this point, all of the faces have been copied into the 
-	// cube map texture, so we can describe a shader resource view for it
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = cubeDesc.Format;         // Same format as texture
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE; // Treat this as a cube!
-	srvDesc.TextureCube.MipLevels = 1;        // Only need access to 1 mip
-	srvDesc.TextureCube.MostDetailedMip = 0;  // Index of the first mip we want to see
-
-	// Make the SRV
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeSRV;
-	Graphics::Device->CreateShaderResourceView(cubeMapTexture.Get(), &srvDesc, cubeSRV.GetAddressOf());
-
-	// Send back the SRV, which is what we need for our shaders
-	return cubeSRV;
+	SkyLighting::FaceImage faces[6];
+	for (unsigned int i = 0; i < 6; ++i) {
+		faces[i].pixels = pixels[i].data();
+		faces[i].rowPitch = size * 4;
+	}
+	lighting->Build(faces, size, bgra);
+	return true;
 }
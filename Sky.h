@@ -3,11 +3,15 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
+#include <filesystem>
 #include <memory>
+#include <string>
 
+#include "RenderDevice.h"
 #include "Mesh.h"
 #include "SimpleShader.h"
-#include "Camera.h"
+#include "SkyLighting.h"
+#include "JobSystem.h"
 
 
 class Sky
@@ -15,6 +19,7 @@ class Sky
 public:
 	Sky
 	(
+		RenderDevice* device,
 		std::shared_ptr<Mesh> mesh, 
 		Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler,
 		std::shared_ptr<SimpleVertexShader> vs,
@@ -24,13 +29,23 @@ public:
 		const wchar_t* up,
 		const wchar_t* down,
 		const wchar_t* front,
-		const wchar_t* back	
+		const wchar_t* back,
+		const std::filesystem::path& cacheFolder,
+		JobSystem* jobs
 	);
 	~Sky();
 	Sky(const Sky&) = delete; // Remove copy constructor
 	Sky& operator=(const Sky&) = delete; // Remove copy-assignment operator
 
-	void Draw(Camera* cameraPtr);
+	void Draw(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// Image based lighting from the sky (see SkyLighting).  Missing
+	// if the faces are in a format it can't read back
+	bool HasLighting() { return lighting != nullptr; }
+	const DirectX::XMFLOAT4* GetIrradiance() { return lighting->GetIrradiance(); } // 9 SH coefficients
+	const SkyLighting::Stats& GetLightingStats() { return lighting->GetStats(); }
+	ID3D11ShaderResourceView* GetSpecularIBL() { return specularSRV.Get(); }
+	ID3D11ShaderResourceView* GetBrdfLut() { return brdfLutSRV.Get(); }
 
 
 private:
@@ -39,17 +54,16 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> skyDepthState;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerOpts;
 
+	std::unique_ptr<SkyLighting> lighting;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> specularSRV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> brdfLutSRV;
+
 	std::shared_ptr<Mesh> skyGeo;
 	std::shared_ptr<SimplePixelShader> skyPs;
 	std::shared_ptr<SimpleVertexShader> skyVs;
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(
-		const wchar_t* right,
-		const wchar_t* left,
-		const wchar_t* up,
-		const wchar_t* down,
-		const wchar_t* front,
-		const wchar_t* back);
+	void CreateLighting(RenderDevice* device, const std::wstring facePaths[6], const std::filesystem::path& cacheFolder, JobSystem* jobs);
+	bool BuildLighting(RenderDevice* device);
 
 };
 
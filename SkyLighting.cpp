@@ -0,0 +1,565 @@
+#include "SkyLighting.h"
+#include "PbrLighting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+using namespace DirectX;
+using PbrLighting::Vec3;
+using PbrLighting::Dot;
+using PbrLighting::Normalize;
+
+namespace
+{
+	// Start of a cache file.  Bump the version whenever the layout or
+	// anything that goes into the numbers changes
+	const unsigned int CACHE_MAGIC = 0x4C594B53; // "SKYL"
+	const unsigned int CACHE_VERSION = 1;
+
+	// Rows per job for the per-texel passes
+	const unsigned int ROW_CHUNK = 4;
+
+	Vec3 Cross(Vec3 a, Vec3 b)
+	{
+		return Vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	// Direction through a face at s, t in [-1, 1], D3D's cube map layout
+	Vec3 FaceDirection(unsigned int face, float s, float t)
+	{
+		switch (face) {
+		case 0: return Normalize(Vec3{ 1, -t, -s });
+		case 1: return Normalize(Vec3{ -1, -t, s });
+		case 2: return Normalize(Vec3{ s, 1, t });
+		case 3: return Normalize(Vec3{ s, -1, -t });
+		case 4: return Normalize(Vec3{ s, -t, 1 });
+		default: return Normalize(Vec3{ -s, -t, -1 });
+		}
+	}
+
+	Vec3 TexelDirection(unsigned int face, unsigned int x, unsigned int y, unsigned int size)
+	{
+		return FaceDirection(face, 2 * (x + 0.5f) / size - 1, 2 * (y + 0.5f) / size - 1);
+	}
+
+	// Solid angle a texel covers, from the area its corners cut out of the sphere
+	float AreaElement(float x, float y)
+	{
+		return std::atan2(x * y, std::sqrt(x * x + y * y + 1));
+	}
+
+	float TexelSolidAngle(unsigned int x, unsigned int y, unsigned int size)
+	{
+		float s0 = 2.0f * x / size - 1;
+		float s1 = 2.0f * (x + 1) / size - 1;
+		float t0 = 2.0f * y / size - 1;
+		float t1 = 2.0f * (y + 1) / size - 1;
+		return AreaElement(s0, t0) - AreaElement(s0, t1) - AreaElement(s1, t0) + AreaElement(s1, t1);
+	}
+
+	// Bilinear lookup along a direction, clamped at the face's edges
+	Vec3 SampleCube(const SkyLighting::Cubemap& map, Vec3 d)
+	{
+		float ax = std::abs(d.x);
+		float ay = std::abs(d.y);
+		float az = std::abs(d.z);
+		unsigned int face;
+		float major, s, t;
+		if (ax >= ay && ax >= az) {
+			face = d.x > 0 ? 0 : 1;
+			major = ax;
+			s = d.x > 0 ? -d.z : d.z;
+			t = -d.y;
+		}
+		else if (ay >= az) {
+			face = d.y > 0 ? 2 : 3;
+			major = ay;
+			s = d.x;
+			t = d.y > 0 ? d.z : -d.z;
+		}
+		else {
+			face = d.z > 0 ? 4 : 5;
+			major = az;
+			s = d.z > 0 ? d.x : -d.x;
+			t = -d.y;
+		}
+
+		float last = (float)(map.size - 1);
+		float u = std::clamp((s / major + 1) * 0.5f * map.size - 0.5f, 0.0f, last);
+		float v = std::clamp((t / major + 1) * 0.5f * map.size - 0.5f, 0.0f, last);
+		unsigned int x0 = (unsigned int)u;
+		unsigned int y0 = (unsigned int)v;
+		unsigned int x1 = std::min(x0 + 1, map.size - 1);
+		unsigned int y1 = std::min(y0 + 1, map.size - 1);
+		float fx = u - x0;
+		float fy = v - y0;
+
+		const std::vector<XMFLOAT4>& texels = map.faces[face];
+		const XMFLOAT4& a = texels[y0 * map.size + x0];
+		const XMFLOAT4& b = texels[y0 * map.size + x1];
+		const XMFLOAT4& c = texels[y1 * map.size + x0];
+		const XMFLOAT4& e = texels[y1 * map.size + x1];
+		float wa = (1 - fx) * (1 - fy);
+		float wb = fx * (1 - fy);
+		float wc = (1 - fx) * fy;
+		float we = fx * fy;
+		return Vec3{
+			a.x * wa + b.x * wb + c.x * wc + e.x * we,
+			a.y * wa + b.y * wb + c.y * wc + e.y * we,
+			a.z * wa + b.z * wb + c.z * wc + e.z * we };
+	}
+
+	// Low discrepancy point i of count in [0, 1)^2
+	void Hammersley(unsigned int i, unsigned int count, float& u, float& v)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		u = (float)i / count;
+		v = bits * 2.3283064365386963e-10f;
+	}
+
+	// Half vector around +z distributed like GGX with this alpha
+	// (roughness squared, the same remap as D_GGX)
+	Vec3 SampleGGX(float u, float v, float alpha)
+	{
+		float phi = 2 * PbrLighting::PI * u;
+		float cosTheta = std::sqrt((1 - v) / (1 + (alpha * alpha - 1) * v));
+		float sinTheta = std::sqrt(1 - cosTheta * cosTheta);
+		return Vec3{ sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+	}
+
+	float D_GGX(float NdotH, float alpha)
+	{
+		float a2 = std::max(alpha * alpha, PbrLighting::MIN_ROUGHNESS);
+		float denomToSquare = NdotH * NdotH * (a2 - 1) + 1;
+		return a2 / (PbrLighting::PI * denomToSquare * denomToSquare);
+	}
+
+	// Largest power of two no bigger than value
+	unsigned int PowerOfTwoBelow(unsigned int value)
+	{
+		unsigned int result = 1;
+		while (result * 2 <= value) {
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+SkyLighting::SkyLighting(JobSystem* jobs)
+{
+	this->jobs = jobs;
+	for (XMFLOAT4& coefficient : irradiance) {
+		coefficient = XMFLOAT4(0, 0, 0, 0);
+	}
+}
+
+SkyLighting::~SkyLighting()
+{
+}
+
+void SkyLighting::Build(const FaceImage faces[6], unsigned int size, bool bgra)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	Downsample(faces, size, bgra);
+	ProjectIrradiance();
+	Prefilter();
+	IntegrateBrdf();
+
+	//only the prefilter needed these
+	sourceMips.clear();
+	sourceMips.shrink_to_fit();
+
+	stats.fromCache = false;
+	stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SkyLighting::Downsample(const FaceImage faces[6], unsigned int size, bool bgra)
+{
+	//the faces are gamma encoded the same way the albedo textures are
+	float toLinear[256];
+	for (unsigned int i = 0; i < 256; ++i) {
+		toLinear[i] = std::pow(i / 255.0f, 2.2f);
+	}
+	unsigned int red = bgra ? 2 : 0;
+	unsigned int blue = bgra ? 0 : 2;
+
+	unsigned int sourceSize = PowerOfTwoBelow(std::min(size, SOURCE_SIZE));
+	sourceMips.clear();
+	sourceMips.emplace_back();
+	Cubemap& top = sourceMips.back();
+	top.size = sourceSize;
+	for (std::vector<XMFLOAT4>& face : top.faces) {
+		face.resize(sourceSize * sourceSize);
+	}
+
+	//box filter, each texel averaging the block of face pixels under it
+	jobs->ParallelFor(6 * sourceSize, ROW_CHUNK, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int row = begin; row < end; ++row) {
+			unsigned int face = row / sourceSize;
+			unsigned int y = row % sourceSize;
+			unsigned int y0 = y * size / sourceSize;
+			unsigned int y1 = (y + 1) * size / sourceSize;
+			for (unsigned int x = 0; x < sourceSize; ++x) {
+				unsigned int x0 = x * size / sourceSize;
+				unsigned int x1 = (x + 1) * size / sourceSize;
+				float r = 0, g = 0, b = 0;
+				for (unsigned int py = y0; py < y1; ++py) {
+					const unsigned char* pixel = faces[face].pixels + py * faces[face].rowPitch + x0 * 4;
+					for (unsigned int px = x0; px < x1; ++px, pixel += 4) {
+						r += toLinear[pixel[red]];
+						g += toLinear[pixel[1]];
+						b += toLinear[pixel[blue]];
+					}
+				}
+				float scale = 1.0f / ((x1 - x0) * (y1 - y0));
+				top.faces[face][y * sourceSize + x] = XMFLOAT4(r * scale, g * scale, b * scale, 1);
+			}
+		}
+	});
+
+	//and a 2x2 box mip chain below that
+	while (sourceMips.back().size > 1) {
+		const Cubemap& above = sourceMips.back();
+		Cubemap mip;
+		mip.size = above.size / 2;
+		for (std::vector<XMFLOAT4>& face : mip.faces) {
+			face.resize(mip.size * mip.size);
+		}
+		jobs->ParallelFor(6 * mip.size, ROW_CHUNK, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int row = begin; row < end; ++row) {
+				unsigned int face = row / mip.size;
+				unsigned int y = row % mip.size;
+				for (unsigned int x = 0; x < mip.size; ++x) {
+					const XMFLOAT4& a = above.faces[face][(2 * y) * above.size + 2 * x];
+					const XMFLOAT4& b = above.faces[face][(2 * y) * above.size + 2 * x + 1];
+					const XMFLOAT4& c = above.faces[face][(2 * y + 1) * above.size + 2 * x];
+					const XMFLOAT4& d = above.faces[face][(2 * y + 1) * above.size + 2 * x + 1];
+					mip.faces[face][y * mip.size + x] = XMFLOAT4(
+						(a.x + b.x + c.x + d.x) * 0.25f,
+						(a.y + b.y + c.y + d.y) * 0.25f,
+						(a.z + b.z + c.z + d.z) * 0.25f, 1);
+				}
+			}
+		});
+		sourceMips.push_back(std::move(mip));
+	}
+}
+
+void SkyLighting::ProjectIrradiance()
+{
+	//harmonics are smooth, a small mip is plenty to project from
+	const Cubemap* source = &sourceMips.back();
+	for (const Cubemap& mip : sourceMips) {
+		if (mip.size <= SH_SIZE) {
+			source = &mip;
+			break;
+		}
+	}
+	unsigned int size = source->size;
+
+	//a partial sum per row, added up in order afterwards so the result
+	//doesn't depend on which thread finished first
+	struct RowSum
+	{
+		double color[9][3];
+		double weight;
+	};
+	std::vector<RowSum> rows(6 * size);
+
+	jobs->ParallelFor(6 * size, 1, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int row = begin; row < end; ++row) {
+			unsigned int face = row / size;
+			unsigned int y = row % size;
+			RowSum& sum = rows[row];
+			sum = {};
+			for (unsigned int x = 0; x < size; ++x) {
+				Vec3 n = TexelDirection(face, x, y, size);
+				float weight = TexelSolidAngle(x, y, size);
+				const XMFLOAT4& color = source->faces[face][y * size + x];
+
+				//real SH basis, bands 0 to 2
+				float basis[9] = {
+					0.282095f,
+					0.488603f * n.y,
+					0.488603f * n.z,
+					0.488603f * n.x,
+					1.092548f * n.x * n.y,
+					1.092548f * n.y * n.z,
+					0.315392f * (3 * n.z * n.z - 1),
+					1.092548f * n.x * n.z,
+					0.546274f * (n.x * n.x - n.y * n.y) };
+				for (unsigned int i = 0; i < 9; ++i) {
+					sum.color[i][0] += (double)color.x * basis[i] * weight;
+					sum.color[i][1] += (double)color.y * basis[i] * weight;
+					sum.color[i][2] += (double)color.z * basis[i] * weight;
+				}
+				sum.weight += weight;
+			}
+		}
+	});
+
+	RowSum total = {};
+	for (const RowSum& sum : rows) {
+		for (unsigned int i = 0; i < 9; ++i) {
+			for (unsigned int c = 0; c < 3; ++c) {
+				total.color[i][c] += sum.color[i][c];
+			}
+		}
+		total.weight += sum.weight;
+	}
+
+	//the solid angles should add up to the whole sphere, scale away
+	//whatever they miss by.  Then convolve with the clamped cosine
+	//(pi, 2pi/3, pi/4 per band) and divide by pi for Lambert
+	double normalize = 4 * PbrLighting::PI / total.weight;
+	const double bandScale[9] = { 1.0, 2.0 / 3, 2.0 / 3, 2.0 / 3, 0.25, 0.25, 0.25, 0.25, 0.25 };
+	for (unsigned int i = 0; i < 9; ++i) {
+		double scale = normalize * bandScale[i];
+		irradiance[i] = XMFLOAT4(
+			(float)(total.color[i][0] * scale),
+			(float)(total.color[i][1] * scale),
+			(float)(total.color[i][2] * scale), 0);
+	}
+}
+
+void SkyLighting::Prefilter()
+{
+	unsigned int sourceSize = sourceMips[0].size;
+	unsigned int lastSource = (unsigned int)sourceMips.size() - 1;
+	float texelSolidAngle = 4 * PbrLighting::PI / (6.0f * sourceSize * sourceSize);
+
+	//what each sample needs, worked out once per mip around +z: with
+	//N = V = R the light direction, its weight (NdotL) and which source
+	//mip to read so the samples together cover the lobe (filtered
+	//importance sampling)
+	struct LobeSample
+	{
+		Vec3 direction;
+		float weight;
+		unsigned int mip;
+	};
+
+	specular.clear();
+	specular.resize(SPECULAR_MIPS);
+	for (unsigned int level = 0; level < SPECULAR_MIPS; ++level) {
+		Cubemap& mip = specular[level];
+		mip.size = SPECULAR_SIZE >> level;
+		for (std::vector<XMFLOAT4>& face : mip.faces) {
+			face.resize(mip.size * mip.size);
+		}
+
+		//never read a source mip finer than this one's texels
+		float minimumLod = std::log2(std::max((float)sourceSize / mip.size, 1.0f));
+		float roughness = (float)level / (SPECULAR_MIPS - 1);
+		float alpha = roughness * roughness;
+
+		std::vector<LobeSample> lobe;
+		if (level == 0) {
+			lobe.push_back({ Vec3{ 0, 0, 1 }, 1, std::min((unsigned int)minimumLod, lastSource) });
+		}
+		else {
+			for (unsigned int i = 0; i < SPECULAR_SAMPLES; ++i) {
+				float u, v;
+				Hammersley(i, SPECULAR_SAMPLES, u, v);
+				Vec3 h = SampleGGX(u, v, alpha);
+				Vec3 l = h * (2 * h.z) - Vec3{ 0, 0, 1 };
+				if (l.z <= 0) {
+					continue;
+				}
+				float pdf = D_GGX(h.z, alpha) * 0.25f; //NdotH and VdotH cancel with N = V
+				float sampleSolidAngle = 1.0f / (SPECULAR_SAMPLES * pdf + 0.0001f);
+				float lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1, minimumLod);
+				lobe.push_back({ l, l.z, std::min((unsigned int)(lod + 0.5f), lastSource) });
+			}
+		}
+
+		jobs->ParallelFor(6 * mip.size, ROW_CHUNK, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int row = begin; row < end; ++row) {
+				unsigned int face = row / mip.size;
+				unsigned int y = row % mip.size;
+				for (unsigned int x = 0; x < mip.size; ++x) {
+					Vec3 n = TexelDirection(face, x, y, mip.size);
+					Vec3 up = std::abs(n.z) < 0.999f ? Vec3{ 0, 0, 1 } : Vec3{ 1, 0, 0 };
+					Vec3 tangent = Normalize(Cross(up, n));
+					Vec3 bitangent = Cross(n, tangent);
+
+					Vec3 color = { 0, 0, 0 };
+					float totalWeight = 0;
+					for (const LobeSample& sample : lobe) {
+						Vec3 l = tangent * sample.direction.x + bitangent * sample.direction.y + n * sample.direction.z;
+						color = color + SampleCube(sourceMips[sample.mip], l) * sample.weight;
+						totalWeight += sample.weight;
+					}
+					color = color / totalWeight;
+					mip.faces[face][y * mip.size + x] = XMFLOAT4(color.x, color.y, color.z, 1);
+				}
+			}
+		});
+	}
+}
+
+void SkyLighting::IntegrateBrdf()
+{
+	brdfLut.resize(BRDF_LUT_SIZE * BRDF_LUT_SIZE);
+
+	//the second half of the split sum: with N = +z, how much of F0 (x)
+	//and how much on top of it (y) the GGX lobe reflects, using the
+	//k = alpha / 2 Smith remap for image based lighting
+	jobs->ParallelFor(BRDF_LUT_SIZE, 1, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int row = begin; row < end; ++row) {
+			float roughness = (row + 0.5f) / BRDF_LUT_SIZE;
+			float alpha = roughness * roughness;
+			float k = alpha * 0.5f;
+			for (unsigned int column = 0; column < BRDF_LUT_SIZE; ++column) {
+				float NdotV = (column + 0.5f) / BRDF_LUT_SIZE;
+				Vec3 v = { std::sqrt(1 - NdotV * NdotV), 0, NdotV };
+				float scale = 0;
+				float bias = 0;
+				for (unsigned int i = 0; i < BRDF_SAMPLES; ++i) {
+					float u, w;
+					Hammersley(i, BRDF_SAMPLES, u, w);
+					Vec3 h = SampleGGX(u, w, alpha);
+					float VdotH = Dot(v, h);
+					Vec3 l = h * (2 * VdotH) - v;
+					float NdotL = l.z;
+					if (NdotL <= 0) {
+						continue;
+					}
+					float NdotH = h.z;
+					VdotH = std::max(VdotH, 0.0f);
+					float G = (NdotV / (NdotV * (1 - k) + k)) * (NdotL / (NdotL * (1 - k) + k));
+					float visibility = G * VdotH / (NdotH * NdotV);
+					float fresnel = std::pow(1 - VdotH, 5.0f);
+					scale += (1 - fresnel) * visibility;
+					bias += fresnel * visibility;
+				}
+				brdfLut[row * BRDF_LUT_SIZE + column] = XMFLOAT2(scale / BRDF_SAMPLES, bias / BRDF_SAMPLES);
+			}
+		}
+	});
+}
+
+unsigned long long SkyLighting::CacheKey(const std::wstring facePaths[6])
+{
+	//FNV-1a over the settings, then each face's path, size and last write
+	unsigned long long hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t bytes) {
+		const unsigned char* byte = (const unsigned char*)data;
+		for (size_t i = 0; i < bytes; ++i) {
+			hash ^= byte[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	unsigned int settings[] = { CACHE_VERSION, SOURCE_SIZE, SH_SIZE, SPECULAR_SIZE, SPECULAR_MIPS, SPECULAR_SAMPLES, BRDF_LUT_SIZE, BRDF_SAMPLES };
+	mix(settings, sizeof(settings));
+	for (unsigned int i = 0; i < 6; ++i) {
+		std::error_code error;
+		unsigned long long fileSize = std::filesystem::file_size(facePaths[i], error);
+		if (error) {
+			fileSize = 0;
+		}
+		long long written = std::filesystem::last_write_time(facePaths[i], error).time_since_epoch().count();
+		if (error) {
+			written = 0;
+		}
+		mix(facePaths[i].data(), facePaths[i].size() * sizeof(wchar_t));
+		mix(&fileSize, sizeof(fileSize));
+		mix(&written, sizeof(written));
+	}
+	return hash;
+}
+
+bool SkyLighting::Load(const std::filesystem::path& path, unsigned long long key)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	auto read = [&file](void* data, size_t bytes) {
+		file.read((char*)data, bytes);
+		return (bool)file;
+	};
+
+	unsigned int magic = 0;
+	unsigned int version = 0;
+	unsigned long long fileKey = 0;
+	if (!read(&magic, sizeof(magic)) || !read(&version, sizeof(version)) || !read(&fileKey, sizeof(fileKey)) ||
+		magic != CACHE_MAGIC || version != CACHE_VERSION || fileKey != key) {
+		return false;
+	}
+
+	//into temporaries, so a truncated file leaves everything as it was
+	XMFLOAT4 loadedIrradiance[9];
+	unsigned int mipCount = 0;
+	if (!read(loadedIrradiance, sizeof(loadedIrradiance)) || !read(&mipCount, sizeof(mipCount)) || mipCount != SPECULAR_MIPS) {
+		return false;
+	}
+	std::vector<Cubemap> loadedSpecular(mipCount);
+	for (unsigned int level = 0; level < mipCount; ++level) {
+		Cubemap& mip = loadedSpecular[level];
+		if (!read(&mip.size, sizeof(mip.size)) || mip.size != SPECULAR_SIZE >> level) {
+			return false;
+		}
+		for (std::vector<XMFLOAT4>& face : mip.faces) {
+			face.resize(mip.size * mip.size);
+			if (!read(face.data(), sizeof(XMFLOAT4) * face.size())) {
+				return false;
+			}
+		}
+	}
+	unsigned int lutSize = 0;
+	if (!read(&lutSize, sizeof(lutSize)) || lutSize != BRDF_LUT_SIZE) {
+		return false;
+	}
+	std::vector<XMFLOAT2> loadedLut(lutSize * lutSize);
+	if (!read(loadedLut.data(), sizeof(XMFLOAT2) * loadedLut.size())) {
+		return false;
+	}
+
+	std::copy(loadedIrradiance, loadedIrradiance + 9, irradiance);
+	specular = std::move(loadedSpecular);
+	brdfLut = std::move(loadedLut);
+
+	stats.fromCache = true;
+	stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool SkyLighting::Save(const std::filesystem::path& path, unsigned long long key)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	auto write = [&file](const void* data, size_t bytes) {
+		file.write((const char*)data, bytes);
+	};
+
+	unsigned int mipCount = (unsigned int)specular.size();
+	unsigned int lutSize = BRDF_LUT_SIZE;
+	write(&CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	write(&CACHE_VERSION, sizeof(CACHE_VERSION));
+	write(&key, sizeof(key));
+	write(irradiance, sizeof(irradiance));
+	write(&mipCount, sizeof(mipCount));
+	for (const Cubemap& mip : specular) {
+		write(&mip.size, sizeof(mip.size));
+		for (const std::vector<XMFLOAT4>& face : mip.faces) {
+			write(face.data(), sizeof(XMFLOAT4) * face.size());
+		}
+	}
+	write(&lutSize, sizeof(lutSize));
+	write(brdfLut.data(), sizeof(XMFLOAT2) * brdfLut.size());
+	return (bool)file;
+}
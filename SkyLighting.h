@@ -0,0 +1,96 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Image based lighting precomputed from the sky's cube map,
+// all on the CPU:
+//  - the irradiance it casts on a surface, as 9 spherical
+//    harmonic coefficients with the cosine lobe (and the
+//    1/pi of a Lambert surface) already folded in
+//  - a mip chain of the sky prefiltered with the GGX lobe,
+//    roughness going from 0 at the top mip to 1 at the last
+//  - the split sum BRDF table: for (NdotV, roughness), the
+//    scale and bias to apply to F0
+//
+// The faces are box filtered down to SOURCE_SIZE before any
+// of it, and everything is split across a job system with
+// fixed chunks, so it comes out the same on every machine.
+// Building takes a while, so the results can be saved to
+// and loaded from a cache file keyed by the face files.
+// --------------------------------------------------------
+class SkyLighting
+{
+public:
+
+	static constexpr unsigned int SOURCE_SIZE = 256; // faces are filtered down to this first
+	static constexpr unsigned int SH_SIZE = 32; // face size the harmonics are projected from
+	static constexpr unsigned int SPECULAR_SIZE = 128; // top mip of the prefiltered cube
+	static constexpr unsigned int SPECULAR_MIPS = 6; // down to 4x4, roughness 1
+	static constexpr unsigned int SPECULAR_SAMPLES = 256; // per prefiltered texel
+	static constexpr unsigned int BRDF_LUT_SIZE = 64; // same as BRDF_LUT_SIZE in the shaders
+	static constexpr unsigned int BRDF_SAMPLES = 512; // per table entry
+
+	// Linear RGB faces in +X, -X, +Y, -Y, +Z, -Z order, rows top to bottom
+	struct Cubemap
+	{
+		unsigned int size = 0;
+		std::vector<DirectX::XMFLOAT4> faces[6];
+	};
+
+	// One face as it was loaded: 8 bit sRGB, 4 channels
+	struct FaceImage
+	{
+		const unsigned char* pixels;
+		unsigned int rowPitch; // bytes
+	};
+
+	struct Stats
+	{
+		bool fromCache;
+		float ms; // to build or load
+	};
+
+	SkyLighting(JobSystem* jobs);
+	~SkyLighting();
+	SkyLighting(const SkyLighting&) = delete; // Remove copy constructor
+	SkyLighting& operator=(const SkyLighting&) = delete; // Remove copy-assignment operator
+
+	// Everything from square faces of any size, BGRA when bgra is set
+	void Build(const FaceImage faces[6], unsigned int size, bool bgra);
+
+	// Identifies a set of face files by name, size and last write,
+	// plus every setting above, so any change makes a new key
+	static unsigned long long CacheKey(const std::wstring facePaths[6]);
+	// False (and nothing changed) when the file is missing, from another
+	// key or a different layout
+	bool Load(const std::filesystem::path& path, unsigned long long key);
+	bool Save(const std::filesystem::path& path, unsigned long long key);
+
+	const DirectX::XMFLOAT4* GetIrradiance() { return irradiance; } // 9 coefficients, rgb
+	const std::vector<Cubemap>& GetSpecular() { return specular; } // SPECULAR_MIPS mips
+	const std::vector<DirectX::XMFLOAT2>& GetBrdfLut() { return brdfLut; } // rows roughness, columns NdotV
+	const Stats& GetStats() { return stats; }
+
+private:
+
+	void Downsample(const FaceImage faces[6], unsigned int size, bool bgra);
+	void ProjectIrradiance();
+	void Prefilter();
+	void IntegrateBrdf();
+
+	JobSystem* jobs;
+
+	// SOURCE_SIZE on down to 1x1, for the prefilter's sample lookups
+	std::vector<Cubemap> sourceMips;
+
+	DirectX::XMFLOAT4 irradiance[9];
+	std::vector<Cubemap> specular;
+	std::vector<DirectX::XMFLOAT2> brdfLut;
+	Stats stats = {};
+};
@@ -0,0 +1,460 @@
+#include "SoftwareRasterizer.h"
+#include "PbrBatch.h"
+#include "PbrLighting.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	// a * b, row vectors like everything else
+	XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		XMFLOAT4X4 result;
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+		return result;
+	}
+
+	// Twice the signed area of abp; positive when p is to the right of
+	// a->b on screen, so clockwise (front facing) triangles are positive
+	float Edge(float ax, float ay, float bx, float by, float px, float py)
+	{
+		return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+	}
+
+	// D3D's top-left rule, for clockwise triangles with y down
+	bool TopLeft(float ax, float ay, float bx, float by)
+	{
+		return (ay == by && bx > ax) || by < ay;
+	}
+
+	unsigned int PackColor(float r, float g, float b)
+	{
+		auto channel = [](float v) { return (unsigned int)(PbrLighting::Saturate(v) * 255.0f + 0.5f); };
+		return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (255u << 24);
+	}
+
+	const unsigned int NO_TRIANGLE = 0xFFFFFFFF;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+void SoftwareRasterizer::Render(const RasterScene& scene)
+{
+	PROFILE_SCOPE("SoftwareRasterizer::Render");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	width = scene.width;
+	height = scene.height;
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	unsigned int tileCount = tilesX * tilesY;
+	pixels.resize((size_t)width * height);
+	stats = {};
+	stats.draws = (unsigned int)scene.draws.size();
+
+	//the shader raises albedo to 2.2 per pixel, once per draw is enough here
+	linearAlbedo.resize(scene.draws.size());
+	for (size_t i = 0; i < scene.draws.size(); ++i) {
+		const XMFLOAT3& albedo = scene.draws[i].albedo;
+		linearAlbedo[i] = XMFLOAT3(std::pow(albedo.x, 2.2f), std::pow(albedo.y, 2.2f), std::pow(albedo.z, 2.2f));
+	}
+
+	//setup: transform, clip, cull and list tiles, a chunk of draws per job
+	unsigned int chunkCount = ((unsigned int)scene.draws.size() + DRAW_CHUNK - 1) / DRAW_CHUNK;
+	if (chunks.size() < chunkCount) {
+		chunks.resize(chunkCount);
+	}
+	{
+		PROFILE_SCOPE("Software setup");
+		jobs->ParallelFor(chunkCount, 1, [&](unsigned int begin, unsigned int end) {
+			std::vector<ClipVertex> transformed;
+			for (unsigned int c = begin; c < end; ++c) {
+				Chunk& chunk = chunks[c];
+				chunk.triangles.clear();
+				chunk.bins.clear();
+				chunk.submitted = 0;
+				chunk.culled = 0;
+				chunk.clipped = 0;
+
+				unsigned int last = std::min((c + 1) * DRAW_CHUNK, (unsigned int)scene.draws.size());
+				for (unsigned int d = c * DRAW_CHUNK; d < last; ++d) {
+					SetupDraw(scene, d, chunk, transformed);
+				}
+			}
+		});
+	}
+	std::chrono::steady_clock::time_point setupDone = std::chrono::steady_clock::now();
+
+	//binning: a counting sort of every chunk's entries by tile, which
+	//keeps them in chunk order and so in draw order within each tile
+	{
+		PROFILE_SCOPE("Software binning");
+		tileStart.assign(tileCount + 1, 0);
+		for (unsigned int c = 0; c < chunkCount; ++c) {
+			for (const BinEntry& entry : chunks[c].bins) {
+				tileStart[entry.tile + 1]++;
+			}
+			stats.triangles += chunks[c].submitted;
+			stats.trianglesCulled += chunks[c].culled;
+			stats.trianglesClipped += chunks[c].clipped;
+		}
+		for (unsigned int t = 0; t < tileCount; ++t) {
+			tileStart[t + 1] += tileStart[t];
+		}
+
+		tileTriangles.resize(tileStart[tileCount]);
+		std::vector<unsigned int> cursor(tileStart.begin(), tileStart.end() - 1);
+		for (unsigned int c = 0; c < chunkCount; ++c) {
+			for (const BinEntry& entry : chunks[c].bins) {
+				tileTriangles[cursor[entry.tile]++] = TriangleRef{ c, entry.triangle };
+			}
+		}
+		stats.tileReferences = tileStart[tileCount];
+	}
+	std::chrono::steady_clock::time_point binDone = std::chrono::steady_clock::now();
+
+	//raster: every tile on its own, each writes only its own pixels
+	{
+		PROFILE_SCOPE("Software raster");
+		tilePixelsShaded.assign(tileCount, 0);
+		jobs->ParallelFor(tileCount, 1, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int t = begin; t < end; ++t) {
+				RasterTile(scene, t);
+			}
+		});
+		for (unsigned int shaded : tilePixelsShaded) {
+			stats.pixelsShaded += shaded;
+		}
+	}
+	std::chrono::steady_clock::time_point rasterDone = std::chrono::steady_clock::now();
+
+	stats.setupMs = std::chrono::duration<float, std::milli>(setupDone - start).count();
+	stats.binMs = std::chrono::duration<float, std::milli>(binDone - setupDone).count();
+	stats.rasterMs = std::chrono::duration<float, std::milli>(rasterDone - binDone).count();
+}
+
+// --------------------------------------------------------
+// The vertex shader for every vertex of the draw, then each
+// triangle is clipped against the near plane (z = 0 in D3D
+// clip space) and handed on.  Only the near plane has to be
+// clipped: the others are handled by the screen bounds
+// --------------------------------------------------------
+void SoftwareRasterizer::SetupDraw(const RasterScene& scene, unsigned int drawIndex, Chunk& chunk, std::vector<ClipVertex>& transformed)
+{
+	const RasterDraw& draw = scene.draws[drawIndex];
+	XMFLOAT4X4 wvp = Multiply(Multiply(draw.world, scene.view), scene.projection);
+	const XMFLOAT4X4& w = draw.world;
+	const XMFLOAT4X4& n = draw.worldInvTranspose;
+
+	//only the vertices the indices reach
+	unsigned int vertexCount = 0;
+	for (unsigned int i = 0; i < draw.indexCount; ++i) {
+		vertexCount = std::max(vertexCount, draw.indices[i] + 1);
+	}
+	transformed.resize(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		const XMFLOAT3& p = draw.vertices[i].Position;
+		const XMFLOAT3& nrm = draw.vertices[i].Normal;
+		ClipVertex& out = transformed[i];
+		for (int c = 0; c < 4; ++c) {
+			out.clip[c] = p.x * wvp.m[0][c] + p.y * wvp.m[1][c] + p.z * wvp.m[2][c] + wvp.m[3][c];
+		}
+		for (int c = 0; c < 3; ++c) {
+			out.world[c] = p.x * w.m[0][c] + p.y * w.m[1][c] + p.z * w.m[2][c] + w.m[3][c];
+			out.normal[c] = nrm.x * n.m[0][c] + nrm.y * n.m[1][c] + nrm.z * n.m[2][c];
+		}
+	}
+
+	for (unsigned int i = 0; i + 2 < draw.indexCount; i += 3) {
+		chunk.submitted++;
+		const ClipVertex* v[3] = { &transformed[draw.indices[i]], &transformed[draw.indices[i + 1]], &transformed[draw.indices[i + 2]] };
+		int inFront = (v[0]->clip[2] >= 0) + (v[1]->clip[2] >= 0) + (v[2]->clip[2] >= 0);
+		if (inFront == 3) {
+			AddTriangle(*v[0], *v[1], *v[2], drawIndex, chunk);
+			continue;
+		}
+		if (inFront == 0) {
+			chunk.culled++;
+			continue;
+		}
+
+		//one plane cuts a triangle into a triangle or a quad
+		chunk.clipped++;
+		ClipVertex polygon[4];
+		int corners = 0;
+		for (int e = 0; e < 3; ++e) {
+			const ClipVertex& a = *v[e];
+			const ClipVertex& b = *v[(e + 1) % 3];
+			if (a.clip[2] >= 0) {
+				polygon[corners++] = a;
+			}
+			if ((a.clip[2] >= 0) != (b.clip[2] >= 0)) {
+				float t = a.clip[2] / (a.clip[2] - b.clip[2]);
+				ClipVertex& cut = polygon[corners++];
+				for (int c = 0; c < 4; ++c) { cut.clip[c] = a.clip[c] + (b.clip[c] - a.clip[c]) * t; }
+				for (int c = 0; c < 3; ++c) { cut.world[c] = a.world[c] + (b.world[c] - a.world[c]) * t; }
+				for (int c = 0; c < 3; ++c) { cut.normal[c] = a.normal[c] + (b.normal[c] - a.normal[c]) * t; }
+			}
+		}
+		AddTriangle(polygon[0], polygon[1], polygon[2], drawIndex, chunk);
+		if (corners == 4) {
+			AddTriangle(polygon[0], polygon[2], polygon[3], drawIndex, chunk);
+		}
+	}
+}
+
+void SoftwareRasterizer::AddTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int drawIndex, Chunk& chunk)
+{
+	const ClipVertex* v[3] = { &a, &b, &c };
+
+	//entirely outside one side of the view
+	for (int axis = 0; axis < 2; ++axis) {
+		if ((a.clip[axis] > a.clip[3] && b.clip[axis] > b.clip[3] && c.clip[axis] > c.clip[3]) ||
+			(a.clip[axis] < -a.clip[3] && b.clip[axis] < -b.clip[3] && c.clip[axis] < -c.clip[3])) {
+			chunk.culled++;
+			return;
+		}
+	}
+
+	Triangle triangle;
+	for (int i = 0; i < 3; ++i) {
+		if (v[i]->clip[3] <= 0) {
+			chunk.culled++;
+			return;
+		}
+		float invW = 1.0f / v[i]->clip[3];
+		triangle.x[i] = (v[i]->clip[0] * invW * 0.5f + 0.5f) * width;
+		triangle.y[i] = (0.5f - v[i]->clip[1] * invW * 0.5f) * height;
+		triangle.z[i] = v[i]->clip[2] * invW;
+		triangle.invW[i] = invW;
+		for (int k = 0; k < 3; ++k) {
+			triangle.world[i][k] = v[i]->world[k] * invW;
+			triangle.normal[i][k] = v[i]->normal[k] * invW;
+		}
+	}
+
+	//back faces and slivers
+	triangle.area = Edge(triangle.x[0], triangle.y[0], triangle.x[1], triangle.y[1], triangle.x[2], triangle.y[2]);
+	if (triangle.area <= 0) {
+		chunk.culled++;
+		return;
+	}
+	triangle.draw = drawIndex;
+
+	float minX = std::max(std::floor(std::min({ triangle.x[0], triangle.x[1], triangle.x[2] })), 0.0f);
+	float minY = std::max(std::floor(std::min({ triangle.y[0], triangle.y[1], triangle.y[2] })), 0.0f);
+	float maxX = std::min(std::ceil(std::max({ triangle.x[0], triangle.x[1], triangle.x[2] })), (float)width - 1);
+	float maxY = std::min(std::ceil(std::max({ triangle.y[0], triangle.y[1], triangle.y[2] })), (float)height - 1);
+	if (minX > maxX || minY > maxY) {
+		chunk.culled++;
+		return;
+	}
+
+	unsigned int index = (unsigned int)chunk.triangles.size();
+	chunk.triangles.push_back(triangle);
+	for (unsigned int ty = (unsigned int)minY / TILE_SIZE; ty <= (unsigned int)maxY / TILE_SIZE; ++ty) {
+		for (unsigned int tx = (unsigned int)minX / TILE_SIZE; tx <= (unsigned int)maxX / TILE_SIZE; ++tx) {
+			chunk.bins.push_back(BinEntry{ ty * tilesX + tx, index });
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Visibility first: the nearest triangle and its screen
+// barycentrics per pixel, LESS depth test like the default
+// depth state.  Then each covered pixel is shaded once, with
+// the attributes interpolated perspective correctly
+// --------------------------------------------------------
+void SoftwareRasterizer::RasterTile(const RasterScene& scene, unsigned int tile)
+{
+	unsigned int left = (tile % tilesX) * TILE_SIZE;
+	unsigned int top = (tile / tilesX) * TILE_SIZE;
+	unsigned int right = std::min(left + TILE_SIZE, width);
+	unsigned int bottom = std::min(top + TILE_SIZE, height);
+
+	float depth[TILE_SIZE * TILE_SIZE];
+	unsigned int visible[TILE_SIZE * TILE_SIZE];
+	float weight1[TILE_SIZE * TILE_SIZE];
+	float weight2[TILE_SIZE * TILE_SIZE];
+	std::fill(depth, depth + TILE_SIZE * TILE_SIZE, 1.0f);
+	std::fill(visible, visible + TILE_SIZE * TILE_SIZE, NO_TRIANGLE);
+
+	for (unsigned int r = tileStart[tile]; r < tileStart[tile + 1]; ++r) {
+		const Triangle& t = chunks[tileTriangles[r].chunk].triangles[tileTriangles[r].triangle];
+		bool topLeft0 = TopLeft(t.x[1], t.y[1], t.x[2], t.y[2]);
+		bool topLeft1 = TopLeft(t.x[2], t.y[2], t.x[0], t.y[0]);
+		bool topLeft2 = TopLeft(t.x[0], t.y[0], t.x[1], t.y[1]);
+		float invArea = 1.0f / t.area;
+
+		unsigned int x0 = std::max(left, (unsigned int)std::max(std::floor(std::min({ t.x[0], t.x[1], t.x[2] })), 0.0f));
+		unsigned int y0 = std::max(top, (unsigned int)std::max(std::floor(std::min({ t.y[0], t.y[1], t.y[2] })), 0.0f));
+		unsigned int x1 = std::min(right, (unsigned int)std::max(std::ceil(std::max({ t.x[0], t.x[1], t.x[2] })) + 1, 0.0f));
+		unsigned int y1 = std::min(bottom, (unsigned int)std::max(std::ceil(std::max({ t.y[0], t.y[1], t.y[2] })) + 1, 0.0f));
+
+		for (unsigned int y = y0; y < y1; ++y) {
+			float py = y + 0.5f;
+			for (unsigned int x = x0; x < x1; ++x) {
+				float px = x + 0.5f;
+				float w0 = Edge(t.x[1], t.y[1], t.x[2], t.y[2], px, py);
+				float w1 = Edge(t.x[2], t.y[2], t.x[0], t.y[0], px, py);
+				float w2 = Edge(t.x[0], t.y[0], t.x[1], t.y[1], px, py);
+				if (w0 < 0 || w1 < 0 || w2 < 0 ||
+					(w0 == 0 && !topLeft0) || (w1 == 0 && !topLeft1) || (w2 == 0 && !topLeft2)) {
+					continue;
+				}
+
+				float l1 = w1 * invArea;
+				float l2 = w2 * invArea;
+				float z = t.z[0] + (t.z[1] - t.z[0]) * l1 + (t.z[2] - t.z[0]) * l2;
+				unsigned int p = (y - top) * TILE_SIZE + (x - left);
+				if (z < 0 || z >= depth[p]) {
+					continue;
+				}
+				depth[p] = z;
+				visible[p] = r;
+				weight1[p] = l1;
+				weight2[p] = l2;
+			}
+		}
+	}
+
+	//covered pixels are shaded eight at a time: gathered into lanes
+	//of a batch, shaded together, then written out
+	PbrLighting::Vec3 cameraPos = PbrLighting::ToVec3(scene.cameraPosition);
+	unsigned int background = PackColor(scene.background[0], scene.background[1], scene.background[2]);
+	unsigned int shaded = 0;
+	float lanes[11][PbrBatch::WIDTH];
+	unsigned int* targets[PbrBatch::WIDTH];
+	unsigned int laneCount = 0;
+	auto shadeLanes = [&]() {
+		//unused lanes repeat the first so they stay well formed
+		for (unsigned int i = laneCount; i < PbrBatch::WIDTH; ++i) {
+			for (auto& lane : lanes) {
+				lane[i] = lane[0];
+			}
+		}
+
+		PbrBatch::Samples samples;
+		samples.normal = PbrBatch::Normalize(PbrBatch::Vec3x8{ PbrBatch::Load(lanes[0]), PbrBatch::Load(lanes[1]), PbrBatch::Load(lanes[2]) });
+		samples.position = PbrBatch::Vec3x8{ PbrBatch::Load(lanes[3]), PbrBatch::Load(lanes[4]), PbrBatch::Load(lanes[5]) };
+		samples.albedo = PbrBatch::Vec3x8{ PbrBatch::Load(lanes[6]), PbrBatch::Load(lanes[7]), PbrBatch::Load(lanes[8]) };
+		samples.roughness = PbrBatch::Load(lanes[9]);
+		samples.metalness = PbrBatch::Load(lanes[10]);
+		samples.shadow = PbrBatch::Splat(1.0f);
+		PbrBatch::Vec3x8 color = PbrBatch::Shade(samples, cameraPos, scene.lights, scene.lightCount);
+
+		float rgb[3][PbrBatch::WIDTH];
+		PbrBatch::Store(rgb[0], color.x);
+		PbrBatch::Store(rgb[1], color.y);
+		PbrBatch::Store(rgb[2], color.z);
+		for (unsigned int i = 0; i < laneCount; ++i) {
+			//the shader's final gamma
+			*targets[i] = PackColor(std::pow(rgb[0][i], 1.0f / 2.2f), std::pow(rgb[1][i], 1.0f / 2.2f), std::pow(rgb[2][i], 1.0f / 2.2f));
+		}
+		shaded += laneCount;
+		laneCount = 0;
+	};
+
+	for (unsigned int y = top; y < bottom; ++y) {
+		for (unsigned int x = left; x < right; ++x) {
+			unsigned int p = (y - top) * TILE_SIZE + (x - left);
+			unsigned int& out = pixels[(size_t)y * width + x];
+			if (visible[p] == NO_TRIANGLE) {
+				out = background;
+				continue;
+			}
+
+			const Triangle& t = chunks[tileTriangles[visible[p]].chunk].triangles[tileTriangles[visible[p]].triangle];
+			float l[3] = { 1.0f - weight1[p] - weight2[p], weight1[p], weight2[p] };
+			float invW = l[0] * t.invW[0] + l[1] * t.invW[1] + l[2] * t.invW[2];
+			for (int k = 0; k < 3; ++k) {
+				lanes[k][laneCount] = (l[0] * t.normal[0][k] + l[1] * t.normal[1][k] + l[2] * t.normal[2][k]) / invW;
+				lanes[3 + k][laneCount] = (l[0] * t.world[0][k] + l[1] * t.world[1][k] + l[2] * t.world[2][k]) / invW;
+			}
+
+			const RasterDraw& draw = scene.draws[t.draw];
+			lanes[6][laneCount] = linearAlbedo[t.draw].x;
+			lanes[7][laneCount] = linearAlbedo[t.draw].y;
+			lanes[8][laneCount] = linearAlbedo[t.draw].z;
+			lanes[9][laneCount] = draw.roughness;
+			lanes[10][laneCount] = draw.metalness;
+			targets[laneCount++] = &out;
+			if (laneCount == PbrBatch::WIDTH) {
+				shadeLanes();
+			}
+		}
+	}
+	if (laneCount > 0) {
+		shadeLanes();
+	}
+	tilePixelsShaded[tile] = shaded;
+}
+
+bool SoftwareRasterizer::WritePpm(const std::string& path)
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		return false;
+	}
+
+	out << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			unsigned int pixel = pixels[(size_t)y * width + x];
+			row[x * 3 + 0] = (unsigned char)(pixel & 0xFF);
+			row[x * 3 + 1] = (unsigned char)((pixel >> 8) & 0xFF);
+			row[x * 3 + 2] = (unsigned char)((pixel >> 16) & 0xFF);
+		}
+		out.write((const char*)row.data(), row.size());
+	}
+	return (bool)out;
+}
+
+long long SoftwareRasterizer::CompareToPpm(const std::string& path, int tolerance)
+{
+	std::ifstream in(path, std::ios::binary);
+	std::string magic;
+	unsigned int fileWidth = 0;
+	unsigned int fileHeight = 0;
+	unsigned int maxValue = 0;
+	if (!(in >> magic >> fileWidth >> fileHeight >> maxValue) || magic != "P6" || maxValue != 255 ||
+		fileWidth != width || fileHeight != height) {
+		return -1;
+	}
+	in.get(); //the one whitespace character before the data
+
+	std::vector<unsigned char> golden((size_t)width * height * 3);
+	if (!in.read((char*)golden.data(), golden.size())) {
+		return -1;
+	}
+
+	long long mismatched = 0;
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		for (int channel = 0; channel < 3; ++channel) {
+			int ours = (pixels[i] >> (channel * 8)) & 0xFF;
+			if (std::abs(ours - (int)golden[i * 3 + channel]) > tolerance) {
+				mismatched++;
+				break;
+			}
+		}
+	}
+	return mismatched;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+#include "Vertex.h"
+#include "Lights.h"
+#include "JobSystem.h"
+
+// One mesh instance to rasterize.  Points at the mesh's CPU
+// copy of its geometry, which has to outlive the Render call
+struct RasterDraw
+{
+	const Vertex* vertices;
+	const unsigned int* indices;
+	unsigned int indexCount;
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+	DirectX::XMFLOAT3 albedo; // sRGB, like a texture sample
+	float roughness;
+	float metalness;
+};
+
+// Everything a frame needs, in the same conventions the
+// shaders use (row vectors, D3D clip space, y down on screen)
+struct RasterScene
+{
+	unsigned int width;
+	unsigned int height;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT3 cameraPosition;
+	const Light* lights;
+	unsigned int lightCount;
+	float background[4];
+	std::vector<RasterDraw> draws;
+};
+
+// --------------------------------------------------------
+// Draws a scene on the CPU, tile by tile, into an RGBA8
+// image.  Used to see what a frame should look like without
+// a GPU and to compare frames against golden images.
+//
+// A frame runs in three steps:
+//  - Setup: draws are split into fixed chunks on the job
+//    system; each transforms its triangles, clips them to
+//    the near plane, culls back faces and lists the screen
+//    tiles each one touches
+//  - Binning: the lists are gathered per tile, in chunk
+//    order, so every tile sees triangles in draw order
+//  - Raster: tiles run in parallel.  Each resolves depth
+//    into a small visibility buffer first and then shades
+//    every pixel once, eight at a time with PbrBatch
+//
+// Nothing depends on thread count or timing, so the same
+// scene always gives the same image.
+//
+// Textures, shadows, the sky and post processing are left
+// out: albedo and roughness come from the material, normals
+// from the vertices, and lights[0] is never shadowed
+// --------------------------------------------------------
+class SoftwareRasterizer
+{
+public:
+
+	static const unsigned int TILE_SIZE = 32;
+
+	struct Stats
+	{
+		unsigned int draws;
+		unsigned int triangles; // submitted
+		unsigned int trianglesCulled; // back facing, behind the camera or off screen
+		unsigned int trianglesClipped; // crossed the near plane
+		unsigned int tileReferences; // triangle-tile pairs binned
+		unsigned long long pixelsShaded;
+		float setupMs;
+		float binMs;
+		float rasterMs;
+	};
+
+	explicit SoftwareRasterizer(JobSystem* jobs);
+	~SoftwareRasterizer();
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete; // Remove copy constructor
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete; // Remove copy-assignment operator
+
+	void Render(const RasterScene& scene);
+
+	// Last rendered image, top row first, one RGBA8 value per
+	// pixel with red in the low byte
+	unsigned int Width() { return width; }
+	unsigned int Height() { return height; }
+	const std::vector<unsigned int>& Pixels() { return pixels; }
+	const Stats& GetStats() { return stats; }
+
+	// Binary PPM, which any image viewer opens.  Returns false if
+	// the file couldn't be written
+	bool WritePpm(const std::string& path);
+
+	// Pixels where any channel differs from a PPM of the same size
+	// by more than tolerance, or -1 if it can't be read or the size
+	// is different
+	long long CompareToPpm(const std::string& path, int tolerance);
+
+private:
+
+	// Draws per setup job.  Fixed, so chunk boundaries (and the
+	// order triangles are binned in) never depend on the machine
+	static const unsigned int DRAW_CHUNK = 16;
+
+	// A vertex after the vertex shader, in clip space
+	struct ClipVertex
+	{
+		float clip[4];
+		float world[3];
+		float normal[3];
+	};
+
+	// A setup triangle in screen space.  Attributes are divided by w
+	// so they interpolate linearly across the screen
+	struct Triangle
+	{
+		float x[3]; // pixels
+		float y[3];
+		float z[3]; // depth, 0 to 1
+		float invW[3];
+		float world[3][3]; // world position / w
+		float normal[3][3]; // world normal / w
+		float area; // twice the screen area, always positive
+		unsigned int draw;
+	};
+
+	// A tile a triangle touches, written by setup
+	struct BinEntry
+	{
+		unsigned int tile;
+		unsigned int triangle;
+	};
+
+	// One setup job's output.  Kept between frames so the
+	// vectors stop reallocating once they're big enough
+	struct Chunk
+	{
+		std::vector<Triangle> triangles;
+		std::vector<BinEntry> bins;
+		unsigned int submitted;
+		unsigned int culled;
+		unsigned int clipped;
+	};
+
+	struct TriangleRef
+	{
+		unsigned int chunk;
+		unsigned int triangle;
+	};
+
+	void SetupDraw(const RasterScene& scene, unsigned int drawIndex, Chunk& chunk, std::vector<ClipVertex>& transformed);
+	void AddTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, unsigned int drawIndex, Chunk& chunk);
+	void RasterTile(const RasterScene& scene, unsigned int tile);
+
+	JobSystem* jobs;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int tilesX = 0;
+	unsigned int tilesY = 0;
+	std::vector<unsigned int> pixels;
+	Stats stats = {};
+
+	std::vector<Chunk> chunks;
+	std::vector<unsigned int> tileStart; // per tile, then one past the end
+	std::vector<TriangleRef> tileTriangles;
+	std::vector<unsigned int> tilePixelsShaded;
+	std::vector<DirectX::XMFLOAT3> linearAlbedo; // per draw
+};
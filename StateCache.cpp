@@ -0,0 +1,284 @@
+#include "StateCache.h"
+
+#include <cstring>
+
+namespace
+{
+	StateCache* defaultStates = nullptr;
+	thread_local StateCache* scopeStates = nullptr; // set by StateCache::Scope
+}
+
+StateCache::StateCache(std::shared_ptr<RenderContext> context)
+{
+	this->context = context;
+
+	ResetStats();
+	Invalidate();
+}
+
+StateCache::~StateCache()
+{
+}
+
+template <typename T>
+bool StateCache::Filter(Slot<T>& slot, T* value, Category category)
+{
+	if (slot.known && slot.bound == value) {
+		stats.skipped[category]++;
+		return false;
+	}
+
+	slot.bound = value;
+	slot.known = true;
+	stats.issued[category]++;
+	return true;
+}
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader)
+{
+	if (Filter(vertexShader, shader, CATEGORY_SHADER)) {
+		context->VSSetShader(shader);
+	}
+}
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader)
+{
+	if (Filter(pixelShader, shader, CATEGORY_SHADER)) {
+		context->PSSetShader(shader);
+	}
+}
+
+void StateCache::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (Filter(vsConstantBuffers[slot], buffer, CATEGORY_CBUFFER)) {
+		context->VSSetConstantBuffer(slot, buffer);
+	}
+}
+
+void StateCache::PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (Filter(psConstantBuffers[slot], buffer, CATEGORY_CBUFFER)) {
+		context->PSSetConstantBuffer(slot, buffer);
+	}
+}
+
+void StateCache::VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (Filter(vsResources[slot], srv, CATEGORY_SRV)) {
+		context->VSSetShaderResources(slot, 1, &srv);
+	}
+}
+
+void StateCache::PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (Filter(psResources[slot], srv, CATEGORY_SRV)) {
+		context->PSSetShaderResources(slot, 1, &srv);
+	}
+}
+
+void StateCache::VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (Filter(vsSamplers[slot], sampler, CATEGORY_SAMPLER)) {
+		context->VSSetSampler(slot, sampler);
+	}
+}
+
+void StateCache::PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (Filter(psSamplers[slot], sampler, CATEGORY_SAMPLER)) {
+		context->PSSetSampler(slot, sampler);
+	}
+}
+
+// --------------------------------------------------------
+// Unbinds every pixel shader resource in one call, which is
+// how we get render targets (shadow map, post process chain)
+// out of the input slots before writing to them again
+// --------------------------------------------------------
+void StateCache::PSClearShaderResources()
+{
+	ID3D11ShaderResourceView* nullSRVs[RenderContext::INPUT_RESOURCE_SLOTS] = {};
+	context->PSSetShaderResources(0, RenderContext::INPUT_RESOURCE_SLOTS, nullSRVs);
+	stats.issued[CATEGORY_SRV]++;
+
+	for (auto& s : psResources) {
+		s.bound = nullptr;
+		s.known = true;
+	}
+}
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	if (Filter(inputLayout, layout, CATEGORY_INPUT_ASSEMBLER)) {
+		context->IASetInputLayout(layout);
+	}
+}
+
+void StateCache::IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	//stride and offset are part of the binding, so a change there must go through too
+	if (stride != vertexStride || offset != vertexOffset) {
+		vertexBuffer.known = false;
+	}
+
+	if (Filter(vertexBuffer, buffer, CATEGORY_INPUT_ASSEMBLER)) {
+		vertexStride = stride;
+		vertexOffset = offset;
+		context->IASetVertexBuffer(buffer, stride, offset);
+	}
+}
+
+void StateCache::IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset)
+{
+	if (format != indexFormat || offset != indexOffset) {
+		indexBuffer.known = false;
+	}
+
+	if (Filter(indexBuffer, buffer, CATEGORY_INPUT_ASSEMBLER)) {
+		indexFormat = format;
+		indexOffset = offset;
+		context->IASetIndexBuffer(buffer, format, offset);
+	}
+}
+
+// --------------------------------------------------------
+// Topology and viewport are set once per pass, so they are
+// passed straight through rather than tracked
+// --------------------------------------------------------
+void StateCache::IASetPrimitiveTopology(unsigned int topology)
+{
+	context->IASetPrimitiveTopology(topology);
+	stats.issued[CATEGORY_INPUT_ASSEMBLER]++;
+}
+
+void StateCache::RSSetState(ID3D11RasterizerState* state)
+{
+	if (Filter(rasterizerState, state, CATEGORY_RENDER_STATE)) {
+		context->RSSetState(state);
+	}
+}
+
+void StateCache::RSSetViewport(float width, float height, float left, float top)
+{
+	context->RSSetViewport(width, height, left, top);
+	stats.issued[CATEGORY_RENDER_STATE]++;
+}
+
+void StateCache::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	if (stencilRef != this->stencilRef) {
+		depthStencilState.known = false;
+	}
+
+	if (Filter(depthStencilState, state, CATEGORY_RENDER_STATE)) {
+		this->stencilRef = stencilRef;
+		context->OMSetDepthStencilState(state, stencilRef);
+	}
+}
+
+// --------------------------------------------------------
+// Render targets are always set (they change a handful of
+// times per frame), but D3D silently unbinds any SRV of a
+// resource we start writing to, so our SRV slots can no
+// longer be trusted afterwards
+// --------------------------------------------------------
+void StateCache::OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv)
+{
+	context->OMSetRenderTargets(count, rtvs, dsv);
+	stats.issued[CATEGORY_RENDER_STATE]++;
+
+	for (auto& s : vsResources) { s.known = false; }
+	for (auto& s : psResources) { s.known = false; }
+}
+
+void StateCache::ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4])
+{
+	context->ClearRenderTargetView(rtv, color);
+}
+
+void StateCache::ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth)
+{
+	context->ClearDepthStencilView(dsv, depth);
+}
+
+void StateCache::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+	stats.draws++;
+}
+
+void StateCache::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	context->Draw(vertexCount, startVertex);
+	stats.draws++;
+}
+
+void StateCache::UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes)
+{
+	context->UpdateConstantBuffer(buffer, data, bytes);
+	stats.uploads++;
+	stats.uploadBytes += bytes;
+}
+
+void StateCache::UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes)
+{
+	context->UpdateBuffer(buffer, data, bytes);
+	stats.uploads++;
+	stats.uploadBytes += bytes;
+}
+
+void StateCache::Invalidate()
+{
+	vertexShader.known = false;
+	pixelShader.known = false;
+	for (auto& s : vsConstantBuffers) { s.known = false; }
+	for (auto& s : psConstantBuffers) { s.known = false; }
+	for (auto& s : vsResources) { s.known = false; }
+	for (auto& s : psResources) { s.known = false; }
+	for (auto& s : vsSamplers) { s.known = false; }
+	for (auto& s : psSamplers) { s.known = false; }
+
+	inputLayout.known = false;
+	vertexBuffer.known = false;
+	indexBuffer.known = false;
+
+	rasterizerState.known = false;
+	depthStencilState.known = false;
+}
+
+void StateCache::ResetStats()
+{
+	memset(&stats, 0, sizeof(Stats));
+}
+
+void StateCache::Accumulate(Stats& total, const Stats& stats)
+{
+	for (int i = 0; i < CATEGORY_COUNT; ++i) {
+		total.issued[i] += stats.issued[i];
+		total.skipped[i] += stats.skipped[i];
+	}
+	total.draws += stats.draws;
+	total.uploads += stats.uploads;
+	total.uploadBytes += stats.uploadBytes;
+}
+
+StateCache* StateCache::Current()
+{
+	return scopeStates ? scopeStates : defaultStates;
+}
+
+void StateCache::SetDefault(StateCache* states)
+{
+	defaultStates = states;
+}
+
+StateCache::Scope::Scope(StateCache* states)
+{
+	previous = scopeStates;
+	scopeStates = states;
+}
+
+StateCache::Scope::~Scope()
+{
+	scopeStates = previous;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <memory>
+
+#include "RenderContext.h"
+
+// --------------------------------------------------------
+// Thin layer over a render context that remembers what is
+// currently bound and drops redundant Set calls.
+//
+// Anything that talks to the device context directly (ImGui,
+// the swap chain, etc.) leaves this out of date, so
+// Invalidate() must be called afterwards.
+//
+// Only sees the backend through RenderContext, so it builds
+// without D3D headers on top of a NullRenderContext.
+// --------------------------------------------------------
+class StateCache
+{
+public:
+
+	// Kinds of binding we keep counters for
+	enum Category
+	{
+		CATEGORY_SHADER,
+		CATEGORY_SRV,
+		CATEGORY_SAMPLER,
+		CATEGORY_CBUFFER,
+		CATEGORY_INPUT_ASSEMBLER,
+		CATEGORY_RENDER_STATE,
+		CATEGORY_COUNT
+	};
+
+	struct Stats
+	{
+		unsigned int issued[CATEGORY_COUNT];
+		unsigned int skipped[CATEGORY_COUNT];
+		unsigned int draws;
+		unsigned int uploads; // constant and structured buffer updates
+		unsigned long long uploadBytes;
+	};
+
+	StateCache(std::shared_ptr<RenderContext> context);
+	~StateCache();
+	StateCache(const StateCache&) = delete; // Remove copy constructor
+	StateCache& operator=(const StateCache&) = delete; // Remove copy-assignment operator
+
+	// Shaders
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+	void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+	void PSClearShaderResources();
+
+	// Input assembler
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void IASetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset);
+	void IASetPrimitiveTopology(unsigned int topology);
+
+	// Fixed function state
+	void RSSetState(ID3D11RasterizerState* state);
+	void RSSetViewport(float width, float height, float left = 0, float top = 0);
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+	void OMSetRenderTargets(unsigned int count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv);
+
+	// Not state, always passed through, but counted alongside it
+	void ClearRenderTargetView(ID3D11RenderTargetView* rtv, const float color[4]);
+	void ClearDepthStencilView(ID3D11DepthStencilView* dsv, float depth);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void Draw(unsigned int vertexCount, unsigned int startVertex);
+	void UpdateConstantBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes);
+	void UpdateBuffer(ID3D11Buffer* buffer, const void* data, unsigned int bytes);
+
+	// Forget everything we think is bound
+	void Invalidate();
+
+	// Counters are per frame, so this should be called once at frame start
+	void ResetStats();
+	const Stats& GetStats() { return stats; }
+
+	RenderContext* Backend() { return context.get(); }
+
+	// Adds one filter's counters to another's, for frames recorded
+	// through more than one
+	static void Accumulate(Stats& total, const Stats& stats);
+
+	// The filter draw code (Mesh, Sky, SimpleShader) sends its commands
+	// to on the calling thread: the innermost Scope's, or the default
+	static StateCache* Current();
+	static void SetDefault(StateCache* states);
+
+	// Points Current at states on the calling thread for as long as
+	// it's alive, which is how passes record on other threads or to
+	// other backends.  Scopes nest
+	class Scope
+	{
+	public:
+		Scope(StateCache* states);
+		~Scope();
+		Scope(const Scope&) = delete; // Remove copy constructor
+		Scope& operator=(const Scope&) = delete; // Remove copy-assignment operator
+
+	private:
+		StateCache* previous;
+	};
+
+private:
+
+	// A cached binding that may be "unknown" after an invalidate,
+	// in which case the next Set always goes through
+	template <typename T>
+	struct Slot
+	{
+		T* bound = nullptr;
+		bool known = false;
+	};
+
+	// Returns true (and records the new value) when the call must be issued
+	template <typename T>
+	bool Filter(Slot<T>& slot, T* value, Category category);
+
+	std::shared_ptr<RenderContext> context;
+	Stats stats;
+
+	Slot<ID3D11VertexShader> vertexShader;
+	Slot<ID3D11PixelShader> pixelShader;
+	Slot<ID3D11Buffer> vsConstantBuffers[RenderContext::CONSTANT_BUFFER_SLOTS];
+	Slot<ID3D11Buffer> psConstantBuffers[RenderContext::CONSTANT_BUFFER_SLOTS];
+	Slot<ID3D11ShaderResourceView> vsResources[RenderContext::INPUT_RESOURCE_SLOTS];
+	Slot<ID3D11ShaderResourceView> psResources[RenderContext::INPUT_RESOURCE_SLOTS];
+	Slot<ID3D11SamplerState> vsSamplers[RenderContext::SAMPLER_SLOTS];
+	Slot<ID3D11SamplerState> psSamplers[RenderContext::SAMPLER_SLOTS];
+
+	Slot<ID3D11InputLayout> inputLayout;
+	Slot<ID3D11Buffer> vertexBuffer;
+	unsigned int vertexStride = 0;
+	unsigned int vertexOffset = 0;
+	Slot<ID3D11Buffer> indexBuffer;
+	unsigned int indexFormat = 0;
+	unsigned int indexOffset = 0;
+
+	Slot<ID3D11RasterizerState> rasterizerState;
+	Slot<ID3D11DepthStencilState> depthStencilState;
+	unsigned int stencilRef = 0;
+};
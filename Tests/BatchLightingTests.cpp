@@ -0,0 +1,188 @@
+#include "PbrBatch.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// --------------------------------------------------------
+// PbrBatch against the scalar PbrLighting::Shade on fixed
+// inputs.  This file is built twice, once as the engine is
+// (SSE) and once with AVX2 on, so between the two builds the
+// AVX, SSE and scalar paths are all checked to agree within
+// PbrBatch::SCALAR_TOLERANCE
+// --------------------------------------------------------
+namespace
+{
+	// ctest's SKIP_RETURN_CODE, for an AVX build on a CPU without it
+	const int SKIPPED = 77;
+
+	// Inputs as ShadeStream takes them, one array per component
+	struct Inputs
+	{
+		std::vector<float> normal[3];
+		std::vector<float> position[3];
+		std::vector<float> albedo[3];
+		std::vector<float> roughness;
+		std::vector<float> metalness;
+		std::vector<float> shadow;
+
+		void Add(PbrLighting::Vec3 n, PbrLighting::Vec3 p, PbrLighting::Vec3 a, float r, float m, float s)
+		{
+			n = PbrLighting::Normalize(n);
+			const float values[3][3] = { { n.x, n.y, n.z }, { p.x, p.y, p.z }, { a.x, a.y, a.z } };
+			for (int c = 0; c < 3; ++c) {
+				normal[c].push_back(values[0][c]);
+				position[c].push_back(values[1][c]);
+				albedo[c].push_back(values[2][c]);
+			}
+			roughness.push_back(r);
+			metalness.push_back(m);
+			shadow.push_back(s);
+		}
+
+		unsigned int Count() { return (unsigned int)roughness.size(); }
+	};
+
+	// One light of each type first, then a seeded spread of point and
+	// spot lights, like Benchmarks::BatchLighting
+	std::vector<Light> MakeLights()
+	{
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> zeroOne(0.0f, 1.0f);
+
+		std::vector<Light> lights(8);
+		std::memset(lights.data(), 0, sizeof(Light) * lights.size());
+		for (unsigned int i = 0; i < lights.size(); ++i) {
+			Light& light = lights[i];
+			light.Type = i == 0 ? LIGHT_TYPE_DIRECTIONAL : (i % 2 ? LIGHT_TYPE_POINT : LIGHT_TYPE_SPOT);
+			PbrLighting::Vec3 direction = PbrLighting::Normalize(PbrLighting::Vec3{ unit(rng), unit(rng) - 1.5f, unit(rng) });
+			light.Direction = DirectX::XMFLOAT3(direction.x, direction.y, direction.z);
+			light.Position = DirectX::XMFLOAT3(unit(rng) * 6, 2 + zeroOne(rng) * 4, unit(rng) * 6);
+			light.Range = 6 + zeroOne(rng) * 8;
+			light.Intensity = 0.5f + zeroOne(rng) * 2;
+			light.Color = DirectX::XMFLOAT3(zeroOne(rng), zeroOne(rng), zeroOne(rng));
+			light.SpotInnerAngle = DirectX::XMConvertToRadians(20);
+			light.SpotOuterAngle = DirectX::XMConvertToRadians(35);
+			light.ShadowTile = -1;
+		}
+		return lights;
+	}
+
+	// The cases most likely to split the paths apart come first: very
+	// smooth and very rough, fully metal, shadowed, facing away from
+	// every light and sitting right on a light.  Then a seeded spread.
+	// The count isn't a multiple of the batch width, so the padded last
+	// batch is covered too
+	Inputs MakeInputs(const std::vector<Light>& lights)
+	{
+		Inputs inputs;
+		PbrLighting::Vec3 up{ 0, 1, 0 };
+		PbrLighting::Vec3 grey{ 0.5f, 0.5f, 0.5f };
+		PbrLighting::Vec3 origin{ 0, 0, 0 };
+		inputs.Add(up, origin, grey, 0.05f, 0.0f, 1.0f);
+		inputs.Add(up, origin, grey, 1.0f, 0.0f, 1.0f);
+		inputs.Add(up, origin, PbrLighting::Vec3{ 1.0f, 0.8f, 0.3f }, 0.3f, 1.0f, 1.0f);
+		inputs.Add(up, origin, grey, 0.5f, 0.0f, 0.0f);
+		inputs.Add(PbrLighting::Vec3{ 0, -1, 0 }, origin, grey, 0.5f, 0.5f, 1.0f);
+		inputs.Add(PbrLighting::Vec3{ 1, 0.001f, 0 }, PbrLighting::Vec3{ 3, 0, 0 }, grey, 0.5f, 0.0f, 1.0f);
+		const DirectX::XMFLOAT3& lightPosition = lights[1].Position;
+		inputs.Add(up, PbrLighting::Vec3{ lightPosition.x, lightPosition.y - 0.01f, lightPosition.z }, grey, 0.5f, 0.0f, 1.0f);
+
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> zeroOne(0.0f, 1.0f);
+		while (inputs.Count() < 4093) {
+			inputs.Add(
+				PbrLighting::Vec3{ unit(rng), unit(rng), unit(rng) },
+				PbrLighting::Vec3{ unit(rng) * 8, unit(rng) * 2, unit(rng) * 8 },
+				PbrLighting::Vec3{ zeroOne(rng), zeroOne(rng), zeroOne(rng) },
+				0.05f + zeroOne(rng) * 0.95f,
+				zeroOne(rng) < 0.5f ? 0.0f : 1.0f,
+				zeroOne(rng) < 0.3f ? 0.0f : 1.0f);
+		}
+		return inputs;
+	}
+
+	bool CpuRunsThisBuild()
+	{
+#if defined(__AVX2__) && defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(__AVX2__)
+		return __builtin_cpu_supports("avx2");
+#else
+		return true;
+#endif
+	}
+
+	void BatchMatchesScalar()
+	{
+		std::vector<Light> lights = MakeLights();
+		Inputs inputs = MakeInputs(lights);
+		unsigned int count = inputs.Count();
+		PbrLighting::Vec3 cameraPos{ 0, 3, -8 };
+
+		std::vector<float> batched[3];
+		PbrBatch::SampleStream stream = {};
+		stream.count = count;
+		for (int c = 0; c < 3; ++c) {
+			batched[c].resize(count);
+			stream.normal[c] = inputs.normal[c].data();
+			stream.position[c] = inputs.position[c].data();
+			stream.albedo[c] = inputs.albedo[c].data();
+			stream.color[c] = batched[c].data();
+		}
+		stream.roughness = inputs.roughness.data();
+		stream.metalness = inputs.metalness.data();
+		stream.shadow = inputs.shadow.data();
+		PbrBatch::ShadeStream(stream, cameraPos, lights.data(), (unsigned int)lights.size());
+
+		float maxError = 0;
+		unsigned int mismatches = 0;
+		for (unsigned int i = 0; i < count; ++i) {
+			PbrLighting::Vec3 scalar = PbrLighting::Shade(
+				PbrLighting::Vec3{ inputs.normal[0][i], inputs.normal[1][i], inputs.normal[2][i] },
+				PbrLighting::Vec3{ inputs.position[0][i], inputs.position[1][i], inputs.position[2][i] },
+				cameraPos,
+				PbrLighting::Vec3{ inputs.albedo[0][i], inputs.albedo[1][i], inputs.albedo[2][i] },
+				inputs.roughness[i], inputs.metalness[i], inputs.shadow[i], lights.data(), (unsigned int)lights.size());
+			const float expected[3] = { scalar.x, scalar.y, scalar.z };
+
+			for (int c = 0; c < 3; ++c) {
+				float error = std::fabs(batched[c][i] - expected[c]) / std::fmax(std::fabs(expected[c]), 0.01f);
+				maxError = std::fmax(maxError, error);
+				//NaNs count too
+				if (!(error <= PbrBatch::SCALAR_TOLERANCE) && mismatches++ < 5) {
+					std::printf("  sample %u channel %d: scalar %g, batched %g\n", i, c, expected[c], batched[c][i]);
+				}
+			}
+		}
+		std::printf("  %u samples, max relative error %.2e\n", count, maxError);
+		CHECK(mismatches == 0);
+	}
+}
+
+int main()
+{
+#if defined(__AVX__)
+	std::printf("Batch path: AVX\n");
+#else
+	std::printf("Batch path: SSE\n");
+#endif
+	if (!CpuRunsThisBuild()) {
+		std::printf("Skipped, this CPU has no AVX2\n");
+		return SKIPPED;
+	}
+
+	RUN_TEST(BatchMatchesScalar);
+	return Check::Result();
+}
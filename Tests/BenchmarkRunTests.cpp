@@ -0,0 +1,181 @@
+#include "BenchmarkRun.h"
+#include "NullScene.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// A short scripted flythrough of the null scene (see
+// NullScene), recorded the way Game records a benchmark run,
+// and the JSON report it writes read back
+// --------------------------------------------------------
+namespace
+{
+	const unsigned int FRAMES = 8;
+	const unsigned long long FIRST_FRAME = 1;
+
+	std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream in(path);
+		std::stringstream text;
+		text << in.rdbuf();
+		return text.str();
+	}
+
+	// Braces and brackets outside strings close in the order they opened
+	bool Balanced(const std::string& json)
+	{
+		std::vector<char> open;
+		bool inString = false;
+		for (char c : json) {
+			if (inString) {
+				inString = c != '"';
+			}
+			else if (c == '"') {
+				inString = true;
+			}
+			else if (c == '{' || c == '[') {
+				open.push_back(c);
+			}
+			else if (c == '}' || c == ']') {
+				if (open.empty() || open.back() != (c == '}' ? '{' : '[')) {
+					return false;
+				}
+				open.pop_back();
+			}
+		}
+		return open.empty() && !inString;
+	}
+
+	// Every value of an unsigned integer field, in the order they appear
+	std::vector<unsigned long long> Values(const std::string& json, const std::string& field)
+	{
+		std::vector<unsigned long long> values;
+		std::regex pattern("\"" + field + "\":([0-9]+)");
+		for (auto match = std::sregex_iterator(json.begin(), json.end(), pattern); match != std::sregex_iterator(); ++match) {
+			values.push_back(std::stoull((*match)[1].str()));
+		}
+		return values;
+	}
+
+	bool Has(const std::string& json, const std::string& text)
+	{
+		return json.find(text) != std::string::npos;
+	}
+
+	void WritesAFlythroughReport()
+	{
+		std::filesystem::path reportPath = std::filesystem::temp_directory_path() / "BenchmarkRunTests.json";
+		NullScene scene;
+		BenchmarkRun run("flythrough", FRAMES, FIRST_FRAME, reportPath.string());
+
+		//one tick and one drawn frame each, as -benchmark pins the game to
+		std::vector<unsigned long long> draws, visible, casters;
+		NullPassRecorder recorder;
+		for (unsigned long long frame = FIRST_FRAME; !run.Done(); ++frame) {
+			scene.pool.BeginTick();
+			DirectX::XMFLOAT3 position, target;
+			run.CameraPose(frame, position, target);
+			SceneSnapshot snapshot;
+			scene.Prepare(snapshot, position, target);
+
+			auto start = std::chrono::steady_clock::now();
+			scene.renderer->Record(recorder, snapshot, scene.resources);
+			recorder.Submit();
+			float drawMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			StateCache::Stats stats = {};
+			recorder.AddStats(stats);
+			run.RecordDraw(frame, drawMs, stats);
+			draws.push_back(stats.draws);
+
+			run.RecordFrame(frame, 16.0f, 2.0f, scene.entities.GetCount(),
+				scene.renderer->GetVisibleCount(), scene.renderer->GetShadowCasterCount());
+			visible.push_back(scene.renderer->GetVisibleCount());
+			casters.push_back(scene.renderer->GetShadowCasterCount());
+		}
+		CHECK(draws.size() == FRAMES);
+		//the path passes the cubes at least once
+		CHECK(*std::max_element(visible.begin(), visible.end()) > 0);
+		run.AddResult("check", "{\"passed\":true}");
+		CHECK(run.WriteReport(NullScene::WIDTH, NullScene::HEIGHT, false, true));
+
+		std::string json = ReadFile(reportPath);
+		std::filesystem::remove(reportPath);
+		std::printf("  %zu byte report\n", json.size());
+
+		CHECK(Balanced(json));
+		CHECK(Has(json, "\"scene\":\"flythrough\""));
+		CHECK(Has(json, "\"frames\":8,"));
+		CHECK(Has(json, "\"framesDrawn\":8,"));
+		CHECK(Has(json, "\"width\":1280,"));
+		CHECK(Has(json, "\"height\":720,"));
+		CHECK(Has(json, "\"deferredPasses\":false,"));
+		CHECK(Has(json, "\"nullBackend\":true,"));
+		CHECK(Has(json, "\"check\":{\"passed\":true},"));
+
+		//the first frame has nothing to measure its frameMs from
+		CHECK(Has(json, "\"frameMs\":{\"count\":7,\"mean\":16.0000,"));
+		CHECK(Has(json, "\"updateMs\":{\"count\":8,\"mean\":2.0000,"));
+		CHECK(Has(json, "\"drawMs\":{\"count\":8,"));
+
+		//every frame, numbered from the run's start, with what was drawn
+		std::vector<unsigned long long> frames = Values(json, "frame");
+		CHECK(frames.size() == FRAMES);
+		bool inOrder = true;
+		for (unsigned int i = 0; i < frames.size(); ++i) {
+			inOrder = inOrder && frames[i] == i;
+		}
+		CHECK(inOrder);
+		CHECK(Values(json, "entities") == std::vector<unsigned long long>(FRAMES, scene.entities.GetCount()));
+		CHECK(Values(json, "visible") == visible);
+		CHECK(Values(json, "shadowCasters") == casters);
+		CHECK(Values(json, "drawCalls") == draws);
+		CHECK(Values(json, "uploads").size() == FRAMES);
+		CHECK(Values(json, "stateCalls").size() == FRAMES);
+	}
+
+	void SkipsFramesNeverDrawn()
+	{
+		std::filesystem::path reportPath = std::filesystem::temp_directory_path() / "BenchmarkRunTests.json";
+		BenchmarkRun run("flythrough", 3, FIRST_FRAME, reportPath.string());
+
+		//the renderer skipped the middle frame for the newest snapshot;
+		//frames outside the run are ignored
+		StateCache::Stats stats = {};
+		stats.draws = 5;
+		for (unsigned long long frame = 0; frame <= 4; ++frame) {
+			run.RecordFrame(frame, 10.0f, 1.0f, 1, 1, 0);
+			if (frame != 2) {
+				run.RecordDraw(frame, 3.0f, stats);
+			}
+		}
+		CHECK(run.Done());
+		CHECK(run.WriteReport(NullScene::WIDTH, NullScene::HEIGHT, true, false));
+
+		std::string json = ReadFile(reportPath);
+		std::filesystem::remove(reportPath);
+
+		CHECK(Balanced(json));
+		CHECK(Has(json, "\"frames\":3,"));
+		CHECK(Has(json, "\"framesDrawn\":2,"));
+		CHECK(Has(json, "\"deferredPasses\":true,"));
+		CHECK(Has(json, "\"nullBackend\":false,"));
+		CHECK(Has(json, "\"drawMs\":{\"count\":2,"));
+		CHECK(Values(json, "frame").size() == 3);
+		CHECK(Values(json, "drawCalls") == std::vector<unsigned long long>({ 5, 5 }));
+	}
+}
+
+int main()
+{
+	RUN_TEST(WritesAFlythroughReport);
+	RUN_TEST(SkipsFramesNeverDrawn);
+	return Check::Result();
+}
@@ -0,0 +1,60 @@
+#include "Benchmarks.h"
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <cstdio>
+
+// --------------------------------------------------------
+// The checks built into the benchmarks, run headless on
+// smaller data than the UI uses.  Timings are printed but
+// never checked
+// --------------------------------------------------------
+namespace
+{
+	void Report(const Benchmarks::Result& result)
+	{
+		std::printf("  %s\n", result.text.c_str());
+	}
+
+	void InverseTransposeMatchesGeneralInverse()
+	{
+		Benchmarks::Result result = Benchmarks::InverseTranspose(100000);
+		Report(result);
+		CHECK(result.passed);
+	}
+
+	void ParallelSpinIsDeterministic()
+	{
+		//workers of its own, so the parallel path really is split up even
+		//on a machine with one core
+		JobSystem jobs(3);
+		Benchmarks::Result result = Benchmarks::EntityIteration(100000, 2, &jobs);
+		Report(result);
+		CHECK(result.passed);
+	}
+
+	void JobScalingLosesNoJobs()
+	{
+		//up to 4 threads whatever the core count, so stealing and helping
+		//while waiting happen even on one core
+		Benchmarks::Result result = Benchmarks::JobScaling(20000, 10000, 4);
+		Report(result);
+		CHECK(result.passed);
+	}
+
+	void BatchLightingMatchesScalar()
+	{
+		Benchmarks::Result result = Benchmarks::BatchLighting(100000);
+		Report(result);
+		CHECK(result.passed);
+	}
+}
+
+int main()
+{
+	RUN_TEST(InverseTransposeMatchesGeneralInverse);
+	RUN_TEST(ParallelSpinIsDeterministic);
+	RUN_TEST(JobScalingLosesNoJobs);
+	RUN_TEST(BatchLightingMatchesScalar);
+	return Check::Result();
+}
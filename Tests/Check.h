@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+
+// --------------------------------------------------------
+// Just enough of a test framework for the engine tests: a
+// failed CHECK prints where it was and keeps going, and
+// main returns Check::Result() so ctest sees the failure.
+// Each test is a plain function run through RUN_TEST
+// --------------------------------------------------------
+namespace Check
+{
+	inline int failures = 0;
+
+	inline bool That(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition) {
+			std::printf("%s(%d): CHECK failed: %s\n", file, line, expression);
+			failures++;
+		}
+		return condition;
+	}
+
+	inline int Result()
+	{
+		if (failures > 0) {
+			std::printf("%d check(s) failed\n", failures);
+			return 1;
+		}
+		std::printf("All checks passed\n");
+		return 0;
+	}
+}
+
+#define CHECK(condition) Check::That((condition), #condition, __FILE__, __LINE__)
+#define RUN_TEST(test) do { std::printf("%s\n", #test); test(); } while (0)
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// --------------------------------------------------------
+// Plain scalar versions of the DirectXMath functions the
+// device-free code uses, for building it off Windows (see
+// Windows.h in this directory).  Same conventions as the
+// real library: row vectors, matrices multiply left to
+// right, left handed projections, and quaternions stored as
+// (x, y, z, w) with XMQuaternionMultiply(a, b) meaning "a,
+// then b".  Results can differ from the SSE versions in
+// rounding
+// --------------------------------------------------------
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_1DIVPI = 0.318309886f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	struct alignas(16) XMVECTOR
+	{
+		float f[4];
+	};
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct alignas(16) XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		constexpr XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) : r{ r0, r1, r2, r3 } {}
+	};
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMFLOAT2
+	{
+		float x, y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct alignas(16) XMFLOAT4A : public XMFLOAT4
+	{
+		using XMFLOAT4::XMFLOAT4;
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(
+			float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03),
+			_21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23),
+			_41(m30), _42(m31), _43(m32), _44(m33) {}
+	};
+
+	// --- Loads and stores ---
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* source) { return XMVECTOR{ { source->x, source->y, 0, 0 } }; }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return XMVECTOR{ { source->x, source->y, source->z, 0 } }; }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVECTOR{ { source->x, source->y, source->z, source->w } }; }
+	inline XMVECTOR XMLoadFloat4A(const XMFLOAT4A* source) { return XMLoadFloat4(source); }
+
+	inline void XMStoreFloat2(XMFLOAT2* destination, FXMVECTOR v) { *destination = XMFLOAT2(v.f[0], v.f[1]); }
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v) { *destination = XMFLOAT3(v.f[0], v.f[1], v.f[2]); }
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { *destination = XMFLOAT4(v.f[0], v.f[1], v.f[2], v.f[3]); }
+	inline void XMStoreFloat4A(XMFLOAT4A* destination, FXMVECTOR v) { XMStoreFloat4(destination, v); }
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX result;
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				result.r[r].f[c] = source->m[r][c];
+			}
+		}
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				destination->m[r][c] = m.r[r].f[c];
+			}
+		}
+	}
+
+	// --- Vectors ---
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return XMVECTOR{ { x, y, z, w } }; }
+	inline XMVECTOR XMVectorReplicate(float value) { return XMVECTOR{ { value, value, value, value } }; }
+	inline XMVECTOR XMVectorZero() { return XMVectorReplicate(0); }
+	inline XMVECTOR XMVectorSplatOne() { return XMVectorReplicate(1); }
+
+	inline float XMVectorGetX(FXMVECTOR v) { return v.f[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { return v.f[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { return v.f[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { return v.f[3]; }
+	inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w) { return XMVECTOR{ { v.f[0], v.f[1], v.f[2], w } }; }
+
+	// Applies op to each component
+	template <typename Op>
+	inline XMVECTOR XMVectorMap(FXMVECTOR a, FXMVECTOR b, Op op)
+	{
+		return XMVECTOR{ { op(a.f[0], b.f[0]), op(a.f[1], b.f[1]), op(a.f[2], b.f[2]), op(a.f[3], b.f[3]) } };
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x + y; }); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x - y; }); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x * y; }); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x / y; }); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x > y ? x : y; }); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return XMVectorMap(a, b, [](float x, float y) { return x < y ? x : y; }); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return XMVectorAdd(XMVectorMultiply(a, b), c); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return XMVectorMultiply(v, XMVectorReplicate(scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return XMVectorSubtract(XMVectorZero(), v); }
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR v) { return XMVectorDivide(XMVectorSplatOne(), v); }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR v) { return XMVectorSet(std::sqrt(v.f[0]), std::sqrt(v.f[1]), std::sqrt(v.f[2]), std::sqrt(v.f[3])); }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t) { return XMVectorAdd(a, XMVectorScale(XMVectorSubtract(b, a), t)); }
+	inline XMVECTOR XMVectorCatmullRom(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2, GXMVECTOR p3, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return XMVectorAdd(XMVectorAdd(XMVectorScale(p0, (-t3 + 2.0f * t2 - t) * 0.5f), XMVectorScale(p1, (3.0f * t3 - 5.0f * t2 + 2.0f) * 0.5f)),
+			XMVectorAdd(XMVectorScale(p2, (-3.0f * t3 + 4.0f * t2 + t) * 0.5f), XMVectorScale(p3, (t3 - t2) * 0.5f)));
+	}
+
+	inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return XMVectorAdd(a, b); }
+	inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) { return XMVectorSubtract(a, b); }
+	inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) { return XMVectorMultiply(a, b); }
+	inline XMVECTOR operator/(FXMVECTOR a, FXMVECTOR b) { return XMVectorDivide(a, b); }
+	inline XMVECTOR operator*(FXMVECTOR v, float s) { return XMVectorScale(v, s); }
+	inline XMVECTOR operator*(float s, FXMVECTOR v) { return XMVectorScale(v, s); }
+	inline XMVECTOR operator-(FXMVECTOR v) { return XMVectorNegate(v); }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.f[0] * b.f[0] + a.f[1] * b.f[1] + a.f[2] * b.f[2]); }
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.f[0] * b.f[0] + a.f[1] * b.f[1] + a.f[2] * b.f[2] + a.f[3] * b.f[3]); }
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorSqrt(XMVector3LengthSq(v)); }
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(
+			a.f[1] * b.f[2] - a.f[2] * b.f[1],
+			a.f[2] * b.f[0] - a.f[0] * b.f[2],
+			a.f[0] * b.f[1] - a.f[1] * b.f[0],
+			0);
+	}
+
+	// Zero length comes back as zero, like the real one
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0 ? XMVectorScale(v, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v)
+	{
+		float length = std::sqrt(XMVectorGetX(XMVector4Dot(v, v)));
+		return length > 0 ? XMVectorScale(v, 1.0f / length) : XMVectorZero();
+	}
+
+	// Treats v as a point (w = 1)
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = m.r[3];
+		result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[2]), m.r[2], result);
+		result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[1]), m.r[1], result);
+		return XMVectorMultiplyAdd(XMVectorReplicate(v.f[0]), m.r[0], result);
+	}
+
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVector3Transform(v, m);
+		return XMVectorScale(result, 1.0f / result.f[3]);
+	}
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVectorMultiply(XMVectorReplicate(v.f[3]), m.r[3]);
+		result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[2]), m.r[2], result);
+		result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[1]), m.r[1], result);
+		return XMVectorMultiplyAdd(XMVectorReplicate(v.f[0]), m.r[0], result);
+	}
+
+	// --- Planes ---
+
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane)
+	{
+		float length = XMVectorGetX(XMVector3Length(plane));
+		return length > 0 ? XMVectorScale(plane, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XMPlaneDotCoord(FXMVECTOR plane, FXMVECTOR point)
+	{
+		return XMVectorReplicate(plane.f[0] * point.f[0] + plane.f[1] * point.f[1] + plane.f[2] * point.f[2] + plane.f[3]);
+	}
+
+	// --- Quaternions ---
+
+	inline XMVECTOR XMQuaternionIdentity() { return XMVectorSet(0, 0, 0, 1); }
+	inline XMVECTOR XMQuaternionNormalize(FXMVECTOR q) { return XMVector4Normalize(q); }
+	inline XMVECTOR XMQuaternionConjugate(FXMVECTOR q) { return XMVectorSet(-q.f[0], -q.f[1], -q.f[2], q.f[3]); }
+
+	// q1 then q2, which is the product q2 * q1
+	inline XMVECTOR XMQuaternionMultiply(FXMVECTOR q1, FXMVECTOR q2)
+	{
+		return XMVectorSet(
+			q2.f[3] * q1.f[0] + q2.f[0] * q1.f[3] + q2.f[1] * q1.f[2] - q2.f[2] * q1.f[1],
+			q2.f[3] * q1.f[1] - q2.f[0] * q1.f[2] + q2.f[1] * q1.f[3] + q2.f[2] * q1.f[0],
+			q2.f[3] * q1.f[2] + q2.f[0] * q1.f[1] - q2.f[1] * q1.f[0] + q2.f[2] * q1.f[3],
+			q2.f[3] * q1.f[3] - q2.f[0] * q1.f[0] - q2.f[1] * q1.f[1] - q2.f[2] * q1.f[2]);
+	}
+
+	// Roll about z, then pitch about x, then yaw about y
+	inline XMVECTOR XMQuaternionRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		float sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+		float sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+		float sr = std::sin(roll * 0.5f), cr = std::cos(roll * 0.5f);
+		return XMVectorSet(
+			cr * sp * cy + sr * cp * sy,
+			cr * cp * sy - sr * sp * cy,
+			sr * cp * cy - cr * sp * sy,
+			cr * cp * cy + sr * sp * sy);
+	}
+
+	inline XMVECTOR XMQuaternionSlerp(FXMVECTOR q0, FXMVECTOR q1, float t)
+	{
+		float cosOmega = XMVectorGetX(XMVector4Dot(q0, q1));
+		float sign = 1;
+		if (cosOmega < 0) {
+			cosOmega = -cosOmega;
+			sign = -1;
+		}
+
+		float s0, s1;
+		if (1.0f - cosOmega > 0.00001f) {
+			float omega = std::acos(cosOmega);
+			float sinOmega = std::sin(omega);
+			s0 = std::sin((1.0f - t) * omega) / sinOmega;
+			s1 = std::sin(t * omega) / sinOmega;
+		}
+		else {
+			s0 = 1.0f - t;
+			s1 = t;
+		}
+		return XMVectorAdd(XMVectorScale(q0, s0), XMVectorScale(q1, s1 * sign));
+	}
+
+	// --- Matrices ---
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX(XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, 0, 1));
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		return XMMATRIX(XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(x, y, z, 1));
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z)
+	{
+		return XMMATRIX(XMVectorSet(x, 0, 0, 0), XMVectorSet(0, y, 0, 0), XMVectorSet(0, 0, z, 0), XMVectorSet(0, 0, 0, 1));
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX result;
+		for (int r = 0; r < 4; ++r) {
+			result.r[r] = XMVector4Transform(a.r[r], b);
+		}
+		return result;
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		XMMATRIX result;
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				result.r[r].f[c] = m.r[c].f[r];
+			}
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q)
+	{
+		float x = q.f[0], y = q.f[1], z = q.f[2], w = q.f[3];
+		return XMMATRIX(
+			XMVectorSet(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0),
+			XMVectorSet(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0),
+			XMVectorSet(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0),
+			XMVectorSet(0, 0, 0, 1));
+	}
+
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		return XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+	}
+
+	// Cofactor expansion; the determinant (replicated) goes to determinant
+	// when it's given, and a singular matrix comes back as all infinities
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		float a[16];
+		for (int i = 0; i < 16; ++i) {
+			a[i] = m.r[i / 4].f[i % 4];
+		}
+
+		float inv[16];
+		inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+		if (determinant) {
+			*determinant = XMVectorReplicate(det);
+		}
+
+		XMMATRIX result;
+		for (int i = 0; i < 16; ++i) {
+			result.r[i / 4].f[i % 4] = inv[i] / det;
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eyePosition, FXMVECTOR eyeDirection, FXMVECTOR upDirection)
+	{
+		XMVECTOR r2 = XMVector3Normalize(eyeDirection);
+		XMVECTOR r0 = XMVector3Normalize(XMVector3Cross(upDirection, r2));
+		XMVECTOR r1 = XMVector3Cross(r2, r0);
+		XMVECTOR negEye = XMVectorNegate(eyePosition);
+
+		XMMATRIX m(
+			XMVectorSetW(r0, XMVectorGetX(XMVector3Dot(r0, negEye))),
+			XMVectorSetW(r1, XMVectorGetX(XMVector3Dot(r1, negEye))),
+			XMVectorSetW(r2, XMVectorGetX(XMVector3Dot(r2, negEye))),
+			XMVectorSet(0, 0, 0, 1));
+		return XMMatrixTranspose(m);
+	}
+
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eyePosition, FXMVECTOR focusPosition, FXMVECTOR upDirection)
+	{
+		return XMMatrixLookToLH(eyePosition, XMVectorSubtract(focusPosition, eyePosition), upDirection);
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float height = std::cos(fovAngleY * 0.5f) / std::sin(fovAngleY * 0.5f);
+		float width = height / aspectRatio;
+		float range = farZ / (farZ - nearZ);
+		return XMMATRIX(
+			XMVectorSet(width, 0, 0, 0),
+			XMVectorSet(0, height, 0, 0),
+			XMVectorSet(0, 0, range, 1),
+			XMVectorSet(0, 0, -range * nearZ, 0));
+	}
+
+	inline XMMATRIX XMMatrixOrthographicLH(float viewWidth, float viewHeight, float nearZ, float farZ)
+	{
+		float range = 1.0f / (farZ - nearZ);
+		return XMMATRIX(
+			XMVectorSet(2.0f / viewWidth, 0, 0, 0),
+			XMVectorSet(0, 2.0f / viewHeight, 0, 0),
+			XMVectorSet(0, 0, range, 0),
+			XMVectorSet(0, 0, -range * nearZ, 1));
+	}
+
+	inline XMMATRIX XMMatrixOrthographicOffCenterLH(float viewLeft, float viewRight, float viewBottom, float viewTop, float nearZ, float farZ)
+	{
+		float width = 1.0f / (viewRight - viewLeft);
+		float height = 1.0f / (viewTop - viewBottom);
+		float range = 1.0f / (farZ - nearZ);
+		return XMMATRIX(
+			XMVectorSet(width + width, 0, 0, 0),
+			XMVectorSet(0, height + height, 0, 0),
+			XMVectorSet(0, 0, range, 0),
+			XMVectorSet(-(viewLeft + viewRight) * width, -(viewTop + viewBottom) * height, -range * nearZ, 1));
+	}
+
+	// --- Scalars ---
+
+	inline void XMScalarSinCos(float* sin, float* cos, float value)
+	{
+		*sin = std::sin(value);
+		*cos = std::cos(value);
+	}
+}
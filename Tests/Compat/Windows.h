@@ -0,0 +1,47 @@
+#pragma once
+
+// --------------------------------------------------------
+// Off Windows, the CMake build puts this directory ahead of
+// the system headers.  It only declares the small part of
+// the Windows and D3D11 headers that the device-free code
+// mentions, so it can be built.  The only D3D objects that
+// ever exist there are NullRenderDevice's stand ins
+// --------------------------------------------------------
+typedef int BOOL;
+typedef long HRESULT;
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef unsigned short WORD;
+typedef const wchar_t* LPCWSTR;
+
+#define TRUE 1
+#define FALSE 0
+
+#define STDMETHODCALLTYPE
+#define S_OK ((HRESULT)0)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+// Console colors, which only mean anything on Windows
+#define FOREGROUND_BLUE 0x1
+#define FOREGROUND_GREEN 0x2
+#define FOREGROUND_RED 0x4
+#define FOREGROUND_INTENSITY 0x8
+
+struct GUID
+{
+	unsigned long Data1;
+	unsigned short Data2;
+	unsigned short Data3;
+	unsigned char Data4[8];
+};
+typedef GUID IID;
+typedef const IID& REFIID;
+
+struct IUnknown
+{
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) = 0;
+	virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+	virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
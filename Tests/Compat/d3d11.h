@@ -0,0 +1,63 @@
+#pragma once
+
+// Declarations only, see Windows.h in this directory
+#include <Windows.h>
+
+// The enum values the device-free code passes on, with their
+// real values
+enum D3D_CBUFFER_TYPE
+{
+	D3D_CT_CBUFFER = 0,
+	D3D11_CT_CBUFFER = D3D_CT_CBUFFER
+};
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_R32_UINT = 42
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4
+};
+
+enum D3D11_CULL_MODE
+{
+	D3D11_CULL_NONE = 1,
+	D3D11_CULL_FRONT = 2,
+	D3D11_CULL_BACK = 3
+};
+
+enum D3D11_COMPARISON_FUNC
+{
+	D3D11_COMPARISON_NEVER = 1,
+	D3D11_COMPARISON_LESS = 2,
+	D3D11_COMPARISON_EQUAL = 3,
+	D3D11_COMPARISON_LESS_EQUAL = 4,
+	D3D11_COMPARISON_GREATER = 5,
+	D3D11_COMPARISON_NOT_EQUAL = 6,
+	D3D11_COMPARISON_GREATER_EQUAL = 7,
+	D3D11_COMPARISON_ALWAYS = 8
+};
+
+struct ID3D11DeviceChild : IUnknown {};
+struct ID3D11Resource : ID3D11DeviceChild {};
+struct ID3D11Buffer : ID3D11Resource {};
+struct ID3D11View : ID3D11DeviceChild {};
+struct ID3D11ShaderResourceView : ID3D11View {};
+struct ID3D11UnorderedAccessView : ID3D11View {};
+struct ID3D11RenderTargetView : ID3D11View {};
+struct ID3D11DepthStencilView : ID3D11View {};
+struct ID3D11VertexShader : ID3D11DeviceChild {};
+struct ID3D11PixelShader : ID3D11DeviceChild {};
+struct ID3D11DomainShader : ID3D11DeviceChild {};
+struct ID3D11HullShader : ID3D11DeviceChild {};
+struct ID3D11GeometryShader : ID3D11DeviceChild {};
+struct ID3D11ComputeShader : ID3D11DeviceChild {};
+struct ID3D11InputLayout : ID3D11DeviceChild {};
+struct ID3D11SamplerState : ID3D11DeviceChild {};
+struct ID3D11RasterizerState : ID3D11DeviceChild {};
+struct ID3D11DepthStencilState : ID3D11DeviceChild {};
+struct ID3D11CommandList : ID3D11DeviceChild {};
+struct ID3D11DeviceContext : ID3D11DeviceChild {};
+struct ID3D11Device : IUnknown {};
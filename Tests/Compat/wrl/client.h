@@ -0,0 +1,64 @@
+#pragma once
+
+// --------------------------------------------------------
+// The part of WRL's ComPtr the engine's headers use: owns
+// one reference to a COM object and releases it when reset
+// or destroyed.  See Windows.h in the parent directory
+// --------------------------------------------------------
+namespace Microsoft
+{
+	namespace WRL
+	{
+		template <typename T>
+		class ComPtr
+		{
+		public:
+
+			ComPtr() {}
+			ComPtr(decltype(nullptr)) {}
+			template <typename U>
+			ComPtr(U* other) : ptr(other) { AddRef(); }
+			ComPtr(const ComPtr& other) : ptr(other.ptr) { AddRef(); }
+			ComPtr(ComPtr&& other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+			~ComPtr() { Reset(); }
+
+			ComPtr& operator=(const ComPtr& other)
+			{
+				ComPtr(other).Swap(*this);
+				return *this;
+			}
+
+			ComPtr& operator=(ComPtr&& other) noexcept
+			{
+				ComPtr(static_cast<ComPtr&&>(other)).Swap(*this);
+				return *this;
+			}
+
+			T* Get() const { return ptr; }
+			T* operator->() const { return ptr; }
+			explicit operator bool() const { return ptr != nullptr; }
+
+			T* const* GetAddressOf() const { return &ptr; }
+			T** GetAddressOf() { return &ptr; }
+			T** ReleaseAndGetAddressOf() { Reset(); return &ptr; }
+			T** operator&() { return ReleaseAndGetAddressOf(); }
+			T* Detach() { T* t = ptr; ptr = nullptr; return t; }
+
+			void Reset()
+			{
+				if (ptr) {
+					T* old = ptr;
+					ptr = nullptr;
+					old->Release();
+				}
+			}
+
+		private:
+
+			void AddRef() { if (ptr) { ptr->AddRef(); } }
+			void Swap(ComPtr& other) { T* t = ptr; ptr = other.ptr; other.ptr = t; }
+
+			T* ptr = nullptr;
+		};
+	}
+}
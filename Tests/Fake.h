@@ -0,0 +1,13 @@
+#pragma once
+
+// --------------------------------------------------------
+// Stand ins for D3D objects in tests that only pass them
+// through.  Nothing is ever dereferenced, so any distinct
+// addresses will do
+// --------------------------------------------------------
+namespace FakeObjects
+{
+	inline char storage[64];
+}
+
+template <typename T> T* Fake(int index) { return reinterpret_cast<T*>(&FakeObjects::storage[index]); }
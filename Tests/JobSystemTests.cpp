@@ -0,0 +1,93 @@
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	void WaitRunsOnlyItsOwnGroup()
+	{
+		//no workers, so whatever runs, runs on a waiting thread
+		JobSystem jobs(0);
+		std::atomic<bool> release = false;
+		std::atomic<bool> otherRan = false;
+		JobSystem::Counter other = 0;
+		JobSystem::Counter own = 0;
+
+		//queued last, so it's the newest job, but if Wait picked it up
+		//it would never return
+		int ownRuns = 0;
+		for (int i = 0; i < 4; ++i) {
+			jobs.Run([&]() { ownRuns++; }, &own);
+		}
+		jobs.Run([&]() { otherRan = true; while (!release) { std::this_thread::yield(); } }, &other);
+
+		jobs.Wait(&own);
+		CHECK(ownRuns == 4);
+		CHECK(!otherRan);
+
+		release = true;
+		jobs.Wait(&other);
+		CHECK(otherRan);
+	}
+
+	void NestedGroupsStillFinish()
+	{
+		JobSystem jobs(0);
+		std::atomic<int> leaves = 0;
+		JobSystem::Counter outer = 0;
+		for (int i = 0; i < 4; ++i) {
+			jobs.Run([&]() {
+				jobs.ParallelFor(64, 8, [&](unsigned int begin, unsigned int end) { leaves += end - begin; });
+			}, &outer);
+		}
+		jobs.Wait(&outer);
+		CHECK(leaves == 4 * 64);
+	}
+
+	void OtherThreadsKeepTheirOwnJobs()
+	{
+		//the render thread waiting on its passes doesn't run the main
+		//thread's jobs, even when they're all that's queued
+		JobSystem jobs(0);
+		std::atomic<bool> release = false;
+		std::atomic<bool> mainJobRan = false;
+		std::atomic<bool> passQueued = false;
+		std::atomic<bool> mainQueued = false;
+		JobSystem::Counter mainJobs = 0;
+
+		//the main thread's job is queued after the pass, so it's the newest
+		bool renderDone = false;
+		std::thread render([&]() {
+			JobSystem::Counter passes = 0;
+			jobs.Run([&]() {}, &passes);
+			passQueued = true;
+			while (!mainQueued) {
+				std::this_thread::yield();
+			}
+			jobs.Wait(&passes);
+			renderDone = true;
+		});
+		while (!passQueued) {
+			std::this_thread::yield();
+		}
+		jobs.Run([&]() { mainJobRan = true; while (!release) { std::this_thread::yield(); } }, &mainJobs);
+		mainQueued = true;
+		render.join();
+		CHECK(renderDone);
+		CHECK(!mainJobRan);
+
+		release = true;
+		jobs.Wait(&mainJobs);
+		CHECK(mainJobRan);
+	}
+}
+
+int main()
+{
+	RUN_TEST(WaitRunsOnlyItsOwnGroup);
+	RUN_TEST(NestedGroupsStillFinish);
+	RUN_TEST(OtherThreadsKeepTheirOwnJobs);
+	return Check::Result();
+}
@@ -0,0 +1,183 @@
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include "ClipPlanes.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// LightClusters' froxel lists against brute force: points
+// sampled through every light's Range sphere are put in the
+// cluster a pixel there would read, the way the shader finds
+// it, and that cluster has to list the light
+// --------------------------------------------------------
+namespace
+{
+	struct Scene
+	{
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 projection;
+		std::vector<Light> lights;
+
+		Scene()
+		{
+			XMStoreFloat4x4(&view, XMMatrixLookAtLH(XMVectorSet(2, 3, -10, 0), XMVectorSet(0, 0, 5, 0), XMVectorSet(0, 1, 0, 0)));
+			XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 60.0f));
+
+			//a few that are awkward on purpose: around the camera, behind
+			//it, across the near plane and past the far one
+			Add(LIGHT_TYPE_POINT, XMFLOAT3(2, 3, -10), 3);
+			Add(LIGHT_TYPE_POINT, XMFLOAT3(2, 3, -16), 4);
+			Add(LIGHT_TYPE_SPOT, XMFLOAT3(2, 3, -9.5f), 1);
+			Add(LIGHT_TYPE_POINT, XMFLOAT3(0, 0, 55), 8);
+
+			//then a seeded spread, with directional lights mixed in.  Several
+			//chunks' worth, so the merge across jobs is covered
+			std::mt19937 rng(5);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::uniform_real_distribution<float> zeroOne(0.0f, 1.0f);
+			while (lights.size() < 300) {
+				int type = lights.size() % 50 == 7 ? LIGHT_TYPE_DIRECTIONAL : (lights.size() % 2 ? LIGHT_TYPE_POINT : LIGHT_TYPE_SPOT);
+				Add(type, XMFLOAT3(unit(rng) * 30, unit(rng) * 12, 25 + unit(rng) * 35), 0.5f + zeroOne(rng) * 6);
+			}
+		}
+
+		void Add(int type, XMFLOAT3 position, float range)
+		{
+			Light light;
+			std::memset(&light, 0, sizeof(Light));
+			light.Type = type;
+			light.Position = position;
+			light.Range = range;
+			light.Direction = XMFLOAT3(0, -1, 0);
+			light.ShadowTile = -1;
+			lights.push_back(light);
+		}
+	};
+
+	// The cluster a world position's pixel reads, or false off screen
+	bool ClusterOf(const Scene& scene, const ClusterGrid& grid, XMFLOAT3 world, unsigned int& cluster)
+	{
+		XMFLOAT3 viewPos;
+		XMStoreFloat3(&viewPos, XMVector3TransformCoord(XMLoadFloat3(&world), XMLoadFloat4x4(&scene.view)));
+		float depth = world.x * grid.depthPlane.x + world.y * grid.depthPlane.y + world.z * grid.depthPlane.z + grid.depthPlane.w;
+
+		float nearZ;
+		float farZ;
+		GetClipPlanes(scene.projection, nearZ, farZ);
+		float ndcX = viewPos.x * scene.projection._11 / viewPos.z;
+		float ndcY = viewPos.y * scene.projection._22 / viewPos.z;
+		if (depth < nearZ || depth > farZ || std::fabs(ndcX) > 1 || std::fabs(ndcY) > 1) {
+			return false;
+		}
+
+		unsigned int x = std::min((unsigned int)((ndcX + 1) * 0.5f * LightClusters::GRID_X), LightClusters::GRID_X - 1);
+		unsigned int y = std::min((unsigned int)((1 - ndcY) * 0.5f * LightClusters::GRID_Y), LightClusters::GRID_Y - 1);
+		unsigned int z = 0;
+		if (depth >= grid.sliceNear) {
+			z = std::min(1 + (unsigned int)(std::log(depth / grid.sliceNear) * grid.sliceScale), LightClusters::GRID_Z - 1);
+		}
+		cluster = (z * LightClusters::GRID_Y + y) * LightClusters::GRID_X + x;
+		return true;
+	}
+
+	bool Lists(const ClusterGrid& grid, unsigned int cluster, unsigned int light)
+	{
+		const ClusterGrid::Range& range = grid.ranges[cluster];
+		const unsigned int* first = grid.indices.data() + range.offset;
+		return std::binary_search(first, first + range.count, light);
+	}
+
+	void NoLightMissesAClusterItTouches()
+	{
+		Scene scene;
+		JobSystem jobs(3);
+		LightClusters clusters(&jobs);
+		ClusterGrid grid;
+		clusters.Build(scene.view, scene.projection, scene.lights.data(), (unsigned int)scene.lights.size(), grid);
+
+		//directional lights head the list, in light order
+		std::vector<unsigned int> directional;
+		for (unsigned int i = 0; i < scene.lights.size(); ++i) {
+			if (scene.lights[i].Type == LIGHT_TYPE_DIRECTIONAL)
+				directional.push_back(i);
+		}
+		CHECK(grid.directionalCount == directional.size());
+		CHECK(std::equal(directional.begin(), directional.end(), grid.indices.begin()));
+
+		//every list sorted, which Lists relies on as well
+		bool sorted = true;
+		for (const ClusterGrid::Range& range : grid.ranges) {
+			sorted &= std::is_sorted(grid.indices.begin() + range.offset, grid.indices.begin() + range.offset + range.count);
+		}
+		CHECK(sorted);
+
+		//samples all through each sphere, most of them near its surface
+		//where the froxel boxes are tightest
+		std::mt19937 rng(9);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		unsigned int onScreen = 0;
+		unsigned int missing = 0;
+		for (unsigned int i = 0; i < scene.lights.size(); ++i) {
+			const Light& light = scene.lights[i];
+			if (light.Type == LIGHT_TYPE_DIRECTIONAL)
+				continue;
+
+			for (int s = 0; s < 4000; ++s) {
+				XMFLOAT3 d(unit(rng), unit(rng), unit(rng));
+				float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+				if (length < 0.001f || length > 1)
+					continue;
+				float scale = light.Range * 0.999f * (s % 4 ? 1.0f / length : 1.0f);
+				XMFLOAT3 world(light.Position.x + d.x * scale, light.Position.y + d.y * scale, light.Position.z + d.z * scale);
+
+				unsigned int cluster;
+				if (!ClusterOf(scene, grid, world, cluster))
+					continue;
+				onScreen++;
+				if (!Lists(grid, cluster, i) && missing++ < 5) {
+					std::printf("  light %u is missing from cluster %u\n", i, cluster);
+				}
+			}
+		}
+		std::printf("  %u samples on screen, %u references\n", onScreen, clusters.GetStats().references);
+		CHECK(onScreen > 100000);
+		CHECK(missing == 0);
+	}
+
+	void SameGridOnAnyThreadCount()
+	{
+		Scene scene;
+		JobSystem serial(0);
+		JobSystem parallel(3);
+		LightClusters one(&serial);
+		LightClusters many(&parallel);
+		ClusterGrid a;
+		ClusterGrid b;
+		one.Build(scene.view, scene.projection, scene.lights.data(), (unsigned int)scene.lights.size(), a);
+		many.Build(scene.view, scene.projection, scene.lights.data(), (unsigned int)scene.lights.size(), b);
+
+		CHECK(a.indices == b.indices);
+		bool sameRanges = a.ranges.size() == b.ranges.size();
+		for (unsigned int i = 0; sameRanges && i < a.ranges.size(); ++i) {
+			sameRanges = a.ranges[i].offset == b.ranges[i].offset && a.ranges[i].count == b.ranges[i].count;
+		}
+		CHECK(sameRanges);
+		CHECK(one.GetStats().references == many.GetStats().references);
+		CHECK(one.GetStats().lightsCulled == many.GetStats().lightsCulled);
+	}
+}
+
+int main()
+{
+	RUN_TEST(NoLightMissesAClusterItTouches);
+	RUN_TEST(SameGridOnAnyThreadCount);
+	return Check::Result();
+}
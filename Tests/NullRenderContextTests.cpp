@@ -0,0 +1,90 @@
+#include "NullRenderContext.h"
+#include "StateCache.h"
+#include "Check.h"
+#include "Fake.h"
+
+#include <memory>
+
+namespace
+{
+	void CountsByType()
+	{
+		NullRenderContext context;
+		ID3D11Buffer* buffer = Fake<ID3D11Buffer>(0);
+		float color[4] = {};
+
+		context.VSSetShader(Fake<ID3D11VertexShader>(1));
+		context.PSSetShader(Fake<ID3D11PixelShader>(2));
+		context.UpdateConstantBuffer(buffer, FakeObjects::storage, 64);
+		context.UpdateBuffer(buffer, FakeObjects::storage, 16);
+		context.ClearRenderTargetView(Fake<ID3D11RenderTargetView>(3), color);
+		context.DrawIndexed(36, 0, 0);
+		context.Draw(3, 0);
+
+		const NullRenderContext::Totals& totals = context.GetTotals();
+		CHECK(totals.commands[NullRenderContext::COMMAND_SHADER] == 2);
+		CHECK(totals.commands[NullRenderContext::COMMAND_UPLOAD] == 2);
+		CHECK(totals.commands[NullRenderContext::COMMAND_CLEAR] == 1);
+		CHECK(totals.commands[NullRenderContext::COMMAND_DRAW] == 2);
+		CHECK(totals.uploadBytes == 80);
+		CHECK(totals.vertices == 39);
+
+		//nothing is kept unless asked for
+		CHECK(context.GetCommands().empty());
+
+		context.Reset();
+		CHECK(context.GetTotals().commands[NullRenderContext::COMMAND_SHADER] == 0);
+		CHECK(context.GetTotals().vertices == 0);
+	}
+
+	void KeepsEveryViewOfARange()
+	{
+		NullRenderContext context(true);
+		ID3D11ShaderResourceView* srvs[3] = {
+			Fake<ID3D11ShaderResourceView>(0),
+			Fake<ID3D11ShaderResourceView>(1),
+			Fake<ID3D11ShaderResourceView>(2) };
+
+		context.PSSetShaderResources(4, 3, srvs);
+		CHECK(context.GetTotals().commands[NullRenderContext::COMMAND_SRV] == 1);
+
+		const std::vector<NullRenderContext::Command>& commands = context.GetCommands();
+		if (CHECK(commands.size() == 3)) {
+			for (unsigned int i = 0; i < 3; i++) {
+				CHECK(commands[i].type == NullRenderContext::COMMAND_SRV);
+				CHECK(commands[i].object == srvs[i]);
+				CHECK(commands[i].value == 4 + i);
+			}
+		}
+
+		//an empty range never touches the array
+		context.Reset();
+		context.VSSetShaderResources(0, 0, nullptr);
+		CHECK(context.GetTotals().commands[NullRenderContext::COMMAND_SRV] == 1);
+		CHECK(context.GetCommands().empty());
+	}
+
+	void RecordsThroughStateCache()
+	{
+		auto context = std::make_shared<NullRenderContext>(true);
+		StateCache cache(context);
+		ID3D11ShaderResourceView* srv = Fake<ID3D11ShaderResourceView>(0);
+
+		cache.PSSetShaderResource(1, srv);
+		cache.PSSetShaderResource(1, srv);
+		cache.PSClearShaderResources();
+
+		//the bind, then every slot of the clear
+		CHECK(context->GetTotals().commands[NullRenderContext::COMMAND_SRV] == 2);
+		CHECK(context->GetCommands().size() == 1 + RenderContext::INPUT_RESOURCE_SLOTS);
+		CHECK(context->GetCommands().back().object == nullptr);
+	}
+}
+
+int main()
+{
+	RUN_TEST(CountsByType);
+	RUN_TEST(KeepsEveryViewOfARange);
+	RUN_TEST(RecordsThroughStateCache);
+	return Check::Result();
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "SceneRenderer.h"
+#include "NullRenderDevice.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// --------------------------------------------------------
+// Everything Game makes for a frame, made on a null device,
+// for tests that run whole frames: a few cubes in front of
+// the default camera and one behind it, a shadowed
+// directional light and a spot light that gets an atlas
+// tile.  Shaders only have the variables the passes set;
+// the rest of what the real ones have doesn't change what's
+// issued
+// --------------------------------------------------------
+struct NullScene
+{
+	static const unsigned int WIDTH = 1280;
+	static const unsigned int HEIGHT = 720;
+	static const unsigned int CUBE_INDICES = 36;
+
+	NullRenderDevice device;
+	JobSystem jobs{ 2 };
+	TransformPool pool;
+	EntityStore entities = EntityStore(&pool);
+	std::vector<Light> lights;
+
+	std::shared_ptr<Mesh> cube;
+	std::vector<std::shared_ptr<Material>> materials;
+	std::shared_ptr<Sky> sky;
+	std::shared_ptr<SimpleVertexShader> shadowVS;
+	std::shared_ptr<SimpleVertexShader> shadowClearVS;
+	std::shared_ptr<SimpleVertexShader> postVS;
+	std::vector<std::shared_ptr<SimplePixelShader>> postShaders;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler = NullRenderDevice::StandIn<ID3D11SamplerState>();
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> shadowClearDepthState;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSVs[ShadowCascades::CASCADE_COUNT];
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowAtlasDSV = NullRenderDevice::StandIn<ID3D11DepthStencilView>();
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> postTargets[3];
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> postInputs[3];
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBuffer = NullRenderDevice::StandIn<ID3D11RenderTargetView>();
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthBuffer = NullRenderDevice::StandIn<ID3D11DepthStencilView>();
+
+	SceneRenderer::Resources resources;
+	std::unique_ptr<SceneRenderer> renderer;
+
+	NullScene()
+	{
+		AddShaders();
+
+		Vertex vertices[8] = {};
+		for (int i = 0; i < 8; ++i) {
+			vertices[i].Position = DirectX::XMFLOAT3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+		}
+		UINT indices[CUBE_INDICES] = {
+			0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+			0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+			0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+		cube = std::make_shared<Mesh>(&device, vertices, 8, indices, (int)CUBE_INDICES);
+
+		//two materials on one pair of shaders, like the game's
+		auto vs = std::make_shared<SimpleVertexShader>(&device, L"VertexShader.cso");
+		auto ps = std::make_shared<SimplePixelShader>(&device, L"PixelShader.cso");
+		for (int i = 0; i < 2; ++i) {
+			materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), vs, ps, 1, 0.5f));
+			materials[i]->AddTextureSRV("Albedo", NullRenderDevice::StandIn<ID3D11ShaderResourceView>());
+			materials[i]->AddSampler("BasicSampler", sampler);
+		}
+
+		//no faces on disk and no read back, so no image based lighting
+		std::wstring face = L"missing.png";
+		sky = std::make_shared<Sky>(&device, cube, sampler,
+			std::make_shared<SimpleVertexShader>(&device, L"SkyVertexShader.cso"),
+			std::make_shared<SimplePixelShader>(&device, L"SkyPixelShader.cso"),
+			face.c_str(), face.c_str(), face.c_str(), face.c_str(), face.c_str(), face.c_str(),
+			std::filesystem::temp_directory_path(), &jobs);
+
+		shadowVS = std::make_shared<SimpleVertexShader>(&device, L"ShadowVertexShader.cso");
+		shadowClearVS = std::make_shared<SimpleVertexShader>(&device, L"ShadowClearVS.cso");
+		postVS = std::make_shared<SimpleVertexShader>(&device, L"FullTriVS.cso");
+		postShaders.push_back(std::make_shared<SimplePixelShader>(&device, L"GaussianBlurXPS.cso"));
+		postShaders.push_back(std::make_shared<SimplePixelShader>(&device, L"GaussianBlurYPS.cso"));
+		postShaders.push_back(std::make_shared<SimplePixelShader>(&device, L"ChromaticAbberationPS.cso"));
+		device.CreateRasterizerState(D3D11_CULL_BACK, shadowRasterizer.GetAddressOf());
+		device.CreateDepthStencilState(D3D11_COMPARISON_ALWAYS, true, shadowClearDepthState.GetAddressOf());
+		for (auto& dsv : shadowDSVs) {
+			dsv = NullRenderDevice::StandIn<ID3D11DepthStencilView>();
+		}
+		for (int i = 0; i < 3; ++i) {
+			postTargets[i] = NullRenderDevice::StandIn<ID3D11RenderTargetView>();
+			postInputs[i] = NullRenderDevice::StandIn<ID3D11ShaderResourceView>();
+		}
+
+		for (auto& m : materials) {
+			resources.materials.push_back(m.get());
+		}
+		resources.sky = sky.get();
+		resources.shadowVS = shadowVS.get();
+		resources.shadowClearVS = shadowClearVS.get();
+		resources.shadowRasterizer = shadowRasterizer.Get();
+		resources.shadowClearDepthState = shadowClearDepthState.Get();
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			resources.shadowDSVs[i] = shadowDSVs[i].Get();
+		}
+		resources.shadowAtlasDSV = shadowAtlasDSV.Get();
+		resources.postVS = postVS.get();
+		for (int i = 0; i < 3; ++i) {
+			resources.postShaders.push_back(postShaders[i].get());
+			resources.postTargets.push_back(postTargets[i].Get());
+			resources.postInputs.push_back(postInputs[i].Get());
+		}
+		resources.backBuffer = backBuffer.Get();
+		resources.depthBuffer = depthBuffer.Get();
+
+		//three cubes in view, one behind the camera
+		float positions[][3] = { { -2, 0, 8 }, { 0, 0, 10 }, { 2, 0, 8 }, { 0, 0, -10 } };
+		for (int i = 0; i < 4; ++i) {
+			EntityHandle entity = entities.Create(cube.get(), materials[i % 2].get());
+			pool.SetPosition(entities.GetTransform(entity), positions[i][0], positions[i][1], positions[i][2]);
+		}
+
+		Light sun = {};
+		sun.Type = LIGHT_TYPE_DIRECTIONAL;
+		sun.Direction = DirectX::XMFLOAT3(0.3f, -1, 0.2f);
+		sun.Color = DirectX::XMFLOAT3(1, 1, 1);
+		sun.Intensity = 1;
+		lights.push_back(sun);
+
+		Light spot = {};
+		spot.Type = LIGHT_TYPE_SPOT;
+		spot.Position = DirectX::XMFLOAT3(0, 4, 9);
+		spot.Direction = DirectX::XMFLOAT3(0, -1, 0);
+		spot.Color = DirectX::XMFLOAT3(1, 1, 1);
+		spot.Intensity = 1;
+		spot.Range = 10;
+		spot.SpotInnerAngle = 20;
+		spot.SpotOuterAngle = 30;
+		lights.push_back(spot);
+
+		renderer = std::make_unique<SceneRenderer>(&device, &jobs, 512, 1024);
+	}
+
+	// The simulation side of a frame, seen from position towards target
+	void Prepare(SceneSnapshot& frame, DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0, 2, 0), DirectX::XMFLOAT3 target = DirectX::XMFLOAT3(0, 1.9f, 1))
+	{
+		using namespace DirectX;
+
+		frame.width = WIDTH;
+		frame.height = HEIGHT;
+		frame.hasCamera = true;
+		XMStoreFloat4x4(&frame.view, XMMatrixLookAtLH(XMLoadFloat3(&position), XMLoadFloat3(&target), XMVectorSet(0, 1, 0, 0)));
+		XMStoreFloat4x4(&frame.projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, (float)WIDTH / HEIGHT, 0.1f, 100.0f));
+		frame.cameraPosition = position;
+		for (int i = 0; i < 4; ++i) {
+			frame.background[i] = 0;
+			frame.tint[i] = 1;
+		}
+
+		SceneRenderer::Settings settings = {};
+		settings.objectLights = true;
+		settings.shadowAtlas = true;
+		settings.shadowCaching = true;
+		renderer->Prepare(frame, entities, lights, 1.0f, settings);
+	}
+
+private:
+
+	static ShaderReflection::ConstantBuffer Buffer(const char* name, std::vector<const char*> variables, unsigned int variableSize)
+	{
+		ShaderReflection::ConstantBuffer buffer = { name, D3D11_CT_CBUFFER, 0, 0, {} };
+		for (const char* variable : variables) {
+			buffer.variables.push_back({ variable, buffer.size, variableSize });
+			buffer.size += variableSize;
+		}
+		return buffer;
+	}
+
+	void AddShaders()
+	{
+		ShaderReflection vs;
+		vs.constantBuffers.push_back(Buffer("ExternalData", { "worldMatrix", "worldInvTranspose", "viewMatrix", "projectionMatrix" }, 64));
+		device.AddShader(L"VertexShader.cso", vs);
+
+		ShaderReflection ps;
+		ps.constantBuffers.push_back(Buffer("ExternalData", { "uvScale", "uvOffset", "cameraPos", "roughness", "ambient", "lightCount", "objectLightCount" }, 16));
+		ps.constantBuffers.push_back(Buffer("LightData", { "lights" }, sizeof(Light) * MAX_LIGHT_COUNT));
+		ps.textures = { { "Albedo", 0 }, { "ShadowMap", 1 } };
+		ps.samplers = { { "BasicSampler", 0 }, { "ShadowSampler", 1 } };
+		device.AddShader(L"PixelShader.cso", ps);
+
+		ShaderReflection shadow;
+		shadow.constantBuffers.push_back(Buffer("ExternalData", { "world", "view", "projection" }, 64));
+		device.AddShader(L"ShadowVertexShader.cso", shadow);
+
+		ShaderReflection skyVS;
+		skyVS.constantBuffers.push_back(Buffer("ExternalData", { "viewMatrix", "projectionMatrix" }, 64));
+		device.AddShader(L"SkyVertexShader.cso", skyVS);
+
+		ShaderReflection skyPS;
+		skyPS.textures = { { "SkyMap", 0 } };
+		skyPS.samplers = { { "BasicSampler", 0 } };
+		device.AddShader(L"SkyPixelShader.cso", skyPS);
+
+		ShaderReflection post;
+		post.constantBuffers.push_back(Buffer("ExternalData", { "blurAmount", "pixelSize", "mousePos", "offsets", "mode" }, 16));
+		post.textures = { { "Pixels", 0 } };
+		post.samplers = { { "ClampSampler", 0 } };
+		device.AddShader(L"GaussianBlurXPS.cso", post);
+		device.AddShader(L"GaussianBlurYPS.cso", post);
+		device.AddShader(L"ChromaticAbberationPS.cso", post);
+	}
+};
@@ -0,0 +1,186 @@
+#include "ObjectLights.h"
+#include "JobSystem.h"
+#include "NullRenderDevice.h"
+#include "SceneSnapshot.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// ObjectLights' per-draw lists around a unit cube: the most
+// influential point and spot lights make the list, every
+// directional light does whatever its strength, and the
+// list comes out in light order either way
+// --------------------------------------------------------
+namespace
+{
+	struct Fixture
+	{
+		NullRenderDevice device;
+		JobSystem jobs{ 2 };
+		ObjectLights objectLights{ &jobs };
+		std::unique_ptr<Mesh> cube;
+
+		Fixture()
+		{
+			Vertex vertices[8] = {};
+			for (int i = 0; i < 8; ++i) {
+				vertices[i].Position = XMFLOAT3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+			}
+			UINT indices[3] = { 0, 1, 2 };
+			cube = std::make_unique<Mesh>(&device, vertices, 8, indices, 3);
+		}
+
+		DrawItem Item(float x, float y, float z)
+		{
+			DrawItem item = {};
+			XMStoreFloat4x4(&item.world, XMMatrixTranslation(x, y, z));
+			item.mesh = cube.get();
+			return item;
+		}
+	};
+
+	Light PointLight(float x, float y, float z, float range, float intensity)
+	{
+		Light light = {};
+		light.Type = LIGHT_TYPE_POINT;
+		light.Position = XMFLOAT3(x, y, z);
+		light.Color = XMFLOAT3(1, 1, 1);
+		light.Range = range;
+		light.Intensity = intensity;
+		return light;
+	}
+
+	Light DirectionalLight(float intensity)
+	{
+		Light light = {};
+		light.Type = LIGHT_TYPE_DIRECTIONAL;
+		light.Direction = XMFLOAT3(0, -1, 0);
+		light.Color = XMFLOAT3(1, 1, 1);
+		light.Intensity = intensity;
+		return light;
+	}
+
+	std::vector<unsigned int> List(const DrawItem& item)
+	{
+		return std::vector<unsigned int>(item.lightIndices, item.lightIndices + item.lightCount);
+	}
+
+	void PicksTheMostInfluential()
+	{
+		Fixture fixture;
+
+		//twelve lights just as far from the cube, brightness shuffled, so
+		//only intensity tells them apart; the dim ones are 1 to 4
+		float intensities[] = { 7, 2, 11, 5, 1, 12, 9, 4, 6, 3, 10, 8 };
+		std::vector<Light> lights;
+		for (float intensity : intensities) {
+			lights.push_back(PointLight(0, 2, 0, 10, intensity));
+		}
+		std::vector<DrawItem> items = { fixture.Item(0, 0, 0) };
+		fixture.objectLights.Build(lights.data(), (unsigned int)lights.size(), items);
+
+		std::vector<unsigned int> expected = { 0, 2, 3, 5, 6, 8, 10, 11 };
+		CHECK(List(items[0]) == expected);
+
+		const ObjectLights::Stats& stats = fixture.objectLights.GetStats();
+		CHECK(stats.draws == 1);
+		CHECK(stats.references == MAX_OBJECT_LIGHTS);
+		CHECK(stats.dropped == 12 - MAX_OBJECT_LIGHTS);
+		CHECK(stats.evaluationsSaved == 12 - MAX_OBJECT_LIGHTS);
+	}
+
+	void NearerBeatsBrighter()
+	{
+		Fixture fixture;
+
+		//the falloff is the shader's, measured from the cube's surface:
+		//a light reaching just past it counts for less than a dimmer one
+		//on top of it, and one that doesn't reach it isn't listed at all
+		std::vector<Light> lights = {
+			PointLight(0, 5, 0, 5, 4),
+			PointLight(0, 1, 0, 5, 1),
+			PointLight(0, 20, 0, 5, 100) };
+		std::vector<Light> crowd(MAX_OBJECT_LIGHTS - 1, PointLight(0, 2, 0, 10, 2));
+		lights.insert(lights.end(), crowd.begin(), crowd.end());
+		std::vector<DrawItem> items = { fixture.Item(0, 0, 0) };
+		fixture.objectLights.Build(lights.data(), (unsigned int)lights.size(), items);
+
+		std::vector<unsigned int> list = List(items[0]);
+		CHECK(list.size() == MAX_OBJECT_LIGHTS);
+		CHECK(std::find(list.begin(), list.end(), 0u) == list.end());
+		CHECK(std::find(list.begin(), list.end(), 1u) != list.end());
+		CHECK(std::find(list.begin(), list.end(), 2u) == list.end());
+		CHECK(fixture.objectLights.GetStats().dropped == 1);
+	}
+
+	void DirectionalLightsAlwaysListed()
+	{
+		Fixture fixture;
+
+		//two all but black directional lights after a full list's worth
+		//of bright point lights still make it, pushing the dimmest out
+		std::vector<Light> lights;
+		for (unsigned int i = 0; i < MAX_OBJECT_LIGHTS; ++i) {
+			lights.push_back(PointLight(0, 2, 0, 10, 10.0f + i));
+		}
+		lights.push_back(DirectionalLight(0.001f));
+		lights.push_back(DirectionalLight(0.0f));
+		std::vector<DrawItem> items = { fixture.Item(0, 0, 0) };
+		fixture.objectLights.Build(lights.data(), (unsigned int)lights.size(), items);
+
+		std::vector<unsigned int> expected = { 2, 3, 4, 5, 6, 7, 8, 9 };
+		CHECK(List(items[0]) == expected);
+
+		//and reach draws no point light does
+		items = { fixture.Item(100, 0, 0) };
+		fixture.objectLights.Build(lights.data(), (unsigned int)lights.size(), items);
+		expected = { 8, 9 };
+		CHECK(List(items[0]) == expected);
+	}
+
+	void ListsInLightOrder()
+	{
+		Fixture fixture;
+
+		//brightest last, directional in the middle: picked best first,
+		//listed in the order the full light loop would add them up
+		std::vector<Light> lights;
+		for (unsigned int i = 0; i < 6; ++i) {
+			lights.push_back(PointLight(0, 2, 0, 10, 1.0f + i));
+		}
+		lights.insert(lights.begin() + 3, DirectionalLight(1));
+
+		//enough draws for several chunks, each near its own few lights
+		std::vector<DrawItem> items;
+		for (unsigned int i = 0; i < 600; ++i) {
+			items.push_back(fixture.Item(i % 2 == 0 ? 0.0f : 100.0f, 0, 0));
+		}
+		fixture.objectLights.Build(lights.data(), (unsigned int)lights.size(), items);
+
+		std::vector<unsigned int> near = { 0, 1, 2, 3, 4, 5, 6 };
+		std::vector<unsigned int> far = { 3 };
+		bool allInOrder = true;
+		for (unsigned int i = 0; i < items.size(); ++i) {
+			std::vector<unsigned int> list = List(items[i]);
+			allInOrder = allInOrder && std::is_sorted(list.begin(), list.end()) &&
+				list == (i % 2 == 0 ? near : far);
+		}
+		CHECK(allInOrder);
+		CHECK(fixture.objectLights.GetStats().draws == 600);
+		CHECK(fixture.objectLights.GetStats().references == 300 * 7 + 300 * 1);
+	}
+}
+
+int main()
+{
+	RUN_TEST(PicksTheMostInfluential);
+	RUN_TEST(NearerBeatsBrighter);
+	RUN_TEST(DirectionalLightsAlwaysListed);
+	RUN_TEST(ListsInLightOrder);
+	return Check::Result();
+}
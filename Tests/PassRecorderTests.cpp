@@ -0,0 +1,124 @@
+#include "PassRecorder.h"
+#include "PassScheduler.h"
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Same slots as the game's frame
+	enum RenderPass
+	{
+		PASS_SHADOW,
+		PASS_OPAQUE,
+		PASS_POST,
+		PASS_COUNT
+	};
+
+	// --------------------------------------------------------
+	// Records passes side by side through a PassScheduler, the
+	// same way DeferredPassRecorder does, but with no device:
+	// it logs each body as it finishes recording and each slot
+	// as it's submitted
+	// --------------------------------------------------------
+	class LoggingPassRecorder : public PassRecorder
+	{
+	public:
+
+		LoggingPassRecorder(JobSystem* jobs) : scheduler(PASS_COUNT, jobs) {}
+
+		void Record(unsigned int pass, PassBody body) override
+		{
+			scheduler.Record(pass, [this, pass, body = std::move(body)]() {
+				body(nullptr);
+
+				std::lock_guard<std::mutex> guard(lock);
+				log.push_back("Record " + std::to_string(pass));
+			});
+		}
+
+		void Submit() override
+		{
+			scheduler.Submit([this](unsigned int pass) {
+				std::lock_guard<std::mutex> guard(lock);
+				log.push_back("Submit " + std::to_string(pass));
+			});
+		}
+
+		std::vector<std::string> TakeLog()
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return std::move(log);
+		}
+
+	private:
+
+		std::mutex lock;
+		std::vector<std::string> log;
+		PassScheduler scheduler;
+	};
+
+	void WaitFor(const std::atomic<bool>& flag)
+	{
+		while (!flag) {
+			std::this_thread::yield();
+		}
+	}
+
+	void SubmitsInSlotOrder()
+	{
+		//one thread per pass (counting the waiting one), so a body stuck
+		//waiting on a later pass can't starve it
+		JobSystem jobs(PASS_COUNT);
+		LoggingPassRecorder recorder(&jobs);
+
+		//post finishes first and shadow last, the reverse of slot order
+		std::atomic<bool> postDone = false;
+		std::atomic<bool> opaqueDone = false;
+		recorder.Record(PASS_SHADOW, [&](StateCache*) { WaitFor(opaqueDone); });
+		recorder.Record(PASS_OPAQUE, [&](StateCache*) { WaitFor(postDone); opaqueDone = true; });
+		recorder.Record(PASS_POST, [&](StateCache*) { postDone = true; });
+		recorder.Submit();
+
+		std::vector<std::string> expected = {
+			"Record 2", "Record 1", "Record 0",
+			"Submit 0", "Submit 1", "Submit 2" };
+		std::vector<std::string> log = recorder.TakeLog();
+		CHECK(log == expected);
+		for (const std::string& line : log) {
+			std::printf("  %s\n", line.c_str());
+		}
+	}
+
+	void SubmitsOnlyWhatWasRecorded()
+	{
+		JobSystem jobs(PASS_COUNT);
+		LoggingPassRecorder recorder(&jobs);
+
+		recorder.Record(PASS_POST, [](StateCache*) {});
+		recorder.Record(PASS_SHADOW, [](StateCache*) {});
+		recorder.Submit();
+		recorder.TakeLog();
+
+		//a frame without a shadow pass doesn't submit last frame's again
+		recorder.Record(PASS_OPAQUE, [](StateCache*) {});
+		recorder.Submit();
+		std::vector<std::string> expected = { "Record 1", "Submit 1" };
+		CHECK(recorder.TakeLog() == expected);
+
+		recorder.Submit();
+		CHECK(recorder.TakeLog().empty());
+	}
+}
+
+int main()
+{
+	RUN_TEST(SubmitsInSlotOrder);
+	RUN_TEST(SubmitsOnlyWhatWasRecorded);
+	return Check::Result();
+}
@@ -0,0 +1,157 @@
+#include "NullScene.h"
+#include "Check.h"
+
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// A whole frame, from Prepare to Submit, on NullRenderDevice
+// and a NullPassRecorder keeping its commands: the game's
+// shadow, opaque and post passes with no GPU (see NullScene)
+// --------------------------------------------------------
+namespace
+{
+	unsigned int CountCommands(NullPassRecorder& recorder, NullRenderContext::CommandType type, unsigned int value)
+	{
+		unsigned int count = 0;
+		for (const NullRenderContext::Command& command : recorder.GetCommands()) {
+			if (command.type == type && command.value == value) {
+				count++;
+			}
+		}
+		return count;
+	}
+
+	std::vector<const void*> Clears(NullPassRecorder& recorder)
+	{
+		std::vector<const void*> clears;
+		for (const NullRenderContext::Command& command : recorder.GetCommands()) {
+			if (command.type == NullRenderContext::COMMAND_CLEAR) {
+				clears.push_back(command.object);
+			}
+		}
+		return clears;
+	}
+
+	void PrepareCullsAndGathers()
+	{
+		NullScene scene;
+		SceneSnapshot frame;
+		scene.Prepare(frame);
+
+		CHECK(scene.renderer->GetVisibleCount() == 3);
+		CHECK(frame.opaque.size() == 3);
+		CHECK(frame.objectLights);
+		CHECK(frame.lights.size() == 2);
+		CHECK(frame.shadowSplits.w > 0);
+		CHECK(frame.shadowTiles.size() == 1);
+		CHECK(frame.lights[1].ShadowTile == 0);
+
+		//the camera can't see the one behind it, the sun can
+		unsigned int casters = 0;
+		for (const ShadowCascade& cascade : frame.cascades) {
+			casters += (unsigned int)cascade.casters.size();
+		}
+		casters += (unsigned int)frame.shadowTiles[0].casters.size();
+		CHECK(casters == scene.renderer->GetShadowCasterCount());
+		CHECK(casters > 0);
+	}
+
+	void RecordsAFullFrame()
+	{
+		NullScene scene;
+		SceneSnapshot frame;
+		scene.Prepare(frame);
+
+		NullPassRecorder recorder(true);
+		scene.renderer->Record(recorder, frame, scene.resources);
+		recorder.Submit();
+
+		//every view drawn fresh: each cascade's and the tile's casters, the
+		//tile's clear, the opaque cubes, the sky and the three post processes
+		unsigned int shadowDraws = 0;
+		for (const ShadowCascade& cascade : frame.cascades) {
+			shadowDraws += (unsigned int)cascade.casters.size();
+		}
+		shadowDraws += (unsigned int)frame.shadowTiles[0].casters.size();
+		unsigned int draws = shadowDraws + 1 + 3 + 1 + 3;
+		StateCache::Stats stats = {};
+		recorder.AddStats(stats);
+		const NullRenderContext::Totals& totals = recorder.GetTotals();
+		std::printf("  %u draws, %u shader binds issued, %u skipped\n", stats.draws,
+			stats.issued[StateCache::CATEGORY_SHADER], stats.skipped[StateCache::CATEGORY_SHADER]);
+		CHECK(stats.draws == draws);
+		CHECK(totals.commands[NullRenderContext::COMMAND_DRAW] == draws);
+		CHECK(CountCommands(recorder, NullRenderContext::COMMAND_DRAW, NullScene::CUBE_INDICES) == shadowDraws + 3 + 1);
+		CHECK(CountCommands(recorder, NullRenderContext::COMMAND_DRAW, 3) == 1 + 3);
+		CHECK(scene.renderer->GetShadowCacheStats().redrawn == ShadowCascades::CASCADE_COUNT + 1);
+
+		//the passes in order: shadow cascades, opaque, post
+		std::vector<const void*> expected;
+		for (auto& dsv : scene.shadowDSVs) {
+			expected.push_back(dsv.Get());
+		}
+		expected.push_back(scene.postTargets[0].Get());
+		expected.push_back(scene.depthBuffer.Get());
+		expected.push_back(scene.backBuffer.Get());
+		expected.push_back(scene.postTargets[1].Get());
+		expected.push_back(scene.postTargets[2].Get());
+		CHECK(Clears(recorder) == expected);
+		CHECK(recorder.GetCommands().back().type == NullRenderContext::COMMAND_DRAW);
+
+		//only what changed reaches the context; the two materials share
+		//their shaders, so the second one's binds are all skipped
+		CHECK(totals.commands[NullRenderContext::COMMAND_SHADER] == stats.issued[StateCache::CATEGORY_SHADER]);
+		CHECK(stats.skipped[StateCache::CATEGORY_SHADER] > 0);
+		CHECK(stats.skipped[StateCache::CATEGORY_CBUFFER] > 0);
+		CHECK(stats.uploads > 0);
+	}
+
+	void ReusesCachedShadowViews()
+	{
+		NullScene scene;
+		NullPassRecorder recorder(true);
+		SceneSnapshot frames[2];
+		for (SceneSnapshot& frame : frames) {
+			//a simulation tick in between, as Game's Update has
+			scene.pool.BeginTick();
+			scene.Prepare(frame);
+			scene.renderer->Record(recorder, frame, scene.resources);
+			recorder.Submit();
+		}
+
+		//nothing moved, so no view is drawn again and no cascade cleared
+		CHECK(scene.renderer->GetShadowCacheStats().redrawn == 0);
+		CHECK(scene.renderer->GetShadowCacheStats().reused == ShadowCascades::CASCADE_COUNT + 1);
+		StateCache::Stats stats = {};
+		recorder.AddStats(stats);
+		CHECK(stats.draws == 3 + 1 + 3);
+		std::vector<const void*> expected = { scene.postTargets[0].Get(), scene.depthBuffer.Get(),
+			scene.backBuffer.Get(), scene.postTargets[1].Get(), scene.postTargets[2].Get() };
+		CHECK(Clears(recorder) == expected);
+	}
+
+	void ReleasesEverything()
+	{
+		{
+			NullScene scene;
+			SceneSnapshot frame;
+			scene.Prepare(frame);
+			NullPassRecorder recorder;
+			scene.renderer->Record(recorder, frame, scene.resources);
+			recorder.Submit();
+			CHECK(NullRenderDevice::LiveObjects() > 0);
+		}
+		CHECK(NullRenderDevice::LiveObjects() == 0);
+	}
+}
+
+int main()
+{
+	RUN_TEST(PrepareCullsAndGathers);
+	RUN_TEST(RecordsAFullFrame);
+	RUN_TEST(ReusesCachedShadowViews);
+	RUN_TEST(ReleasesEverything);
+	return Check::Result();
+}
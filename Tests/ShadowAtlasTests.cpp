@@ -0,0 +1,178 @@
+#include "ShadowAtlas.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// ShadowAtlas::Allocate on lights set out in front of a
+// fixed camera, further away meaning less important: tiles
+// have to stay apart and inside the atlas, shrink before
+// anything is dropped, and past MAX_TILES the least
+// important lights go first
+// --------------------------------------------------------
+namespace
+{
+	struct Scene
+	{
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 projection;
+		std::vector<Light> lights;
+
+		Scene()
+		{
+			XMStoreFloat4x4(&view, XMMatrixIdentity());
+			XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 300.0f));
+		}
+
+		void Add(int type, float z, float range)
+		{
+			Light light;
+			std::memset(&light, 0, sizeof(Light));
+			light.Type = type;
+			light.Position = XMFLOAT3(0, 0, z);
+			light.Direction = XMFLOAT3(0.3f, -1, 0.2f);
+			light.Range = range;
+			light.SpotOuterAngle = 0.5f;
+			lights.push_back(light);
+		}
+
+		void Allocate(ShadowAtlas& atlas)
+		{
+			atlas.Allocate(view, projection, lights, 100, 200);
+		}
+	};
+
+	// Every tile inside the atlas, none overlapping, and each shadowed
+	// light's ShadowTile pointing at its own run of faces
+	bool TilesAreValid(ShadowAtlas& atlas, const std::vector<Light>& lights)
+	{
+		const std::vector<ShadowAtlas::Tile>& tiles = atlas.GetTiles();
+		bool valid = tiles.size() <= ShadowAtlas::MAX_TILES;
+		for (unsigned int i = 0; i < tiles.size(); ++i) {
+			const ShadowAtlas::Tile& a = tiles[i];
+			valid &= a.size >= ShadowAtlas::MIN_TILE && a.x + a.size <= atlas.GetSize() && a.y + a.size <= atlas.GetSize();
+			for (unsigned int j = i + 1; j < tiles.size(); ++j) {
+				const ShadowAtlas::Tile& b = tiles[j];
+				if (a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size) {
+					std::printf("  tiles %u and %u overlap\n", i, j);
+					valid = false;
+				}
+			}
+		}
+
+		unsigned int covered = 0;
+		for (unsigned int i = 0; i < lights.size(); ++i) {
+			if (lights[i].ShadowTile < 0)
+				continue;
+			unsigned int faces = lights[i].Type == LIGHT_TYPE_POINT ? 6 : 1;
+			for (unsigned int face = 0; face < faces; ++face) {
+				unsigned int tile = lights[i].ShadowTile + face;
+				valid &= tile < tiles.size() && tiles[tile].light == i;
+			}
+			covered += faces;
+		}
+		return valid && covered == tiles.size();
+	}
+
+	void TilesDontOverlap()
+	{
+		//a mix of everything, in a few atlas sizes
+		Scene scene;
+		scene.Add(LIGHT_TYPE_DIRECTIONAL, 0, 0);
+		scene.Add(LIGHT_TYPE_DIRECTIONAL, 0, 0);
+		for (int i = 0; i < 12; ++i) {
+			scene.Add(i % 3 ? LIGHT_TYPE_SPOT : LIGHT_TYPE_POINT, 4.0f + i * 3, 2.0f + i % 4);
+		}
+
+		for (unsigned int size : { 2048u, 4096u, 8192u }) {
+			ShadowAtlas atlas(size);
+			scene.Allocate(atlas);
+			CHECK(!atlas.GetTiles().empty());
+			CHECK(TilesAreValid(atlas, scene.lights));
+
+			//the first directional light has the cascades, the second a tile
+			CHECK(scene.lights[0].ShadowTile == -1);
+			CHECK(scene.lights[1].ShadowTile >= 0);
+		}
+	}
+
+	void TilesShrinkBeforeLightsAreDropped()
+	{
+		//spot lights only, each fading in importance from the last
+		Scene scene;
+		for (int i = 0; i < 8; ++i) {
+			scene.Add(LIGHT_TYPE_SPOT, 10.0f + i * 2, 4);
+		}
+
+		ShadowAtlas roomy(8192);
+		ShadowAtlas tight(2048);
+		scene.Allocate(roomy);
+		std::vector<Light> roomyLights = scene.lights;
+		scene.Allocate(tight);
+		CHECK(TilesAreValid(roomy, roomyLights));
+		CHECK(TilesAreValid(tight, scene.lights));
+
+		//the wanted sizes don't fit...
+		unsigned int wanted = 0;
+		for (const ShadowAtlas::Tile& tile : roomy.GetTiles()) {
+			wanted += tile.size * tile.size;
+		}
+		CHECK(wanted > 2048 * 2048);
+
+		//...so every light keeps a shadow, just a smaller one, and the
+		//least important gave up the most
+		CHECK(tight.GetStats().dropped == 0);
+		CHECK(tight.GetStats().shadowed == 8);
+		const std::vector<ShadowAtlas::Tile>& before = roomy.GetTiles();
+		const std::vector<ShadowAtlas::Tile>& after = tight.GetTiles();
+		if (CHECK(before.size() == 8 && after.size() == 8)) {
+			for (unsigned int i = 0; i < 8; ++i) {
+				CHECK(after[i].light == before[i].light);
+				CHECK(after[i].size <= before[i].size);
+				if (i > 0) {
+					CHECK(after[i].size <= after[i - 1].size);
+				}
+			}
+			CHECK(after.back().size < before.back().size);
+		}
+	}
+
+	void LeastImportantDroppedPastMaxTiles()
+	{
+		//seven point lights want 42 tiles, and two spots behind them one each
+		Scene scene;
+		scene.Add(LIGHT_TYPE_DIRECTIONAL, 0, 0);
+		for (int i = 0; i < 7; ++i) {
+			scene.Add(LIGHT_TYPE_POINT, 10.0f + i * 3, 3);
+		}
+		scene.Add(LIGHT_TYPE_SPOT, 40, 3);
+		scene.Add(LIGHT_TYPE_SPOT, 45, 3);
+
+		//room for every tile, only the count is short
+		ShadowAtlas atlas(8192);
+		scene.Allocate(atlas);
+		CHECK(TilesAreValid(atlas, scene.lights));
+		CHECK(atlas.GetTiles().size() <= ShadowAtlas::MAX_TILES);
+
+		//the five nearest point lights, and then nothing less important
+		//jumps the queue, even if it would fit
+		for (unsigned int i = 1; i < scene.lights.size(); ++i) {
+			CHECK((scene.lights[i].ShadowTile >= 0) == (i <= 5));
+		}
+		CHECK(atlas.GetStats().candidates == 9);
+		CHECK(atlas.GetStats().shadowed == 5);
+		CHECK(atlas.GetStats().dropped == 4);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TilesDontOverlap);
+	RUN_TEST(TilesShrinkBeforeLightsAreDropped);
+	RUN_TEST(LeastImportantDroppedPastMaxTiles);
+	return Check::Result();
+}
@@ -0,0 +1,185 @@
+#include "ShadowCache.h"
+#include "EntityStore.h"
+#include "TransformPool.h"
+#include "Check.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// ShadowCache's version tracking against a real EntityStore,
+// stepped tick by tick the way Game drives it: BeginTick,
+// then whatever moves, then the simulation side Tracks and
+// the render side asks NeedsRedraw
+// --------------------------------------------------------
+namespace
+{
+	struct Fixture
+	{
+		TransformPool pool;
+		EntityStore store = EntityStore(&pool);
+		ShadowCache cache;
+		std::vector<EntityHandle> entities;
+		std::vector<unsigned int> casters;
+		XMFLOAT4X4 viewProjection;
+
+		Fixture()
+		{
+			//meshless entities are fine, nothing here draws
+			for (int i = 0; i < 4; ++i) {
+				entities.push_back(store.Create(nullptr, nullptr));
+			}
+			casters = { 0, 1, 2 };
+			XMStoreFloat4x4(&viewProjection, XMMatrixOrthographicLH(20, 20, 0, 50));
+		}
+
+		unsigned long long Track(unsigned int view, unsigned int x = 0, unsigned int y = 0, unsigned int size = 0)
+		{
+			return cache.Track(view, viewProjection, x, y, size, casters, store.GetChangeTick(casters), pool.GetTick());
+		}
+
+		// One frame of a single view, tracked and drawn at once
+		bool Frame(unsigned int view, unsigned int x = 0, unsigned int y = 0, unsigned int size = 0)
+		{
+			return cache.NeedsRedraw(view, Track(view, x, y, size), x, y, size, (unsigned int)casters.size());
+		}
+	};
+
+	void StillSceneReusesViews()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		CHECK(f.Frame(0));
+		for (int i = 0; i < 3; ++i) {
+			f.pool.BeginTick();
+			f.cache.ResetStats();
+			CHECK(!f.Frame(0));
+		}
+		CHECK(f.cache.GetStats().reused == 1);
+		CHECK(f.cache.GetStats().castersSkipped == 3);
+		CHECK(f.cache.GetStats().totalRedrawn == 1);
+		CHECK(f.cache.GetStats().totalReused == 3);
+	}
+
+	void MovedCasterRedraws()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		f.Frame(0);
+
+		f.pool.BeginTick();
+		f.pool.SetPosition(f.store.GetTransform(f.entities[1]), 0, 1, 0);
+		CHECK(f.Frame(0));
+
+		//it's drawn interpolated for the tick it moved in, so the next one
+		//redraws too, and only then does the view settle
+		f.pool.BeginTick();
+		CHECK(f.Frame(0));
+		f.pool.BeginTick();
+		CHECK(!f.Frame(0));
+
+		//an entity that isn't a caster can move all it likes
+		f.pool.BeginTick();
+		f.pool.SetPosition(f.store.GetTransform(f.entities[3]), 0, 1, 0);
+		CHECK(!f.Frame(0));
+	}
+
+	void SwapRemovedCasterRedraws()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		f.Frame(0);
+
+		//destroying slot 1 moves the last entity into it, so the caster list
+		//reads the same but slot 1 now holds something else
+		f.pool.BeginTick();
+		f.store.Destroy(f.entities[1]);
+		f.casters = { 0, 1, 2 };
+		CHECK(f.Frame(0));
+	}
+
+	void ChangeInTheSameTickRedraws()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		unsigned long long before = f.Track(0);
+
+		//a caster moving after the view was tracked, still in the same tick
+		f.pool.SetPosition(f.store.GetTransform(f.entities[0]), 1, 0, 0);
+		unsigned long long after = f.Track(0);
+		CHECK(after != before);
+		CHECK(f.cache.NeedsRedraw(0, after, 0, 0, 0, 3));
+	}
+
+	void ViewProjectionComparedBitForBit()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		unsigned long long version = f.Track(0);
+
+		//recomputed the same way, so the same bits
+		XMStoreFloat4x4(&f.viewProjection, XMMatrixOrthographicLH(20, 20, 0, 50));
+		f.pool.BeginTick();
+		CHECK(f.Track(0) == version);
+
+		//one ulp off anywhere is a different view
+		f.viewProjection._41 = std::nextafter(f.viewProjection._41, 1.0f);
+		f.pool.BeginTick();
+		CHECK(f.Track(0) != version);
+	}
+
+	void NewTileInvalidatesTilesUnderIt()
+	{
+		Fixture f;
+		unsigned int a = ShadowCache::TileView(0);
+		unsigned int b = ShadowCache::TileView(1);
+		unsigned int c = ShadowCache::TileView(2);
+
+		f.pool.BeginTick();
+		CHECK(f.Frame(a, 0, 0, 512));
+		CHECK(f.Frame(c, 1024, 0, 256));
+		CHECK(f.Frame(0));
+
+		//b takes over half of a's rect; a's version and rect didn't change,
+		//but what's in the atlas there did
+		f.pool.BeginTick();
+		CHECK(f.Frame(b, 256, 256, 512));
+		CHECK(f.Frame(a, 0, 0, 512));
+		CHECK(!f.Frame(c, 1024, 0, 256));
+		CHECK(!f.Frame(0));
+
+		//and redrawing a wiped b in turn
+		f.pool.BeginTick();
+		CHECK(f.Frame(b, 256, 256, 512));
+
+		//the same view moving to another rect is a redraw too
+		f.pool.BeginTick();
+		CHECK(f.Frame(c, 1024, 256, 256));
+	}
+
+	void InvalidateForgetsEverything()
+	{
+		Fixture f;
+		f.pool.BeginTick();
+		f.Frame(0);
+		f.Frame(ShadowCache::TileView(0), 0, 0, 256);
+
+		f.cache.Invalidate();
+		f.pool.BeginTick();
+		CHECK(f.Frame(0));
+		CHECK(f.Frame(ShadowCache::TileView(0), 0, 0, 256));
+	}
+}
+
+int main()
+{
+	RUN_TEST(StillSceneReusesViews);
+	RUN_TEST(MovedCasterRedraws);
+	RUN_TEST(SwapRemovedCasterRedraws);
+	RUN_TEST(ChangeInTheSameTickRedraws);
+	RUN_TEST(ViewProjectionComparedBitForBit);
+	RUN_TEST(NewTileInvalidatesTilesUnderIt);
+	RUN_TEST(InvalidateForgetsEverything);
+	return Check::Result();
+}
@@ -0,0 +1,144 @@
+#include "ShadowCascades.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// ShadowCascades::Fit against the camera it's fitted to:
+// every slice of the view frustum has to land inside its
+// cascade, and moving the camera less than a texel must not
+// move the shadow map's texel grid in the world
+// --------------------------------------------------------
+namespace
+{
+	const unsigned int RESOLUTION = 2048;
+
+	struct Camera
+	{
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 projection;
+
+		Camera(XMFLOAT3 position, XMFLOAT3 direction)
+		{
+			XMStoreFloat4x4(&view, XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&direction), XMVectorSet(0, 1, 0, 0)));
+			XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 300.0f));
+		}
+	};
+
+	// Where a world position lands in a cascade, in texels across and
+	// 0 to 1 deep
+	XMFLOAT3 ToShadowMap(const ShadowCascades::Cascade& cascade, XMVECTOR world)
+	{
+		XMFLOAT3 ndc;
+		XMStoreFloat3(&ndc, XMVector3TransformCoord(world, XMLoadFloat4x4(&cascade.viewProjection)));
+		return XMFLOAT3((ndc.x + 1) * 0.5f * RESOLUTION, (1 - ndc.y) * 0.5f * RESOLUTION, ndc.z);
+	}
+
+	// How far a value is from the nearest whole number
+	float OffGrid(float value)
+	{
+		return std::fabs(value - std::round(value));
+	}
+
+	void SlicesFitInTheirCascades()
+	{
+		const XMFLOAT3 lightDirections[] = { XMFLOAT3(0.3f, 1, 0.2f), XMFLOAT3(-1, 0.4f, 0.5f), XMFLOAT3(0, 1, 0) };
+		const Camera cameras[] = {
+			Camera(XMFLOAT3(0, 2, -10), XMFLOAT3(0, 0, 1)),
+			Camera(XMFLOAT3(40, 15, 3), XMFLOAT3(-1, -0.5f, 0.3f)),
+			Camera(XMFLOAT3(-5, 30, 7), XMFLOAT3(0.1f, -1, 0.05f)),
+		};
+
+		unsigned int outside = 0;
+		for (const XMFLOAT3& lightDirection : lightDirections) {
+			for (const Camera& camera : cameras) {
+				ShadowCascades cascades;
+				cascades.Fit(camera.view, camera.projection, lightDirection, RESOLUTION);
+				XMMATRIX cameraWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&camera.view));
+
+				//the slices run back to back from the near plane to the shadow distance
+				CHECK(std::fabs(cascades.GetCascade(0).splitNear - 0.1f) < 1e-4f);
+				CHECK(cascades.GetCascade(ShadowCascades::CASCADE_COUNT - 1).splitFar == cascades.GetShadowDistance());
+
+				for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+					const ShadowCascades::Cascade& cascade = cascades.GetCascade(i);
+					if (i > 0) {
+						CHECK(cascade.splitNear == cascades.GetCascade(i - 1).splitFar);
+					}
+					CHECK(cascade.splitFar > cascade.splitNear);
+
+					for (int corner = 0; corner < 8; ++corner) {
+						float d = (corner & 4) ? cascade.splitFar : cascade.splitNear;
+						float sx = (corner & 1) ? 1.0f : -1.0f;
+						float sy = (corner & 2) ? 1.0f : -1.0f;
+						XMVECTOR viewCorner = XMVectorSet(sx * d / camera.projection._11, sy * d / camera.projection._22, d, 1);
+						XMFLOAT3 texel = ToShadowMap(cascade, XMVector3TransformCoord(viewCorner, cameraWorld));
+
+						//the depth range is fitted to the corners exactly, so allow rounding
+						bool inside = texel.x >= 0 && texel.x <= RESOLUTION && texel.y >= 0 && texel.y <= RESOLUTION &&
+							texel.z >= -1e-4f && texel.z <= 1 + 1e-4f;
+						if (!inside && outside++ < 5) {
+							std::printf("  cascade %u corner %d at (%g, %g, %g)\n", i, corner, texel.x, texel.y, texel.z);
+						}
+					}
+				}
+			}
+		}
+		CHECK(outside == 0);
+	}
+
+	void SnappingHoldsTheTexelGrid()
+	{
+		XMFLOAT3 lightDirection(0.3f, 1, 0.2f);
+		XMFLOAT3 direction(0.2f, -0.3f, 1);
+		Camera start(XMFLOAT3(3, 5, -10), direction);
+		ShadowCascades reference;
+		reference.Fit(start.view, start.projection, lightDirection, RESOLUTION);
+
+		//a fixed point in each cascade, near the middle of its slice
+		XMVECTOR probes[ShadowCascades::CASCADE_COUNT];
+		XMFLOAT3 startTexels[ShadowCascades::CASCADE_COUNT];
+		XMMATRIX startWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&start.view));
+		for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+			const ShadowCascades::Cascade& cascade = reference.GetCascade(i);
+			probes[i] = XMVector3TransformCoord(XMVectorSet(0.3f, 0.1f, (cascade.splitNear + cascade.splitFar) * 0.5f, 1), startWorld);
+			startTexels[i] = ToShadowMap(cascade, probes[i]);
+		}
+
+		//slide the camera a tenth of the first cascade's texel at a time,
+		//for a few texels, without turning it
+		float step = reference.GetCascade(0).texelSize * 0.1f;
+		unsigned int snaps = 0;
+		float worstDrift = 0;
+		for (int s = 1; s <= 40; ++s) {
+			Camera moved(XMFLOAT3(3 + s * step, 5 + s * step * 0.5f, -10 - s * step * 0.3f), direction);
+			ShadowCascades cascades;
+			cascades.Fit(moved.view, moved.projection, lightDirection, RESOLUTION);
+
+			for (unsigned int i = 0; i < ShadowCascades::CASCADE_COUNT; ++i) {
+				const ShadowCascades::Cascade& cascade = cascades.GetCascade(i);
+				CHECK(cascade.texelSize == reference.GetCascade(i).texelSize);
+
+				//the probe may only ever shift by whole texels
+				XMFLOAT3 texel = ToShadowMap(cascade, probes[i]);
+				float driftX = OffGrid(texel.x - startTexels[i].x);
+				float driftY = OffGrid(texel.y - startTexels[i].y);
+				worstDrift = std::fmax(worstDrift, std::fmax(driftX, driftY));
+				snaps += i == 0 && std::fabs(texel.x - startTexels[i].x) > 0.5f;
+			}
+		}
+		std::printf("  worst drift %.4f texels, first cascade snapped %u times\n", worstDrift, snaps);
+		CHECK(worstDrift < 0.01f);
+		CHECK(snaps > 0);
+	}
+}
+
+int main()
+{
+	RUN_TEST(SlicesFitInTheirCascades);
+	RUN_TEST(SnappingHoldsTheTexelGrid);
+	return Check::Result();
+}
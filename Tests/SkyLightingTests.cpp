@@ -0,0 +1,207 @@
+#include "SkyLighting.h"
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// SkyLighting on small generated skies: a constant sky has
+// to light every direction the same, and the cache file has
+// to give back exactly what was built, but only for the key
+// it was saved under
+// --------------------------------------------------------
+namespace
+{
+	const unsigned int FACE_SIZE = 16;
+
+	// Six faces of 8 bit pixels, filled in by whoever makes them
+	struct Sky
+	{
+		std::vector<unsigned char> pixels[6];
+		SkyLighting::FaceImage faces[6];
+
+		Sky()
+		{
+			for (unsigned int face = 0; face < 6; ++face) {
+				pixels[face].resize(FACE_SIZE * FACE_SIZE * 4);
+				faces[face] = SkyLighting::FaceImage{ pixels[face].data(), FACE_SIZE * 4 };
+			}
+		}
+
+		void Set(unsigned int face, unsigned int x, unsigned int y, unsigned char r, unsigned char g, unsigned char b)
+		{
+			unsigned char* pixel = &pixels[face][(y * FACE_SIZE + x) * 4];
+			pixel[0] = r;
+			pixel[1] = g;
+			pixel[2] = b;
+			pixel[3] = 255;
+		}
+	};
+
+	// Irradiance from the harmonics toward a normal, the way the shader
+	// evaluates them
+	XMFLOAT3 Irradiance(const XMFLOAT4* sh, XMFLOAT3 n)
+	{
+		float basis[9] = {
+			0.282095f,
+			0.488603f * n.y,
+			0.488603f * n.z,
+			0.488603f * n.x,
+			1.092548f * n.x * n.y,
+			1.092548f * n.y * n.z,
+			0.315392f * (3 * n.z * n.z - 1),
+			1.092548f * n.x * n.z,
+			0.546274f * (n.x * n.x - n.y * n.y) };
+		XMFLOAT3 result(0, 0, 0);
+		for (unsigned int i = 0; i < 9; ++i) {
+			result.x += sh[i].x * basis[i];
+			result.y += sh[i].y * basis[i];
+			result.z += sh[i].z * basis[i];
+		}
+		return result;
+	}
+
+	bool Near(float a, float b, float tolerance)
+	{
+		return std::fabs(a - b) <= tolerance * std::fmax(std::fabs(b), 1e-3f);
+	}
+
+	void ConstantSkyGivesConstantIrradiance()
+	{
+		//given as BGRA, so the channel swap is covered too
+		Sky sky;
+		for (unsigned int face = 0; face < 6; ++face) {
+			for (unsigned int i = 0; i < FACE_SIZE * FACE_SIZE; ++i) {
+				sky.Set(face, i % FACE_SIZE, i / FACE_SIZE, 200, 128, 40);
+			}
+		}
+		JobSystem jobs(2);
+		SkyLighting lighting(&jobs);
+		lighting.Build(sky.faces, FACE_SIZE, true);
+
+		XMFLOAT3 expected(std::pow(40 / 255.0f, 2.2f), std::pow(128 / 255.0f, 2.2f), std::pow(200 / 255.0f, 2.2f));
+		const XMFLOAT4* sh = lighting.GetIrradiance();
+
+		//nothing past the constant band
+		float largest = 0;
+		for (unsigned int i = 1; i < 9; ++i) {
+			largest = std::fmax(largest, std::fmax(std::fabs(sh[i].x), std::fmax(std::fabs(sh[i].y), std::fabs(sh[i].z))));
+		}
+		std::printf("  band 0 %g %g %g, largest other %g\n", sh[0].x, sh[0].y, sh[0].z, largest);
+		CHECK(largest < 1e-4f * sh[0].z);
+
+		//and the same light from every side, equal to the sky's own radiance
+		const XMFLOAT3 normals[] = { XMFLOAT3(1, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0.577f, 0.577f, -0.577f), XMFLOAT3(-0.6f, 0.8f, 0) };
+		for (const XMFLOAT3& n : normals) {
+			XMFLOAT3 e = Irradiance(sh, n);
+			CHECK(Near(e.x, expected.x, 1e-3f) && Near(e.y, expected.y, 1e-3f) && Near(e.z, expected.z, 1e-3f));
+		}
+
+		//every prefiltered texel is the sky's color too
+		bool flat = true;
+		for (const SkyLighting::Cubemap& mip : lighting.GetSpecular()) {
+			for (const std::vector<XMFLOAT4>& face : mip.faces) {
+				for (const XMFLOAT4& texel : face) {
+					flat &= Near(texel.x, expected.x, 1e-3f) && Near(texel.y, expected.y, 1e-3f) && Near(texel.z, expected.z, 1e-3f);
+				}
+			}
+		}
+		CHECK(lighting.GetSpecular().size() == SkyLighting::SPECULAR_MIPS);
+		CHECK(flat);
+	}
+
+	// A sky with something in it, so a cache mixup would show
+	void MakeGradient(Sky& sky)
+	{
+		for (unsigned int face = 0; face < 6; ++face) {
+			for (unsigned int y = 0; y < FACE_SIZE; ++y) {
+				for (unsigned int x = 0; x < FACE_SIZE; ++x) {
+					sky.Set(face, x, y, (unsigned char)(face * 40), (unsigned char)(x * 16), (unsigned char)(255 - y * 16));
+				}
+			}
+		}
+	}
+
+	bool SameResults(SkyLighting& a, SkyLighting& b)
+	{
+		bool same = std::memcmp(a.GetIrradiance(), b.GetIrradiance(), sizeof(XMFLOAT4) * 9) == 0;
+		same &= a.GetSpecular().size() == b.GetSpecular().size();
+		for (unsigned int level = 0; same && level < a.GetSpecular().size(); ++level) {
+			same &= a.GetSpecular()[level].size == b.GetSpecular()[level].size;
+			for (unsigned int face = 0; face < 6; ++face) {
+				same &= a.GetSpecular()[level].faces[face].size() == b.GetSpecular()[level].faces[face].size() &&
+					std::memcmp(a.GetSpecular()[level].faces[face].data(), b.GetSpecular()[level].faces[face].data(), sizeof(XMFLOAT4) * a.GetSpecular()[level].faces[face].size()) == 0;
+			}
+		}
+		return same && a.GetBrdfLut().size() == b.GetBrdfLut().size() &&
+			std::memcmp(a.GetBrdfLut().data(), b.GetBrdfLut().data(), sizeof(XMFLOAT2) * a.GetBrdfLut().size()) == 0;
+	}
+
+	// Face files on disk for CacheKey, each holding some bytes
+	void WriteFaceFiles(const std::wstring paths[6], unsigned int bytes)
+	{
+		for (unsigned int i = 0; i < 6; ++i) {
+			std::ofstream file(std::filesystem::path(paths[i]), std::ios::binary);
+			std::vector<char> contents(bytes + i, 'x');
+			file.write(contents.data(), contents.size());
+		}
+	}
+
+	void CacheRoundTripsForItsKeyOnly()
+	{
+		std::filesystem::path folder = std::filesystem::temp_directory_path() / "SkyLightingTests";
+		std::filesystem::create_directories(folder);
+		std::filesystem::path cache = folder / "sky.cache";
+		std::wstring facePaths[6];
+		for (unsigned int i = 0; i < 6; ++i) {
+			facePaths[i] = (folder / ("face" + std::to_string(i) + ".png")).wstring();
+		}
+		WriteFaceFiles(facePaths, 100);
+		unsigned long long key = SkyLighting::CacheKey(facePaths);
+		CHECK(SkyLighting::CacheKey(facePaths) == key);
+
+		Sky sky;
+		MakeGradient(sky);
+		JobSystem jobs(2);
+		SkyLighting built(&jobs);
+		built.Build(sky.faces, FACE_SIZE, false);
+		CHECK(!built.GetStats().fromCache);
+		CHECK(built.Save(cache, key));
+
+		SkyLighting loaded(&jobs);
+		CHECK(loaded.Load(cache, key));
+		CHECK(loaded.GetStats().fromCache);
+		CHECK(SameResults(built, loaded));
+
+		//a face file changing makes a new key, and the old file is refused
+		//without touching what's already there
+		WriteFaceFiles(facePaths, 200);
+		unsigned long long changedKey = SkyLighting::CacheKey(facePaths);
+		CHECK(changedKey != key);
+		SkyLighting stale(&jobs);
+		CHECK(!stale.Load(cache, changedKey));
+		CHECK(stale.GetSpecular().empty() && stale.GetBrdfLut().empty());
+		CHECK(!stale.GetStats().fromCache);
+
+		//as is one cut short
+		std::filesystem::resize_file(cache, std::filesystem::file_size(cache) - 4);
+		CHECK(!stale.Load(cache, key));
+		CHECK(stale.GetSpecular().empty());
+
+		std::filesystem::remove_all(folder);
+	}
+}
+
+int main()
+{
+	RUN_TEST(ConstantSkyGivesConstantIrradiance);
+	RUN_TEST(CacheRoundTripsForItsKeyOnly);
+	return Check::Result();
+}
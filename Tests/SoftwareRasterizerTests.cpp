@@ -0,0 +1,194 @@
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Renders a fixed scene with the SoftwareRasterizer and
+// compares it with a checked in golden image, the same way
+// "-benchmark <scene> -software -golden <path>" checks the
+// game's last frame.  Takes the same arguments:
+//  "-golden <path>" the reference PPM (required)
+//  "-tolerance <n>" how far a channel may be off (default 2)
+//  "-image <path>" also writes the frame, e.g. to update the
+//   reference after an intended change
+// --------------------------------------------------------
+namespace
+{
+	std::string goldenImage;
+	std::string outputImage;
+	int goldenTolerance = 2;
+
+	// A unit cube, flat shaded, with its faces wound like the game's meshes
+	struct Cube
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+
+		Cube()
+		{
+			AddFace(XMFLOAT3(0, 0, -1), XMFLOAT3(1, 0, 0), XMFLOAT3(0, 1, 0));
+			AddFace(XMFLOAT3(0, 0, 1), XMFLOAT3(-1, 0, 0), XMFLOAT3(0, 1, 0));
+			AddFace(XMFLOAT3(1, 0, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0, 1, 0));
+			AddFace(XMFLOAT3(-1, 0, 0), XMFLOAT3(0, 0, -1), XMFLOAT3(0, 1, 0));
+			AddFace(XMFLOAT3(0, 1, 0), XMFLOAT3(1, 0, 0), XMFLOAT3(0, 0, 1));
+			AddFace(XMFLOAT3(0, -1, 0), XMFLOAT3(1, 0, 0), XMFLOAT3(0, 0, -1));
+		}
+
+		//corners at normal +- u +- v, half a unit out
+		void AddFace(XMFLOAT3 normal, XMFLOAT3 u, XMFLOAT3 v)
+		{
+			static const float corners[4][2] = { { -1, -1 }, { -1, 1 }, { 1, 1 }, { 1, -1 } };
+			unsigned int first = (unsigned int)vertices.size();
+			for (const float* c : corners) {
+				Vertex vertex = {};
+				vertex.Position = XMFLOAT3(
+					0.5f * (normal.x + c[0] * u.x + c[1] * v.x),
+					0.5f * (normal.y + c[0] * u.y + c[1] * v.y),
+					0.5f * (normal.z + c[0] * u.z + c[1] * v.z));
+				vertex.Normal = normal;
+				vertices.push_back(vertex);
+			}
+			for (unsigned int i : { 0u, 1u, 2u, 0u, 2u, 3u }) {
+				indices.push_back(first + i);
+			}
+		}
+	};
+
+	// --------------------------------------------------------
+	// A floor of small cubes under a large one, lit by one of
+	// each light type, plus a cube through the near plane so
+	// clipping is covered too
+	// --------------------------------------------------------
+	struct Scene
+	{
+		Cube cube;
+		std::vector<Light> lights;
+		RasterScene raster = {};
+
+		Scene()
+		{
+			raster.width = 320;
+			raster.height = 240;
+			raster.background[0] = 0.1f;
+			raster.background[1] = 0.2f;
+			raster.background[2] = 0.3f;
+			raster.background[3] = 1.0f;
+
+			XMVECTOR eye = XMVectorSet(3, 2.5f, -5, 0);
+			raster.cameraPosition = XMFLOAT3(3, 2.5f, -5);
+			XMStoreFloat4x4(&raster.view, XMMatrixLookAtLH(eye, XMVectorZero(), XMVectorSet(0, 1, 0, 0)));
+			XMStoreFloat4x4(&raster.projection, XMMatrixPerspectiveFovLH(1.0f, raster.width / (float)raster.height, 0.1f, 100.0f));
+
+			lights.resize(3);
+			std::memset(lights.data(), 0, sizeof(Light) * lights.size());
+			lights[0].Type = LIGHT_TYPE_DIRECTIONAL;
+			lights[0].Direction = XMFLOAT3(0.5f, -1, 0.1f);
+			lights[0].Color = XMFLOAT3(1, 1, 1);
+			lights[0].Intensity = 2;
+			lights[1].Type = LIGHT_TYPE_POINT;
+			lights[1].Position = XMFLOAT3(-2, 2, -2);
+			lights[1].Color = XMFLOAT3(1, 0.3f, 0.3f);
+			lights[1].Intensity = 3;
+			lights[1].Range = 8;
+			lights[2].Type = LIGHT_TYPE_SPOT;
+			lights[2].Position = XMFLOAT3(2, 3, 2);
+			lights[2].Direction = XMFLOAT3(-0.4f, -1, -0.2f);
+			lights[2].Color = XMFLOAT3(0.3f, 0.5f, 1);
+			lights[2].Intensity = 5;
+			lights[2].Range = 10;
+			lights[2].SpotInnerAngle = XMConvertToRadians(20);
+			lights[2].SpotOuterAngle = XMConvertToRadians(35);
+			for (Light& light : lights) {
+				light.ShadowTile = -1;
+			}
+			raster.lights = lights.data();
+			raster.lightCount = (unsigned int)lights.size();
+
+			Add(XMMatrixScaling(2, 2, 2), XMFLOAT3(0.8f, 0.8f, 0.8f), 0.4f, 0.0f);
+			for (int i = 0; i < 200; ++i) {
+				float x = (i % 20 - 10) * 0.6f;
+				float z = (i / 20) * 0.6f;
+				XMFLOAT3 albedo(0.3f + 0.035f * (i % 20), 0.6f, 0.3f + 0.07f * (i / 20));
+				Add(XMMatrixMultiply(XMMatrixScaling(0.4f, 0.4f, 0.4f), XMMatrixTranslation(x, -1.5f, z)), albedo, 0.2f + 0.004f * i, (i % 3) * 0.5f);
+			}
+			Add(XMMatrixTranslation(3, 2.5f, -4.9f), XMFLOAT3(0.9f, 0.4f, 0.1f), 0.6f, 0.0f);
+		}
+
+		void Add(FXMMATRIX world, XMFLOAT3 albedo, float roughness, float metalness)
+		{
+			RasterDraw draw = {};
+			draw.vertices = cube.vertices.data();
+			draw.indices = cube.indices.data();
+			draw.indexCount = (unsigned int)cube.indices.size();
+			XMStoreFloat4x4(&draw.world, world);
+			XMStoreFloat4x4(&draw.worldInvTranspose, XMMatrixTranspose(XMMatrixInverse(nullptr, world)));
+			draw.albedo = albedo;
+			draw.roughness = roughness;
+			draw.metalness = metalness;
+			raster.draws.push_back(draw);
+		}
+	};
+
+	void SameImageOnAnyThreadCount()
+	{
+		Scene scene;
+		JobSystem serial(0);
+		JobSystem parallel(3);
+		SoftwareRasterizer one(&serial);
+		SoftwareRasterizer many(&parallel);
+		one.Render(scene.raster);
+		many.Render(scene.raster);
+		CHECK(one.Pixels() == many.Pixels());
+		CHECK(many.GetStats().trianglesClipped > 0);
+	}
+
+	void MatchesGoldenImage()
+	{
+		Scene scene;
+		JobSystem jobs(3);
+		SoftwareRasterizer rasterizer(&jobs);
+		rasterizer.Render(scene.raster);
+
+		if (!outputImage.empty()) {
+			CHECK(rasterizer.WritePpm(outputImage));
+		}
+
+		long long mismatched = rasterizer.CompareToPpm(goldenImage, goldenTolerance);
+		if (mismatched < 0) {
+			std::printf("  Couldn't read \"%s\" as a %ux%u PPM\n", goldenImage.c_str(), rasterizer.Width(), rasterizer.Height());
+		}
+		else {
+			std::printf("  %lld pixels differ by more than %d from \"%s\"\n", mismatched, goldenTolerance, goldenImage.c_str());
+		}
+		CHECK(mismatched == 0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string argument = argv[i];
+		if (argument == "-golden")
+			goldenImage = argv[i + 1];
+		else if (argument == "-image")
+			outputImage = argv[i + 1];
+		else if (argument == "-tolerance")
+			goldenTolerance = std::atoi(argv[i + 1]);
+	}
+	if (goldenImage.empty()) {
+		std::printf("Usage: SoftwareRasterizerTests -golden <path> [-tolerance <n>] [-image <path>]\n");
+		return 1;
+	}
+
+	RUN_TEST(SameImageOnAnyThreadCount);
+	RUN_TEST(MatchesGoldenImage);
+	return Check::Result();
+}
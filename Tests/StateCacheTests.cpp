@@ -0,0 +1,125 @@
+#include "StateCache.h"
+#include "NullRenderContext.h"
+#include "Check.h"
+#include "Fake.h"
+
+#include <memory>
+
+namespace
+{
+	// A cache over a null context that keeps every command it's sent
+	struct Fixture
+	{
+		std::shared_ptr<NullRenderContext> context = std::make_shared<NullRenderContext>(true);
+		StateCache cache = StateCache(context);
+
+		unsigned int Sent(NullRenderContext::CommandType type) { return context->GetTotals().commands[type]; }
+	};
+
+	void RedundantBindsAreDropped()
+	{
+		Fixture f;
+		ID3D11PixelShader* shader = Fake<ID3D11PixelShader>(0);
+		ID3D11ShaderResourceView* srv = Fake<ID3D11ShaderResourceView>(1);
+		ID3D11SamplerState* sampler = Fake<ID3D11SamplerState>(2);
+		ID3D11Buffer* buffer = Fake<ID3D11Buffer>(3);
+
+		for (int i = 0; i < 3; i++) {
+			f.cache.PSSetShader(shader);
+			f.cache.PSSetShaderResource(4, srv);
+			f.cache.PSSetSampler(1, sampler);
+			f.cache.VSSetConstantBuffer(0, buffer);
+			f.cache.IASetVertexBuffer(buffer, 32, 0);
+		}
+
+		CHECK(f.Sent(NullRenderContext::COMMAND_SHADER) == 1);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SRV) == 1);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SAMPLER) == 1);
+		CHECK(f.Sent(NullRenderContext::COMMAND_CBUFFER) == 1);
+		CHECK(f.Sent(NullRenderContext::COMMAND_INPUT_ASSEMBLER) == 1);
+
+		const StateCache::Stats& stats = f.cache.GetStats();
+		CHECK(stats.issued[StateCache::CATEGORY_SHADER] == 1);
+		CHECK(stats.skipped[StateCache::CATEGORY_SHADER] == 2);
+		CHECK(stats.skipped[StateCache::CATEGORY_SRV] == 2);
+
+		//the same view in another slot, or the same buffer at another offset, is a new binding
+		f.context->Reset();
+		f.cache.PSSetShaderResource(5, srv);
+		f.cache.IASetVertexBuffer(buffer, 32, 16);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SRV) == 1);
+		CHECK(f.Sent(NullRenderContext::COMMAND_INPUT_ASSEMBLER) == 1);
+	}
+
+	void InvalidateForgetsEverything()
+	{
+		Fixture f;
+		ID3D11VertexShader* shader = Fake<ID3D11VertexShader>(0);
+
+		f.cache.VSSetShader(shader);
+		f.cache.Invalidate();
+		f.cache.VSSetShader(shader);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SHADER) == 2);
+	}
+
+	void RenderTargetsInvalidateShaderResources()
+	{
+		Fixture f;
+		ID3D11ShaderResourceView* srv = Fake<ID3D11ShaderResourceView>(0);
+		ID3D11RenderTargetView* rtv = Fake<ID3D11RenderTargetView>(1);
+		ID3D11PixelShader* shader = Fake<ID3D11PixelShader>(2);
+
+		f.cache.PSSetShader(shader);
+		f.cache.PSSetShaderResource(0, srv);
+		f.cache.VSSetShaderResource(0, srv);
+		f.cache.OMSetRenderTargets(1, &rtv, nullptr);
+		f.context->Reset();
+
+		//D3D may have unbound them behind our back, so both must go through again
+		f.cache.PSSetShaderResource(0, srv);
+		f.cache.VSSetShaderResource(0, srv);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SRV) == 2);
+
+		//but nothing else is affected
+		f.cache.PSSetShader(shader);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SHADER) == 0);
+	}
+
+	void ClearingShaderResourcesResetsSlots()
+	{
+		Fixture f;
+		ID3D11ShaderResourceView* srv = Fake<ID3D11ShaderResourceView>(0);
+
+		f.cache.PSSetShaderResource(2, srv);
+		f.context->Reset();
+		f.cache.PSClearShaderResources();
+
+		//one call covering every slot
+		CHECK(f.Sent(NullRenderContext::COMMAND_SRV) == 1);
+		const std::vector<NullRenderContext::Command>& commands = f.context->GetCommands();
+		if (CHECK(commands.size() == RenderContext::INPUT_RESOURCE_SLOTS)) {
+			CHECK(commands.front().value == 0);
+			CHECK(commands.back().value == RenderContext::INPUT_RESOURCE_SLOTS - 1);
+			CHECK(commands[2].object == nullptr);
+		}
+		f.context->Reset();
+
+		//every slot is now known to be empty...
+		f.cache.PSSetShaderResource(2, nullptr);
+		f.cache.PSSetShaderResource(RenderContext::INPUT_RESOURCE_SLOTS - 1, nullptr);
+		CHECK(f.context->GetCommands().empty());
+
+		//...so the old view has to be bound again
+		f.cache.PSSetShaderResource(2, srv);
+		CHECK(f.Sent(NullRenderContext::COMMAND_SRV) == 1);
+	}
+}
+
+int main()
+{
+	RUN_TEST(RedundantBindsAreDropped);
+	RUN_TEST(InvalidateForgetsEverything);
+	RUN_TEST(RenderTargetsInvalidateShaderResources);
+	RUN_TEST(ClearingShaderResourcesResetsSlots);
+	return Check::Result();
+}
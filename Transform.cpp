@@ -5,139 +5,114 @@
 
 using namespace DirectX;
 
-Transform::Transform()
+Transform::Transform() : Transform(&TransformPool::Default())
 {
-	position = XMFLOAT3(0, 0, 0);
-	rotation = XMFLOAT3(0, 0, 0);
-	scale = XMFLOAT3(1, 1, 1);
-
-
+}
 
-	RecalculateWorldAndTranspose();
+Transform::Transform(TransformPool* pool)
+{
+	this->pool = pool;
+	index = pool->Allocate();
 }
 
 Transform::~Transform()
 {
+	pool->Release(index);
 }
 
 void Transform::SetPosition(float x, float y, float z)
 {
-	position = XMFLOAT3(x, y, z);
-	dirty = true;
+	pool->SetPosition(index, x, y, z);
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 position)
 {
-	this->position = XMFLOAT3(position.x, position.y, position.z);
-	dirty = true;
+	pool->SetPosition(index, position.x, position.y, position.z);
 }
 
 void Transform::SetRotation(float pitch, float yaw, float roll)
 {
-	rotation = XMFLOAT3(pitch, yaw, roll);
-	dirty = true;
+	pool->SetPitchYawRoll(index, pitch, yaw, roll);
 	rotDirty = true;
 }
 
 void Transform::SetRotation(DirectX::XMFLOAT3 rotation)
 {
-	this->rotation = XMFLOAT3(position.x, position.y, position.z);
-	dirty = true;
+	pool->SetPitchYawRoll(index, rotation.x, rotation.y, rotation.z);
+	rotDirty = true;
+}
+
+void Transform::SetRotation(DirectX::XMFLOAT4 quaternion)
+{
+	pool->SetRotation(index, quaternion);
 	rotDirty = true;
 }
 
 void Transform::SetScale(float x, float y, float z)
 {
-	scale = XMFLOAT3(x, y, z);
-	dirty = true;
+	pool->SetScale(index, x, y, z);
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 scale)
 {
-	this->scale = XMFLOAT3(position.x, position.y, position.z);
-	dirty = true;
+	pool->SetScale(index, scale.x, scale.y, scale.z);
 }
 
 DirectX::XMFLOAT3 Transform::GetPosition()
 {
-	return position;
+	return pool->GetPosition(index);
 }
 
 DirectX::XMFLOAT3 Transform::GetPitchYawRoll()
 {
-	return rotation;
+	return pool->GetPitchYawRoll(index);
 }
 
-DirectX::XMFLOAT3 Transform::GetScale()
+DirectX::XMFLOAT4 Transform::GetRotation()
 {
-	return scale;
+	return pool->GetRotation(index);
 }
 
-DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
+DirectX::XMFLOAT3 Transform::GetScale()
 {
-	if (!dirty) {
-		return worldMatrix;
-	}
-
-	//calculate world and inverseTranspose
-	RecalculateWorldAndTranspose();
-
-	return worldMatrix;
+	return pool->GetScale(index);
 }
 
-DirectX::XMFLOAT4X4 Transform::GetWorldInverseTranspose()
+DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
 {
-	if (!dirty) {
-		return worldInverseTranspose;
-	}
-
-	//calculate world and inverseTranspose
-	RecalculateWorldAndTranspose();
-
-	return worldInverseTranspose;
+	//rebuilt by the pool if the batch update hasn't gotten to it yet
+	return pool->GetWorldMatrix(index);
 }
 
-void Transform::RecalculateWorldAndTranspose()
+DirectX::XMFLOAT4X4 Transform::GetWorldInverseTranspose()
 {
-	XMMATRIX translationMat = XMMatrixTranslation(position.x, position.y, position.z);
-	XMMATRIX scaleMat = XMMatrixScaling(scale.x, scale.y, scale.z);
-	XMMATRIX rotationMat = XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-
-	XMMATRIX world = scaleMat * rotationMat * translationMat; //uses overloaded operators
-
-	XMStoreFloat4x4(&worldMatrix, world);
-	XMStoreFloat4x4(&worldInverseTranspose, XMMatrixInverse(0, XMMatrixTranspose(world)));
-
-    dirty = false;
+	return pool->GetWorldInverseTranspose(index);
 }
 
 
 void Transform::MoveAbsolute(float x, float y, float z)
 {
-	position.x += x;
-	position.y += y;
-	position.z += z;
-	dirty = true;
+	XMFLOAT3 position = pool->GetPosition(index);
+	pool->SetPosition(index, position.x + x, position.y + y, position.z + z);
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
 {
-	position.x += offset.x;
-	position.y += offset.y;
-	position.z += offset.z;
-	dirty = true;
+	MoveAbsolute(offset.x, offset.y, offset.z);
 }
 
 void Transform::MoveRelative(float x, float y, float z)
 {
-	XMVECTOR newVec = XMVECTOR({ x, y, z });
-	XMVECTOR rotationQuat = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-	newVec = XMVector3Rotate(newVec, rotationQuat);
+	if (rotDirty) {
+		RecalculateLocalDirections();
+	}
+
+	//the offset is just a mix of the cached basis vectors
+	XMVECTOR newVec = XMVectorScale(XMLoadFloat3(&localRight), x);
+	newVec = XMVectorMultiplyAdd(XMLoadFloat3(&localUp), XMVectorReplicate(y), newVec);
+	newVec = XMVectorMultiplyAdd(XMLoadFloat3(&localForward), XMVectorReplicate(z), newVec);
 
-	position.x += XMVectorGetX(newVec);
-	position.y += XMVectorGetY(newVec);
-	position.z += XMVectorGetZ(newVec);
-	dirty = true;
+	MoveAbsolute(XMVectorGetX(newVec), XMVectorGetY(newVec), XMVectorGetZ(newVec));
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
@@ -147,44 +122,46 @@ void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 
 void Transform::Rotate(float pitch, float yaw, float roll)
 {
-	rotation.x += pitch;
-	rotation.y += yaw;
-	rotation.z += roll;
-	//rotation = XMFLOAT3(
-	//	std::fmod(rotation.x, (2.0f * 3.14159265358979f)),
-	//	std::fmod(rotation.x, (2.0f * 3.14159265358979f)),
-	//	std::fmod(rotation.x, (2.0f * 3.14159265358979f))
-	//);
+	//the delta comes after the current rotation, so it's about the parent's
+	//axes and a pure yaw stays about world up
+	XMFLOAT4 rotation = pool->GetRotation(index);
+	XMVECTOR delta = XMQuaternionRotationRollPitchYaw(pitch, yaw, roll);
+	XMStoreFloat4(&rotation, XMQuaternionMultiply(XMLoadFloat4(&rotation), delta));
+	pool->SetRotation(index, rotation);
 
-	dirty = true;
 	rotDirty = true;
 }
 
 void Transform::Rotate(DirectX::XMFLOAT3 rotation)
 {
-	this->rotation.x += rotation.x;
-	this->rotation.y += rotation.y;
-	this->rotation.z += rotation.z;
-
-
-	dirty = true;
-	rotDirty = true;
+	Rotate(rotation.x, rotation.y, rotation.z);
 }
 
 void Transform::Scale(float x, float y, float z)
 {
-	scale.x *= x;
-	scale.y *= y;
-	scale.z *= z;
-	dirty = true;
+	XMFLOAT3 scale = pool->GetScale(index);
+	pool->SetScale(index, scale.x * x, scale.y * y, scale.z * z);
 }
 
 void Transform::Scale(DirectX::XMFLOAT3 scale)
 {
-	this->scale.x *= scale.x;
-	this->scale.y *= scale.y;
-	this->scale.z *= scale.z;
-	dirty = true;
+	Scale(scale.x, scale.y, scale.z);
+}
+
+bool Transform::SetParent(Transform* parent)
+{
+	if (parent == nullptr) {
+		return pool->SetParent(index, TransformPool::NONE);
+	}
+	if (parent->pool != pool) {
+		return false;
+	}
+	return pool->SetParent(index, parent->index);
+}
+
+bool Transform::HasParent()
+{
+	return pool->GetParent(index) != TransformPool::NONE;
 }
 
 DirectX::XMFLOAT3 Transform::GetRight()
@@ -216,14 +193,13 @@ DirectX::XMFLOAT3 Transform::GetForward()
 
 void Transform::RecalculateLocalDirections()
 {
-	XMVECTOR rotationQuat = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-	XMVECTOR rotatedRight = XMVector3Rotate(XMVECTOR({ 1, 0, 0 }), rotationQuat);
-	XMVECTOR rotatedUp = XMVector3Rotate(XMVECTOR({0, 1, 0}), rotationQuat);
-	XMVECTOR rotatedForward = XMVector3Rotate(XMVECTOR({0, 0, 1}), rotationQuat);
+	//rows of the rotation matrix are the rotated axes, no trig needed
+	XMFLOAT4 rotation = pool->GetRotation(index);
+	XMMATRIX rotationMat = XMMatrixRotationQuaternion(XMLoadFloat4(&rotation));
 
-	localRight = XMFLOAT3(XMVectorGetX(rotatedRight), XMVectorGetY(rotatedRight), XMVectorGetZ(rotatedRight));
-	localUp = XMFLOAT3(XMVectorGetX(rotatedUp), XMVectorGetY(rotatedUp), XMVectorGetZ(rotatedUp));
-	localForward = XMFLOAT3(XMVectorGetX(rotatedForward), XMVectorGetY(rotatedForward), XMVectorGetZ(rotatedForward));
+	XMStoreFloat3(&localRight, rotationMat.r[0]);
+	XMStoreFloat3(&localUp, rotationMat.r[1]);
+	XMStoreFloat3(&localForward, rotationMat.r[2]);
 
 	rotDirty = false;
 }
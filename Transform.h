@@ -2,6 +2,8 @@
 
 #include <DirectXMath.h>
 
+#include "TransformPool.h"
+
 class Transform
 {
 
@@ -9,6 +11,7 @@ public:
 
 
 	Transform();
+	Transform(TransformPool* pool);
 	~Transform();
 	Transform(const Transform&) = delete; // Remove copy constructor
 	Transform& operator=(const Transform&) = delete; // Remove copy-assignment operator
@@ -17,11 +20,13 @@ public:
 	void SetPosition(DirectX::XMFLOAT3 position);
 	void SetRotation(float pitch, float yaw, float roll);
 	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 	void SetScale(DirectX::XMFLOAT3 scale);
 
 	DirectX::XMFLOAT3 GetPosition();
 	DirectX::XMFLOAT3 GetPitchYawRoll();
+	DirectX::XMFLOAT4 GetRotation();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTranspose();
@@ -41,24 +46,24 @@ public:
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
 
+	//parent must come from the same pool, nullptr detaches
+	//(position/rotation/scale are then relative to the parent)
+	bool SetParent(Transform* parent);
+	bool HasParent();
+
 private:
 
-	void RecalculateWorldAndTranspose();
 	void RecalculateLocalDirections();
 
-	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 rotation; //doing rotation as a vector for now, may change to matrix eventually.
-	DirectX::XMFLOAT3 scale;
+	//the actual components and matrices live in the pool
+	TransformPool* pool;
+	unsigned int index;
 
+	//basis vectors of the stored rotation, rebuilt when it changes
 	DirectX::XMFLOAT3 localRight;
 	DirectX::XMFLOAT3 localUp;
 	DirectX::XMFLOAT3 localForward;
 
-
-	DirectX::XMFLOAT4X4 worldMatrix;
-	DirectX::XMFLOAT4X4 worldInverseTranspose;
-
-	bool dirty = true;
-	bool rotDirty = false;
+	bool rotDirty = true;
 };
 
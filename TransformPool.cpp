@@ -0,0 +1,661 @@
+#include "TransformPool.h"
+#include "Profiler.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Single transform version of the batch kernel's math: the
+	// S*R*T matrix and its closed-form inverse-transpose
+	// --------------------------------------------------------
+	void BuildMatrices(FXMVECTOR position, FXMVECTOR rotation, FXMVECTOR scale, XMMATRIX& srt, XMMATRIX& inverseTranspose)
+	{
+		XMMATRIX r = XMMatrixRotationQuaternion(rotation);
+		XMVECTOR scaleSq = XMVectorMultiply(scale, scale);
+
+		XMVECTOR rows[3] = {
+			XMVectorScale(r.r[0], XMVectorGetX(scale)),
+			XMVectorScale(r.r[1], XMVectorGetY(scale)),
+			XMVectorScale(r.r[2], XMVectorGetZ(scale)) };
+		float invScaleSq[3] = { 1.0f / XMVectorGetX(scaleSq), 1.0f / XMVectorGetY(scaleSq), 1.0f / XMVectorGetZ(scaleSq) };
+
+		srt.r[0] = rows[0];
+		srt.r[1] = rows[1];
+		srt.r[2] = rows[2];
+		srt.r[3] = XMVectorSetW(position, 1.0f);
+
+		for (int row = 0; row < 3; ++row) {
+			XMVECTOR n = XMVectorScale(rows[row], invScaleSq[row]);
+			inverseTranspose.r[row] = XMVectorSetW(n, -XMVectorGetX(XMVector3Dot(position, n)));
+		}
+		inverseTranspose.r[3] = XMVectorSet(0, 0, 0, 1);
+	}
+}
+
+TransformPool::TransformPool()
+{
+	dirtyCount = 0;
+	orderDirty = false;
+	tick = 0;
+}
+
+TransformPool::~TransformPool()
+{
+}
+
+TransformPool& TransformPool::Default()
+{
+	static TransformPool pool;
+	return pool;
+}
+
+unsigned int TransformPool::Allocate()
+{
+	unsigned int index;
+	if (!freeList.empty()) {
+		index = freeList.back();
+		freeList.pop_back();
+	}
+	else {
+		//grow a whole lane at a time, spare slots stay dead until handed out
+		index = (unsigned int)alive.size();
+		size_t newSize = alive.size() + 4;
+
+		positionX.resize(newSize, 0); positionY.resize(newSize, 0); positionZ.resize(newSize, 0);
+		rotationX.resize(newSize, 0); rotationY.resize(newSize, 0); rotationZ.resize(newSize, 0); rotationW.resize(newSize, 1);
+		scaleX.resize(newSize, 1); scaleY.resize(newSize, 1); scaleZ.resize(newSize, 1);
+		dirty.resize(newSize, 0);
+		alive.resize(newSize, 0);
+		worldMatrices.resize(newSize);
+		worldInverseTransposes.resize(newSize);
+		parent.resize(newSize, NONE);
+		firstChild.resize(newSize, NONE);
+		nextSibling.resize(newSize, NONE);
+		prevSibling.resize(newSize, NONE);
+		localMatrices.resize(newSize);
+		localInverseTransposes.resize(newSize);
+		worldDirty.resize(newSize, 0);
+		orderPosition.resize(newSize, NONE);
+		subtreeSize.resize(newSize, 0);
+		previousPositions.resize(newSize);
+		previousRotations.resize(newSize);
+		previousScales.resize(newSize);
+		tickChange.resize(newSize, TICK_SAME);
+		changeTicks.resize(newSize, 0);
+
+		for (unsigned int i = index + 3; i > index; --i) {
+			freeList.push_back(i);
+		}
+	}
+
+	positionX[index] = 0; positionY[index] = 0; positionZ[index] = 0;
+	rotationX[index] = 0; rotationY[index] = 0; rotationZ[index] = 0; rotationW[index] = 1;
+	scaleX[index] = 1; scaleY[index] = 1; scaleZ[index] = 1;
+	parent[index] = NONE;
+	firstChild[index] = NONE;
+	nextSibling[index] = NONE;
+	prevSibling[index] = NONE;
+	worldDirty[index] = 0;
+	alive[index] = 1;
+	NoteChange(index, TICK_RESET);
+	MarkDirty(index);
+
+	return index;
+}
+
+void TransformPool::Release(unsigned int index)
+{
+	//orphaned children become roots
+	while (firstChild[index] != NONE) {
+		SetParent(firstChild[index], NONE);
+	}
+	SetParent(index, NONE);
+
+	if (dirty[index]) {
+		dirty[index] = 0;
+		dirtyCount--;
+	}
+	alive[index] = 0;
+	freeList.push_back(index);
+}
+
+DirectX::XMFLOAT3 TransformPool::GetPosition(unsigned int index)
+{
+	return XMFLOAT3(positionX[index], positionY[index], positionZ[index]);
+}
+
+DirectX::XMFLOAT4 TransformPool::GetRotation(unsigned int index)
+{
+	return XMFLOAT4(rotationX[index], rotationY[index], rotationZ[index], rotationW[index]);
+}
+
+// --------------------------------------------------------
+// Recovers angles from the rotation matrix elements the
+// quaternion stands for (R = roll * pitch * yaw, so m21 is
+// -sin(pitch)).  Looking straight up or down, yaw and roll
+// spin about the same axis, so it all goes into yaw
+// --------------------------------------------------------
+DirectX::XMFLOAT3 TransformPool::GetPitchYawRoll(unsigned int index)
+{
+	float x = rotationX[index];
+	float y = rotationY[index];
+	float z = rotationZ[index];
+	float w = rotationW[index];
+
+	float m21 = 2.0f * (y * z - x * w);
+	if (m21 > 0.9999f || m21 < -0.9999f) {
+		float m00 = 1.0f - 2.0f * (y * y + z * z);
+		float m02 = 2.0f * (x * z - y * w);
+		return XMFLOAT3(m21 > 0 ? -XM_PIDIV2 : XM_PIDIV2, std::atan2(-m02, m00), 0);
+	}
+
+	float m01 = 2.0f * (x * y + z * w);
+	float m11 = 1.0f - 2.0f * (x * x + z * z);
+	float m20 = 2.0f * (x * z + y * w);
+	float m22 = 1.0f - 2.0f * (x * x + y * y);
+	return XMFLOAT3(std::asin(-m21), std::atan2(m20, m22), std::atan2(m01, m11));
+}
+
+DirectX::XMFLOAT3 TransformPool::GetScale(unsigned int index)
+{
+	return XMFLOAT3(scaleX[index], scaleY[index], scaleZ[index]);
+}
+
+void TransformPool::SetPosition(unsigned int index, float x, float y, float z)
+{
+	positionX[index] = x;
+	positionY[index] = y;
+	positionZ[index] = z;
+	MarkDirty(index);
+}
+
+void TransformPool::SetRotation(unsigned int index, DirectX::XMFLOAT4 quaternion)
+{
+	XMFLOAT4 q;
+	XMStoreFloat4(&q, XMQuaternionNormalize(XMLoadFloat4(&quaternion)));
+	rotationX[index] = q.x;
+	rotationY[index] = q.y;
+	rotationZ[index] = q.z;
+	rotationW[index] = q.w;
+	MarkDirty(index);
+}
+
+void TransformPool::SetPitchYawRoll(unsigned int index, float pitch, float yaw, float roll)
+{
+	XMFLOAT4 q;
+	XMStoreFloat4(&q, XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+	rotationX[index] = q.x;
+	rotationY[index] = q.y;
+	rotationZ[index] = q.z;
+	rotationW[index] = q.w;
+	MarkDirty(index);
+}
+
+void TransformPool::SetScale(unsigned int index, float x, float y, float z)
+{
+	scaleX[index] = x;
+	scaleY[index] = y;
+	scaleZ[index] = z;
+	MarkDirty(index);
+}
+
+// --------------------------------------------------------
+// Attaches a transform to a new parent (or detaches it with
+// NONE).  Its components are kept as-is and are from now on
+// relative to the parent.
+//
+// Returns false if that would make a cycle
+// --------------------------------------------------------
+bool TransformPool::SetParent(unsigned int index, unsigned int parentIndex)
+{
+	if (parent[index] == parentIndex) {
+		return true;
+	}
+
+	if (parentIndex == index) {
+		return false;
+	}
+
+	//only something with descendants can end up parented under one of them
+	if (parentIndex != NONE && firstChild[index] != NONE) {
+		for (unsigned int p = parentIndex; p != NONE; p = parent[p]) {
+			if (p == index) {
+				return false;
+			}
+		}
+	}
+
+	//unlink from the old parent's child list
+	unsigned int oldParent = parent[index];
+	if (oldParent != NONE) {
+		if (prevSibling[index] != NONE) {
+			nextSibling[prevSibling[index]] = nextSibling[index];
+		}
+		else {
+			firstChild[oldParent] = nextSibling[index];
+		}
+		if (nextSibling[index] != NONE) {
+			prevSibling[nextSibling[index]] = prevSibling[index];
+		}
+	}
+
+	parent[index] = parentIndex;
+	nextSibling[index] = NONE;
+	prevSibling[index] = NONE;
+	worldDirty[index] = 0;
+	if (parentIndex != NONE) {
+		nextSibling[index] = firstChild[parentIndex];
+		if (firstChild[parentIndex] != NONE) {
+			prevSibling[firstChild[parentIndex]] = index;
+		}
+		firstChild[parentIndex] = index;
+	}
+	orderDirty = true;
+
+	//components now mean something else, so don't blend across this
+	NoteChange(index, TICK_RESET);
+
+	//the kernel has to write to the other matrix now
+	MarkDirty(index);
+
+	return true;
+}
+
+const DirectX::XMFLOAT4X4& TransformPool::GetWorldMatrix(unsigned int index)
+{
+	if (orderDirty) {
+		RebuildOrder();
+	}
+	if (dirty[index] || worldDirty[index]) {
+		ResolveWorld(index);
+	}
+	return worldMatrices[index];
+}
+
+const DirectX::XMFLOAT4X4& TransformPool::GetWorldInverseTranspose(unsigned int index)
+{
+	if (orderDirty) {
+		RebuildOrder();
+	}
+	if (dirty[index] || worldDirty[index]) {
+		ResolveWorld(index);
+	}
+	return worldInverseTransposes[index];
+}
+
+const DirectX::XMFLOAT4X4& TransformPool::GetCachedWorldMatrix(unsigned int index) const
+{
+	assert(!orderDirty && !dirty[index] && !worldDirty[index]);
+	return worldMatrices[index];
+}
+
+void TransformPool::UpdateDirty(JobSystem* jobs)
+{
+	PROFILE_SCOPE("TransformPool::UpdateDirty");
+
+	if (orderDirty) {
+		RebuildOrder();
+	}
+
+	unsigned int count = (unsigned int)alive.size();
+	if (dirtyCount > 0 && jobs != nullptr) {
+		//lane groups never share a transform, so chunks can run side by side
+		std::vector<unsigned int> cleaned((count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK, 0);
+		jobs->ParallelFor(count, PARALLEL_CHUNK, [this, &cleaned](unsigned int begin, unsigned int end) {
+			cleaned[begin / PARALLEL_CHUNK] = RecalculateRange(begin, end);
+		});
+
+		for (unsigned int n : cleaned) {
+			dirtyCount -= n;
+		}
+	}
+	else if (dirtyCount > 0) {
+		dirtyCount -= RecalculateRange(0, count);
+	}
+
+	//parents come first in the order, so by the time we reach a
+	//child its parent's world is already final
+	for (unsigned int n : order) {
+		if (worldDirty[n]) {
+			ComposeWorld(n);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Flags a transform's own matrix for rebuilding.  The first
+// time it goes dirty, everything below it in the hierarchy
+// gets its world flagged too - that's one contiguous range
+// of the depth-first order.  While the order is stale there
+// is nothing to mark, the rebuild flags every child anyway
+// --------------------------------------------------------
+void TransformPool::MarkDirty(unsigned int index)
+{
+	NoteChange(index, TICK_MOVED);
+
+	if (parent[index] != NONE) {
+		worldDirty[index] = 1;
+	}
+
+	if (dirty[index]) {
+		return;
+	}
+	dirty[index] = 1;
+	dirtyCount++;
+
+	if (firstChild[index] != NONE && !orderDirty) {
+		unsigned int start = orderPosition[index] + 1;
+		unsigned int end = start + subtreeSize[index];
+		for (unsigned int i = start; i < end; ++i) {
+			worldDirty[order[i]] = 1;
+		}
+	}
+}
+
+// RESET wins over MOVED, and each transform is listed once
+void TransformPool::NoteChange(unsigned int index, unsigned char change)
+{
+	changeTicks[index] = tick;
+	if (tickChange[index] == TICK_SAME) {
+		tickChanged.push_back(index);
+	}
+	if (change > tickChange[index]) {
+		tickChange[index] = change;
+	}
+}
+
+// --------------------------------------------------------
+// Only transforms changed since the last tick can differ
+// from what was saved then, so only those get copied
+// --------------------------------------------------------
+void TransformPool::BeginTick()
+{
+	for (unsigned int i : tickChanged) {
+		previousPositions[i] = XMFLOAT3(positionX[i], positionY[i], positionZ[i]);
+		previousRotations[i] = XMFLOAT4(rotationX[i], rotationY[i], rotationZ[i], rotationW[i]);
+		previousScales[i] = XMFLOAT3(scaleX[i], scaleY[i], scaleZ[i]);
+		tickChange[i] = TICK_SAME;
+	}
+	tickChanged.clear();
+	tick++;
+}
+
+unsigned long long TransformPool::GetChangeTick(unsigned int index)
+{
+	unsigned long long latest = 0;
+	for (unsigned int n = index; n != NONE; n = parent[n]) {
+		latest = changeTicks[n] > latest ? changeTicks[n] : latest;
+	}
+	return latest;
+}
+
+// Whether this transform or anything above it moved this tick
+bool TransformPool::MovedSinceTick(unsigned int index)
+{
+	for (unsigned int n = index; n != NONE; n = parent[n]) {
+		if (tickChange[n] == TICK_MOVED) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Positions and scales lerp, rotations slerp, and children
+// are composed with their parent's interpolated world the
+// same way the batch update composes them.  Anything that
+// didn't move, all the way up its parent chain, just hands
+// back the cached matrices
+// --------------------------------------------------------
+void TransformPool::GetInterpolatedWorld(unsigned int index, float alpha, DirectX::XMFLOAT4X4& world, DirectX::XMFLOAT4X4& worldInverseTranspose)
+{
+	if (alpha >= 1.0f || !MovedSinceTick(index)) {
+		world = worldMatrices[index];
+		worldInverseTranspose = worldInverseTransposes[index];
+		return;
+	}
+
+	//a reset transform has no history of its own, but may still sit under one that moved
+	float t = tickChange[index] == TICK_MOVED ? alpha : 1.0f;
+	XMVECTOR position = XMVectorLerp(XMLoadFloat3(&previousPositions[index]), XMVectorSet(positionX[index], positionY[index], positionZ[index], 0), t);
+	XMVECTOR rotation = XMQuaternionSlerp(XMLoadFloat4(&previousRotations[index]), XMVectorSet(rotationX[index], rotationY[index], rotationZ[index], rotationW[index]), t);
+	XMVECTOR scale = XMVectorLerp(XMLoadFloat3(&previousScales[index]), XMVectorSet(scaleX[index], scaleY[index], scaleZ[index], 0), t);
+
+	XMMATRIX srt;
+	XMMATRIX inverseTranspose;
+	BuildMatrices(position, rotation, scale, srt, inverseTranspose);
+
+	if (parent[index] != NONE) {
+		XMFLOAT4X4 parentWorld;
+		XMFLOAT4X4 parentInverseTranspose;
+		GetInterpolatedWorld(parent[index], alpha, parentWorld, parentInverseTranspose);
+		srt = XMMatrixMultiply(srt, XMLoadFloat4x4(&parentWorld));
+		inverseTranspose = XMMatrixMultiply(inverseTranspose, XMLoadFloat4x4(&parentInverseTranspose));
+	}
+
+	XMStoreFloat4x4(&world, srt);
+	XMStoreFloat4x4(&worldInverseTranspose, inverseTranspose);
+}
+
+// --------------------------------------------------------
+// Lays out every transform that has a parent or children in
+// depth-first order.  Only needed after parenting changes,
+// and since those can move whole subtrees every child's
+// world is treated as stale afterwards
+// --------------------------------------------------------
+void TransformPool::RebuildOrder()
+{
+	for (unsigned int n : order) {
+		orderPosition[n] = NONE;
+		subtreeSize[n] = 0;
+	}
+	order.clear();
+
+	//iterative, since chains can be far deeper than the call stack
+	std::vector<unsigned int> stack;
+	unsigned int count = (unsigned int)alive.size();
+	for (unsigned int root = 0; root < count; ++root) {
+		if (!alive[root] || parent[root] != NONE || firstChild[root] == NONE) {
+			continue;
+		}
+
+		stack.push_back(root);
+		while (!stack.empty()) {
+			unsigned int n = stack.back();
+			stack.pop_back();
+
+			orderPosition[n] = (unsigned int)order.size();
+			order.push_back(n);
+
+			for (unsigned int c = firstChild[n]; c != NONE; c = nextSibling[c]) {
+				stack.push_back(c);
+			}
+		}
+	}
+
+	//children follow their parents, so walking backwards
+	//finishes every subtree before its parent is reached
+	for (size_t i = order.size(); i-- > 0;) {
+		unsigned int n = order[i];
+		if (parent[n] != NONE) {
+			subtreeSize[parent[n]] += 1 + subtreeSize[n];
+			worldDirty[n] = 1;
+		}
+	}
+
+	orderDirty = false;
+}
+
+// --------------------------------------------------------
+// Brings a single transform's world up to date outside of
+// the batch update, fixing stale ancestors top-down first
+// --------------------------------------------------------
+void TransformPool::ResolveWorld(unsigned int index)
+{
+	//a clean ancestor means everything above it is clean too,
+	//since any change up there would have flagged it
+	std::vector<unsigned int> chain;
+	for (unsigned int n = index; n != NONE && (dirty[n] || worldDirty[n]); n = parent[n]) {
+		chain.push_back(n);
+	}
+
+	for (size_t i = chain.size(); i-- > 0;) {
+		unsigned int n = chain[i];
+		if (dirty[n]) {
+			dirtyCount -= RecalculateBatch(n & ~3u);
+		}
+		if (worldDirty[n]) {
+			ComposeWorld(n);
+		}
+	}
+}
+
+void TransformPool::ComposeWorld(unsigned int index)
+{
+	unsigned int p = parent[index];
+	XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4(&localMatrices[index]), XMLoadFloat4x4(&worldMatrices[p]));
+
+	//(local * parent)^-T = local^-T * parent^-T, so no inverse needed here either
+	XMMATRIX inverseTranspose = XMMatrixMultiply(XMLoadFloat4x4(&localInverseTransposes[index]), XMLoadFloat4x4(&worldInverseTransposes[p]));
+
+	XMStoreFloat4x4(&worldMatrices[index], world);
+	XMStoreFloat4x4(&worldInverseTransposes[index], inverseTranspose);
+	worldDirty[index] = 0;
+}
+
+// --------------------------------------------------------
+// Rebuilds world = scale * rotation * translation for the 4
+// transforms starting at first.  Every XMVECTOR below holds
+// one matrix element for all 4 transforms, so the rotation
+// and scale products are done once per lane group.
+//
+// Rotation is expanded from the quaternion the same way as
+// XMMatrixRotationQuaternion, which needs no trig at all.
+//
+// The inverse-transpose comes straight from the same parts
+// instead of a general 4x4 inverse.  With the upper 3x3 being
+// rows of R scaled by s, its inverse-transpose is just rows of
+// R divided by s (so each scaled row over s squared), and the
+// translation lands in the last column as -dot(t, row).  That
+// holds for uniform and non-uniform scale alike.
+//
+// Children only get their local matrix here; their world is
+// composed with the parent's afterwards.
+//
+// Only touches these 4 transforms, and returns how many were
+// dirty rather than updating the count itself, so batches
+// can run on different threads.
+// --------------------------------------------------------
+unsigned int TransformPool::RecalculateBatch(unsigned int first)
+{
+	XMVECTOR qx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&rotationX[first]));
+	XMVECTOR qy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&rotationY[first]));
+	XMVECTOR qz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&rotationZ[first]));
+	XMVECTOR qw = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&rotationW[first]));
+
+	XMVECTOR sx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&scaleX[first]));
+	XMVECTOR sy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&scaleY[first]));
+	XMVECTOR sz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&scaleZ[first]));
+
+	XMVECTOR one = XMVectorSplatOne();
+	XMVECTOR x2 = XMVectorAdd(qx, qx);
+	XMVECTOR y2 = XMVectorAdd(qy, qy);
+	XMVECTOR z2 = XMVectorAdd(qz, qz);
+	XMVECTOR xx = XMVectorMultiply(qx, x2);
+	XMVECTOR yy = XMVectorMultiply(qy, y2);
+	XMVECTOR zz = XMVectorMultiply(qz, z2);
+	XMVECTOR xy = XMVectorMultiply(qx, y2);
+	XMVECTOR xz = XMVectorMultiply(qx, z2);
+	XMVECTOR yz = XMVectorMultiply(qy, z2);
+	XMVECTOR wx = XMVectorMultiply(qw, x2);
+	XMVECTOR wy = XMVectorMultiply(qw, y2);
+	XMVECTOR wz = XMVectorMultiply(qw, z2);
+
+	//rows of the scaled rotation, element by element
+	XMFLOAT4A m[9];
+	XMStoreFloat4A(&m[0], XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(yy, zz)), sx));
+	XMStoreFloat4A(&m[1], XMVectorMultiply(XMVectorAdd(xy, wz), sx));
+	XMStoreFloat4A(&m[2], XMVectorMultiply(XMVectorSubtract(xz, wy), sx));
+	XMStoreFloat4A(&m[3], XMVectorMultiply(XMVectorSubtract(xy, wz), sy));
+	XMStoreFloat4A(&m[4], XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(xx, zz)), sy));
+	XMStoreFloat4A(&m[5], XMVectorMultiply(XMVectorAdd(yz, wx), sy));
+	XMStoreFloat4A(&m[6], XMVectorMultiply(XMVectorAdd(xz, wy), sz));
+	XMStoreFloat4A(&m[7], XMVectorMultiply(XMVectorSubtract(yz, wx), sz));
+	XMStoreFloat4A(&m[8], XMVectorMultiply(XMVectorSubtract(one, XMVectorAdd(xx, yy)), sz));
+
+	XMVECTOR tx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&positionX[first]));
+	XMVECTOR ty = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&positionY[first]));
+	XMVECTOR tz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&positionZ[first]));
+
+	//inverse-transpose rows, plus the translation column
+	XMFLOAT4A n[12];
+	XMVECTOR invScaleSq[3] = {
+		XMVectorReciprocal(XMVectorMultiply(sx, sx)),
+		XMVectorReciprocal(XMVectorMultiply(sy, sy)),
+		XMVectorReciprocal(XMVectorMultiply(sz, sz)) };
+	for (int row = 0; row < 3; ++row) {
+		XMVECTOR n0 = XMVectorMultiply(XMLoadFloat4A(&m[row * 3 + 0]), invScaleSq[row]);
+		XMVECTOR n1 = XMVectorMultiply(XMLoadFloat4A(&m[row * 3 + 1]), invScaleSq[row]);
+		XMVECTOR n2 = XMVectorMultiply(XMLoadFloat4A(&m[row * 3 + 2]), invScaleSq[row]);
+		XMStoreFloat4A(&n[row * 4 + 0], n0);
+		XMStoreFloat4A(&n[row * 4 + 1], n1);
+		XMStoreFloat4A(&n[row * 4 + 2], n2);
+		XMStoreFloat4A(&n[row * 4 + 3], XMVectorNegate(XMVectorMultiplyAdd(tz, n2, XMVectorMultiplyAdd(ty, n1, XMVectorMultiply(tx, n0)))));
+	}
+
+	unsigned int cleaned = 0;
+	for (unsigned int lane = 0; lane < 4; ++lane) {
+		unsigned int i = first + lane;
+		const float* e = &m[0].x + lane;
+		const float* ne = &n[0].x + lane;
+
+		//each element array is 4 floats wide, so stepping by 4 walks one lane
+		XMFLOAT4X4 srt(
+			e[0],  e[4],  e[8],  0,
+			e[12], e[16], e[20], 0,
+			e[24], e[28], e[32], 0,
+			positionX[i], positionY[i], positionZ[i], 1);
+
+		XMFLOAT4X4 inverseTranspose(
+			ne[0],  ne[4],  ne[8],  ne[12],
+			ne[16], ne[20], ne[24], ne[28],
+			ne[32], ne[36], ne[40], ne[44],
+			0, 0, 0, 1);
+
+		if (parent[i] != NONE) {
+			localMatrices[i] = srt;
+			localInverseTransposes[i] = inverseTranspose;
+		}
+		else {
+			worldMatrices[i] = srt;
+			worldInverseTransposes[i] = inverseTranspose;
+		}
+
+		if (dirty[i]) {
+			dirty[i] = 0;
+			cleaned++;
+		}
+	}
+
+	return cleaned;
+}
+
+// Every lane group from first up to end that has something dirty
+unsigned int TransformPool::RecalculateRange(unsigned int first, unsigned int end)
+{
+	unsigned int cleaned = 0;
+	for (unsigned int i = first; i < end; i += 4) {
+		//skip lanes with nothing to do (a u32 read covers all 4 flags)
+		unsigned int laneDirty;
+		memcpy(&laneDirty, &dirty[i], sizeof(unsigned int));
+		if (laneDirty) {
+			cleaned += RecalculateBatch(i);
+		}
+	}
+	return cleaned;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Structure-of-arrays storage for every Transform's
+// components and cached matrices.
+//
+// Each Transform is just an index into here, so the per
+// frame rebuild can walk the component arrays 4 transforms
+// at a time instead of one heap object at a time.
+//
+// Transforms can also be parented.  Everything involved in
+// a hierarchy is kept in a depth-first (parents before
+// children) order array, so a subtree is one contiguous
+// range to mark dirty and world matrices are composed in a
+// single linear sweep over it.
+// --------------------------------------------------------
+class TransformPool
+{
+public:
+
+	TransformPool();
+	~TransformPool();
+	TransformPool(const TransformPool&) = delete; // Remove copy constructor
+	TransformPool& operator=(const TransformPool&) = delete; // Remove copy-assignment operator
+
+	// The pool Transforms are created in unless told otherwise
+	static TransformPool& Default();
+
+	// Marks "no transform" for parent/child links
+	static constexpr unsigned int NONE = 0xFFFFFFFF;
+
+	// Transforms per job when the batch update is split up (multiple of 4)
+	static const unsigned int PARALLEL_CHUNK = 4096;
+
+	unsigned int Allocate();
+	void Release(unsigned int index);
+
+	// Component access
+	DirectX::XMFLOAT3 GetPosition(unsigned int index);
+	DirectX::XMFLOAT4 GetRotation(unsigned int index);
+	DirectX::XMFLOAT3 GetScale(unsigned int index);
+	void SetPosition(unsigned int index, float x, float y, float z);
+	void SetRotation(unsigned int index, DirectX::XMFLOAT4 quaternion);
+	void SetScale(unsigned int index, float x, float y, float z);
+
+	// Euler angles, converted to/from the stored quaternion.  What comes
+	// back is the equivalent angle set (pitch within +-pi/2), not
+	// necessarily what was set
+	DirectX::XMFLOAT3 GetPitchYawRoll(unsigned int index);
+	void SetPitchYawRoll(unsigned int index, float pitch, float yaw, float roll);
+
+	// Hierarchy.  Components of a child are relative to its parent
+	bool SetParent(unsigned int index, unsigned int parentIndex);
+	unsigned int GetParent(unsigned int index) { return parent[index]; }
+
+	// Cached matrices, rebuilt on demand if the batch update hasn't run yet
+	const DirectX::XMFLOAT4X4& GetWorldMatrix(unsigned int index);
+	const DirectX::XMFLOAT4X4& GetWorldInverseTranspose(unsigned int index);
+
+	// The cached world matrix as the last batch update left it, never
+	// rebuilt here.  Only reads, so it's what jobs running side by side
+	// should use, once UpdateDirty has run
+	const DirectX::XMFLOAT4X4& GetCachedWorldMatrix(unsigned int index) const;
+
+	// Rebuilds every dirty world and inverse-transpose matrix in one pass.
+	// With a job system, the per-transform part is split across its threads
+	void UpdateDirty(JobSystem* jobs = nullptr);
+
+	// Fixed-step interpolation.  BeginTick remembers every transform's
+	// state at the start of a simulation tick; GetInterpolatedWorld then
+	// gives the world matrices part way (alpha) from there to now.  Only
+	// reads, so it's safe from several threads once UpdateDirty has run
+	void BeginTick();
+	void GetInterpolatedWorld(unsigned int index, float alpha, DirectX::XMFLOAT4X4& world, DirectX::XMFLOAT4X4& worldInverseTranspose);
+
+	// Change tracking, for caches of what was drawn (see ShadowCache).
+	// Ticks count BeginTick calls, and a transform's change tick is the
+	// last one it or anything above it changed in
+	unsigned long long GetTick() { return tick; }
+	unsigned long long GetChangeTick(unsigned int index);
+
+	unsigned int GetCount() { return (unsigned int)alive.size(); }
+	unsigned int GetDirtyCount() const { return dirtyCount; }
+
+private:
+
+	void MarkDirty(unsigned int index);
+	void NoteChange(unsigned int index, unsigned char change);
+	bool MovedSinceTick(unsigned int index);
+	unsigned int RecalculateBatch(unsigned int first);
+	unsigned int RecalculateRange(unsigned int first, unsigned int end);
+	void RebuildOrder();
+	void ResolveWorld(unsigned int index);
+	void ComposeWorld(unsigned int index);
+
+	// Components, one entry per transform.  Always sized to a multiple
+	// of 4 so the batch kernel can load whole lanes without checking
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> rotationX;
+	std::vector<float> rotationY;
+	std::vector<float> rotationZ;
+	std::vector<float> rotationW;
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+
+	std::vector<unsigned char> dirty;
+	std::vector<unsigned char> alive;
+	std::vector<unsigned int> freeList;
+	unsigned int dirtyCount;
+
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldInverseTransposes;
+
+	// Hierarchy links, NONE when unused
+	std::vector<unsigned int> parent;
+	std::vector<unsigned int> firstChild;
+	std::vector<unsigned int> nextSibling;
+	std::vector<unsigned int> prevSibling;
+
+	// Children only: own S*R*T and its inverse-transpose, and whether
+	// the composed world is stale
+	std::vector<DirectX::XMFLOAT4X4> localMatrices;
+	std::vector<DirectX::XMFLOAT4X4> localInverseTransposes;
+	std::vector<unsigned char> worldDirty;
+
+	// State at the last BeginTick and what's happened since.  RESET
+	// (new or reparented) means there's nothing sensible to blend from
+	static constexpr unsigned char TICK_SAME = 0;
+	static constexpr unsigned char TICK_MOVED = 1;
+	static constexpr unsigned char TICK_RESET = 2;
+	std::vector<DirectX::XMFLOAT3> previousPositions;
+	std::vector<DirectX::XMFLOAT4> previousRotations;
+	std::vector<DirectX::XMFLOAT3> previousScales;
+	std::vector<unsigned char> tickChange;
+	std::vector<unsigned int> tickChanged; // everything not TICK_SAME
+	unsigned long long tick; // BeginTick calls so far
+	std::vector<unsigned long long> changeTicks; // the tick each transform last changed in
+
+	// Depth-first order of every transform in a hierarchy, plus each
+	// one's position in it and how many descendants follow it
+	std::vector<unsigned int> order;
+	std::vector<unsigned int> orderPosition;
+	std::vector<unsigned int> subtreeSize;
+	bool orderDirty;
+};
@@ -11,8 +11,6 @@ cbuffer ExternalData : register(b0)
     matrix viewMatrix;
     matrix projectionMatrix;
 	matrix worldInvTranspose;
-    matrix lightView;
-    matrix lightProjection;
 	
 }
 
@@ -33,9 +31,6 @@ VertexToPixel main( VertexShaderInput input )
     matrix wvp = mul(projectionMatrix, mul(viewMatrix, worldMatrix));
     output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
 
-    matrix shadowWVP = mul(lightProjection, mul(lightView, worldMatrix));
-    output.shadowMapPos = mul(shadowWVP, float4(input.localPosition, 1.0f));
-
 
     output.normal = mul((float3x3)worldInvTranspose, input.normal);
 	output.worldPosition = mul(worldMatrix, float4(input.localPosition, 1)).xyz;
@@ -302,8 +302,8 @@ LRESULT Window::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		windowWidth = LOWORD(lParam);
 		windowHeight = HIWORD(lParam);
 
-		// Let other systems know
-		Graphics::ResizeBuffers(windowWidth, windowHeight);
+		// Let other systems know (the swap chain is resized
+		// by the render thread once it sees the new size)
 		if(onResize)
 			onResize();
 